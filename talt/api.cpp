@@ -0,0 +1,133 @@
+#include "api.h"
+#include "context.h"
+
+namespace {
+
+TargetAbi toTargetAbi(TaltTarget target) {
+    switch (target) {
+    case TALT_TARGET_LP64: return ABI_LP64;
+    case TALT_TARGET_LLP64: return ABI_LLP64;
+    default: return ABI_ILP32;
+    }
+}
+
+//   .    
+// ,      ,    .
+template <class T>
+T& nextItem(std::vector<T>& items, size_t& used) {
+    if (used == items.size()) items.emplace_back();
+    return items[used++];
+}
+
+void addDiagnostics(TaltResult& result, size_t& used,
+    const std::vector<Diagnostic>& diagnostics, bool syntax) {
+    for (const auto& diagnostic : diagnostics) {
+        TaltDiagnostic& item = nextItem(result.diagnostics, used);
+        item.line = diagnostic.line;
+        item.column = diagnostic.column;
+        item.warning = diagnostic.warning;
+        item.syntax = syntax;
+        item.message = diagnostic.message;
+    }
+}
+
+//    SemanticAnalyzer::printScope
+void addScope(TaltResult& result, size_t& used, const SemanticAnalyzer& semantic,
+    const Symbol* scope, int depth) {
+    for (const Symbol* sym = scope->firstChild; sym; sym = sym->nextSibling) {
+        if (sym->category != CAT_TYPE) {
+            TaltSymbol& symbol = nextItem(result.symbols, used);
+            symbol.name = semantic.nameOf(sym->name);
+            symbol.category = SemanticAnalyzer::categoryToString(sym->category);
+            symbol.type = SemanticAnalyzer::dataTypeToString(sym->type->kind);
+            symbol.structType = semantic.nameOf(sym->type->structName);
+            symbol.depth = depth;
+            symbol.initialized = sym->category == CAT_VARIABLE && sym->isInitialized;
+        }
+        if (sym->firstChild) {
+            addScope(result, used, semantic, sym, depth + 2);
+        }
+    }
+}
+
+void addStructs(TaltResult& result, const SemanticAnalyzer& semantic,
+    std::vector<const StructTypeInfo*>& sorted) {
+    semantic.sortedStructTypes(sorted);
+    result.structs.resize(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const StructTypeInfo& info = *sorted[i];
+        TaltStruct& type = result.structs[i];
+        type.name = info.name;
+        type.size = info.size;
+        type.align = info.align;
+        type.complete = info.complete;
+        type.fields.resize(info.fields.size());
+        for (size_t j = 0; j < info.fields.size(); j++) {
+            const FieldInfo& field = info.fields[j];
+            TaltField& item = type.fields[j];
+            item.name = field.name;
+            item.type = SemanticAnalyzer::dataTypeToString(field.type);
+            item.structType = field.structTypeName;
+            item.offset = field.offset;
+            item.size = field.size;
+            item.align = field.align;
+        }
+    }
+}
+
+void checkInto(CheckContext& context, std::string_view source, const TaltOptions& options,
+    TaltResult& result, std::vector<const StructTypeInfo*>& sorted) {
+    result.ok = false;
+    size_t diagnostics = 0, symbols = 0;
+
+    //    32-;       stderr
+    if (source.size() > SOURCE_SIZE_LIMIT) {
+        nextItem(result.diagnostics, diagnostics) =
+            { 0, 0, false, true, "   4 " };
+        source = std::string_view();
+    }
+    bool tooLong = diagnostics > 0;
+
+    ProgramNode* ast = context.parse(source, options.maxErrors);
+    Parser& parser = context.getParser();
+    SemanticAnalyzer& semantic = context.getSemantic();
+    addDiagnostics(result, diagnostics, parser.diagnostics, true);
+    if (ast && !tooLong) {
+        context.analyze(toTargetAbi(options.target), nullptr);
+        addDiagnostics(result, diagnostics, semantic.getDiagnostics(), false);
+        addScope(result, symbols, semantic, semantic.getGlobalScope(), 0);
+        addStructs(result, semantic, sorted);
+        result.ok = !parser.hasError && !semantic.hasErrors();
+    }
+    else {
+        result.structs.clear();
+    }
+    result.diagnostics.resize(diagnostics);
+    result.symbols.resize(symbols);
+}
+}
+
+struct TaltContext::State {
+    CheckContext context;
+    TaltResult result;
+    std::vector<const StructTypeInfo*> sorted;
+};
+
+TaltContext::TaltContext() : state(new State()) {}
+
+TaltContext::~TaltContext() {
+    delete state;
+}
+
+const TaltResult& TaltContext::check(std::string_view source, const TaltOptions& options) {
+    checkInto(state->context, source, options, state->result, state->sorted);
+    return state->result;
+}
+
+TaltResult taltCheck(std::string_view source, const TaltOptions& options) {
+    CheckContext context;
+    TaltResult result;
+    std::vector<const StructTypeInfo*> sorted;
+    checkInto(context, source, options, result, sorted);
+    return result;
+}
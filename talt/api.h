@@ -0,0 +1,115 @@
+#ifndef TALT_API_H
+#define TALT_API_H
+
+//        talt  
+// .  :    
+//   .     ,    
+//     ;     .
+//
+// : talt_lib.vcxproj -  , talt_dll.vcxproj -
+//  (TALT_BUILD_DLL). ,  DLL, 
+// TALT_USE_DLL.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(TALT_BUILD_DLL)
+#ifdef _WIN32
+#define TALT_API __declspec(dllexport)
+#else
+#define TALT_API __attribute__((visibility("default")))
+#endif
+#elif defined(TALT_USE_DLL) && defined(_WIN32)
+#define TALT_API __declspec(dllimport)
+#else
+#define TALT_API
+#endif
+
+//    ,  --target
+enum TaltTarget {
+    TALT_TARGET_ILP32,
+    TALT_TARGET_LP64,
+    TALT_TARGET_LLP64
+};
+
+struct TaltOptions {
+    TaltTarget target = TALT_TARGET_ILP32;
+    int maxErrors = 100;  //     
+};
+
+//   .     ,  
+//   (cp1251);  0:0 -    .
+struct TaltDiagnostic {
+    int line;
+    int column;
+    bool warning;
+    bool syntax;  //  ;  - 
+    std::string message;
+};
+
+struct TaltField {
+    std::string name;
+    std::string type;        // short, int, long, float  struct
+    std::string structType;  //  -
+    int offset;              // -1,    
+    int size;
+    int align;
+};
+
+//       
+struct TaltStruct {
+    std::string name;
+    std::vector<TaltField> fields;
+    int size;
+    int align;
+    bool complete;
+};
+
+//    .     
+// , depth - ,     .
+//    .
+struct TaltSymbol {
+    std::string name;
+    std::string category;    // variable, field, struct_type, function
+    std::string type;        //  function -  
+    std::string structType;
+    int depth;
+    bool initialized;
+};
+
+struct TaltResult {
+    bool ok = false;  //     
+    std::vector<TaltDiagnostic> diagnostics;
+    std::vector<TaltStruct> structs;  //  
+    std::vector<TaltSymbol> symbols;
+};
+
+//    .  : import - . 
+//    ;     .
+TALT_API TaltResult taltCheck(std::string_view source,
+    const TaltOptions& options = TaltOptions());
+
+//    .    ,
+//     ,   
+//        .  - 
+//  .
+class TALT_API TaltContext {
+public:
+    TaltContext();
+    ~TaltContext();
+
+    TaltContext(const TaltContext&) = delete;
+    TaltContext& operator=(const TaltContext&) = delete;
+
+    //  ,  taltCheck;     
+    const TaltResult& check(std::string_view source,
+        const TaltOptions& options = TaltOptions());
+
+private:
+    struct State;
+    State* state;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "cache.h"
+#include "stats.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define TALT_MKDIR(path) _mkdir(path)
+#define TALT_GETPID() _getpid()
+#else
+#include <unistd.h>
+#define TALT_MKDIR(path) mkdir(path, 0777)
+#define TALT_GETPID() getpid()
+#endif
+
+// ==================== xxHash64 ====================
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= hashRound(0, val);
+    return acc * PRIME1 + PRIME4;
+}
+
+uint64_t ResultCache::hash(const char* data, size_t size, uint64_t seed) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = hashRound(v1, read64(p));
+            v2 = hashRound(v2, read64(p + 8));
+            v3 = hashRound(v3, read64(p + 16));
+            v4 = hashRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = seed + PRIME5;
+    }
+
+    h += (uint64_t)size;
+
+    while (p + 8 <= end) {
+        h ^= hashRound(0, read64(p));
+        h = rotl64(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME1;
+        h = rotl64(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (*p) * PRIME5;
+        h = rotl64(h, 11) * PRIME1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t ResultCache::makeKey(const std::string& content, const std::string& settings) {
+    static const uint64_t versionSeed = hash(TALT_CACHE_STAMP, std::strlen(TALT_CACHE_STAMP));
+    uint64_t seed = hash(settings.data(), settings.size(), versionSeed);
+    return hash(content.data(), content.size(), seed);
+}
+
+// ====================  ====================
+
+ResultCache::ResultCache(const std::string& dir)
+    : directory(dir), usable(false) {
+    struct stat info;
+    if (stat(directory.c_str(), &info) != 0) {
+        TALT_MKDIR(directory.c_str());
+    }
+    usable = stat(directory.c_str(), &info) == 0 && (info.st_mode & S_IFDIR) != 0;
+}
+
+std::string ResultCache::entryPath(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tc", (unsigned long long)key);
+    return directory + "/" + name;
+}
+
+static bool readBlock(std::istream& in, std::string& block) {
+    size_t size = 0;
+    if (!(in >> size) || in.get() != '\n') {
+        return false;
+    }
+    block.resize(size);
+    return size == 0 || in.read(&block[0], size).gcount() == (std::streamsize)size;
+}
+
+bool ResultCache::load(uint64_t key, CachedResult& result) {
+    std::ifstream in(entryPath(key), std::ios::binary);
+    std::string header;
+
+    bool found = in.is_open() &&
+        std::getline(in, header) &&
+        header == "talt-cache " TALT_CACHE_STAMP &&
+        readBlock(in, result.parseErrors) &&
+        readBlock(in, result.report) &&
+        readBlock(in, result.summary);
+
+    if (found) {
+        hits++;
+        TALT_COUNT(STAT_CACHE_HITS);
+    }
+    else {
+        misses++;
+        TALT_COUNT(STAT_CACHE_MISSES);
+    }
+    return found;
+}
+
+bool ResultCache::store(uint64_t key, const CachedResult& result) {
+    if (!usable) {
+        return false;
+    }
+
+    //    :  +  + .
+    // store      
+    static std::atomic<unsigned> counter{ 0 };
+    std::stringstream tmpName;
+    tmpName << entryPath(key) << ".tmp." << TALT_GETPID() << "."
+        << std::chrono::steady_clock::now().time_since_epoch().count()
+        << "." << counter.fetch_add(1, std::memory_order_relaxed);
+    std::string tmpPath = tmpName.str();
+
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << "talt-cache " TALT_CACHE_STAMP "\n"
+            << result.parseErrors.size() << "\n" << result.parseErrors
+            << result.report.size() << "\n" << result.report
+            << result.summary.size() << "\n" << result.summary;
+        //     :    
+        // ,        
+        out.close();
+        if (out.fail()) {
+            std::remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    // rename   .     rename 
+    //   ,      
+    //    ,     .
+    if (std::rename(tmpPath.c_str(), entryPath(key).c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
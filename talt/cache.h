@@ -0,0 +1,55 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+//  
+#define TALT_VERSION "0.10"
+
+//   .     , 
+//   (, , )   
+// --check,     .    
+//      ,   
+//   .
+#define TALT_RESULT_STAMP "4"
+#define TALT_CACHE_STAMP TALT_VERSION "/" TALT_RESULT_STAMP
+
+//     
+struct CachedResult {
+    std::string parseErrors;  //  ,    
+    std::string report;       // ,  , , 
+    std::string summary;      //    import, . module.h
+};
+
+//    .  -     
+// ,  -   <>.tc   .
+//       , 
+//        .
+class ResultCache {
+private:
+    std::string directory;
+    bool usable;
+
+    std::string entryPath(uint64_t key) const;
+
+public:
+    explicit ResultCache(const std::string& dir);
+
+    //          
+    std::atomic<unsigned long long> hits{ 0 };
+    std::atomic<unsigned long long> misses{ 0 };
+
+    bool isUsable() const { return usable; }
+
+    static uint64_t hash(const char* data, size_t size, uint64_t seed = 0);
+    // settings -  ,   
+    static uint64_t makeKey(const std::string& content, const std::string& settings = "");
+
+    bool load(uint64_t key, CachedResult& result);
+    bool store(uint64_t key, const CachedResult& result);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "context.h"
+
+CheckContext::CheckContext()
+    : scanner("", 0), parser(scanner), lastSize(0) {
+    parser.reportToStderr = false;
+}
+
+CheckContext::~CheckContext() {
+    releaseTree();
+}
+
+void CheckContext::releaseTree() {
+    //         
+    NodeArenaScope scope(&nodes);
+    ast.reset();
+}
+
+ProgramNode* CheckContext::parse(std::string_view text, int maxErrors) {
+    releaseTree();
+    if (lastSize > RETAIN_LIMIT || semantic.getNames().size() > NAME_LIMIT ||
+        parser.tableSize() > NAME_LIMIT) {
+        nodes.release();
+        semantic.clear();
+        parser.releaseTables();
+    }
+    else {
+        nodes.rewind();
+        semantic.reset();
+    }
+    lastSize = text.size();
+
+    scanner.assign(text.data(), text.size());
+    parser.reset();
+    parser.maxErrors = maxErrors;
+    semantic.setLineTable(&scanner.lineTable());
+
+    NodeArenaScope scope(&nodes);
+    ast = parser.parse();
+    return ast.get();
+}
+
+void CheckContext::analyze(TargetAbi target, ModuleProvider* modules) {
+    if (!ast) return;
+    semantic.setTargetAbi(target);
+    semantic.setModuleProvider(modules);
+
+    NodeArenaScope scope(&nodes);
+    Symbol* dummy = nullptr;
+    ast->checkSemantics(semantic, dummy);
+}
@@ -0,0 +1,52 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "parser.h"
+#include "semantic.h"
+#include <memory>
+#include <string_view>
+
+//    ,   . , , 
+//      ,     :
+//         
+// .    .
+class CheckContext {
+public:
+    CheckContext();
+    ~CheckContext();
+
+    CheckContext(const CheckContext&) = delete;
+    CheckContext& operator=(const CheckContext&) = delete;
+
+    //  text,      .
+    //      ; nullptr -  
+    // ,   getParser().
+    ProgramNode* parse(std::string_view text, int maxErrors);
+    //    
+    void analyze(TargetAbi target, ModuleProvider* modules);
+
+    Parser& getParser() { return parser; }
+    SemanticAnalyzer& getSemantic() { return semantic; }
+    const LineTable& lineTable() const { return scanner.lineTable(); }
+
+    //        ,  
+    //    
+    static const size_t RETAIN_LIMIT = 1024 * 1024;
+
+private:
+    // ,   ,  ,
+    //    :      
+    //    
+    static const size_t NAME_LIMIT = 64 * 1024;
+
+    Arena nodes;
+    Scanner scanner;
+    Parser parser;
+    SemanticAnalyzer semantic;
+    std::unique_ptr<ProgramNode> ast;
+    size_t lastSize;
+
+    void releaseTree();
+};
+
+#endif
@@ -0,0 +1,527 @@
+#include "dataflow.h"
+#include "visitor.h"
+#include "stats.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t NO_DEFINITION = UINT32_MAX;
+
+size_t wordCount(size_t bits) {
+    return (bits + 63) / 64;
+}
+
+bool testBit(const uint64_t* words, size_t bit) {
+    return (words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+void setBit(uint64_t* words, size_t bit) {
+    words[bit >> 6] |= uint64_t(1) << (bit & 63);
+}
+
+void resetBit(uint64_t* words, size_t bit) {
+    words[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+}
+
+//      
+int lowestBit(uint64_t bits) {
+    int index = 0;
+    while (!(bits & 0xFF)) {
+        bits >>= 8;
+        index += 8;
+    }
+    while (!(bits & 1)) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+}
+
+}
+
+void BitMatrix::assign(size_t rows, size_t bits, bool value) {
+    rowCount = rows;
+    bitCount = bits;
+    words = wordCount(bits);
+    data.assign(rows * words, value ? ~uint64_t(0) : 0);
+
+    //      ,   
+    //  
+    if (value && (bits & 63)) {
+        uint64_t last = (uint64_t(1) << (bits & 63)) - 1;
+        for (size_t r = 0; r < rows; r++) {
+            row(r)[words - 1] = last;
+        }
+    }
+}
+
+//      .  
+// for (init; cond; inc) body   
+//   init -> cond -> body -> inc -> cond, cond ->  
+class FlowGraphBuilder : public ASTWalker<FlowGraphBuilder> {
+private:
+    FlowGraph& graph;
+    int32_t initializing = -1;  // ,   
+
+    //    -   :  
+    // walk       visit 
+    void walkPart(const std::unique_ptr<ASTNode>& part) {
+        if (part) walk(static_cast<const ASTNode&>(*part));
+    }
+
+    static SourceOffset nameOffset(SourceOffset name, SourceOffset node) {
+        return name ? name : node;
+    }
+
+public:
+    using ASTWalker::visit;
+
+    explicit FlowGraphBuilder(FlowGraph& target) : graph(target) {}
+
+    void visit(const BlockNode& node) {
+        size_t mark = graph.openScope();
+        visitChildren(node);
+        graph.closeScope(mark);
+    }
+
+    void visit(const ForLoopNode& node) {
+        size_t mark = graph.openScope();
+        walkPart(node.init);
+
+        uint32_t before = graph.currentBlock();
+        uint32_t condition = graph.startBlock();
+        graph.addEdge(before, condition);
+        walkPart(node.condition);
+
+        uint32_t body = graph.startBlock();
+        graph.addEdge(condition, body);
+        walkPart(node.body);
+
+        uint32_t bodyEnd = graph.currentBlock();
+        uint32_t increment = graph.startBlock();
+        graph.addEdge(bodyEnd, increment);
+        walkPart(node.increment);
+        graph.addEdge(graph.currentBlock(), condition);
+
+        //     :    
+        uint32_t after = graph.startBlock();
+        if (node.condition) graph.addEdge(condition, after);
+        graph.closeScope(mark);
+    }
+
+    void visit(const VarDeclNode& node) {
+        //   :     
+        uint32_t variable = graph.declare(node.name, node.offset);
+        if (node.initValue) {
+            initializing = (int32_t)variable;
+            walkPart(node.initValue);
+            initializing = -1;
+            graph.addEvent(FLOW_DEF, variable, node.offset);
+        }
+        else {
+            graph.addEvent(FLOW_DECLARE, variable, node.offset);
+            graph.mayReadUninitialized = true;
+        }
+    }
+
+    void visit(const AssignNode& node) {
+        walkPart(node.expression);
+        int32_t variable = graph.lookup(node.varName);
+        if (variable >= 0) {
+            graph.addEvent(node.fieldName.empty() ? FLOW_DEF : FLOW_DEF_FIELD,
+                (uint32_t)variable, nameOffset(node.nameOffset, node.offset));
+        }
+    }
+
+    void visit(const VarNode& node) {
+        int32_t variable = graph.lookup(node.name);
+        if (variable == initializing) graph.mayReadUninitialized = true;
+        if (variable >= 0) {
+            graph.addEvent(FLOW_USE, (uint32_t)variable,
+                nameOffset(node.nameOffset, node.offset));
+        }
+    }
+
+    void visit(const ReturnNode& node) {
+        walkPart(node.expression);
+        graph.returns.push_back(graph.currentBlock());
+        graph.startBlock();
+    }
+};
+
+uint32_t FlowGraph::startBlock() {
+    uint32_t first = (uint32_t)events.size();
+    blocks.push_back({ first, first });
+    return (uint32_t)blocks.size() - 1;
+}
+
+int32_t FlowGraph::lookup(const std::string& name) const {
+    if (indexed) {
+        NameId id = names->find(name);
+        return id < binding.size() ? binding[id] : -1;
+    }
+    for (size_t i = visible.size(); i-- > 0;) {
+        if (*visible[i].name == name) return visible[i].variable;
+    }
+    return -1;
+}
+
+void FlowGraph::bind(VisibleName& entry) {
+    entry.id = names->find(*entry.name);
+    if (entry.id == NO_NAME) return;
+    if (entry.id >= binding.size()) binding.resize(entry.id + 1, -1);
+    entry.shadowed = binding[entry.id];
+    binding[entry.id] = entry.variable;
+}
+
+uint32_t FlowGraph::declare(const std::string& name, SourceOffset offset) {
+    int32_t variable = (int32_t)variables.size();
+    visible.push_back({ &name, NO_NAME, variable, -1 });
+    if (indexed) {
+        bind(visible.back());
+    }
+    else if (visible.size() > SMALL_SCOPE_VARIABLES) {
+        indexed = true;
+        for (auto& entry : visible) bind(entry);
+    }
+    variables.push_back({ &name, offset });
+    return (uint32_t)variable;
+}
+
+void FlowGraph::closeScope(size_t mark) {
+    while (visible.size() > mark) {
+        const VisibleName& last = visible.back();
+        if (indexed && last.id != NO_NAME) binding[last.id] = last.shadowed;
+        visible.pop_back();
+    }
+}
+
+void FlowGraph::build(const FunctionNode& function, const NameTable& nameTable) {
+    blocks.clear();
+    events.clear();
+    variables.clear();
+    edges.clear();
+    returns.clear();
+    names = &nameTable;
+    mayReadUninitialized = false;
+
+    startBlock();
+    //      
+    for (const auto& param : function.params) {
+        addEvent(FLOW_DEF, declare(param.name, param.offset), param.offset);
+    }
+    FlowGraphBuilder builder(*this);
+    if (function.body) builder.walk(static_cast<const ASTNode&>(*function.body));
+    closeScope(0);
+    indexed = false;
+
+    uint32_t last = currentBlock();
+    uint32_t exitBlock = startBlock();
+    addEdge(last, exitBlock);
+    for (uint32_t from : returns) {
+        addEdge(from, exitBlock);
+    }
+    finishEdges();
+    TALT_COUNT_ADD(STAT_FLOW_BLOCKS, blocks.size());
+}
+
+void FlowGraph::finishEdges() {
+    for (size_t b = 0; b + 1 < blocks.size(); b++) {
+        blocks[b].endEvent = blocks[b + 1].firstEvent;
+    }
+    blocks.back().endEvent = (uint32_t)events.size();
+
+    //     :  ,  
+    size_t n = blocks.size();
+    successorStart.assign(n + 1, 0);
+    predecessorStart.assign(n + 1, 0);
+    for (const auto& edge : edges) {
+        successorStart[edge.first + 1]++;
+        predecessorStart[edge.second + 1]++;
+    }
+    for (size_t b = 0; b < n; b++) {
+        successorStart[b + 1] += successorStart[b];
+        predecessorStart[b + 1] += predecessorStart[b];
+    }
+    successors.resize(edges.size());
+    predecessors.resize(edges.size());
+    //      ;  
+    for (const auto& edge : edges) {
+        successors[successorStart[edge.first]++] = edge.second;
+        predecessors[predecessorStart[edge.second]++] = edge.first;
+    }
+    for (size_t b = n; b > 0; b--) {
+        successorStart[b] = successorStart[b - 1];
+        predecessorStart[b] = predecessorStart[b - 1];
+    }
+    successorStart[0] = 0;
+    predecessorStart[0] = 0;
+}
+
+void DataflowSolver::solve(const FlowGraph& graph, const DataflowProblem& problem,
+    DataflowSolution& result) {
+    size_t n = graph.blockCount();
+    bool forward = problem.direction == FLOW_FORWARD;
+    bool intersect = problem.meet == FLOW_INTERSECTION;
+
+    //   -  :   ,
+    //    
+    result.in.assign(n, problem.width, intersect);
+    result.out.assign(n, problem.width, intersect);
+    result.evaluations = 0;
+
+    //         
+    BitMatrix& source = forward ? result.in : result.out;
+    BitMatrix& target = forward ? result.out : result.in;
+    uint32_t boundary = forward ? graph.entry() : graph.exit();
+    size_t words = source.wordsPerRow();
+
+    pending.assign(wordCount(n), ~uint64_t(0));
+    if (n & 63) pending.back() = (uint64_t(1) << (n & 63)) - 1;
+
+    size_t cursor = 0;
+    for (;;) {
+        //    ,   cursor,  
+        size_t found = n;
+        for (size_t pass = 0; pass < 2 && found == n; pass++) {
+            size_t w = cursor >> 6;
+            uint64_t bits = w < pending.size() ? pending[w] & (~uint64_t(0) << (cursor & 63)) : 0;
+            while (w < pending.size()) {
+                if (bits) {
+                    found = (w << 6) + lowestBit(bits);
+                    break;
+                }
+                if (++w < pending.size()) bits = pending[w];
+            }
+            cursor = 0;
+        }
+        if (found == n) break;
+        resetBit(pending.data(), found);
+        cursor = found + 1;
+
+        uint32_t block = (uint32_t)(forward ? found : n - 1 - found);
+        uint64_t* in = source.row(block);
+        const uint32_t* begin = forward ? graph.predecessorsBegin(block) : graph.successorsBegin(block);
+        const uint32_t* end = forward ? graph.predecessorsEnd(block) : graph.successorsEnd(block);
+        bool empty = true;
+        if (block == boundary) {
+            std::copy(problem.boundary.row(0), problem.boundary.row(0) + words, in);
+            empty = false;
+        }
+        for (const uint32_t* it = begin; it != end; ++it) {
+            const uint64_t* other = target.row(*it);
+            if (empty) {
+                std::copy(other, other + words, in);
+                empty = false;
+            }
+            else if (intersect) {
+                for (size_t w = 0; w < words; w++) in[w] &= other[w];
+            }
+            else {
+                for (size_t w = 0; w < words; w++) in[w] |= other[w];
+            }
+        }
+
+        const uint64_t* gen = problem.gen.row(block);
+        const uint64_t* kill = problem.kill.row(block);
+        uint64_t* out = target.row(block);
+        bool changed = false;
+        for (size_t w = 0; w < words; w++) {
+            uint64_t value = gen[w] | (in[w] & ~kill[w]);
+            changed |= value != out[w];
+            out[w] = value;
+        }
+        result.evaluations++;
+
+        if (changed) {
+            const uint32_t* next = forward ? graph.successorsBegin(block) : graph.predecessorsBegin(block);
+            const uint32_t* last = forward ? graph.successorsEnd(block) : graph.predecessorsEnd(block);
+            for (; next != last; ++next) {
+                setBit(pending.data(), forward ? *next : n - 1 - *next);
+            }
+        }
+    }
+    TALT_COUNT_ADD(STAT_FLOW_EVALUATIONS, result.evaluations);
+}
+
+void ReachingDefinitions::compute(const FlowGraph& graph, DataflowSolver& solver) {
+    size_t variableCount = graph.variables.size();
+    definitions.clear();
+    definitionIndex.assign(graph.events.size(), NO_DEFINITION);
+    byVariableStart.assign(variableCount + 1, 0);
+    for (uint32_t e = 0; e < graph.events.size(); e++) {
+        FlowEventKind kind = graph.events[e].kind;
+        if (kind == FLOW_DEF || kind == FLOW_DEF_FIELD) {
+            definitionIndex[e] = (uint32_t)definitions.size();
+            definitions.push_back(e);
+            byVariableStart[graph.events[e].variable + 1]++;
+        }
+    }
+
+    //    ,   kill
+    for (size_t v = 0; v < variableCount; v++) {
+        byVariableStart[v + 1] += byVariableStart[v];
+    }
+    byVariable.resize(definitions.size());
+    killedList.assign(byVariableStart.begin(), byVariableStart.end() - 1);
+    for (uint32_t d = 0; d < definitions.size(); d++) {
+        byVariable[killedList[graph.events[definitions[d]].variable]++] = d;
+    }
+    killedList.clear();
+
+    size_t blocks = graph.blockCount();
+    problem.direction = FLOW_FORWARD;
+    problem.meet = FLOW_UNION;
+    problem.width = definitions.size();
+    problem.gen.assign(blocks, problem.width, false);
+    problem.kill.assign(blocks, problem.width, false);
+    problem.boundary.assign(1, problem.width, false);
+    killedLater.assign(wordCount(variableCount), 0);
+
+    //    :     
+    //  ,      
+    // . kill -    .
+    for (uint32_t b = 0; b < blocks; b++) {
+        const FlowBlock& block = graph.blocks[b];
+        for (uint32_t e = block.endEvent; e-- > block.firstEvent;) {
+            const FlowEvent& event = graph.events[e];
+            if (event.kind == FLOW_USE || testBit(killedLater.data(), event.variable)) continue;
+            if (event.kind != FLOW_DECLARE) problem.gen.set(b, definitionIndex[e]);
+            if (event.kind != FLOW_DEF_FIELD) {
+                setBit(killedLater.data(), event.variable);
+                killedList.push_back(event.variable);
+            }
+        }
+        for (uint32_t v : killedList) {
+            for (uint32_t i = byVariableStart[v]; i < byVariableStart[v + 1]; i++) {
+                problem.kill.set(b, byVariable[i]);
+            }
+            resetBit(killedLater.data(), v);
+        }
+        killedList.clear();
+    }
+
+    solver.solve(graph, problem, solution);
+}
+
+void DefiniteInitialization::compute(const FlowGraph& graph, DataflowSolver& solver) {
+    size_t blocks = graph.blockCount();
+    problem.direction = FLOW_FORWARD;
+    problem.meet = FLOW_INTERSECTION;
+    problem.width = graph.variables.size();
+    problem.gen.assign(blocks, problem.width, false);
+    problem.kill.assign(blocks, problem.width, false);
+    //        
+    problem.boundary.assign(1, problem.width, false);
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        const FlowBlock& block = graph.blocks[b];
+        for (uint32_t e = block.firstEvent; e < block.endEvent; e++) {
+            const FlowEvent& event = graph.events[e];
+            if (event.kind == FLOW_DEF || event.kind == FLOW_DEF_FIELD) {
+                problem.gen.set(b, event.variable);
+                problem.kill.reset(b, event.variable);
+            }
+            else if (event.kind == FLOW_DECLARE) {
+                problem.gen.reset(b, event.variable);
+                problem.kill.set(b, event.variable);
+            }
+        }
+    }
+
+    solver.solve(graph, problem, solution);
+}
+
+void DefiniteInitialization::uninitializedUses(const FlowGraph& graph,
+    std::vector<FlowEvent>& uses) {
+    size_t words = solution.in.wordsPerRow();
+    reported.assign(words, 0);
+    current.resize(words);
+
+    for (uint32_t b = 0; b < graph.blockCount(); b++) {
+        const FlowBlock& block = graph.blocks[b];
+        if (block.firstEvent == block.endEvent) continue;
+        const uint64_t* in = solution.in.row(b);
+        std::copy(in, in + words, current.begin());
+        for (uint32_t e = block.firstEvent; e < block.endEvent; e++) {
+            const FlowEvent& event = graph.events[e];
+            switch (event.kind) {
+            case FLOW_USE:
+                if (!testBit(current.data(), event.variable) &&
+                    !testBit(reported.data(), event.variable)) {
+                    setBit(reported.data(), event.variable);
+                    uses.push_back(event);
+                }
+                break;
+            case FLOW_DECLARE:
+                resetBit(current.data(), event.variable);
+                break;
+            default:
+                setBit(current.data(), event.variable);
+                break;
+            }
+        }
+    }
+}
+
+void LiveVariables::compute(const FlowGraph& graph, DataflowSolver& solver) {
+    size_t blocks = graph.blockCount();
+    problem.direction = FLOW_BACKWARD;
+    problem.meet = FLOW_UNION;
+    problem.width = graph.variables.size();
+    problem.gen.assign(blocks, problem.width, false);
+    problem.kill.assign(blocks, problem.width, false);
+    //      
+    problem.boundary.assign(1, problem.width, false);
+
+    //   :    ,  
+    //   -    
+    for (uint32_t b = 0; b < blocks; b++) {
+        const FlowBlock& block = graph.blocks[b];
+        for (uint32_t e = block.endEvent; e-- > block.firstEvent;) {
+            const FlowEvent& event = graph.events[e];
+            if (event.kind == FLOW_USE) {
+                problem.gen.set(b, event.variable);
+            }
+            else if (event.kind != FLOW_DEF_FIELD) {
+                problem.gen.reset(b, event.variable);
+                problem.kill.set(b, event.variable);
+            }
+        }
+    }
+
+    solver.solve(graph, problem, solution);
+}
+
+namespace {
+
+//         
+struct InitializationCheck {
+    FlowGraph graph;
+    DataflowSolver solver;
+    DefiniteInitialization initialization;
+    std::vector<FlowEvent> uses;
+};
+
+thread_local InitializationCheck initializationCheck;
+
+}
+
+void checkInitialization(const FunctionNode& function, SemanticAnalyzer& sem) {
+    InitializationCheck& check = initializationCheck;
+    check.graph.build(function, sem.getNames());
+    if (!check.graph.mayReadUninitialized) return;
+
+    check.initialization.compute(check.graph, check.solver);
+    check.uses.clear();
+    check.initialization.uninitializedUses(check.graph, check.uses);
+
+    //      ;  -  
+    std::sort(check.uses.begin(), check.uses.end(),
+        [](const FlowEvent& a, const FlowEvent& b) { return a.offset < b.offset; });
+    for (const auto& use : check.uses) {
+        const FlowVariable& variable = check.graph.variables[use.variable];
+        sem.addWarning(" '" + *variable.name +
+            "'    ", use.offset);
+    }
+}
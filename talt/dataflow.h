@@ -0,0 +1,219 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include "parser.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//   :    ,    
+//  .    ,  
+//         .
+class BitMatrix {
+private:
+    std::vector<uint64_t> data;
+    size_t rowCount = 0;
+    size_t bitCount = 0;
+    size_t words = 0;
+
+public:
+    // rows   bits ,    value
+    void assign(size_t rows, size_t bits, bool value);
+
+    size_t rows() const { return rowCount; }
+    size_t bits() const { return bitCount; }
+    size_t wordsPerRow() const { return words; }
+
+    uint64_t* row(size_t r) { return data.data() + r * words; }
+    const uint64_t* row(size_t r) const { return data.data() + r * words; }
+
+    bool test(size_t r, size_t bit) const {
+        return (row(r)[bit >> 6] >> (bit & 63)) & 1;
+    }
+    void set(size_t r, size_t bit) { row(r)[bit >> 6] |= uint64_t(1) << (bit & 63); }
+    void reset(size_t r, size_t bit) { row(r)[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+};
+
+//     
+enum FlowEventKind : unsigned char {
+    FLOW_USE,        //     
+    FLOW_DEF,        //   
+    FLOW_DEF_FIELD,  //  :   
+    FLOW_DECLARE     //   :   
+};
+
+struct FlowEvent {
+    FlowEventKind kind;
+    uint32_t variable;     //   FlowGraph::variables
+    SourceOffset offset;   //    
+};
+
+struct FlowVariable {
+    const std::string* name;  //   
+    SourceOffset offset;
+};
+
+//  :  [firstEvent, endEvent)  
+struct FlowBlock {
+    uint32_t firstEvent;
+    uint32_t endEvent;
+};
+
+//    ,    AST.
+//    .  0 - ,  -
+// ,    return   .   return 
+//    .     ,
+//   :         
+//        .
+class FlowGraph {
+public:
+    std::vector<FlowBlock> blocks;
+    std::vector<FlowEvent> events;
+    std::vector<FlowVariable> variables;
+
+    //       
+    //  .     
+    // ,   .
+    bool mayReadUninitialized = false;
+
+    size_t blockCount() const { return blocks.size(); }
+    uint32_t entry() const { return 0; }
+    uint32_t exit() const { return (uint32_t)blocks.size() - 1; }
+
+    //     successors  predecessors
+    const uint32_t* successorsBegin(uint32_t b) const { return successors.data() + successorStart[b]; }
+    const uint32_t* successorsEnd(uint32_t b) const { return successors.data() + successorStart[b + 1]; }
+    const uint32_t* predecessorsBegin(uint32_t b) const { return predecessors.data() + predecessorStart[b]; }
+    const uint32_t* predecessorsEnd(uint32_t b) const { return predecessors.data() + predecessorStart[b + 1]; }
+
+    //    names ,  
+    void build(const FunctionNode& function, const NameTable& names);
+
+private:
+    std::vector<uint32_t> successorStart, successors;
+    std::vector<uint32_t> predecessorStart, predecessors;
+
+    //        ,  
+    //    ;  -     binding
+    static const size_t SMALL_SCOPE_VARIABLES = 16;
+
+    struct VisibleName {
+        const std::string* name;
+        NameId id;
+        int32_t variable;
+        int32_t shadowed;  //   binding[id]
+    };
+
+    //  : ,  return   
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    std::vector<uint32_t> returns;
+    std::vector<VisibleName> visible;
+    bool indexed = false;
+    std::vector<int32_t> binding;  // NameId ->   -1
+    const NameTable* names = nullptr;
+
+    friend class FlowGraphBuilder;
+
+    uint32_t startBlock();
+    void addEdge(uint32_t from, uint32_t to) { edges.push_back({ from, to }); }
+    void addEvent(FlowEventKind kind, uint32_t variable, SourceOffset offset) {
+        events.push_back({ kind, variable, offset });
+    }
+    uint32_t currentBlock() const { return (uint32_t)blocks.size() - 1; }
+    int32_t lookup(const std::string& name) const;
+    //  ,    
+    uint32_t declare(const std::string& name, SourceOffset offset);
+    //   mark    
+    size_t openScope() const { return visible.size(); }
+    void closeScope(size_t mark);
+    void bind(VisibleName& entry);
+    void finishEdges();
+};
+
+//    gen/kill    width:
+//   out = gen | (in & ~kill)
+//    in  -  out , 
+//  -  in ,   in  out  .
+enum FlowDirection { FLOW_FORWARD, FLOW_BACKWARD };
+enum FlowMeet { FLOW_UNION, FLOW_INTERSECTION };
+
+struct DataflowProblem {
+    FlowDirection direction = FLOW_FORWARD;
+    FlowMeet meet = FLOW_UNION;
+    size_t width = 0;
+    BitMatrix gen, kill;      //   
+    BitMatrix boundary;       //  :  entry   exit
+};
+
+// in  out    
+struct DataflowSolution {
+    BitMatrix in, out;
+    size_t evaluations = 0;   //    
+};
+
+//    .      
+// ,      (   - 
+// );     ,   .
+//     .    
+//  .
+class DataflowSolver {
+public:
+    void solve(const FlowGraph& graph, const DataflowProblem& problem,
+        DataflowSolution& result);
+
+private:
+    std::vector<uint64_t> pending;    //     
+};
+
+// ,   .  -  FLOW_DEF 
+// FLOW_DEF_FIELD,  i - definitions[i].   
+//    .
+class ReachingDefinitions {
+public:
+    std::vector<uint32_t> definitions;  //  
+    DataflowSolution solution;
+
+    void compute(const FlowGraph& graph, DataflowSolver& solver);
+
+private:
+    DataflowProblem problem;
+    std::vector<uint32_t> definitionIndex;  //  -> 
+    std::vector<uint32_t> byVariableStart, byVariable;
+    std::vector<uint64_t> killedLater;
+    std::vector<uint32_t> killedList;
+};
+
+// ,       . 
+//    .
+class DefiniteInitialization {
+public:
+    DataflowSolution solution;
+
+    void compute(const FlowGraph& graph, DataflowSolver& solver);
+    // ,       ,
+    //   ;    
+    void uninitializedUses(const FlowGraph& graph, std::vector<FlowEvent>& uses);
+
+private:
+    DataflowProblem problem;
+    std::vector<uint64_t> current;
+    std::vector<uint64_t> reported;
+};
+
+// ,       
+class LiveVariables {
+public:
+    DataflowSolution solution;
+
+    void compute(const FlowGraph& graph, DataflowSolver& solver);
+
+private:
+    DataflowProblem problem;
+};
+
+//      ,  
+// -       .  
+//    .
+void checkInitialization(const FunctionNode& function, SemanticAnalyzer& sem);
+
+#endif
@@ -0,0 +1,309 @@
+#include "depend.h"
+
+namespace {
+
+bool sameAddress(const ExecAddress& a, const ExecAddress& b) {
+    return a.global == b.global && a.offset == b.offset;
+}
+
+bool isLoadOf(const ExecNode* node, const ExecAddress& address) {
+    return node && node->op == EX_LOAD && sameAddress(node->address, address);
+}
+
+int valueSize(ExecType type) {
+    switch (type) {
+    case EXT_I16: return 2;
+    case EXT_I64: return 8;
+    default: return 4;
+    }
+}
+
+//   .       ;
+//    ,     
+// .
+class DependenceWalker {
+private:
+    struct Access {
+        ExecAddress address;
+        int size;
+    };
+
+    const CountedLoop& counted;
+    int localBegin;
+    int localEnd;
+    std::vector<Reduction>& reductions;
+    std::vector<Access> sharedReads;
+    std::string& reason;
+
+    bool isLocal(const ExecAddress& address) const {
+        return !address.global && address.offset >= localBegin &&
+            address.offset < localEnd;
+    }
+
+    bool fail(const char* message) {
+        reason = message;
+        return false;
+    }
+
+    bool read(const ExecAddress& address, int size, const std::vector<bool>& assigned) {
+        if (sameAddress(address, counted.induction)) return true;
+        if (isLocal(address)) {
+            for (int i = 0; i < size; i++) {
+                if (!assigned[address.offset - localBegin + i]) {
+                    return fail("      ");
+                }
+            }
+            return true;
+        }
+        sharedReads.push_back({ address, size });
+        return true;
+    }
+
+    bool expression(const ExecNode* node, std::vector<bool>& assigned) {
+        switch (node->op) {
+        case EX_CONST:
+            return true;
+        case EX_LOAD:
+            return read(node->address, valueSize(node->type), assigned);
+        case EX_STORE:
+            if (!expression(node->left, assigned)) return false;
+            return write(node->address, valueSize(node->type), assigned);
+        case EX_CALL:
+            //      ,   
+            return fail("    ");
+        case EX_INLINE:
+            //       
+            if (node->size && !write(node->address, node->size, assigned)) return false;
+            for (const ExecNode* item : node->items) {
+                if (!statement(item, assigned)) return false;
+            }
+            return !node->left || expression(node->left, assigned);
+        default:
+            if (node->left && !expression(node->left, assigned)) return false;
+            if (node->right && !expression(node->right, assigned)) return false;
+            return true;
+        }
+    }
+
+    bool write(const ExecAddress& address, int size, std::vector<bool>& assigned) {
+        if (sameAddress(address, counted.induction)) {
+            return fail("    ");
+        }
+        if (!isLocal(address)) {
+            return fail("      ");
+        }
+        for (int i = 0; i < size; i++) {
+            assigned[address.offset - localBegin + i] = true;
+        }
+        return true;
+    }
+
+    bool reduction(const Reduction& found, std::vector<bool>& assigned) {
+        const Reduction* known = nullptr;
+        for (const auto& r : reductions) {
+            if (sameAddress(r.address, found.address)) known = &r;
+        }
+        if (known && (known->op != found.op || known->type != found.type)) {
+            return fail("   ");
+        }
+        if (!known) reductions.push_back(found);
+
+        for (const auto& term : found.terms) {
+            if (!expression(term.value, assigned)) return false;
+        }
+        return true;
+    }
+
+public:
+    DependenceWalker(const CountedLoop& loop, int begin, int end,
+        std::vector<Reduction>& found, std::string& why)
+        : counted(loop), localBegin(begin), localEnd(end),
+          reductions(found), reason(why) {}
+
+    bool statement(const ExecNode* node, std::vector<bool>& assigned) {
+        switch (node->op) {
+        case EX_SEQ:
+            for (const ExecNode* item : node->items) {
+                if (!statement(item, assigned)) return false;
+            }
+            return true;
+
+        case EX_DISCARD: {
+            const ExecNode* store = node->left;
+            Reduction found;
+            if (store->op == EX_STORE && !isLocal(store->address) &&
+                !sameAddress(store->address, counted.induction) &&
+                matchReduction(node, true, found)) {
+                return reduction(found, assigned);
+            }
+            return expression(store, assigned);
+        }
+
+        case EX_COPY:
+            if (!read(node->source, node->size, assigned)) return false;
+            return write(node->address, node->size, assigned);
+
+        case EX_FOR: {
+            //         ,
+            //        
+            if (node->left && !statement(node->left, assigned)) return false;
+            if (node->right && !expression(node->right, assigned)) return false;
+            std::vector<bool> inner = assigned;
+            if (node->body && !statement(node->body, inner)) return false;
+            if (node->extra && !statement(node->extra, inner)) return false;
+            return true;
+        }
+
+        case EX_RETURN:
+            return fail("return   ");
+
+        default:
+            return expression(node, assigned);
+        }
+    }
+
+    //       
+    bool checkReductions() {
+        for (const auto& r : reductions) {
+            int size = valueSize(r.type);
+            for (const auto& access : sharedReads) {
+                if (access.address.global == r.address.global &&
+                    access.address.offset < r.address.offset + size &&
+                    r.address.offset < access.address.offset + access.size) {
+                    return fail("     ");
+                }
+            }
+            if (counted.bound->op == EX_LOAD && sameAddress(counted.bound->address, r.address)) {
+                return fail("    ");
+            }
+        }
+        return true;
+    }
+};
+
+}
+
+bool matchReduction(const ExecNode* statement, bool reassociateFloat,
+    Reduction& result) {
+    if (statement->op != EX_DISCARD || statement->left->op != EX_STORE) return false;
+    const ExecNode* store = statement->left;
+    const ExecNode* value = store->left;
+    if (value->op != EX_BINARY || value->type != store->type ||
+        value->operandType != store->type) {
+        return false;
+    }
+
+    TokenType op = value->binop == TK_MINUS ? TK_PLUS : value->binop;
+    if (store->type == EXT_F32) {
+        if (!reassociateFloat || (op != TK_PLUS && op != TK_MUL)) return false;
+    }
+    else if (op != TK_PLUS && op != TK_MUL && op != TK_BIT_AND &&
+        op != TK_BIT_OR && op != TK_BIT_XOR) {
+        return false;
+    }
+
+    Reduction reduction;
+    reduction.address = store->address;
+    reduction.type = store->type;
+    reduction.op = op;
+
+    if (op == TK_PLUS) {
+        //        
+        //   
+        const ExecNode* chain = value;
+        while (true) {
+            if (chain->op != EX_BINARY || chain->operandType != store->type ||
+                (chain->binop != TK_PLUS && chain->binop != TK_MINUS)) {
+                return false;
+            }
+            reduction.terms.push_back({ chain->right, chain->binop == TK_MINUS });
+            if (isLoadOf(chain->left, store->address)) break;
+            if (chain->binop == TK_PLUS && isLoadOf(chain->right, store->address) &&
+                reduction.terms.size() == 1) {
+                reduction.terms.back().value = chain->left;  // value + acc
+                break;
+            }
+            chain = chain->left;
+        }
+    }
+    else if (isLoadOf(value->left, store->address)) {
+        reduction.terms.push_back({ value->right, false });
+    }
+    else if (isLoadOf(value->right, store->address)) {
+        reduction.terms.push_back({ value->left, false });
+    }
+    else {
+        return false;
+    }
+
+    result = std::move(reduction);
+    return true;
+}
+
+bool matchCountedLoop(const ExecNode* node, CountedLoop& result) {
+    if (node->op != EX_FOR || !node->right || !node->extra) {
+        return false;
+    }
+
+    // : i < bound  i <= bound
+    const ExecNode* cond = node->right;
+    if (cond->op != EX_BINARY || cond->operandType != EXT_I32 ||
+        (cond->binop != TK_LT && cond->binop != TK_LE) ||
+        cond->left->op != EX_LOAD || cond->left->type != EXT_I32) {
+        return false;
+    }
+    CountedLoop loop;
+    loop.induction = cond->left->address;
+    loop.compare = cond->binop;
+    loop.bound = cond->right;
+    if (loop.bound->type != EXT_I32 ||
+        (loop.bound->op != EX_CONST && loop.bound->op != EX_LOAD) ||
+        isLoadOf(loop.bound, loop.induction)) {
+        return false;
+    }
+
+    // : i = i + step, step > 0  4 * step   int
+    const ExecNode* step = node->extra;
+    if (step->op != EX_DISCARD || step->left->op != EX_STORE ||
+        !sameAddress(step->left->address, loop.induction)) {
+        return false;
+    }
+    const ExecNode* next = step->left->left;
+    if (next->op != EX_BINARY || next->binop != TK_PLUS ||
+        next->operandType != EXT_I32) {
+        return false;
+    }
+    const ExecNode* increment = isLoadOf(next->left, loop.induction) ? next->right
+        : isLoadOf(next->right, loop.induction) ? next->left : nullptr;
+    if (!increment || increment->op != EX_CONST ||
+        increment->intValue < 1 || increment->intValue > (1 << 20)) {
+        return false;
+    }
+    loop.step = (int)increment->intValue;
+
+    result = loop;
+    return true;
+}
+
+bool analyzeDependence(const ExecNode* loop, int localBegin, int localEnd,
+    LoopDependence& result, std::string& reason) {
+    LoopDependence dependence;
+    if (!matchCountedLoop(loop, dependence.counted)) {
+        reason = "  :   for (...; i < n; i = i + )";
+        return false;
+    }
+    if (!loop->body) {
+        reason = " ";
+        return false;
+    }
+
+    DependenceWalker walker(dependence.counted, localBegin, localEnd,
+        dependence.reductions, reason);
+    std::vector<bool> assigned(localEnd > localBegin ? localEnd - localBegin : 0, false);
+    if (!walker.statement(loop->body, assigned) || !walker.checkReductions()) {
+        return false;
+    }
+
+    result = std::move(dependence);
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef DEPEND_H
+#define DEPEND_H
+
+#include "lower.h"
+#include <string>
+#include <vector>
+
+//  
+struct ReductionTerm {
+    const ExecNode* value;
+    bool negate;
+};
+
+//  acc = acc op value.    acc + a - b + c
+//   (a, -b, c).
+struct Reduction {
+    ExecAddress address;
+    ExecType type;
+    TokenType op;           // TK_PLUS, TK_MUL, TK_BIT_AND, TK_BIT_OR, TK_BIT_XOR
+    std::vector<ReductionTerm> terms;
+};
+
+//    EX_DISCARD(EX_STORE).    float
+//    reassociateFloat:   
+// .
+bool matchReduction(const ExecNode* statement, bool reassociateFloat,
+    Reduction& result);
+
+//   for (...; i < bound; i = i + step):  int,
+//  -  ,  -   
+struct CountedLoop {
+    ExecAddress induction;
+    int step = 1;
+    TokenType compare = TK_LT;        // TK_LT  TK_LE
+    const ExecNode* bound = nullptr;  // EX_CONST  EX_LOAD
+};
+
+bool matchCountedLoop(const ExecNode* loop, CountedLoop& result);
+
+//     
+struct LoopDependence {
+    CountedLoop counted;
+    std::vector<Reduction> reductions;  //   
+};
+
+//    , :
+//   -     ;
+//   -    (  [localBegin, localEnd))
+//          ;
+//   -       
+//             .
+//   reason - .
+bool analyzeDependence(const ExecNode* loop, int localBegin, int localEnd,
+    LoopDependence& result, std::string& reason);
+
+#endif
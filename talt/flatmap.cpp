@@ -0,0 +1,38 @@
+#include "flatmap.h"
+
+bool NameIndexMap::insert(NameId key, uint32_t value) {
+    //    ,    
+    if ((count + 1) * 2 > slots.size()) {
+        grow();
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t i = slotFor(key);
+    while (slots[i].key != NO_NAME) {
+        if (slots[i].key == key) return false;
+        i = (i + 1) & mask;
+    }
+
+    slots[i].key = key;
+    slots[i].value = value;
+    count++;
+    return true;
+}
+
+void NameIndexMap::grow() {
+    std::vector<Slot> old;
+    old.swap(slots);
+
+    size_t capacity = old.empty() ? 16 : old.size() * 2;
+    slots.assign(capacity, Slot{ NO_NAME, 0 });
+    shift = 64;
+    for (size_t c = capacity; c > 1; c >>= 1) shift--;
+
+    size_t mask = capacity - 1;
+    for (const Slot& slot : old) {
+        if (slot.key == NO_NAME) continue;
+        size_t i = slotFor(slot.key);
+        while (slots[i].key != NO_NAME) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
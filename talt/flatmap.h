@@ -0,0 +1,59 @@
+#ifndef FLATMAP_H
+#define FLATMAP_H
+
+#include "names.h"
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+//     .   
+//  :       ,
+//  -   ,  ,  .
+class NameIndexMap {
+private:
+    struct Slot {
+        NameId key;       // NO_NAME -  
+        uint32_t value;
+    };
+
+    std::vector<Slot> slots;  //  -  
+    size_t count;
+    int shift;
+
+    size_t slotFor(NameId key) const {
+        //   
+        return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    void grow();
+
+public:
+    static const uint32_t NOT_FOUND = 0xFFFFFFFF;
+
+    NameIndexMap() : count(0), shift(64) {}
+
+    // false,    
+    bool insert(NameId key, uint32_t value);
+    uint32_t find(NameId key) const {
+        if (count == 0) return NOT_FOUND;
+        size_t mask = slots.size() - 1;
+        for (size_t i = slotFor(key);; i = (i + 1) & mask) {
+            if (slots[i].key == key) return slots[i].value;
+            if (slots[i].key == NO_NAME) return NOT_FOUND;
+        }
+    }
+
+    size_t size() const { return count; }
+    void clear() {
+        slots.clear();
+        count = 0;
+        shift = 64;
+    }
+    //     
+    void rewind() {
+        std::fill(slots.begin(), slots.end(), Slot{ NO_NAME, 0 });
+        count = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "inline.h"
+#include "visitor.h"
+
+namespace {
+
+//      .     
+// ,        
+// :     -   .
+class CostWalker : public ASTWalker<CostWalker> {
+private:
+    const FunctionNode* function;
+    const std::unordered_map<std::string, const FunctionNode*>& declared;
+    std::unordered_map<const FunctionNode*, InlineCandidate>& candidates;
+
+public:
+    using ASTWalker::visit;
+
+    int nodes = 0;
+    int returns = 0;
+    bool recursive = false;
+    bool parallel = false;
+
+    CostWalker(const FunctionNode* fn,
+        const std::unordered_map<std::string, const FunctionNode*>& names,
+        std::unordered_map<const FunctionNode*, InlineCandidate>& result)
+        : function(fn), declared(names), candidates(result) {}
+
+    template <class Node>
+    void visit(Node& node) {
+        nodes++;
+        visitChildren(node);
+    }
+
+    void visit(const ForLoopNode& node) {
+        nodes++;
+        parallel |= node.parallel;
+        visitChildren(node);
+    }
+
+    void visit(const ReturnNode& node) {
+        nodes++;
+        returns++;
+        visitChildren(node);
+    }
+
+    void visit(const CallNode& node) {
+        nodes++;
+        auto found = declared.find(node.name);
+        if (found != declared.end()) {
+            candidates[found->second].callSites++;
+            recursive |= found->second == function;
+        }
+        visitChildren(node);
+    }
+};
+
+}
+
+void InlinePlanner::analyze(const ProgramNode& program) {
+    candidates.clear();
+    std::unordered_map<std::string, const FunctionNode*> declared;
+
+    for (const auto& decl : program.declarations) {
+        if (!decl) continue;
+        auto function = nodeCast<FunctionNode>(decl.get());
+        if (!function) {
+            //     
+            CostWalker walker(nullptr, declared, candidates);
+            walker.walk(static_cast<const ASTNode&>(*decl));
+            continue;
+        }
+
+        declared.emplace(function->name, function);
+        CostWalker walker(function, declared, candidates);
+        if (function->body) walker.walk(static_cast<const ASTNode&>(*function->body));
+
+        InlineCandidate& candidate = candidates[function];
+        candidate.cost = walker.nodes;
+        candidate.recursive = walker.recursive;
+
+        auto block = nodeCast<BlockNode>(function->body.get());
+        bool lastReturns = block && !block->statements.empty() &&
+            nodeCast<ReturnNode>(block->statements.back().get());
+        candidate.suitable = block && !walker.parallel &&
+            (walker.returns == 0 || (walker.returns == 1 && lastReturns));
+    }
+}
+
+const InlineCandidate* InlinePlanner::find(const FunctionNode* function) const {
+    auto found = candidates.find(function);
+    return found != candidates.end() ? &found->second : nullptr;
+}
+
+int InlinePlanner::cost(const FunctionNode* function) const {
+    const InlineCandidate* candidate = find(function);
+    return candidate ? candidate->cost : 0;
+}
+
+bool InlinePlanner::shouldInline(const FunctionNode* callee, int depth, int used) const {
+    const InlineCandidate* candidate = find(callee);
+    if (!candidate || !candidate->suitable || candidate->recursive ||
+        depth >= options.maxDepth) {
+        return false;
+    }
+    //         :
+    // inlineCall   ,      
+    //  ,     
+    int limit = candidate->callSites == 1 ? options.singleCallCost : options.maxCost;
+    return candidate->cost <= limit && used + candidate->cost <= options.callerBudget;
+}
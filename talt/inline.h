@@ -0,0 +1,48 @@
+#ifndef INLINE_H
+#define INLINE_H
+
+#include "parser.h"
+#include <string>
+#include <unordered_map>
+
+//  .    AST;  
+// Lowering   ExecProgram,   ,
+//   JIT    .
+
+struct InlineOptions {
+    int maxCost = 40;          //     
+    int singleCallCost = 160;  //        
+    int maxDepth = 4;          //  
+    int callerBudget = 800;    //      
+};
+
+//     
+struct InlineCandidate {
+    int cost = 0;          //  AST  
+    int callSites = 0;     //    
+    bool recursive = false;
+    // return         :
+    //       
+    bool suitable = true;
+};
+
+class InlinePlanner {
+private:
+    InlineOptions options;
+    std::unordered_map<const FunctionNode*, InlineCandidate> candidates;
+
+public:
+    explicit InlinePlanner(const InlineOptions& opt = InlineOptions()) : options(opt) {}
+
+    // ,       
+    void analyze(const ProgramNode& program);
+
+    const InlineCandidate* find(const FunctionNode* function) const;
+    int cost(const FunctionNode* function) const;
+
+    //    callee    depth,  
+    //        used
+    bool shouldInline(const FunctionNode* callee, int depth, int used) const;
+};
+
+#endif
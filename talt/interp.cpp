@@ -0,0 +1,333 @@
+#include "interp.h"
+#include "parallel.h"
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+typedef ExecValue Value;
+
+//        64 
+int64_t wrap(uint64_t value, ExecType type) {
+    switch (type) {
+    case EXT_I16: return (int16_t)value;
+    case EXT_I32: return (int32_t)value;
+    default: return (int64_t)value;
+    }
+}
+
+//        
+enum Flow {
+    FLOW_NEXT,
+    FLOW_RETURN,
+    FLOW_ERROR
+};
+
+class Interpreter {
+private:
+    ExecContext& context;
+    ExecType returnType;
+
+    char* addressOf(const ExecAddress& address) const {
+        return (address.global ? context.globals : context.frame) + address.offset;
+    }
+
+    //  cvttss2si:    NaN   
+    static int64_t truncate(float value, ExecType type) {
+        if (type == EXT_I64) {
+            if (!(value >= -9223372036854775808.0f && value < 9223372036854775808.0f)) {
+                return INT64_MIN;
+            }
+            return (int64_t)value;
+        }
+        int32_t result = INT32_MIN;
+        if (value >= -2147483648.0f && value < 2147483648.0f) {
+            result = (int32_t)value;
+        }
+        return wrap((uint64_t)(int64_t)result, type);
+    }
+
+    Value load(const ExecNode* node) const {
+        Value v;
+        const char* p = addressOf(node->address);
+        switch (node->type) {
+        case EXT_I16: { int16_t x; std::memcpy(&x, p, 2); v.i = x; break; }
+        case EXT_I32: { int32_t x; std::memcpy(&x, p, 4); v.i = x; break; }
+        case EXT_I64: std::memcpy(&v.i, p, 8); break;
+        default: std::memcpy(&v.f, p, 4); break;
+        }
+        return v;
+    }
+
+    static void storeAt(char* p, ExecType type, Value v) {
+        switch (type) {
+        case EXT_I16: { int16_t x = (int16_t)v.i; std::memcpy(p, &x, 2); break; }
+        case EXT_I32: { int32_t x = (int32_t)v.i; std::memcpy(p, &x, 4); break; }
+        case EXT_I64: std::memcpy(p, &v.i, 8); break;
+        default: std::memcpy(p, &v.f, 4); break;
+        }
+    }
+
+    void store(const ExecNode* node, Value v) const {
+        storeAt(addressOf(node->address), node->type, v);
+    }
+
+    //    -      ;
+    //         
+    bool call(const ExecNode* node, Value& v) {
+        const ExecFunction& callee = *node->callee;
+        char* frame = context.stack;
+        if (context.depth >= EXEC_MAX_CALL_DEPTH || !frame ||
+            context.stackEnd - frame < callee.frameSize) {
+            context.status = EXEC_STACK_OVERFLOW;
+            return false;
+        }
+        context.stack = frame + callee.frameSize;
+        std::memset(frame, 0, callee.frameSize);
+        for (size_t i = 0; i < node->items.size(); i++) {
+            Value arg;
+            if (!eval(node->items[i], arg)) {
+                context.stack = frame;
+                return false;
+            }
+            storeAt(frame + callee.params[i], node->items[i]->type, arg);
+        }
+
+        char* savedFrame = context.frame;
+        context.frame = frame;
+        context.depth++;
+        context.intResult = 0;
+        context.floatResult = 0.0f;
+        Interpreter inner(context, callee.returnType);
+        bool ok = !callee.body || inner.exec(callee.body) != FLOW_ERROR;
+        context.depth--;
+        context.frame = savedFrame;
+        context.stack = frame;
+        if (!ok) return false;
+
+        if (callee.returnType == EXT_F32) v.f = context.floatResult;
+        else v.i = context.intResult;
+        return true;
+    }
+
+    bool binary(const ExecNode* node, Value a, Value b, Value& result) const {
+        if ((node->binop == TK_DIV || node->binop == TK_MOD) &&
+            node->operandType != EXT_F32 && b.i == 0) {
+            context.status = EXEC_DIVISION_BY_ZERO;
+            return false;
+        }
+        return evaluateBinary(node->binop, node->operandType, a, b, result);
+    }
+
+public:
+    Interpreter(ExecContext& ctx, ExecType ret) : context(ctx), returnType(ret) {}
+
+    bool eval(const ExecNode* node, Value& v) {
+        Value a, b;
+        switch (node->op) {
+        case EX_CONST:
+            if (node->type == EXT_F32) v.f = node->floatValue;
+            else v.i = node->intValue;
+            return true;
+
+        case EX_LOAD:
+            v = load(node);
+            return true;
+
+        case EX_STORE:
+            if (!eval(node->left, v)) return false;
+            store(node, v);
+            return true;
+
+        case EX_CONVERT:
+            if (!eval(node->left, a)) return false;
+            if (node->type == EXT_F32) {
+                v.f = node->left->type == EXT_F32 ? a.f : (float)a.i;
+            }
+            else if (node->left->type == EXT_F32) {
+                v.i = truncate(a.f, node->type);
+            }
+            else {
+                v.i = wrap((uint64_t)a.i, node->type);
+            }
+            return true;
+
+        case EX_BINARY:
+            if (!eval(node->left, a) || !eval(node->right, b)) return false;
+            return binary(node, a, b, v);
+
+        case EX_NEGATE:
+            if (!eval(node->left, a)) return false;
+            if (node->type == EXT_F32) v.f = -a.f;
+            else v.i = wrap(0 - (uint64_t)a.i, node->type);
+            return true;
+
+        case EX_BIT_NOT:
+            if (!eval(node->left, a)) return false;
+            v.i = ~a.i;
+            return true;
+
+        case EX_CALL:
+            return call(node, v);
+
+        case EX_INLINE:
+            std::memset(addressOf(node->address), 0, node->size);
+            for (const ExecNode* item : node->items) {
+                if (exec(item) != FLOW_NEXT) return false;
+            }
+            return !node->left || eval(node->left, v);
+
+        default:
+            return false;
+        }
+    }
+
+    Flow exec(const ExecNode* node) {
+        Value v;
+        switch (node->op) {
+        case EX_SEQ:
+            for (const ExecNode* item : node->items) {
+                Flow flow = exec(item);
+                if (flow != FLOW_NEXT) return flow;
+            }
+            return FLOW_NEXT;
+
+        case EX_DISCARD:
+            return eval(node->left, v) ? FLOW_NEXT : FLOW_ERROR;
+
+        case EX_COPY:
+            std::memmove(addressOf(node->address), addressOf(node->source), node->size);
+            return FLOW_NEXT;
+
+        case EX_FOR: {
+            if (node->left) {
+                Flow flow = exec(node->left);
+                if (flow != FLOW_NEXT) return flow;
+            }
+            if (node->parallel >= 0 && context.parallel &&
+                context.parallel->runLoop(node->parallel, context)) {
+                return context.status == EXEC_OK ? FLOW_NEXT : FLOW_ERROR;
+            }
+            for (;;) {
+                if (node->right) {
+                    if (!eval(node->right, v)) return FLOW_ERROR;
+                    if (v.i == 0) break;
+                }
+                if (node->body) {
+                    Flow flow = exec(node->body);
+                    if (flow != FLOW_NEXT) return flow;
+                }
+                if (node->extra) {
+                    Flow flow = exec(node->extra);
+                    if (flow != FLOW_NEXT) return flow;
+                }
+            }
+            return FLOW_NEXT;
+        }
+
+        case EX_RETURN:
+            if (node->left) {
+                if (node->left->op == EX_DISCARD) {
+                    Flow flow = exec(node->left);
+                    if (flow != FLOW_NEXT) return flow;
+                }
+                else {
+                    if (!eval(node->left, v)) return FLOW_ERROR;
+                    if (returnType == EXT_F32) context.floatResult = v.f;
+                    else context.intResult = v.i;
+                }
+            }
+            return FLOW_RETURN;
+
+        default:
+            return eval(node, v) ? FLOW_NEXT : FLOW_ERROR;
+        }
+    }
+};
+
+}
+
+bool evaluateBinary(TokenType op, ExecType type, ExecValue a, ExecValue b,
+    ExecValue& result) {
+    if (type == EXT_F32) {
+        switch (op) {
+        case TK_PLUS: result.f = a.f + b.f; return true;
+        case TK_MINUS: result.f = a.f - b.f; return true;
+        case TK_MUL: result.f = a.f * b.f; return true;
+        case TK_DIV: result.f = a.f / b.f; return true;
+        case TK_EQ: result.i = a.f == b.f; return true;
+        case TK_NE: result.i = a.f != b.f; return true;
+        case TK_LT: result.i = a.f < b.f; return true;
+        case TK_LE: result.i = a.f <= b.f; return true;
+        case TK_GT: result.i = a.f > b.f; return true;
+        case TK_GE: result.i = a.f >= b.f; return true;
+        default: return false;
+        }
+    }
+
+    uint64_t x = (uint64_t)a.i;
+    uint64_t y = (uint64_t)b.i;
+    switch (op) {
+    case TK_PLUS: result.i = wrap(x + y, type); return true;
+    case TK_MINUS: result.i = wrap(x - y, type); return true;
+    case TK_MUL: result.i = wrap(x * y, type); return true;
+    case TK_DIV:
+    case TK_MOD:
+        if (b.i == 0) return false;
+        if (b.i == -1) {
+            result.i = op == TK_DIV ? wrap(0 - x, type) : 0;
+        }
+        else {
+            result.i = op == TK_DIV ? a.i / b.i : a.i % b.i;
+            result.i = wrap((uint64_t)result.i, type);
+        }
+        return true;
+    case TK_BIT_AND: result.i = a.i & b.i; return true;
+    case TK_BIT_OR: result.i = a.i | b.i; return true;
+    case TK_BIT_XOR: result.i = a.i ^ b.i; return true;
+    case TK_SHL:
+        if (type == EXT_I64) result.i = (int64_t)(x << (y & 63));
+        else result.i = wrap((uint32_t)x << (y & 31), type);
+        return true;
+    case TK_SHR:
+        if (type == EXT_I64) result.i = a.i >> (y & 63);
+        else result.i = wrap((uint64_t)(int64_t)((int32_t)a.i >> (y & 31)), type);
+        return true;
+    case TK_EQ: result.i = a.i == b.i; return true;
+    case TK_NE: result.i = a.i != b.i; return true;
+    case TK_LT: result.i = a.i < b.i; return true;
+    case TK_LE: result.i = a.i <= b.i; return true;
+    case TK_GT: result.i = a.i > b.i; return true;
+    case TK_GE: result.i = a.i >= b.i; return true;
+    default: return false;
+    }
+}
+
+bool evaluateUnary(TokenType op, ExecType type, ExecValue a, ExecValue& result) {
+    switch (op) {
+    case TK_PLUS:
+        result = a;
+        return true;
+    case TK_MINUS:
+        if (type == EXT_F32) result.f = -a.f;
+        else result.i = wrap(0 - (uint64_t)a.i, type);
+        return true;
+    case TK_BIT_NOT:
+        if (type == EXT_F32) return false;
+        result.i = ~a.i;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void interpretFunction(const ExecFunction& function, ExecContext& context) {
+    context.intResult = 0;
+    context.floatResult = 0.0f;
+    context.status = EXEC_OK;
+
+    Interpreter interpreter(context, function.returnType);
+    if (function.body) {
+        interpreter.exec(function.body);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef INTERP_H
+#define INTERP_H
+
+#include "lower.h"
+
+//     ExecNode.  
+//    JIT:     2^n, 
+//    ,   -1  ,  
+//       EXEC_DIVISION_BY_ZERO.
+void interpretFunction(const ExecFunction& function, ExecContext& context);
+
+//   :     64 
+union ExecValue {
+    int64_t i;
+    float f;
+};
+
+//        .
+// false -         .
+bool evaluateBinary(TokenType op, ExecType type, ExecValue a, ExecValue b,
+    ExecValue& result);
+bool evaluateUnary(TokenType op, ExecType type, ExecValue a, ExecValue& result);
+
+#endif
@@ -0,0 +1,981 @@
+#include "jit.h"
+#include "vectorize.h"
+#include "parallel.h"
+#include "stats.h"
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TALT_JIT_X64
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+typedef void (*JitFunction)(ExecContext*);
+
+#ifdef TALT_JIT_X64
+
+namespace {
+
+enum Register {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R12 = 12, R13 = 13, R14 = 14
+};
+
+//  :
+//   rax, rcx, rdx, xmm0, xmm1 -  ;
+//   rbx -  , r12 - , r13 - ExecContext,
+//   r14 -     (    ).
+//    rax     64 .
+//    xmm0-xmm9 -  , xmm10-xmm13 -
+//  , xmm14 -  , xmm15 - .
+const int VECTOR_EXPRESSION_REGS = 10;
+const int VECTOR_FIRST_ACC = 10;
+const int VECTOR_MAX_REDUCTIONS = 4;
+const int XMM_LANES = 14;
+const int XMM_INDUCTION = 15;
+
+//  :  32-   call  .
+//  ,     .
+typedef std::vector<std::pair<size_t, const ExecFunction*>> CallSites;
+
+class Emitter {
+private:
+    std::vector<unsigned char>& code;
+    const ExecFunction& function;
+    const JitOptions& options;
+    CallSites& calls;
+    ExecAddress induction;  //    
+    std::vector<size_t> exitJumps;
+    std::vector<size_t> errorJumps;
+    std::vector<size_t> overflowJumps;
+
+    void byte(int value) { code.push_back((unsigned char)value); }
+
+    void bytes(std::initializer_list<int> values) {
+        for (int value : values) byte(value);
+    }
+
+    void imm32(int32_t value) {
+        for (int i = 0; i < 4; i++) byte((value >> (8 * i)) & 0xFF);
+    }
+
+    //      [base + disp32].  66/F3
+    //   REX, REX   64-    r8-r15.
+    void memoryOp(int prefix, bool wide, std::initializer_list<int> opcode,
+        int reg, int base, int32_t disp) {
+        if (prefix) byte(prefix);
+        int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+        if (rex != 0x40) byte(rex);
+        bytes(opcode);
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));
+        if ((base & 7) == RSP) byte(0x24);  // r12    SIB
+        imm32(disp);
+    }
+
+    void addressOp(int prefix, bool wide, std::initializer_list<int> opcode,
+        int reg, const ExecAddress& address, int extra = 0) {
+        memoryOp(prefix, wide, opcode, reg, address.global ? R12 : RBX,
+            address.offset + extra);
+    }
+
+    //   32- ;   
+    size_t jump(std::initializer_list<int> opcode) {
+        bytes(opcode);
+        size_t position = code.size();
+        imm32(0);
+        return position;
+    }
+
+    void patch(size_t position, size_t target) {
+        int32_t rel = (int32_t)(target - (position + 4));
+        std::memcpy(&code[position], &rel, 4);
+    }
+
+    void canonicalize(ExecType type) {
+        if (type == EXT_I16) bytes({ 0x48, 0x0F, 0xBF, 0xC0 });  // movsx rax, ax
+        else if (type == EXT_I32) bytes({ 0x48, 0x63, 0xC0 });   // movsxd rax, eax
+    }
+
+    void setCondition(int cc) {
+        bytes({ 0x0F, cc, 0xC0 });        // setcc al
+        bytes({ 0x0F, 0xB6, 0xC0 });      // movzx eax, al
+    }
+
+    //  SSE -: [] [REX] 0F opcode modrm
+    void sse(int prefix, int opcode, int reg, int rm) {
+        if (prefix) byte(prefix);
+        int rex = 0x40 | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+        if (rex != 0x40) byte(rex);
+        bytes({ 0x0F, opcode, 0xC0 | ((reg & 7) << 3) | (rm & 7) });
+    }
+
+    void pshufd(int dst, int src, int order) {
+        sse(0x66, 0x70, dst, src);
+        byte(order);
+    }
+
+    //  66 0F 73 /ext imm8 (psrlq - 2, pslldq - 7)
+    void sseShift(int ext, int reg, int count) {
+        sse(0x66, 0x73, ext, reg);
+        byte(count);
+    }
+
+    void broadcastEax(int reg) {
+        sse(0x66, 0x6E, reg, RAX);    // movd xmm, eax
+        pshufd(reg, reg, 0);
+    }
+
+    void contextOp(bool wide, std::initializer_list<int> opcode, int reg, size_t field) {
+        memoryOp(0, wide, opcode, reg, R13, (int32_t)field);
+    }
+
+    void zeroMemory(int base, int32_t disp, int size);
+    void errorExit(const std::vector<size_t>& jumps, ExecStatus status, size_t exitLabel);
+    void call(const ExecNode* node);
+
+    void vectorIntMul(int dst, int src, int temp1, int temp2);
+    void vectorOp(ExecType type, TokenType op, int dst, int src);
+    void vectorExpression(const ExecNode* node, int reg);
+    bool vectorLoop(const ExecNode* node);
+    void scalarLoop(const ExecNode* node);
+
+    void floatBinary(const ExecNode* node);
+    void intBinary(const ExecNode* node);
+
+public:
+    int vectorizedLoops = 0;
+
+    Emitter(std::vector<unsigned char>& c, const ExecFunction& fn,
+        const JitOptions& opt, CallSites& callSites)
+        : code(c), function(fn), options(opt), calls(callSites) {}
+
+    void prologue();
+    void epilogue();
+    void expression(const ExecNode* node);
+    void statement(const ExecNode* node);
+};
+
+void Emitter::prologue() {
+    bytes({ 0x53 });                  // push rbx
+    bytes({ 0x41, 0x54 });            // push r12
+    bytes({ 0x41, 0x55 });            // push r13
+    bytes({ 0x41, 0x56 });            // push r14
+    bytes({ 0x49, 0x89, 0xE6 });      // mov r14, rsp
+#ifdef _WIN32
+    bytes({ 0x49, 0x89, 0xCD });      // mov r13, rcx
+#else
+    bytes({ 0x49, 0x89, 0xFD });      // mov r13, rdi
+#endif
+    memoryOp(0, true, { 0x8B }, RBX, R13, (int32_t)offsetof(ExecContext, frame));
+    memoryOp(0, true, { 0x8B }, R12, R13, (int32_t)offsetof(ExecContext, globals));
+}
+
+void Emitter::epilogue() {
+    size_t exitLabel = code.size();
+    for (size_t position : exitJumps) patch(position, exitLabel);
+    bytes({ 0x4C, 0x89, 0xF4 });      // mov rsp, r14
+    bytes({ 0x41, 0x5E });            // pop r14
+    bytes({ 0x41, 0x5D });            // pop r13
+    bytes({ 0x41, 0x5C });            // pop r12
+    bytes({ 0x5B });                  // pop rbx
+    bytes({ 0xC3 });                  // ret
+
+    errorExit(errorJumps, EXEC_DIVISION_BY_ZERO, exitLabel);
+    errorExit(overflowJumps, EXEC_STACK_OVERFLOW, exitLabel);
+}
+
+//  :   
+void Emitter::errorExit(const std::vector<size_t>& jumps, ExecStatus status,
+    size_t exitLabel) {
+    if (jumps.empty()) return;
+    size_t errorLabel = code.size();
+    for (size_t position : jumps) patch(position, errorLabel);
+    contextOp(false, { 0xC7 }, 0, offsetof(ExecContext, status));
+    imm32(status);
+    patch(jump({ 0xE9 }), exitLabel);
+}
+
+//  size  ( 8)   [base + disp];  rcx, rdx
+void Emitter::zeroMemory(int base, int32_t disp, int size) {
+    int words = size / 8;
+    if (words == 0) return;
+    bytes({ 0x31, 0xD2 });                // xor edx, edx
+    if (words <= 16) {
+        for (int i = 0; i < words; i++) memoryOp(0, true, { 0x89 }, RDX, base, disp + 8 * i);
+        return;
+    }
+    byte(0xB9);                           // mov ecx, words
+    imm32(words);
+    size_t loop = code.size();
+    // mov [base + rcx*8 + disp - 8], rdx
+    bytes({ 0x48 | ((base & 8) ? 1 : 0), 0x89, 0x94, 0xC8 | (base & 7) });
+    imm32(disp - 8);
+    bytes({ 0xFF, 0xC9 });                // dec ecx
+    patch(jump({ 0x0F, 0x85 }), loop);    // jnz
+}
+
+// :        
+//  ,    ,  call 
+//   16 .     
+//     ,  rbx  r12-r14 
+//  .
+void Emitter::call(const ExecNode* node) {
+    const ExecFunction& callee = *node->callee;
+
+    //          
+    contextOp(true, { 0x8B }, RAX, offsetof(ExecContext, stack));
+    bytes({ 0x48, 0x8D, 0x88 });          // lea rcx, [rax + frameSize]
+    imm32(callee.frameSize);
+    contextOp(true, { 0x3B }, RCX, offsetof(ExecContext, stackEnd));
+    overflowJumps.push_back(jump({ 0x0F, 0x87 }));  // ja
+    contextOp(false, { 0x81 }, 7, offsetof(ExecContext, depth));
+    imm32(EXEC_MAX_CALL_DEPTH);           // cmp dword depth, imm32
+    overflowJumps.push_back(jump({ 0x0F, 0x8D }));  // jge
+    contextOp(false, { 0xFF }, 0, offsetof(ExecContext, depth));  // inc
+    contextOp(true, { 0x89 }, RCX, offsetof(ExecContext, stack));
+    zeroMemory(RAX, 0, callee.frameSize);
+
+    //   -   ,   
+    bytes({ 0x50 });                      // push rax
+    for (size_t i = 0; i < node->items.size(); i++) {
+        const ExecNode* argument = node->items[i];
+        expression(argument);
+        bytes({ 0x48, 0x8B, 0x0C, 0x24 });  // mov rcx, [rsp]
+        int32_t offset = callee.params[i];
+        switch (argument->type) {
+        case EXT_I16: memoryOp(0x66, false, { 0x89 }, RAX, RCX, offset); break;
+        case EXT_I32: memoryOp(0, false, { 0x89 }, RAX, RCX, offset); break;
+        case EXT_I64: memoryOp(0, true, { 0x89 }, RAX, RCX, offset); break;
+        default: memoryOp(0xF3, false, { 0x0F, 0x11 }, 0, RCX, offset); break;
+        }
+    }
+    bytes({ 0x58 });                      // pop rax
+    contextOp(true, { 0x89 }, RAX, offsetof(ExecContext, frame));
+    bytes({ 0x31, 0xC9 });                // xor ecx, ecx
+    contextOp(true, { 0x89 }, RCX, offsetof(ExecContext, intResult));
+    contextOp(false, { 0x89 }, RCX, offsetof(ExecContext, floatResult));
+
+    bytes({ 0x48, 0x89, 0xE2 });          // mov rdx, rsp
+    bytes({ 0x48, 0x83, 0xE4, 0xF0 });    // and rsp, -16
+    bytes({ 0x52 });                      // push rdx
+    bytes({ 0x48, 0x83, 0xEC, 0x28 });    // sub rsp, 40
+#ifdef _WIN32
+    bytes({ 0x4C, 0x89, 0xE9 });          // mov rcx, r13
+#else
+    bytes({ 0x4C, 0x89, 0xEF });          // mov rdi, r13
+#endif
+    calls.push_back({ jump({ 0xE8 }), &callee });
+    bytes({ 0x48, 0x83, 0xC4, 0x28 });    // add rsp, 40
+    bytes({ 0x5C });                      // pop rsp
+
+    //        
+    contextOp(true, { 0x8B }, RAX, offsetof(ExecContext, frame));
+    contextOp(true, { 0x89 }, RAX, offsetof(ExecContext, stack));
+    contextOp(true, { 0x89 }, RBX, offsetof(ExecContext, frame));
+    contextOp(false, { 0xFF }, 1, offsetof(ExecContext, depth));  // dec
+    contextOp(false, { 0x83 }, 7, offsetof(ExecContext, status));
+    byte(0);                              // cmp dword status, 0
+    exitJumps.push_back(jump({ 0x0F, 0x85 }));
+
+    if (node->type == EXT_F32) {
+        memoryOp(0xF3, false, { 0x0F, 0x10 }, 0, R13,
+            (int32_t)offsetof(ExecContext, floatResult));
+    }
+    else if (node->type != EXT_VOID) {
+        contextOp(true, { 0x8B }, RAX, offsetof(ExecContext, intResult));
+    }
+}
+
+void Emitter::floatBinary(const ExecNode* node) {
+    //    ,  -  xmm1
+    expression(node->left);
+    bytes({ 0x66, 0x0F, 0x7E, 0xC0 });    // movd eax, xmm0
+    bytes({ 0x50 });                      // push rax
+    expression(node->right);
+    bytes({ 0x0F, 0x28, 0xC8 });          // movaps xmm1, xmm0
+    bytes({ 0x58 });                      // pop rax
+    bytes({ 0x66, 0x0F, 0x6E, 0xC0 });    // movd xmm0, eax
+
+    switch (node->binop) {
+    case TK_PLUS: bytes({ 0xF3, 0x0F, 0x58, 0xC1 }); break;   // addss
+    case TK_MINUS: bytes({ 0xF3, 0x0F, 0x5C, 0xC1 }); break;  // subss
+    case TK_MUL: bytes({ 0xF3, 0x0F, 0x59, 0xC1 }); break;    // mulss
+    case TK_DIV: bytes({ 0xF3, 0x0F, 0x5E, 0xC1 }); break;    // divss
+
+    //   (NaN)  ,  !=
+    case TK_EQ:
+        bytes({ 0x0F, 0x2E, 0xC1 });      // ucomiss xmm0, xmm1
+        bytes({ 0x0F, 0x94, 0xC0 });      // sete al
+        bytes({ 0x0F, 0x9B, 0xC1 });      // setnp cl
+        bytes({ 0x20, 0xC8 });            // and al, cl
+        bytes({ 0x0F, 0xB6, 0xC0 });      // movzx eax, al
+        break;
+    case TK_NE:
+        bytes({ 0x0F, 0x2E, 0xC1 });
+        bytes({ 0x0F, 0x95, 0xC0 });      // setne al
+        bytes({ 0x0F, 0x9A, 0xC1 });      // setp cl
+        bytes({ 0x08, 0xC8 });            // or al, cl
+        bytes({ 0x0F, 0xB6, 0xC0 });
+        break;
+    case TK_GT:
+        bytes({ 0x0F, 0x2E, 0xC1 });
+        setCondition(0x97);               // seta
+        break;
+    case TK_GE:
+        bytes({ 0x0F, 0x2E, 0xC1 });
+        setCondition(0x93);               // setae
+        break;
+    case TK_LT:
+        bytes({ 0x0F, 0x2E, 0xC8 });      // ucomiss xmm1, xmm0
+        setCondition(0x97);
+        break;
+    case TK_LE:
+        bytes({ 0x0F, 0x2E, 0xC8 });
+        setCondition(0x93);
+        break;
+    default:
+        break;
+    }
+}
+
+void Emitter::intBinary(const ExecNode* node) {
+    ExecType type = node->operandType;
+    bool wide = type == EXT_I64;
+
+    //    ,  -  rcx
+    expression(node->left);
+    bytes({ 0x50 });                      // push rax
+    expression(node->right);
+    bytes({ 0x48, 0x89, 0xC1 });          // mov rcx, rax
+    bytes({ 0x58 });                      // pop rax
+
+    switch (node->binop) {
+    case TK_PLUS:
+        if (wide) byte(0x48);
+        bytes({ 0x01, 0xC8 });            // add eax, ecx
+        canonicalize(type);
+        break;
+    case TK_MINUS:
+        if (wide) byte(0x48);
+        bytes({ 0x29, 0xC8 });            // sub eax, ecx
+        canonicalize(type);
+        break;
+    case TK_MUL:
+        if (wide) byte(0x48);
+        bytes({ 0x0F, 0xAF, 0xC1 });      // imul eax, ecx
+        canonicalize(type);
+        break;
+
+    case TK_DIV:
+    case TK_MOD: {
+        bytes({ 0x48, 0x85, 0xC9 });      // test rcx, rcx
+        errorJumps.push_back(jump({ 0x0F, 0x84 }));  // jz 
+        bytes({ 0x48, 0x83, 0xF9, 0xFF });  // cmp rcx, -1
+        size_t normal = jump({ 0x0F, 0x85 });        // jne
+
+        //   -1     
+        if (node->binop == TK_DIV) {
+            if (wide) byte(0x48);
+            bytes({ 0xF7, 0xD8 });        // neg eax
+        }
+        else {
+            bytes({ 0x31, 0xC0 });        // xor eax, eax
+        }
+        size_t done = jump({ 0xE9 });
+
+        patch(normal, code.size());
+        if (wide) bytes({ 0x48, 0x99, 0x48, 0xF7, 0xF9 });  // cqo; idiv rcx
+        else bytes({ 0x99, 0xF7, 0xF9 });                   // cdq; idiv ecx
+        if (node->binop == TK_MOD) {
+            bytes({ 0x48, 0x89, 0xD0 });  // mov rax, rdx
+        }
+        patch(done, code.size());
+        canonicalize(type);
+        break;
+    }
+
+    //      
+    //  ,    64 
+    case TK_BIT_AND: bytes({ 0x48, 0x21, 0xC8 }); break;
+    case TK_BIT_OR: bytes({ 0x48, 0x09, 0xC8 }); break;
+    case TK_BIT_XOR: bytes({ 0x48, 0x31, 0xC8 }); break;
+
+    case TK_SHL:
+        if (wide) byte(0x48);
+        bytes({ 0xD3, 0xE0 });            // shl eax, cl
+        canonicalize(type);
+        break;
+    case TK_SHR:
+        if (wide) byte(0x48);
+        bytes({ 0xD3, 0xF8 });            // sar eax, cl
+        canonicalize(type);
+        break;
+
+    case TK_EQ: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x94); break;
+    case TK_NE: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x95); break;
+    case TK_LT: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x9C); break;
+    case TK_LE: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x9E); break;
+    case TK_GT: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x9F); break;
+    case TK_GE: bytes({ 0x48, 0x39, 0xC8 }); setCondition(0x9D); break;
+    default:
+        break;
+    }
+}
+
+void Emitter::expression(const ExecNode* node) {
+    switch (node->op) {
+    case EX_CONST:
+        if (node->type == EXT_F32) {
+            int32_t bits;
+            std::memcpy(&bits, &node->floatValue, 4);
+            byte(0xB8);                   // mov eax, imm32
+            imm32(bits);
+            bytes({ 0x66, 0x0F, 0x6E, 0xC0 });  // movd xmm0, eax
+        }
+        else if (node->intValue == (int32_t)node->intValue) {
+            bytes({ 0x48, 0xC7, 0xC0 });  // mov rax, imm32
+            imm32((int32_t)node->intValue);
+        }
+        else {
+            bytes({ 0x48, 0xB8 });        // mov rax, imm64
+            for (int i = 0; i < 8; i++) byte((int)((uint64_t)node->intValue >> (8 * i)) & 0xFF);
+        }
+        break;
+
+    case EX_LOAD:
+        switch (node->type) {
+        case EXT_I16: addressOp(0, true, { 0x0F, 0xBF }, RAX, node->address); break;
+        case EXT_I32: addressOp(0, true, { 0x63 }, RAX, node->address); break;
+        case EXT_I64: addressOp(0, true, { 0x8B }, RAX, node->address); break;
+        default: addressOp(0xF3, false, { 0x0F, 0x10 }, 0, node->address); break;
+        }
+        break;
+
+    case EX_STORE:
+        expression(node->left);
+        switch (node->type) {
+        case EXT_I16: addressOp(0x66, false, { 0x89 }, RAX, node->address); break;
+        case EXT_I32: addressOp(0, false, { 0x89 }, RAX, node->address); break;
+        case EXT_I64: addressOp(0, true, { 0x89 }, RAX, node->address); break;
+        default: addressOp(0xF3, false, { 0x0F, 0x11 }, 0, node->address); break;
+        }
+        break;
+
+    case EX_CONVERT: {
+        ExecType from = node->left->type;
+        expression(node->left);
+        if (node->type == EXT_F32) {
+            if (from == EXT_I64) bytes({ 0xF3, 0x48, 0x0F, 0x2A, 0xC0 });  // cvtsi2ss xmm0, rax
+            else if (from != EXT_F32) bytes({ 0xF3, 0x0F, 0x2A, 0xC0 });   // cvtsi2ss xmm0, eax
+        }
+        else if (from == EXT_F32) {
+            if (node->type == EXT_I64) bytes({ 0xF3, 0x48, 0x0F, 0x2C, 0xC0 });  // cvttss2si rax, xmm0
+            else {
+                bytes({ 0xF3, 0x0F, 0x2C, 0xC0 });  // cvttss2si eax, xmm0
+                canonicalize(node->type);
+            }
+        }
+        else {
+            canonicalize(node->type);
+        }
+        break;
+    }
+
+    case EX_BINARY:
+        if (node->operandType == EXT_F32) floatBinary(node);
+        else intBinary(node);
+        break;
+
+    case EX_NEGATE:
+        expression(node->left);
+        if (node->type == EXT_F32) {
+            bytes({ 0x66, 0x0F, 0x7E, 0xC0 });  // movd eax, xmm0
+            byte(0x35);                         // xor eax, 0x80000000
+            imm32(INT32_MIN);
+            bytes({ 0x66, 0x0F, 0x6E, 0xC0 });  // movd xmm0, eax
+        }
+        else {
+            bytes({ 0x48, 0xF7, 0xD8 });        // neg rax
+            canonicalize(node->type);
+        }
+        break;
+
+    case EX_BIT_NOT:
+        expression(node->left);
+        bytes({ 0x48, 0xF7, 0xD0 });            // not rax
+        break;
+
+    case EX_CALL:
+        call(node);
+        break;
+
+    case EX_INLINE:
+        zeroMemory(node->address.global ? R12 : RBX, node->address.offset, node->size);
+        for (const ExecNode* item : node->items) statement(item);
+        if (node->left) expression(node->left);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Emitter::statement(const ExecNode* node) {
+    switch (node->op) {
+    case EX_SEQ:
+        for (const ExecNode* item : node->items) statement(item);
+        break;
+
+    case EX_DISCARD:
+        expression(node->left);
+        break;
+
+    case EX_COPY: {
+        //     8, 4, 2  1 
+        int offset = 0;
+        while (offset < node->size) {
+            int rest = node->size - offset;
+            if (rest >= 8) {
+                addressOp(0, true, { 0x8B }, RAX, node->source, offset);
+                addressOp(0, true, { 0x89 }, RAX, node->address, offset);
+                offset += 8;
+            }
+            else if (rest >= 4) {
+                addressOp(0, false, { 0x8B }, RAX, node->source, offset);
+                addressOp(0, false, { 0x89 }, RAX, node->address, offset);
+                offset += 4;
+            }
+            else if (rest >= 2) {
+                addressOp(0x66, false, { 0x8B }, RAX, node->source, offset);
+                addressOp(0x66, false, { 0x89 }, RAX, node->address, offset);
+                offset += 2;
+            }
+            else {
+                addressOp(0, false, { 0x8A }, RAX, node->source, offset);
+                addressOp(0, false, { 0x88 }, RAX, node->address, offset);
+                offset += 1;
+            }
+        }
+        break;
+    }
+
+    case EX_FOR: {
+        if (node->left) statement(node->left);
+
+        //  :  runParallelLoop(context, index);
+        // 0 -    
+        size_t parallelDone = 0;
+        if (node->parallel >= 0) {
+#ifdef _WIN32
+            bytes({ 0x4C, 0x89, 0xE9 });      // mov rcx, r13
+            byte(0xBA);                       // mov edx, imm32
+#else
+            bytes({ 0x4C, 0x89, 0xEF });      // mov rdi, r13
+            byte(0xBE);                       // mov esi, imm32
+#endif
+            imm32(node->parallel);
+            bytes({ 0x48, 0xB8 });            // mov rax, imm64
+            uint64_t target = (uint64_t)reinterpret_cast<uintptr_t>(&runParallelLoop);
+            for (int i = 0; i < 8; i++) byte((int)(target >> (8 * i)) & 0xFF);
+            //    16;  Win64  32   
+            bytes({ 0x48, 0x83, 0xEC, 0x28 });  // sub rsp, 40
+            bytes({ 0xFF, 0xD0 });              // call rax
+            bytes({ 0x48, 0x83, 0xC4, 0x28 });  // add rsp, 40
+            bytes({ 0x85, 0xC0 });              // test eax, eax
+            size_t serial = jump({ 0x0F, 0x84 });
+            memoryOp(0, false, { 0x83 }, 7, R13, (int32_t)offsetof(ExecContext, status));
+            byte(0);                            // cmp dword status, 0
+            exitJumps.push_back(jump({ 0x0F, 0x85 }));
+            parallelDone = jump({ 0xE9 });
+            patch(serial, code.size());
+        }
+
+        //     , 
+        //    
+        if (options.vectorize && vectorLoop(node)) vectorizedLoops++;
+        scalarLoop(node);
+        if (node->parallel >= 0) patch(parallelDone, code.size());
+        break;
+    }
+
+    case EX_RETURN:
+        if (node->left) {
+            if (node->left->op == EX_DISCARD) {
+                statement(node->left);
+            }
+            else {
+                expression(node->left);
+                if (function.returnType == EXT_F32) {
+                    memoryOp(0xF3, false, { 0x0F, 0x11 }, 0, R13,
+                        (int32_t)offsetof(ExecContext, floatResult));
+                }
+                else {
+                    memoryOp(0, true, { 0x89 }, RAX, R13,
+                        (int32_t)offsetof(ExecContext, intResult));
+                }
+            }
+        }
+        exitJumps.push_back(jump({ 0xE9 }));
+        break;
+
+    default:
+        expression(node);
+        break;
+    }
+}
+
+void Emitter::scalarLoop(const ExecNode* node) {
+    size_t conditionLabel = code.size();
+    size_t exitJump = 0;
+    bool hasExit = node->right != nullptr;
+    if (hasExit) {
+        expression(node->right);
+        bytes({ 0x48, 0x85, 0xC0 });        // test rax, rax
+        exitJump = jump({ 0x0F, 0x84 });    // jz  
+    }
+
+    if (node->body) statement(node->body);
+    if (node->extra) statement(node->extra);
+
+    size_t back = jump({ 0xE9 });
+    patch(back, conditionLabel);
+    if (hasExit) patch(exitJump, code.size());
+}
+
+//   int  pmulld (SSE4.1): 
+//      pmuludq    
+void Emitter::vectorIntMul(int dst, int src, int temp1, int temp2) {
+    sse(0x66, 0x6F, temp1, dst);      // movdqa t1, dst
+    sse(0x66, 0xF4, dst, src);        // pmuludq dst, src
+    sseShift(2, temp1, 32);           // psrlq t1, 32
+    sse(0x66, 0x6F, temp2, src);      // movdqa t2, src
+    sseShift(2, temp2, 32);           // psrlq t2, 32
+    sse(0x66, 0xF4, temp1, temp2);    // pmuludq t1, t2
+    pshufd(dst, dst, 0x08);
+    pshufd(temp1, temp1, 0x08);
+    sse(0x66, 0x62, dst, temp1);      // punpckldq dst, t1
+}
+
+void Emitter::vectorOp(ExecType type, TokenType op, int dst, int src) {
+    if (type == EXT_F32) {
+        switch (op) {
+        case TK_PLUS: sse(0, 0x58, dst, src); break;    // addps
+        case TK_MINUS: sse(0, 0x5C, dst, src); break;   // subps
+        case TK_MUL: sse(0, 0x59, dst, src); break;     // mulps
+        case TK_DIV: sse(0, 0x5E, dst, src); break;     // divps
+        default: break;
+        }
+        return;
+    }
+
+    switch (op) {
+    case TK_PLUS: sse(0x66, 0xFE, dst, src); break;     // paddd
+    case TK_MINUS: sse(0x66, 0xFA, dst, src); break;    // psubd
+    case TK_BIT_AND: sse(0x66, 0xDB, dst, src); break;  // pand
+    case TK_BIT_OR: sse(0x66, 0xEB, dst, src); break;   // por
+    case TK_BIT_XOR: sse(0x66, 0xEF, dst, src); break;  // pxor
+    case TK_MUL: vectorIntMul(dst, src, src + 1, src + 2); break;
+    default: break;
+    }
+}
+
+//       xmm[reg]; 
+//  reg -  (. vectorRegisters)
+void Emitter::vectorExpression(const ExecNode* node, int reg) {
+    switch (node->op) {
+    case EX_CONST: {
+        int32_t bits = (int32_t)node->intValue;
+        if (node->type == EXT_F32) std::memcpy(&bits, &node->floatValue, 4);
+        byte(0xB8);                       // mov eax, imm32
+        imm32(bits);
+        broadcastEax(reg);
+        break;
+    }
+
+    case EX_LOAD:
+        if (node->address.global == induction.global &&
+            node->address.offset == induction.offset) {
+            sse(0x66, 0x6F, reg, XMM_INDUCTION);  // movdqa
+            break;
+        }
+        addressOp(0x66, false, { 0x0F, 0x6E }, reg, node->address);  // movd
+        pshufd(reg, reg, 0);
+        break;
+
+    case EX_CONVERT:
+        vectorExpression(node->left, reg);
+        sse(0, 0x5B, reg, reg);           // cvtdq2ps
+        break;
+
+    case EX_NEGATE:
+        vectorExpression(node->left, reg);
+        if (node->type == EXT_F32) {
+            byte(0xB8);
+            imm32(INT32_MIN);
+            broadcastEax(reg + 1);
+            sse(0, 0x57, reg, reg + 1);   // xorps
+        }
+        else {
+            sse(0x66, 0xEF, reg + 1, reg + 1);  // pxor
+            sse(0x66, 0xFA, reg + 1, reg);      // psubd
+            sse(0x66, 0x6F, reg, reg + 1);      // movdqa
+        }
+        break;
+
+    case EX_BIT_NOT:
+        vectorExpression(node->left, reg);
+        sse(0x66, 0x76, reg + 1, reg + 1);      // pcmpeqd:  
+        sse(0x66, 0xEF, reg, reg + 1);          // pxor
+        break;
+
+    case EX_BINARY:
+        vectorExpression(node->left, reg);
+        vectorExpression(node->right, reg + 1);
+        vectorOp(node->type, node->binop, reg, reg + 1);
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool Emitter::vectorLoop(const ExecNode* node) {
+    VectorLoop loop;
+    if (!analyzeVectorLoop(node, options.fastMath, loop) ||
+        (int)loop.reductions.size() > VECTOR_MAX_REDUCTIONS) {
+        return false;
+    }
+    for (const auto& reduction : loop.reductions) {
+        for (const auto& term : reduction.terms) {
+            if (vectorRegisters(term.value) > VECTOR_EXPRESSION_REGS) return false;
+        }
+    }
+
+    //    : step * (0, 1, 2, 3)
+    byte(0xB8);
+    imm32(loop.step);
+    broadcastEax(XMM_LANES);
+    sse(0x66, 0x6F, 0, XMM_LANES);    // movdqa xmm0, (s, s, s, s)
+    sseShift(7, 0, 4);                // pslldq: (0, s, s, s)
+    sse(0x66, 0x6F, XMM_LANES, 0);
+    sseShift(7, 0, 4);                // (0, 0, s, s)
+    sse(0x66, 0xFE, XMM_LANES, 0);
+    sseShift(7, 0, 4);                // (0, 0, 0, s)
+    sse(0x66, 0xFE, XMM_LANES, 0);    // (0, s, 2s, 3s)
+    induction = loop.induction;
+
+    //      
+    for (size_t k = 0; k < loop.reductions.size(); k++) {
+        const Reduction& reduction = loop.reductions[k];
+        int32_t identity = 0;
+        if (reduction.op == TK_MUL) {
+            if (reduction.type == EXT_F32) {
+                float one = 1.0f;
+                std::memcpy(&identity, &one, 4);
+            }
+            else {
+                identity = 1;
+            }
+        }
+        else if (reduction.op == TK_BIT_AND) {
+            identity = -1;
+        }
+        byte(0xB8);
+        imm32(identity);
+        broadcastEax(VECTOR_FIRST_ACC + (int)k);
+    }
+
+    //  ,     :
+    // i + 3 * step < bound ( <= bound)
+    size_t top = code.size();
+    addressOp(0, true, { 0x63 }, RAX, loop.induction);        // movsxd rax, i
+    if (loop.bound->op == EX_CONST) {
+        bytes({ 0x48, 0xC7, 0xC1 });                           // mov rcx, imm32
+        imm32((int32_t)loop.bound->intValue);
+    }
+    else {
+        addressOp(0, true, { 0x63 }, RCX, loop.bound->address);  // movsxd rcx, bound
+    }
+    int reach = (VECTOR_LANES - 1) * loop.step - (loop.compare == TK_LE ? 1 : 0);
+    bytes({ 0x48, 0x81, 0xE9 });                               // sub rcx, imm32
+    imm32(reach);
+    bytes({ 0x48, 0x39, 0xC8 });                               // cmp rax, rcx
+    size_t done = jump({ 0x0F, 0x8D });                        // jge
+
+    broadcastEax(XMM_INDUCTION);
+    sse(0x66, 0xFE, XMM_INDUCTION, XMM_LANES);                 // paddd
+
+    for (size_t k = 0; k < loop.reductions.size(); k++) {
+        const Reduction& reduction = loop.reductions[k];
+        for (const auto& term : reduction.terms) {
+            vectorExpression(term.value, 0);
+            vectorOp(reduction.type, term.negate ? TK_MINUS : reduction.op,
+                VECTOR_FIRST_ACC + (int)k, 0);
+        }
+    }
+
+    addressOp(0, false, { 0x81 }, 0, loop.induction);         // add i, imm32
+    imm32(VECTOR_LANES * loop.step);
+    patch(jump({ 0xE9 }), top);
+    patch(done, code.size());
+
+    //      
+    for (size_t k = 0; k < loop.reductions.size(); k++) {
+        const Reduction& reduction = loop.reductions[k];
+        int acc = VECTOR_FIRST_ACC + (int)k;
+        pshufd(0, acc, 0x4E);             //  
+        vectorOp(reduction.type, reduction.op, acc, 0);
+        pshufd(0, acc, 0xB1);             //   
+        vectorOp(reduction.type, reduction.op, acc, 0);
+
+        if (reduction.type == EXT_F32) {
+            addressOp(0xF3, false, { 0x0F, 0x10 }, 0, reduction.address);  // movss
+            sse(0xF3, reduction.op == TK_MUL ? 0x59 : 0x58, 0, acc);       // mulss/addss
+            addressOp(0xF3, false, { 0x0F, 0x11 }, 0, reduction.address);
+            continue;
+        }
+
+        sse(0x66, 0x7E, acc, RAX);        // movd eax, acc
+        addressOp(0, false, { 0x8B }, RCX, reduction.address);  // mov ecx, acc
+        switch (reduction.op) {
+        case TK_PLUS: bytes({ 0x01, 0xC1 }); break;         // add ecx, eax
+        case TK_MUL: bytes({ 0x0F, 0xAF, 0xC8 }); break;    // imul ecx, eax
+        case TK_BIT_AND: bytes({ 0x21, 0xC1 }); break;
+        case TK_BIT_OR: bytes({ 0x09, 0xC1 }); break;
+        case TK_BIT_XOR: bytes({ 0x31, 0xC1 }); break;
+        default: break;
+        }
+        addressOp(0, false, { 0x89 }, RCX, reduction.address);
+    }
+
+    TALT_COUNT(STAT_LOOPS_VECTORIZED);
+    return true;
+}
+
+//   : ,     
+unsigned char* allocateWritable(size_t size) {
+#ifdef _WIN32
+    return (unsigned char*)VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? nullptr : (unsigned char*)memory;
+#endif
+}
+
+bool makeExecutable(unsigned char* memory, size_t size) {
+#ifdef _WIN32
+    DWORD old;
+    if (!VirtualProtect(memory, size, PAGE_EXECUTE_READ, &old)) return false;
+    FlushInstructionCache(GetCurrentProcess(), memory, size);
+    return true;
+#else
+    return mprotect(memory, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
+void freeCode(unsigned char* memory, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, size);
+#endif
+}
+
+}
+
+#endif
+
+JitCode::JitCode() : memory(nullptr), size(0), loopsVectorized(0) {}
+
+JitCode::~JitCode() {
+    release();
+}
+
+void JitCode::release() {
+#ifdef TALT_JIT_X64
+    if (memory) freeCode(memory, size);
+#endif
+    memory = nullptr;
+    size = 0;
+    loopsVectorized = 0;
+    entries.clear();
+}
+
+bool JitCode::isSupported() {
+#ifdef TALT_JIT_X64
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JitCode::compile(const ExecProgram& program, const JitOptions& options,
+    std::string& error) {
+    release();
+
+#ifdef TALT_JIT_X64
+    std::vector<unsigned char> code;
+    CallSites calls;
+    std::vector<const ExecFunction*> functions;
+    functions.push_back(&program.init);
+    for (const auto& fn : program.functions) functions.push_back(&fn);
+    for (const auto& loop : program.parallelLoops) functions.push_back(&loop.chunk);
+
+    for (const ExecFunction* fn : functions) {
+        //      16 
+        while (code.size() % 16 != 0) code.push_back(0xCC);
+        entries[fn] = code.size();
+
+        Emitter emitter(code, *fn, options, calls);
+        emitter.prologue();
+        if (fn->body) emitter.statement(fn->body);
+        emitter.epilogue();
+        loopsVectorized += emitter.vectorizedLoops;
+    }
+
+    for (const auto& call : calls) {
+        int32_t rel = (int32_t)(entries[call.second] - (call.first + 4));
+        std::memcpy(&code[call.first], &rel, 4);
+    }
+
+    size = code.size();
+    memory = allocateWritable(size);
+    if (!memory) {
+        error = "     ";
+        size = 0;
+        return false;
+    }
+    std::memcpy(memory, code.data(), size);
+    if (!makeExecutable(memory, size)) {
+        error = "      ";
+        release();
+        return false;
+    }
+    return true;
+#else
+    (void)program;
+    (void)options;
+    error = "JIT    x86-64";
+    return false;
+#endif
+}
+
+void JitCode::call(const ExecFunction& function, ExecContext& context) const {
+    context.intResult = 0;
+    context.floatResult = 0.0f;
+    context.status = EXEC_OK;
+
+    auto it = entries.find(&function);
+    if (it == entries.end()) return;
+
+    JitFunction entry = reinterpret_cast<JitFunction>(memory + it->second);
+    entry(&context);
+}
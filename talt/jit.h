@@ -0,0 +1,46 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "lower.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+struct JitOptions {
+    bool vectorize = true;   // SSE2     
+    bool fastMath = false;   //    float
+};
+
+//  ExecProgram    x86-64   .
+//         ,   
+//      (W^X):   
+//   .
+class JitCode {
+private:
+    unsigned char* memory;
+    size_t size;
+    int loopsVectorized;
+    std::unordered_map<const ExecFunction*, size_t> entries;
+
+    void release();
+
+public:
+    JitCode();
+    ~JitCode();
+
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    static bool isSupported();
+
+    bool compile(const ExecProgram& program, const JitOptions& options,
+        std::string& error);
+
+    //   ;    -  context
+    void call(const ExecFunction& function, ExecContext& context) const;
+
+    size_t codeSize() const { return size; }
+    int vectorizedLoops() const { return loopsVectorized; }
+};
+
+#endif
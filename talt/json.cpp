@@ -0,0 +1,332 @@
+#include "json.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const int MAX_JSON_DEPTH = 256;
+
+class JsonReader {
+private:
+    const std::string& text;
+    size_t pos;
+    std::string& error;
+
+    bool fail(const char* message) {
+        if (error.empty()) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), " ( %u)", (unsigned)pos);
+            error = std::string(message) + buffer;
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+            text[pos] == '\n' || text[pos] == '\r')) {
+            pos++;
+        }
+    }
+
+    bool literal(const char* word) {
+        size_t i = 0;
+        for (; word[i]; i++) {
+            if (pos + i >= text.size() || text[pos + i] != word[i]) {
+                return fail(" ");
+            }
+        }
+        pos += i;
+        return true;
+    }
+
+    bool hex4(unsigned& code) {
+        if (pos + 4 > text.size()) return fail(" \\u");
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            char ch = text[pos++];
+            code <<= 4;
+            if (ch >= '0' && ch <= '9') code |= ch - '0';
+            else if (ch >= 'a' && ch <= 'f') code |= ch - 'a' + 10;
+            else if (ch >= 'A' && ch <= 'F') code |= ch - 'A' + 10;
+            else return fail("   \\u");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += (char)code;
+        }
+        else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000) {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool string(std::string& out) {
+        pos++;  //  
+        for (;;) {
+            if (pos >= text.size()) return fail(" ");
+            char ch = text[pos++];
+            if (ch == '"') return true;
+            if ((unsigned char)ch < 0x20) return fail("   ");
+            if (ch != '\\') {
+                out += ch;
+                continue;
+            }
+            if (pos >= text.size()) return fail(" ");
+            switch (text[pos++]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                if (!hex4(code)) return false;
+                //   UTF-16
+                if (code >= 0xD800 && code < 0xDC00 && pos + 1 < text.size() &&
+                    text[pos] == '\\' && text[pos + 1] == 'u') {
+                    pos += 2;
+                    unsigned low = 0;
+                    if (!hex4(low)) return false;
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else {
+                        appendUtf8(out, code);
+                        code = low;
+                    }
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default:
+                return fail(" escape-");
+            }
+        }
+    }
+
+    //   strtod:    ,  
+    //   - 
+    bool number(JsonValue& value) {
+        size_t start = pos;
+        bool negative = pos < text.size() && text[pos] == '-';
+        if (negative) pos++;
+        double result = 0;
+        size_t digits = pos;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            result = result * 10 + (text[pos++] - '0');
+        }
+        if (pos == digits) {
+            pos = start;
+            return fail(" ");
+        }
+        if (pos < text.size() && text[pos] == '.') {
+            pos++;
+            double scale = 0.1;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                result += (text[pos++] - '0') * scale;
+                scale *= 0.1;
+            }
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            pos++;
+            bool minus = pos < text.size() && text[pos] == '-';
+            if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) pos++;
+            int exponent = 0;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                if (exponent < 400) exponent = exponent * 10 + (text[pos] - '0');
+                pos++;
+            }
+            result *= std::pow(10.0, minus ? -exponent : exponent);
+        }
+        value.type = JSON_NUMBER;
+        value.number = negative ? -result : result;
+        return true;
+    }
+
+public:
+    JsonReader(const std::string& source, std::string& why)
+        : text(source), pos(0), error(why) {}
+
+    bool value(JsonValue& result, int depth) {
+        if (depth > MAX_JSON_DEPTH) return fail("  ");
+        skipSpace();
+        if (pos >= text.size()) return fail("  ");
+
+        switch (text[pos]) {
+        case '{':
+            result.type = JSON_OBJECT;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return true;
+            }
+            for (;;) {
+                skipSpace();
+                if (pos >= text.size() || text[pos] != '"') return fail("  ");
+                result.members.emplace_back();
+                if (!string(result.members.back().first)) return false;
+                skipSpace();
+                if (pos >= text.size() || text[pos] != ':') return fail(" ':'");
+                pos++;
+                if (!value(result.members.back().second, depth + 1)) return false;
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                if (pos < text.size() && text[pos] == '}') {
+                    pos++;
+                    return true;
+                }
+                return fail(" ','  '}'");
+            }
+
+        case '[':
+            result.type = JSON_ARRAY;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return true;
+            }
+            for (;;) {
+                result.items.emplace_back();
+                if (!value(result.items.back(), depth + 1)) return false;
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                if (pos < text.size() && text[pos] == ']') {
+                    pos++;
+                    return true;
+                }
+                return fail(" ','  ']'");
+            }
+
+        case '"':
+            result.type = JSON_STRING;
+            return string(result.string);
+        case 't':
+            result.type = JSON_BOOL;
+            result.boolean = true;
+            return literal("true");
+        case 'f':
+            result.type = JSON_BOOL;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+            return number(result);
+        }
+    }
+
+    bool finish() {
+        skipSpace();
+        return pos == text.size() || fail("   ");
+    }
+};
+
+const JsonValue& nullValue() {
+    static const JsonValue value;
+    return value;
+}
+
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+    for (const auto& member : members) {
+        if (member.first == key) return member.second;
+    }
+    return nullValue();
+}
+
+const std::string& JsonValue::asString() const {
+    static const std::string empty;
+    return type == JSON_STRING ? string : empty;
+}
+
+bool parseJson(const std::string& text, JsonValue& result, std::string& error) {
+    result = JsonValue();
+    error.clear();
+    JsonReader reader(text, error);
+    return reader.value(result, 0) && reader.finish();
+}
+
+void writeJsonUtf8(OutputWriter& out, const std::string& str) {
+    static const char hex[] = "0123456789abcdef";
+    out.put('"');
+    for (char ch : str) {
+        unsigned char c = (unsigned char)ch;
+        switch (ch) {
+        case '"': out.write("\\\"", 2); break;
+        case '\\': out.write("\\\\", 2); break;
+        case '\n': out.write("\\n", 2); break;
+        case '\r': out.write("\\r", 2); break;
+        case '\t': out.write("\\t", 2); break;
+        default:
+            if (c < 0x20) {
+                char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+                out.write(escape, 6);
+            }
+            else {
+                out.put(ch);
+            }
+        }
+    }
+    out.put('"');
+}
+
+void writeJson(OutputWriter& out, const JsonValue& value) {
+    switch (value.type) {
+    case JSON_NULL:
+        out << "null";
+        break;
+    case JSON_BOOL:
+        out << (value.boolean ? "true" : "false");
+        break;
+    case JSON_NUMBER:
+        //    -    ,   
+        out << (long long)value.number;
+        break;
+    case JSON_STRING:
+        writeJsonUtf8(out, value.string);
+        break;
+    case JSON_ARRAY:
+        out.put('[');
+        for (size_t i = 0; i < value.items.size(); i++) {
+            if (i > 0) out.put(',');
+            writeJson(out, value.items[i]);
+        }
+        out.put(']');
+        break;
+    case JSON_OBJECT:
+        out.put('{');
+        for (size_t i = 0; i < value.members.size(); i++) {
+            if (i > 0) out.put(',');
+            writeJsonUtf8(out, value.members[i].first);
+            out.put(':');
+            writeJson(out, value.members[i].second);
+        }
+        out.put('}');
+        break;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include "output.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+enum JsonType {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+};
+
+//  JSON    .  
+//  UTF-8,   -   .
+class JsonValue {
+public:
+    JsonType type = JSON_NULL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    bool isNull() const { return type == JSON_NULL; }
+
+    //    null,   
+    const JsonValue& operator[](const char* key) const;
+
+    int asInt(int fallback = 0) const {
+        return type == JSON_NUMBER ? (int)number : fallback;
+    }
+    const std::string& asString() const;
+};
+
+//   ;   error   
+bool parseJson(const std::string& text, JsonValue& result, std::string& error);
+
+//  .    UTF-8,   
+// OutputWriter::jsonString,   cp1251.
+void writeJson(OutputWriter& out, const JsonValue& value);
+void writeJsonUtf8(OutputWriter& out, const std::string& str);
+
+#endif
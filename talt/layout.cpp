@@ -0,0 +1,113 @@
+#include "layout.h"
+#include <algorithm>
+
+bool parseTargetAbi(const std::string& name, TargetAbi& abi) {
+    if (name == "ilp32") abi = ABI_ILP32;
+    else if (name == "lp64") abi = ABI_LP64;
+    else if (name == "llp64") abi = ABI_LLP64;
+    else return false;
+    return true;
+}
+
+const char* targetAbiName(TargetAbi abi) {
+    switch (abi) {
+    case ABI_ILP32: return "ilp32";
+    case ABI_LP64: return "lp64";
+    case ABI_LLP64: return "llp64";
+    default: return "?";
+    }
+}
+
+int assignFieldOffsets(std::vector<FieldInfo>& fields) {
+    int offset = 0;
+    int align = 1;
+    for (auto& field : fields) {
+        offset = (offset + field.align - 1) / field.align * field.align;
+        field.offset = offset;
+        offset += field.size;
+        if (field.align > align) align = field.align;
+    }
+    return (offset + align - 1) / align * align;
+}
+
+std::vector<FieldInfo> suggestFieldOrder(const StructTypeInfo& info) {
+    std::vector<FieldInfo> order = info.fields;
+    std::stable_sort(order.begin(), order.end(),
+        [](const FieldInfo& a, const FieldInfo& b) { return a.align > b.align; });
+    assignFieldOffsets(order);
+    return order;
+}
+
+static int cacheLines(int size) {
+    return (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+}
+
+static std::string fieldTypeName(const FieldInfo& field) {
+    if (field.type == TYPE_STRUCT) return field.structTypeName;
+    return SemanticAnalyzer::dataTypeToString(field.type);
+}
+
+void printLayoutReport(const SemanticAnalyzer& semantic, OutputWriter& out) {
+    out << "\n===   (" << targetAbiName(semantic.getTargetAbi())
+        << ",   " << CACHE_LINE_SIZE << " ) ===\n";
+
+    for (const StructTypeInfo* type : semantic.sortedStructTypes()) {
+        const StructTypeInfo& info = *type;
+        if (!info.complete) {
+            out << "struct " << info.name << ":  \n";
+            continue;
+        }
+
+        int padding = info.paddingBytes();
+        out << "struct " << info.name << ":  " << info.size
+            << ",  " << info.align
+            << ",   " << padding << "\n";
+
+        int end = 0;
+        for (const auto& field : info.fields) {
+            if (field.offset > end) {
+                out << "    +" << end << "  (" << (field.offset - end)
+                    << "  )\n";
+            }
+            out << "    +" << field.offset << "  " << fieldTypeName(field)
+                << " " << field.name << " [" << field.size << "]\n";
+            end = field.offset + field.size;
+
+            if (field.size > 0 && field.size <= CACHE_LINE_SIZE &&
+                field.offset / CACHE_LINE_SIZE != (end - 1) / CACHE_LINE_SIZE) {
+                out << "    !  '" << field.name
+                    << "'    \n";
+            }
+        }
+        if (info.size > end) {
+            out << "    +" << end << "  (" << (info.size - end)
+                << "    )\n";
+        }
+
+        if (padding == 0) continue;
+
+        std::vector<FieldInfo> order = suggestFieldOrder(info);
+        int reorderedSize = assignFieldOffsets(order);
+        if (reorderedSize < info.size) {
+            out << "    :";
+            for (const auto& field : order) {
+                out << " " << fieldTypeName(field) << " " << field.name << ";";
+            }
+            out << "\n   " << reorderedSize << "  " << info.size << "\n";
+
+            if (cacheLines(reorderedSize) < cacheLines(info.size)) {
+                out << "  !     : "
+                    << cacheLines(info.size) << "  "
+                    << cacheLines(reorderedSize) << "\n";
+            }
+        }
+
+        //         
+        //  
+        if (info.size <= CACHE_LINE_SIZE) {
+            out << "     " << CACHE_LINE_SIZE / info.size
+                << " () ,   " << padding * (CACHE_LINE_SIZE / info.size)
+                << "  \n";
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "semantic.h"
+#include "output.h"
+#include <string>
+#include <vector>
+
+//   ,    
+const int CACHE_LINE_SIZE = 64;
+
+bool parseTargetAbi(const std::string& name, TargetAbi& abi);
+const char* targetAbiName(TargetAbi abi);
+
+//      ,  
+//     
+int assignFieldOffsets(std::vector<FieldInfo>& fields);
+
+//     ,    -
+//   .      ,
+//         .
+std::vector<FieldInfo> suggestFieldOrder(const StructTypeInfo& info);
+
+//    ,  , 
+//   ,    
+void printLayoutReport(const SemanticAnalyzer& semantic, OutputWriter& out);
+
+#endif
@@ -0,0 +1,674 @@
+#include "lower.h"
+#include "depend.h"
+#include "visitor.h"
+#include "typerules.h"
+#include <sstream>
+#include <algorithm>
+
+const char* execTypeName(ExecType type) {
+    switch (type) {
+    case EXT_VOID: return "void";
+    case EXT_I16: return "short";
+    case EXT_I32: return "int";
+    case EXT_I64: return "long";
+    case EXT_F32: return "float";
+    default: return "?";
+    }
+}
+
+const ExecFunction* ExecProgram::findFunction(const std::string& name) const {
+    for (const auto& fn : functions) {
+        if (fn.name == name) return &fn;
+    }
+    return nullptr;
+}
+
+Lowering::Lowering(SemanticAnalyzer& sem, ExecProgram& prog)
+    : semantic(sem), program(prog), function(nullptr) {}
+
+ExecNode* Lowering::newNode(ExecOp op, ExecType type) {
+    program.nodes.emplace_back(op, type);
+    return &program.nodes.back();
+}
+
+ExecType Lowering::execType(DataType type) const {
+    switch (type) {
+    case TYPE_SHORT: return EXT_I16;
+    case TYPE_INT: return EXT_I32;
+    case TYPE_LONG: return semantic.typeSize(TYPE_LONG) == 8 ? EXT_I64 : EXT_I32;
+    case TYPE_FLOAT: return EXT_F32;
+    default: return EXT_VOID;
+    }
+}
+
+ExecNode* Lowering::convert(ExecNode* node, ExecType type) {
+    if (!node || node->type == type) {
+        return node;
+    }
+
+    //   
+    if (node->op == EX_CONST) {
+        if (type == EXT_F32 && node->type != EXT_F32) {
+            node->floatValue = (float)node->intValue;
+        }
+        else if (type != EXT_F32 && node->type == EXT_F32) {
+            return nullptr;  //  : float     
+        }
+        else if (type == EXT_I16) {
+            node->intValue = (int16_t)node->intValue;
+        }
+        else if (type == EXT_I32) {
+            node->intValue = (int32_t)node->intValue;
+        }
+        node->type = type;
+        return node;
+    }
+
+    ExecNode* conv = newNode(EX_CONVERT, type);
+    conv->left = node;
+    return conv;
+}
+
+ExecNode* Lowering::condition(ExecNode* node) {
+    //   -  0/1;  float   
+    if (node->type != EXT_F32) {
+        return node;
+    }
+    ExecNode* zero = newNode(EX_CONST, EXT_F32);
+    ExecNode* compare = newNode(EX_BINARY, EXT_I32);
+    compare->binop = TK_NE;
+    compare->operandType = EXT_F32;
+    compare->left = node;
+    compare->right = zero;
+    return compare;
+}
+
+bool Lowering::fail(const ASTNode* node, const std::string& message) {
+    if (errorMessage.empty()) {
+        std::stringstream ss;
+        ss << " " << (node ? semantic.position(node->offset).line : 0) << ": " << message;
+        errorMessage = ss.str();
+    }
+    return false;
+}
+
+const Lowering::Variable* Lowering::findVariable(const std::string& name) const {
+    for (size_t i = scopes.size(); i > scopeFloor; i--) {
+        auto it = scopes[i - 1].find(name);
+        if (it != scopes[i - 1].end()) {
+            return &it->second;
+        }
+    }
+    auto it = scopes[0].find(name);
+    return it != scopes[0].end() ? &it->second : nullptr;
+}
+
+bool Lowering::declare(const ASTNode* node, const std::string& name, DataType type,
+    const std::string& structName, Variable& var) {
+    int size, align;
+    var.type = type;
+    var.structInfo = nullptr;
+
+    if (type == TYPE_STRUCT) {
+        var.structInfo = semantic.findStructType(structName);
+        if (!var.structInfo || !var.structInfo->complete) {
+            return fail(node, "   '" + structName + "'");
+        }
+        size = var.structInfo->size;
+        align = var.structInfo->align;
+        var.execType = EXT_VOID;
+    }
+    else {
+        size = semantic.typeSize(type);
+        align = semantic.typeAlign(type);
+        var.execType = execType(type);
+        if (var.execType == EXT_VOID) {
+            return fail(node, "  void");
+        }
+    }
+
+    //   -   ,  -  
+    int& top = function == &program.init && scopes.size() == 1
+        ? program.globalSize : function->frameSize;
+    var.address.global = &top == &program.globalSize;
+    top = (top + align - 1) / align * align;
+    var.address.offset = top;
+    top += size;
+
+    scopes.back()[name] = var;
+    return true;
+}
+
+bool Lowering::place(const ASTNode* node, const std::string& name,
+    const std::string& fieldName, Variable& result) {
+    const Variable* var = findVariable(name);
+    if (!var) {
+        return fail(node, " '" + name + "'  ");
+    }
+    result = *var;
+
+    if (fieldName.empty()) {
+        return true;
+    }
+
+    if (!var->structInfo) {
+        return fail(node, "'" + name + "'   ");
+    }
+    const FieldInfo* field = semantic.lookupField(
+        semantic.getNames().find(var->structInfo->name),
+        semantic.getNames().find(fieldName));
+    if (!field) {
+        return fail(node, " '" + fieldName + "'  ");
+    }
+
+    result.address.offset += field->offset;
+    result.type = field->type;
+    result.execType = execType(field->type);
+    result.structInfo = field->type == TYPE_STRUCT
+        ? semantic.findStructType(field->structTypeName) : nullptr;
+    return true;
+}
+
+//   :       
+void Lowering::makeParallel(const ForLoopNode* node, ExecNode* loop,
+    int localBegin, int localEnd) {
+    LoopDependence dependence;
+    std::string reason;
+    if (!analyzeDependence(loop, localBegin, localEnd, dependence, reason)) {
+        std::ostringstream note;
+        note << " " << semantic.position(node->offset).line << ":   : " << reason;
+        noteMessages.push_back(note.str());
+        return;
+    }
+
+    loop->parallel = (int)program.parallelLoops.size();
+    program.parallelLoops.emplace_back();
+    ExecParallelLoop& info = program.parallelLoops.back();
+    info.line = semantic.position(node->offset).line;
+    info.induction = dependence.counted.induction;
+    info.step = dependence.counted.step;
+    info.compare = dependence.counted.compare;
+    info.bound = dependence.counted.bound;
+    for (const auto& reduction : dependence.reductions) {
+        info.reductions.push_back({ reduction.address, reduction.type, reduction.op });
+    }
+
+    //   -    ,  
+    //  :     
+    int& top = function->frameSize;
+    top = (std::max(top, frameReach) + 3) / 4 * 4;
+    info.chunkEnd.offset = top;
+    top += 4;
+
+    ExecNode* induction = newNode(EX_LOAD, EXT_I32);
+    induction->address = info.induction;
+    ExecNode* end = newNode(EX_LOAD, EXT_I32);
+    end->address = info.chunkEnd;
+    ExecNode* cond = newNode(EX_BINARY, EXT_I32);
+    cond->operandType = EXT_I32;
+    cond->binop = TK_LT;
+    cond->left = induction;
+    cond->right = end;
+
+    ExecNode* chunkLoop = newNode(EX_FOR, EXT_VOID);
+    chunkLoop->right = cond;
+    chunkLoop->extra = loop->extra;
+    chunkLoop->body = loop->body;
+
+    info.chunk.name = function->name + ":parallel";
+    info.chunk.body = chunkLoop;
+}
+
+//       
+void Lowering::finishParallelLoops(size_t first, int frameSize) {
+    for (size_t i = first; i < program.parallelLoops.size(); i++) {
+        program.parallelLoops[i].chunk.frameSize = frameSize;
+    }
+}
+
+bool Lowering::lower(const ProgramNode* ast) {
+    function = &program.init;
+    program.init.name = "<init>";
+    program.init.body = newNode(EX_SEQ, EXT_VOID);
+    scopes.assign(1, std::unordered_map<std::string, Variable>());
+    inlineCost = 0;
+    frameReach = 0;
+
+    std::vector<size_t> initParallel;
+    for (const auto& decl : ast->declarations) {
+        if (!decl || decl->kind == NODE_STRUCT_DECL || decl->kind == NODE_IMPORT) {
+            continue;
+        }
+
+        if (auto fn = nodeCast<FunctionNode>(decl.get())) {
+            int initCost = inlineCost;
+            int initReach = frameReach;
+            if (!lowerFunction(fn)) return false;
+            inlineCost = initCost;
+            frameReach = initReach;
+            continue;
+        }
+
+        size_t firstParallel = program.parallelLoops.size();
+        ExecNode* stmt = lowerStatement(decl.get());
+        if (!stmt) return false;
+        program.init.body->items.push_back(stmt);
+        for (size_t i = firstParallel; i < program.parallelLoops.size(); i++) {
+            initParallel.push_back(i);
+        }
+    }
+    program.init.frameSize = std::max(program.init.frameSize, frameReach);
+    for (size_t i : initParallel) {
+        program.parallelLoops[i].chunk.frameSize = program.init.frameSize;
+    }
+    return true;
+}
+
+bool Lowering::lowerFunction(const FunctionNode* node) {
+    if (program.findFunction(node->name)) {
+        return fail(node, "   '" + node->name + "'");
+    }
+
+    program.functions.emplace_back();
+    ExecFunction& fn = program.functions.back();
+    fn.name = node->name;
+    fn.returnType = execType(node->returnType);
+    //    :  
+    functions[node->name] = { node, &fn };
+
+    ExecFunction* saved = function;
+    size_t firstParallel = program.parallelLoops.size();
+    function = &fn;
+    inlineCost = 0;
+    frameReach = 0;
+
+    //  -   ,   
+    scopes.emplace_back();
+    for (const ParamInfo& param : node->params) {
+        Variable var;
+        if (!declare(node, param.name, param.type, param.structTypeName, var)) {
+            return false;
+        }
+        fn.params.push_back(var.address.offset);
+    }
+    fn.body = node->body ? lowerStatement(node->body.get()) : newNode(EX_SEQ, EXT_VOID);
+    scopes.pop_back();
+    function = saved;
+
+    //    8,     
+    fn.frameSize = (std::max(fn.frameSize, frameReach) + 7) / 8 * 8;
+    finishParallelLoops(firstParallel, fn.frameSize);
+    return fn.body != nullptr;
+}
+
+ExecNode* Lowering::lowerStatement(const ASTNode* node) {
+    if (auto block = nodeCast<BlockNode>(node)) {
+        ExecNode* seq = newNode(EX_SEQ, EXT_VOID);
+        scopes.emplace_back();
+        for (const auto& stmt : block->statements) {
+            if (!stmt) continue;
+            ExecNode* item = lowerStatement(stmt.get());
+            if (!item) return nullptr;
+            seq->items.push_back(item);
+        }
+        scopes.pop_back();
+        return seq;
+    }
+
+    if (auto decl = nodeCast<VarDeclNode>(node)) {
+        //       , 
+        //   ,     
+        //  .     .
+        if (!decl->initValue && (function != &program.init || scopes.size() > 1)) {
+            function->frameSize = std::max(function->frameSize, frameReach);
+        }
+        Variable var;
+        if (!declare(decl, decl->name, decl->type, decl->structName, var)) return nullptr;
+
+        if (!decl->initValue) {
+            return newNode(EX_SEQ, EXT_VOID);
+        }
+        ExecNode* assign = lowerAssign(decl, decl->name, "", decl->initValue.get());
+        if (!assign) return nullptr;
+        if (assign->op == EX_COPY) return assign;
+        ExecNode* discard = newNode(EX_DISCARD, EXT_VOID);
+        discard->left = assign;
+        return discard;
+    }
+
+    if (auto loop = nodeCast<ForLoopNode>(node)) {
+        ExecNode* result = newNode(EX_FOR, EXT_VOID);
+        int localBegin = function->frameSize;
+        scopes.emplace_back();
+
+        if (loop->init) {
+            result->left = lowerStatement(loop->init.get());
+            if (!result->left) return nullptr;
+        }
+        if (loop->condition) {
+            ExecNode* cond = lowerExpression(loop->condition.get());
+            if (!cond) return nullptr;
+            result->right = condition(cond);
+        }
+        if (loop->increment) {
+            result->extra = lowerStatement(loop->increment.get());
+            if (!result->extra) return nullptr;
+        }
+        if (loop->body) {
+            result->body = lowerStatement(loop->body.get());
+            if (!result->body) return nullptr;
+        }
+
+        scopes.pop_back();
+        if (loop->parallel) {
+            makeParallel(loop, result, localBegin, std::max(function->frameSize, frameReach));
+        }
+        return result;
+    }
+
+    if (auto ret = nodeCast<ReturnNode>(node)) {
+        ExecNode* result = newNode(EX_RETURN, EXT_VOID);
+        if (ret->expression) {
+            ExecNode* value = lowerExpression(ret->expression.get());
+            if (!value) return nullptr;
+
+            if (function->returnType == EXT_VOID) {
+                result->left = newNode(EX_DISCARD, EXT_VOID);
+                result->left->left = value;
+            }
+            else if (value->type == EXT_F32 && function->returnType != EXT_F32) {
+                fail(node, "float    ");
+                return nullptr;
+            }
+            else {
+                result->left = convert(value, function->returnType);
+            }
+        }
+        return result;
+    }
+
+    if (auto assign = nodeCast<AssignNode>(node)) {
+        ExecNode* value = lowerAssign(assign, assign->varName, assign->fieldName,
+            assign->expression.get());
+        if (!value || value->op == EX_COPY) return value;
+        ExecNode* discard = newNode(EX_DISCARD, EXT_VOID);
+        discard->left = value;
+        return discard;
+    }
+
+    //   
+    ExecNode* value = lowerExpression(node);
+    if (!value) return nullptr;
+    ExecNode* discard = newNode(EX_DISCARD, EXT_VOID);
+    discard->left = value;
+    return discard;
+}
+
+ExecNode* Lowering::lowerAssign(const ASTNode* node, const std::string& name,
+    const std::string& fieldName, const ASTNode* value) {
+    Variable target;
+    if (!place(node, name, fieldName, target)) return nullptr;
+
+    if (target.type == TYPE_STRUCT) {
+        //         
+        auto var = nodeCast<VarNode>(value);
+        Variable source;
+        if (!var || !place(value, var->name, var->fieldName, source)) {
+            fail(node, "    -");
+            return nullptr;
+        }
+        if (source.structInfo != target.structInfo) {
+            fail(node, "   ");
+            return nullptr;
+        }
+
+        ExecNode* copy = newNode(EX_COPY, EXT_VOID);
+        copy->address = target.address;
+        copy->source = source.address;
+        copy->size = target.structInfo->size;
+        return copy;
+    }
+
+    ExecNode* expr = lowerExpression(value);
+    if (!expr) return nullptr;
+    if (expr->type == EXT_F32 && target.execType != EXT_F32) {
+        fail(node, " float  ");
+        return nullptr;
+    }
+
+    ExecNode* store = newNode(EX_STORE, target.execType);
+    store->address = target.address;
+    store->left = convert(expr, target.execType);
+    return store;
+}
+
+ExecNode* Lowering::lowerExpression(const ASTNode* node) {
+    if (auto constant = nodeCast<ConstNode>(node)) {
+        //    
+        ExecNode* result = newNode(EX_CONST, execType(constant->type));
+        if (constant->type == TYPE_FLOAT) {
+            result->floatValue = constant->floatValue;
+        }
+        else {
+            result->intValue = constant->intValue;
+        }
+        return result;
+    }
+
+    if (auto var = nodeCast<VarNode>(node)) {
+        Variable source;
+        if (!place(node, var->name, var->fieldName, source)) return nullptr;
+        if (source.type == TYPE_STRUCT) {
+            fail(node, "  ");
+            return nullptr;
+        }
+        ExecNode* load = newNode(EX_LOAD, source.execType);
+        load->address = source.address;
+        return load;
+    }
+
+    if (auto assign = nodeCast<AssignNode>(node)) {
+        ExecNode* result = lowerAssign(assign, assign->varName, assign->fieldName,
+            assign->expression.get());
+        if (result && result->op == EX_COPY) {
+            fail(node, "   ");
+            return nullptr;
+        }
+        return result;
+    }
+
+    if (auto binary = nodeCast<BinaryOpNode>(node)) {
+        return lowerBinary(binary);
+    }
+
+    if (auto call = nodeCast<CallNode>(node)) {
+        return lowerCall(call);
+    }
+
+    if (auto unary = nodeCast<UnaryOpNode>(node)) {
+        ExecNode* operand = unary->operand ? lowerExpression(unary->operand.get()) : nullptr;
+        if (!operand) return nullptr;
+        if (unary->op == TK_PLUS) return operand;
+
+        if (unary->op == TK_BIT_NOT && operand->type == EXT_F32) {
+            fail(node, "~  float");
+            return nullptr;
+        }
+        ExecNode* result = newNode(unary->op == TK_MINUS ? EX_NEGATE : EX_BIT_NOT,
+            operand->type);
+        result->left = operand;
+        return result;
+    }
+
+    fail(node, "    ");
+    return nullptr;
+}
+
+ExecNode* Lowering::lowerBinary(const BinaryOpNode* node) {
+    ExecNode* left = node->left ? lowerExpression(node->left.get()) : nullptr;
+    ExecNode* right = left && node->right ? lowerExpression(node->right.get()) : nullptr;
+    if (!left || !right) return nullptr;
+
+    const OperatorRule* rule = findBinaryOperatorRule(node->op);
+    if (!rule) {
+        fail(node, "    ");
+        return nullptr;
+    }
+
+    //   -   ,   TYPE_TRAITS: 
+    //    ,  long     
+    ExecType type = left->type > right->type ? left->type : right->type;
+    if (rule->operands == OPERANDS_INTEGER && type == EXT_F32) {
+        fail(node, "   float");
+        return nullptr;
+    }
+
+    bool comparison = rule->result == RESULT_INT;
+    ExecNode* result = newNode(EX_BINARY, comparison ? EXT_I32 : type);
+    result->binop = node->op;
+    result->operandType = type;
+    result->left = convert(left, type);
+    result->right = convert(right, type);
+    return result;
+}
+
+ExecNode* Lowering::lowerCall(const CallNode* node) {
+    auto found = functions.find(node->name);
+    if (found == functions.end()) {
+        fail(node, " '" + node->name + "'  ");
+        return nullptr;
+    }
+    const FunctionNode* callee = found->second.node;
+    const ExecFunction* target = found->second.exec;
+    if (callee->returnType == TYPE_STRUCT) {
+        fail(node, " ,  ");
+        return nullptr;
+    }
+    if (node->arguments.size() != callee->params.size()) {
+        fail(node, "      ");
+        return nullptr;
+    }
+
+    //           .
+    //         , 
+    // ,   .
+    int savedReach = frameReach;
+    frameReach = function->frameSize;
+    std::vector<ExecNode*> arguments;
+    for (size_t i = 0; i < node->arguments.size(); i++) {
+        ExecNode* value = node->arguments[i] ? lowerExpression(node->arguments[i].get()) : nullptr;
+        if (!value) return nullptr;
+        ExecType type = execType(callee->params[i].type);
+        if (value->type == EXT_F32 && type != EXT_F32) {
+            fail(node, "float    ");
+            return nullptr;
+        }
+        arguments.push_back(convert(value, type));
+    }
+    int argumentsReach = frameReach;
+    frameReach = std::max(savedReach, argumentsReach);
+
+    if (inliner && inliner->shouldInline(callee, inlineDepth, inlineCost)) {
+        return inlineCall(callee, target, arguments, argumentsReach);
+    }
+
+    ExecNode* result = newNode(EX_CALL, target->returnType);
+    result->callee = target;
+    result->items = arguments;
+    return result;
+}
+
+//  callee    .   
+//  callee    ; InlinePlanner
+//   ,  return -  , 
+//  -  items   left.   
+//      : EX_INLINE
+//     ,    .  
+//   ,     .
+ExecNode* Lowering::inlineCall(const FunctionNode* callee, const ExecFunction* target,
+    const std::vector<ExecNode*>& arguments, int argumentsReach) {
+    int& top = function->frameSize;
+    int base = top;
+    top = (std::max(top, argumentsReach) + 7) / 8 * 8;
+    int start = top;
+
+    ExecNode* result = newNode(EX_INLINE, target->returnType);
+    result->address.offset = start;
+
+    size_t savedFloor = scopeFloor;
+    scopes.emplace_back();
+    scopeFloor = scopes.size() - 1;
+    inlineDepth++;
+    inlineCost += inliner->cost(callee);
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < callee->params.size(); i++) {
+        const ParamInfo& param = callee->params[i];
+        Variable var;
+        ok = declare(callee, param.name, param.type, param.structTypeName, var);
+        if (!ok) break;
+        ExecNode* store = newNode(EX_STORE, var.execType);
+        store->address = var.address;
+        store->left = arguments[i];
+        ExecNode* discard = newNode(EX_DISCARD, EXT_VOID);
+        discard->left = store;
+        result->items.push_back(discard);
+    }
+
+    auto block = nodeCast<BlockNode>(callee->body.get());
+    const ReturnNode* ret = nullptr;
+    if (ok && block) {
+        //   -   ,   lowerStatement
+        scopes.emplace_back();
+        for (const auto& stmt : block->statements) {
+            if (!stmt) continue;
+            if (auto r = nodeCast<ReturnNode>(stmt.get())) {
+                ret = r;
+                break;
+            }
+            ExecNode* item = lowerStatement(stmt.get());
+            if (!item) {
+                ok = false;
+                break;
+            }
+            result->items.push_back(item);
+        }
+
+        if (ok && ret && ret->expression) {
+            ExecNode* value = lowerExpression(ret->expression.get());
+            if (!value) {
+                ok = false;
+            }
+            else if (target->returnType == EXT_VOID) {
+                ExecNode* discard = newNode(EX_DISCARD, EXT_VOID);
+                discard->left = value;
+                result->items.push_back(discard);
+            }
+            else if (value->type == EXT_F32 && target->returnType != EXT_F32) {
+                ok = fail(ret, "float    ");
+            }
+            else {
+                result->left = convert(value, target->returnType);
+            }
+        }
+        scopes.pop_back();
+    }
+
+    //  return  - ,   
+    if (ok && !result->left && target->returnType != EXT_VOID) {
+        result->left = newNode(EX_CONST, target->returnType);
+    }
+
+    inlineDepth--;
+    scopes.pop_back();
+    scopeFloor = savedFloor;
+    if (!ok) return nullptr;
+
+    top = (top + 7) / 8 * 8;
+    result->size = top - start;
+    frameReach = std::max(frameReach, top);
+    top = base;
+    inlinedCalls++;
+    TALT_COUNT(STAT_CALLS_INLINED);
+    return result;
+}
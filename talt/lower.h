@@ -0,0 +1,222 @@
+#ifndef LOWER_H
+#define LOWER_H
+
+#include "parser.h"
+#include "semantic.h"
+#include "inline.h"
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+//    .  long   
+// ,      .
+enum ExecType {
+    EXT_VOID,
+    EXT_I16,
+    EXT_I32,
+    EXT_I64,
+    EXT_F32
+};
+
+enum ExecOp {
+    EX_CONST,     // intValue / floatValue
+    EX_LOAD,      //      
+    EX_STORE,     //  left  ,   - 
+    EX_COPY,      //  size    source  
+    EX_CONVERT,   //  left  type
+    EX_BINARY,    // left binop right;     operandType
+    EX_NEGATE,
+    EX_BIT_NOT,
+    EX_SEQ,       // items  
+    EX_FOR,       // left - , right -  ( ),
+                  // extra - , body - 
+    EX_RETURN,    // left -  ( )
+    EX_DISCARD,   //  left   
+    EX_CALL,      //  callee; items -    
+    EX_INLINE     //  :  size    ,
+                  //  items,  - left ( )
+};
+
+//  :        
+struct ExecAddress {
+    bool global = false;
+    int offset = 0;
+};
+
+struct ExecFunction;
+
+//     .    
+//  ,       EX_CONVERT.
+struct ExecNode {
+    ExecOp op;
+    ExecType type;
+    ExecType operandType = EXT_VOID;  // EX_BINARY:  
+    TokenType binop = TK_ERROR;
+
+    ExecAddress address;   // EX_LOAD, EX_STORE, EX_COPY (), EX_INLINE
+    ExecAddress source;    // EX_COPY ()
+    int size = 0;          // EX_COPY, EX_INLINE
+
+    int64_t intValue = 0;
+    float floatValue = 0.0f;
+
+    ExecNode* left = nullptr;
+    ExecNode* right = nullptr;
+    ExecNode* extra = nullptr;
+    ExecNode* body = nullptr;
+    std::vector<ExecNode*> items;
+    int parallel = -1;     // EX_FOR:   ExecProgram::parallelLoops
+    const ExecFunction* callee = nullptr;  // EX_CALL
+
+    ExecNode(ExecOp o, ExecType t) : op(o), type(t) {}
+};
+
+struct ExecFunction {
+    std::string name;
+    ExecType returnType = EXT_VOID;
+    int frameSize = 0;
+    std::vector<int> params;  //    
+    ExecNode* body = nullptr;
+};
+
+//      
+struct ExecReduction {
+    ExecAddress address;
+    ExecType type;
+    TokenType op;
+};
+
+//    PRAGMA_PARALLEL,   .
+//     chunk: for (; i < end; i = i + step)
+//    ,  end      chunkEnd.
+//  chunk    ,    .
+struct ExecParallelLoop {
+    int line = 0;
+    ExecAddress induction;
+    int step = 1;
+    TokenType compare = TK_LT;
+    const ExecNode* bound = nullptr;
+    ExecAddress chunkEnd;
+    std::vector<ExecReduction> reductions;
+    ExecFunction chunk;
+};
+
+// ,   .  
+//       .
+struct ExecProgram {
+    std::deque<ExecNode> nodes;  //   
+    std::deque<ExecFunction> functions;  // EX_CALL   
+    ExecFunction init;
+    int globalSize = 0;
+    std::deque<ExecParallelLoop> parallelLoops;
+
+    const ExecFunction* findFunction(const std::string& name) const;
+};
+
+//   .   JIT  
+//    ,      .
+enum ExecStatus {
+    EXEC_OK = 0,
+    EXEC_DIVISION_BY_ZERO = 1,
+    EXEC_STACK_OVERFLOW = 2
+};
+
+//   :      . 
+//   ,     .
+const int EXEC_MAX_CALL_DEPTH = 1000;
+const size_t EXEC_CALL_STACK_SIZE = 1 << 20;
+
+class ParallelRuntime;
+
+struct ExecContext {
+    char* frame = nullptr;
+    char* globals = nullptr;
+    int64_t intResult = 0;
+    float floatResult = 0.0f;
+    int32_t status = EXEC_OK;
+    ParallelRuntime* parallel = nullptr;  //  -   
+    //  :     [stack, stackEnd)
+    //  ;  -    EXEC_STACK_OVERFLOW
+    char* stack = nullptr;
+    char* stackEnd = nullptr;
+    int32_t depth = 0;
+};
+
+//  ExecProgram   AST.   
+//     :   
+//  .
+class Lowering {
+private:
+    struct Variable {
+        ExecAddress address;
+        DataType type;
+        ExecType execType;
+        const StructTypeInfo* structInfo;
+    };
+
+    struct LoweredFunction {
+        const FunctionNode* node;
+        const ExecFunction* exec;
+    };
+
+    SemanticAnalyzer& semantic;
+    ExecProgram& program;
+    ExecFunction* function;
+    std::vector<std::unordered_map<std::string, Variable>> scopes;
+    // findVariable  scopes[0]     :
+    //        
+    size_t scopeFloor = 1;
+    std::unordered_map<std::string, LoweredFunction> functions;
+    std::string errorMessage;
+    std::vector<std::string> noteMessages;
+
+    const InlinePlanner* inliner = nullptr;
+    int inlineDepth = 0;
+    int inlineCost = 0;  //  ,    
+    //       :   
+    //  (frameSize ),     frameReach
+    int frameReach = 0;
+    int inlinedCalls = 0;
+
+    ExecNode* newNode(ExecOp op, ExecType type);
+    ExecType execType(DataType type) const;
+    ExecNode* convert(ExecNode* node, ExecType type);
+    ExecNode* condition(ExecNode* node);
+    bool fail(const ASTNode* node, const std::string& message);
+
+    const Variable* findVariable(const std::string& name) const;
+    bool declare(const ASTNode* node, const std::string& name, DataType type,
+        const std::string& structName, Variable& var);
+    bool place(const ASTNode* node, const std::string& name,
+        const std::string& fieldName, Variable& result);
+
+    void makeParallel(const ForLoopNode* node, ExecNode* loop,
+        int localBegin, int localEnd);
+    void finishParallelLoops(size_t first, int frameSize);
+    bool lowerFunction(const FunctionNode* node);
+    ExecNode* lowerStatement(const ASTNode* node);
+    ExecNode* lowerExpression(const ASTNode* node);
+    ExecNode* lowerBinary(const BinaryOpNode* node);
+    ExecNode* lowerCall(const CallNode* node);
+    ExecNode* inlineCall(const FunctionNode* callee, const ExecFunction* target,
+        const std::vector<ExecNode*>& arguments, int argumentsReach);
+    ExecNode* lowerAssign(const ASTNode* node, const std::string& name,
+        const std::string& fieldName, const ASTNode* value);
+
+public:
+    Lowering(SemanticAnalyzer& sem, ExecProgram& prog);
+
+    // ,   planner, ;   - 
+    void setInliner(const InlinePlanner* planner) { inliner = planner; }
+    bool lower(const ProgramNode* ast);
+    int callsInlined() const { return inlinedCalls; }
+    const std::string& error() const { return errorMessage; }
+    // ,       
+    const std::vector<std::string>& notes() const { return noteMessages; }
+};
+
+const char* execTypeName(ExecType type);
+
+#endif
@@ -0,0 +1,726 @@
+#include "lsp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <set>
+#include <sstream>
+
+namespace {
+
+//  JSON-RPC
+const int RPC_PARSE_ERROR = -32700;
+const int RPC_INVALID_REQUEST = -32600;
+const int RPC_METHOD_NOT_FOUND = -32601;
+
+//   
+const int COMPLETION_FIELD = 5;
+const int COMPLETION_VARIABLE = 6;
+const int COMPLETION_KEYWORD = 14;
+const int COMPLETION_STRUCT = 22;
+
+const char* const KEYWORDS[] = {
+    "int", "short", "long", "float", "struct", "for", "return", "void"
+};
+
+bool isIdentChar(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+        (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+//      UTF-16,   -
+//  .  ASCII  .
+int utf16Length(const char* begin, const char* end) {
+    int units = 0;
+    for (const char* p = begin; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        if ((c & 0xC0) != 0x80) units += c >= 0xF0 ? 2 : 1;
+    }
+    return units;
+}
+
+//     0
+size_t lineCount(const LspDocument& document) {
+    return document.lines.lineCount();
+}
+
+size_t lineBegin(const LspDocument& document, size_t line) {
+    return document.lines.lineStart(line + 1);
+}
+
+size_t lineEnd(const LspDocument& document, size_t line) {
+    size_t end = line + 1 < lineCount(document)
+        ? lineBegin(document, line + 1) - 1 : document.text.size();
+    if (end > lineBegin(document, line) && document.text[end - 1] == '\r') end--;
+    return end;
+}
+
+//   (  0,  UTF-16) ->   
+size_t offsetAt(const LspDocument& document, int line, int character) {
+    if (line < 0) return 0;
+    if ((size_t)line >= lineCount(document)) return document.text.size();
+    size_t offset = lineBegin(document, line);
+    size_t end = lineEnd(document, line);
+    int units = 0;
+    while (offset < end && units < character) {
+        unsigned char c = (unsigned char)document.text[offset];
+        units += c >= 0xF0 ? 2 : 1;
+        offset++;
+        while (offset < end && ((unsigned char)document.text[offset] & 0xC0) == 0x80) {
+            offset++;
+        }
+    }
+    return offset;
+}
+
+//   (     1) -> 
+void writePosition(OutputWriter& out, const LspDocument& document, int line, int column) {
+    int character = 0;
+    if (line < 1) line = 1;
+    if ((size_t)line > lineCount(document)) line = (int)lineCount(document);
+    if (column > 1) {
+        const char* begin = document.text.data() + lineBegin(document, line - 1);
+        size_t available = lineEnd(document, line - 1) - lineBegin(document, line - 1);
+        size_t bytes = std::min((size_t)(column - 1), available);
+        character = utf16Length(begin, begin + bytes);
+    }
+    out << "{\"line\":" << (line - 1) << ",\"character\":" << character << '}';
+}
+
+void writeRange(OutputWriter& out, const LspDocument& document,
+    int line, int column, int length) {
+    out << "{\"start\":";
+    writePosition(out, document, line, column);
+    out << ",\"end\":";
+    writePosition(out, document, line, column + length);
+    out << '}';
+}
+
+//      
+void writeRange(OutputWriter& out, const LspDocument& document,
+    SourceOffset offset, int length) {
+    SourcePosition at = document.lines.position(offset);
+    writeRange(out, document, at.line, at.column, length);
+}
+
+//  ,    ,  
+//  
+int wordLength(const LspDocument& document, int line, int column) {
+    if (line < 1 || (size_t)line > lineCount(document) || column < 1) return 0;
+    size_t begin = lineBegin(document, line - 1) + column - 1;
+    size_t end = begin;
+    while (end < document.text.size() && isIdentChar(document.text[end])) end++;
+    if (end == begin && begin < lineEnd(document, line - 1)) end++;
+    return (int)(end - begin);
+}
+
+std::string typeText(DataType type, const std::string& structName) {
+    if (type == TYPE_STRUCT) return "struct " + structName;
+    return SemanticAnalyzer::dataTypeToString(type);
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+double lspLatencyTarget(const std::string& method) {
+    if (method == "textDocument/didOpen") return LSP_TARGET_OPEN_MS;
+    if (method == "textDocument/didChange") return LSP_TARGET_CHANGE_MS;
+    if (method == "textDocument/hover" || method == "textDocument/definition" ||
+        method == "textDocument/completion") {
+        return LSP_TARGET_QUERY_MS;
+    }
+    return 0;
+}
+
+void writeLspFrame(OutputWriter& out, const std::string& body) {
+    out << "Content-Length: " << (unsigned long long)body.size() << "\r\n\r\n" << body;
+}
+
+LspServer::LspServer(OutputWriter& writer, TargetAbi abi)
+    : out(writer), target(abi) {}
+
+int LspServer::run(std::istream& in) {
+    std::string header;
+    std::string body;
+    while (!exitReceived) {
+        //    ;   Content-Length
+        size_t length = 0;
+        bool seenHeader = false;
+        while (std::getline(in, header)) {
+            if (!header.empty() && header.back() == '\r') header.pop_back();
+            if (header.empty()) {
+                if (seenHeader) break;
+                continue;
+            }
+            seenHeader = true;
+            if (header.compare(0, 15, "Content-Length:") == 0) {
+                length = (size_t)std::strtoull(header.c_str() + 15, nullptr, 10);
+            }
+        }
+        if (!in) break;
+        if (length == 0) continue;
+
+        body.resize(length);
+        if (!in.read(&body[0], (std::streamsize)length)) break;
+        process(body, in.rdbuf()->in_avail() > 0);
+    }
+    //  shutdown  exit     -  1
+    return shutdownReceived && exitReceived ? 0 : 1;
+}
+
+void LspServer::process(const std::string& message, bool moreInput) {
+    auto start = std::chrono::steady_clock::now();
+
+    JsonValue value;
+    std::string error;
+    if (!parseJson(message, value, error)) {
+        respondError(JsonValue(), RPC_PARSE_ERROR, "  JSON: " + error);
+        return;
+    }
+
+    const std::string& method = value["method"].asString();
+    handle(method, value);
+    if (!moreInput) flushPending();
+
+    timings[method.empty() ? "( )" : method].push_back(millisecondsSince(start));
+}
+
+void LspServer::handle(const std::string& method, const JsonValue& message) {
+    const JsonValue& id = message["id"];
+    const JsonValue& params = message["params"];
+
+    if (method == "exit") {
+        exitReceived = true;
+        return;
+    }
+    if (shutdownReceived && !id.isNull()) {
+        respondError(id, RPC_INVALID_REQUEST, "  ");
+        return;
+    }
+
+    if (method == "initialize") {
+        respond(id, "{\"capabilities\":{"
+            "\"textDocumentSync\":{\"openClose\":true,\"change\":2,\"save\":true},"
+            "\"hoverProvider\":true,"
+            "\"definitionProvider\":true,"
+            "\"completionProvider\":{\"triggerCharacters\":[\".\"]}},"
+            "\"serverInfo\":{\"name\":\"talt\"}}");
+    }
+    else if (method == "shutdown") {
+        shutdownReceived = true;
+        respond(id, "null");
+    }
+    else if (method == "textDocument/didOpen") {
+        openDocument(params);
+    }
+    else if (method == "textDocument/didChange") {
+        changeDocument(params);
+    }
+    else if (method == "textDocument/didClose") {
+        closeDocument(params);
+    }
+    else if (method == "textDocument/didSave") {
+        //       
+        builders.clear();
+        for (auto& entry : documents) {
+            entry.second->dirty = true;
+        }
+    }
+    else if (method == "textDocument/hover") {
+        respond(id, hover(params));
+    }
+    else if (method == "textDocument/definition") {
+        respond(id, definition(params));
+    }
+    else if (method == "textDocument/completion") {
+        respond(id, completion(params));
+    }
+    else if (!id.isNull() && !method.empty()) {
+        respondError(id, RPC_METHOD_NOT_FOUND, "  : " + method);
+    }
+    //   (initialized, $/cancelRequest...)   
+}
+
+void LspServer::send(const std::string& body) {
+    writeLspFrame(out, body);
+    out.flush();
+}
+
+void LspServer::respond(const JsonValue& id, const std::string& result) {
+    std::string body;
+    {
+        OutputWriter writer(body);
+        writer << "{\"jsonrpc\":\"2.0\",\"id\":";
+        writeJson(writer, id);
+        writer << ",\"result\":" << result << '}';
+    }
+    send(body);
+}
+
+void LspServer::respondError(const JsonValue& id, int code, const std::string& message) {
+    std::string body;
+    {
+        OutputWriter writer(body);
+        writer << "{\"jsonrpc\":\"2.0\",\"id\":";
+        writeJson(writer, id);
+        writer << ",\"error\":{\"code\":" << code << ",\"message\":";
+        writer.jsonString(message) << "}}";
+    }
+    send(body);
+}
+
+LspDocument* LspServer::findDocument(const JsonValue& params) {
+    auto it = documents.find(params["textDocument"]["uri"].asString());
+    if (it == documents.end()) return nullptr;
+
+    //   ,   
+    LspDocument& document = *it->second;
+    if (document.dirty) {
+        analyze(document);
+        publishDiagnostics(document);
+    }
+    return &document;
+}
+
+void LspServer::openDocument(const JsonValue& params) {
+    const JsonValue& item = params["textDocument"];
+    std::unique_ptr<LspDocument>& slot = documents[item["uri"].asString()];
+    slot.reset(new LspDocument());
+    slot->uri = item["uri"].asString();
+    slot->version = item["version"].asInt();
+    slot->text = item["text"].asString();
+    slot->lines.assign(slot->text);
+    slot->semantic.setTargetAbi(target);
+    slot->semantic.setLineTable(&slot->lines);
+    slot->semantic.setRecordReferences(true);
+}
+
+void LspServer::changeDocument(const JsonValue& params) {
+    auto it = documents.find(params["textDocument"]["uri"].asString());
+    if (it == documents.end()) return;
+    LspDocument& document = *it->second;
+    document.version = params["textDocument"]["version"].asInt(document.version);
+
+    for (const JsonValue& change : params["contentChanges"].items) {
+        const JsonValue& range = change["range"];
+        if (range.isNull()) {
+            document.text = change["text"].asString();
+        }
+        else {
+            size_t begin = offsetAt(document, range["start"]["line"].asInt(),
+                range["start"]["character"].asInt());
+            size_t end = offsetAt(document, range["end"]["line"].asInt(),
+                range["end"]["character"].asInt());
+            if (end < begin) end = begin;
+            document.text.replace(begin, end - begin, change["text"].asString());
+        }
+        document.lines.assign(document.text);
+    }
+    document.dirty = true;
+}
+
+void LspServer::closeDocument(const JsonValue& params) {
+    auto it = documents.find(params["textDocument"]["uri"].asString());
+    if (it == documents.end()) return;
+
+    //        
+    std::string body;
+    {
+        OutputWriter writer(body);
+        writer << "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+            "\"params\":{\"uri\":";
+        writeJsonUtf8(writer, it->first);
+        writer << ",\"diagnostics\":[]}}";
+    }
+    documents.erase(it);
+    send(body);
+}
+
+void LspServer::flushPending() {
+    for (auto& entry : documents) {
+        LspDocument& document = *entry.second;
+        if (document.dirty) {
+            analyze(document);
+            publishDiagnostics(document);
+        }
+    }
+}
+
+ModuleBuilder& LspServer::modulesFor(const std::string& uri) {
+    // file:///  %XX   
+    std::string path = uri.compare(0, 7, "file://") == 0 ? uri.substr(7) : uri;
+    std::string decoded;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '%' && i + 2 < path.size()) {
+            decoded += (char)std::strtol(path.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        }
+        else {
+            decoded += path[i];
+        }
+    }
+
+    std::string root = ModuleBuilder::directoryOf(decoded);
+    auto& builder = builders[root];
+    if (!builder) {
+        CheckOptions options;
+        options.target = target;
+        builder.reset(new ModuleBuilder(root, ModuleBuilder::extensionOf(decoded), options));
+    }
+    return *builder;
+}
+
+void LspServer::analyze(LspDocument& document) {
+    document.ast.reset();
+    document.semantic.clear();
+    document.semantic.setModuleProvider(&modulesFor(document.uri));
+
+    Scanner scanner(document.text.data(), document.text.size());
+    Parser parser(scanner);
+    parser.reportToStderr = false;
+    document.ast = parser.parse();
+    document.diagnostics = std::move(parser.diagnostics);
+
+    if (document.ast) {
+        Symbol* dummy = nullptr;
+        document.ast->checkSemantics(document.semantic, dummy);
+    }
+    const auto& semantic = document.semantic.getDiagnostics();
+    document.diagnostics.insert(document.diagnostics.end(), semantic.begin(), semantic.end());
+
+    document.references = document.semantic.getReferences();
+    std::stable_sort(document.references.begin(), document.references.end(),
+        [](const SymbolReference& a, const SymbolReference& b) {
+            return a.offset < b.offset;
+        });
+    document.dirty = false;
+}
+
+void LspServer::publishDiagnostics(const LspDocument& document) {
+    std::string body;
+    {
+        OutputWriter writer(body);
+        writer << "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+            "\"params\":{\"uri\":";
+        writeJsonUtf8(writer, document.uri);
+        writer << ",\"version\":" << document.version << ",\"diagnostics\":[";
+        for (size_t i = 0; i < document.diagnostics.size(); i++) {
+            const Diagnostic& diagnostic = document.diagnostics[i];
+            if (i > 0) writer << ',';
+            writer << "{\"range\":";
+            writeRange(writer, document, diagnostic.line, diagnostic.column,
+                wordLength(document, diagnostic.line, diagnostic.column));
+            writer << ",\"severity\":" << (diagnostic.warning ? 2 : 1)
+                << ",\"source\":\"talt\",\"message\":";
+            writer.jsonString(diagnostic.message) << '}';
+        }
+        writer << "]}}";
+    }
+    send(body);
+}
+
+const SymbolReference* LspServer::referenceAt(const LspDocument& document,
+    const JsonValue& position) const {
+    int line = position["line"].asInt(-1);
+    if (line < 0 || (size_t)line >= lineCount(document)) return nullptr;
+    //       ,  1
+    SourceOffset cursor = (SourceOffset)offsetAt(document, line, position["character"].asInt()) + 1;
+
+    //  ,       
+    // ;        
+    auto it = std::upper_bound(document.references.begin(), document.references.end(),
+        cursor, [](SourceOffset key, const SymbolReference& r) { return key < r.offset; });
+    if (it == document.references.begin()) return nullptr;
+    --it;
+    if (it->offset <= lineBegin(document, line) || cursor > it->offset + it->length) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+std::string LspServer::hover(const JsonValue& params) {
+    LspDocument* document = findDocument(params);
+    if (!document) return "null";
+    const SymbolReference* reference = referenceAt(*document, params["position"]);
+    if (!reference) return "null";
+
+    const SemanticAnalyzer& semantic = document->semantic;
+    std::string text;
+    if (reference->symbol) {
+        const Symbol* symbol = reference->symbol;
+        if (symbol->category == CAT_STRUCT_TYPE) {
+            text = "struct " + semantic.nameOf(symbol->name);
+        }
+        else if (symbol->category == CAT_FUNCTION) {
+            text = typeText(symbol->type->kind, semantic.nameOf(symbol->type->structName)) +
+                " " + semantic.nameOf(symbol->name) + "(";
+            if (const SymbolExtra* extra = semantic.findExtraInfo(symbol)) {
+                for (size_t i = 0; i < extra->paramTypes.size(); i++) {
+                    if (i > 0) text += ", ";
+                    text += typeText(extra->paramTypes[i], "");
+                }
+            }
+            text += ")";
+        }
+        else {
+            text = typeText(symbol->type->kind, semantic.nameOf(symbol->type->structName)) +
+                " " + semantic.nameOf(symbol->name);
+        }
+    }
+    else {
+        const FieldInfo* field = semantic.lookupField(reference->structName, reference->field);
+        if (!field) return "null";
+        std::ostringstream ss;
+        ss << typeText(field->type, field->structTypeName) << " "
+            << semantic.nameOf(reference->structName) << "." << field->name
+            << "\n " << field->offset << ",  " << field->size;
+        text = ss.str();
+    }
+
+    std::string result;
+    {
+        OutputWriter writer(result);
+        writer << "{\"contents\":{\"kind\":\"plaintext\",\"value\":";
+        writer.jsonString(text) << "},\"range\":";
+        writeRange(writer, *document, reference->offset, reference->length);
+        writer << '}';
+    }
+    return result;
+}
+
+std::string LspServer::definition(const JsonValue& params) {
+    LspDocument* document = findDocument(params);
+    if (!document) return "null";
+    const SymbolReference* reference = referenceAt(*document, params["position"]);
+    if (!reference) return "null";
+
+    const SemanticAnalyzer& semantic = document->semantic;
+    SourceOffset declaration = 0;
+    if (reference->symbol) {
+        const SymbolExtra* extra = semantic.findExtraInfo(reference->symbol);
+        if (extra) declaration = extra->sourceOffset;
+    }
+    else {
+        const FieldInfo* field = semantic.lookupField(reference->structName, reference->field);
+        if (field) declaration = field->sourceOffset;
+    }
+    if (declaration == 0) return "null";
+
+    std::string result;
+    {
+        OutputWriter writer(result);
+        writer << "{\"uri\":";
+        writeJsonUtf8(writer, document->uri);
+        writer << ",\"range\":";
+        writeRange(writer, *document, declaration, reference->length);
+        writer << '}';
+    }
+    return result;
+}
+
+std::string LspServer::completion(const JsonValue& params) {
+    LspDocument* document = findDocument(params);
+    if (!document) return "null";
+    const JsonValue& position = params["position"];
+    int line = position["line"].asInt(-1);
+    if (line < 0 || (size_t)line >= lineCount(*document)) return "null";
+
+    const std::string& text = document->text;
+    size_t cursor = offsetAt(*document, line, position["character"].asInt());
+    size_t begin = cursor;
+    size_t lineFirst = lineBegin(*document, line);
+    while (begin > lineFirst && isIdentChar(text[begin - 1])) begin--;
+    std::string prefix = text.substr(begin, cursor - begin);
+    //          
+    SourceOffset visibleEnd = (SourceOffset)begin + 1;
+
+    const SemanticAnalyzer& semantic = document->semantic;
+    std::string result;
+    OutputWriter writer(result);
+    writer << "{\"isIncomplete\":false,\"items\":[";
+    bool first = true;
+    auto item = [&](const std::string& label, int kind, const std::string& detail) {
+        if (label.compare(0, prefix.size(), prefix) != 0) return;
+        if (!first) writer << ',';
+        first = false;
+        writer << "{\"label\":";
+        writer.jsonString(label) << ",\"kind\":" << kind;
+        if (!detail.empty()) {
+            writer << ",\"detail\":";
+            writer.jsonString(detail);
+        }
+        writer << '}';
+    };
+
+    if (begin > lineFirst && text[begin - 1] == '.') {
+        // :       
+        //    
+        size_t nameEnd = begin - 1;
+        size_t nameBegin = nameEnd;
+        while (nameBegin > lineFirst && isIdentChar(text[nameBegin - 1])) {
+            nameBegin--;
+        }
+        std::string name = text.substr(nameBegin, nameEnd - nameBegin);
+        const Symbol* variable = nullptr;
+        for (const auto& reference : document->references) {
+            if (reference.offset >= visibleEnd) break;
+            if (reference.symbol && reference.symbol->isVariable() &&
+                semantic.nameOf(reference.symbol->name) == name) {
+                variable = reference.symbol;
+            }
+        }
+        const StructTypeInfo* info = variable && variable->type->isStruct()
+            ? semantic.findStructType(variable->type->structName) : nullptr;
+        if (info) {
+            for (const auto& field : info->fields) {
+                item(field.name, COMPLETION_FIELD, typeText(field.type, field.structTypeName));
+            }
+        }
+    }
+    else {
+        // ,   ,    
+        std::set<std::string> seen;
+        for (const auto& reference : document->references) {
+            if (reference.offset >= visibleEnd) break;
+            if (!reference.declaration || !reference.symbol) continue;
+            const std::string& name = semantic.nameOf(reference.symbol->name);
+            if (seen.insert(name).second) {
+                item(name, COMPLETION_VARIABLE, typeText(reference.symbol->type->kind,
+                    semantic.nameOf(reference.symbol->type->structName)));
+            }
+        }
+        for (const StructTypeInfo* info : semantic.sortedStructTypes()) {
+            item(info->name, COMPLETION_STRUCT, "struct");
+        }
+        for (const char* keyword : KEYWORDS) {
+            item(keyword, COMPLETION_KEYWORD, "");
+        }
+    }
+    writer << "]}";
+    writer.flush();
+    return result;
+}
+
+void LspServer::printLatency(OutputWriter& report) const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-26s %7s %9s %9s %9s %7s\n",
+        "", "", "", "p95", "", "");
+    report << "\n===  LSP,  ===\n" << line;
+
+    for (const auto& entry : timings) {
+        std::vector<double> samples = entry.second;
+        std::sort(samples.begin(), samples.end());
+        double median = samples[samples.size() / 2];
+        double p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+        double target = lspLatencyTarget(entry.first);
+
+        std::snprintf(line, sizeof(line), "%-26s %7u %9.3f %9.3f %9.3f ",
+            entry.first.c_str(), (unsigned)samples.size(), median, p95, samples.back());
+        report << line;
+        if (target > 0) {
+            std::snprintf(line, sizeof(line), "%7.0f %s\n", target,
+                p95 <= target ? "ok" : "");
+            report << line;
+        }
+        else {
+            report << "      -\n";
+        }
+    }
+}
+
+std::vector<std::string> makeLspBenchScript(const std::string& uri,
+    const std::string& text, int rounds) {
+    //          
+    std::vector<std::pair<int, int>> names;
+    std::vector<std::pair<int, int>> dots;
+    {
+        Scanner scanner(text.data(), text.size());
+        for (Token token = scanner.getNextToken();
+            token.type != TK_EOF && token.type != TK_ERROR;
+            token = scanner.getNextToken()) {
+            SourcePosition at = scanner.lineTable().position(token.offset);
+            if (token.type == TK_IDENT) names.push_back({ at.line, at.column });
+            if (token.type == TK_DOT) dots.push_back({ at.line, at.column + 1 });
+        }
+    }
+    if (names.empty()) names.push_back({ 1, 1 });
+    if (dots.empty()) dots = names;
+
+    LspDocument layout;
+    layout.text = text;
+    layout.lines.assign(text);
+
+    std::vector<std::string> script;
+    int id = 1;
+    auto message = [&](const std::string& method, bool request,
+        const std::function<void(OutputWriter&)>& params) {
+        std::string body;
+        {
+            OutputWriter writer(body);
+            writer << "{\"jsonrpc\":\"2.0\",";
+            if (request) writer << "\"id\":" << id++ << ',';
+            writer << "\"method\":\"" << method << "\",\"params\":";
+            params(writer);
+            writer << '}';
+        }
+        script.push_back(body);
+    };
+    auto documentId = [&](OutputWriter& writer) {
+        writer << "{\"uri\":";
+        writeJsonUtf8(writer, uri);
+        writer << '}';
+    };
+    auto query = [&](const char* method, const std::pair<int, int>& at) {
+        message(method, true, [&](OutputWriter& writer) {
+            writer << "{\"textDocument\":";
+            documentId(writer);
+            writer << ",\"position\":";
+            writePosition(writer, layout, at.first, at.second);
+            writer << '}';
+        });
+    };
+
+    message("initialize", true, [](OutputWriter& writer) {
+        writer << "{\"processId\":null,\"rootUri\":null,\"capabilities\":{}}";
+    });
+    message("initialized", false, [](OutputWriter& writer) { writer << "{}"; });
+    message("textDocument/didOpen", false, [&](OutputWriter& writer) {
+        writer << "{\"textDocument\":{\"uri\":";
+        writeJsonUtf8(writer, uri);
+        writer << ",\"languageId\":\"talt\",\"version\":1,\"text\":";
+        writeJsonUtf8(writer, text);
+        writer << "}}";
+    });
+
+    //  -     ,    
+    // :    ,    
+    //  
+    size_t editLine = lineCount(layout) / 2;
+    const char* editBegin = text.data() + lineBegin(layout, editLine);
+    int editCharacter = utf16Length(editBegin, text.data() + lineEnd(layout, editLine));
+
+    for (int round = 0; round < rounds; round++) {
+        bool insert = round % 2 == 0;
+        message("textDocument/didChange", false, [&](OutputWriter& writer) {
+            writer << "{\"textDocument\":{\"uri\":";
+            writeJsonUtf8(writer, uri);
+            writer << ",\"version\":" << (round + 2) << "},\"contentChanges\":[{\"range\":"
+                << "{\"start\":{\"line\":" << (int)editLine << ",\"character\":" << editCharacter
+                << "},\"end\":{\"line\":" << (int)editLine << ",\"character\":"
+                << (editCharacter + (insert ? 0 : 1)) << "}},\"text\":\""
+                << (insert ? " " : "") << "\"}]}";
+        });
+        query("textDocument/hover", names[(size_t)round % names.size()]);
+        query("textDocument/definition", names[((size_t)round * 7 + 3) % names.size()]);
+        query("textDocument/completion", dots[(size_t)round % dots.size()]);
+    }
+
+    message("shutdown", true, [](OutputWriter& writer) { writer << "null"; });
+    message("exit", false, [](OutputWriter& writer) { writer << "null"; });
+    return script;
+}
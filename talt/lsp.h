@@ -0,0 +1,107 @@
+#ifndef LSP_H
+#define LSP_H
+
+#include "parser.h"
+#include "semantic.h"
+#include "json.h"
+#include "output.h"
+#include "module.h"
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//    , .    
+//       .
+const double LSP_TARGET_OPEN_MS = 100;
+const double LSP_TARGET_CHANGE_MS = 30;
+const double LSP_TARGET_QUERY_MS = 5;
+
+//     0,     
+double lspLatencyTarget(const std::string& method);
+
+//         
+struct LspDocument {
+    std::string uri;
+    int version = 0;
+    std::string text;
+    LineTable lines;  //   text;      
+
+    //     ; 
+    //     
+    SemanticAnalyzer semantic;
+    std::unique_ptr<ProgramNode> ast;
+    std::vector<Diagnostic> diagnostics;
+    std::vector<SymbolReference> references;  //   
+    bool dirty = true;
+};
+
+//  Language Server Protocol  stdin/stdout.   
+//      :  
+//   ,  hover, definition  completion 
+//   .
+//
+//     ,  ,  
+//    :    
+//  .
+class LspServer {
+public:
+    LspServer(OutputWriter& out, TargetAbi target);
+
+    //    exit;    
+    int run(std::istream& in);
+
+    //       
+    void process(const std::string& message, bool moreInput = false);
+
+    bool exited() const { return exitReceived; }
+
+    //    , 
+    const std::map<std::string, std::vector<double>>& latencies() const { return timings; }
+    void printLatency(OutputWriter& out) const;
+
+private:
+    OutputWriter& out;
+    TargetAbi target;
+    std::map<std::string, std::unique_ptr<LspDocument>> documents;
+    std::map<std::string, std::vector<double>> timings;
+
+    //     ,    
+    // ;      
+    std::map<std::string, std::unique_ptr<ModuleBuilder>> builders;
+    ModuleBuilder& modulesFor(const std::string& uri);
+    bool shutdownReceived = false;
+    bool exitReceived = false;
+
+    void handle(const std::string& method, const JsonValue& message);
+    void send(const std::string& body);
+    void respond(const JsonValue& id, const std::string& result);
+    void respondError(const JsonValue& id, int code, const std::string& message);
+
+    void openDocument(const JsonValue& params);
+    void changeDocument(const JsonValue& params);
+    void closeDocument(const JsonValue& params);
+    void analyze(LspDocument& document);
+    void publishDiagnostics(const LspDocument& document);
+    void flushPending();
+
+    LspDocument* findDocument(const JsonValue& params);
+    const SymbolReference* referenceAt(const LspDocument& document,
+        const JsonValue& position) const;
+
+    std::string hover(const JsonValue& params);
+    std::string definition(const JsonValue& params);
+    std::string completion(const JsonValue& params);
+};
+
+//  :  Content-Length  
+void writeLspFrame(OutputWriter& out, const std::string& body);
+
+//     --lsp-bench:  , 
+// rounds  , hover, definition  completion   
+// .  -    .
+std::vector<std::string> makeLspBenchScript(const std::string& uri,
+    const std::string& text, int rounds);
+
+#endif
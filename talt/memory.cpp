@@ -0,0 +1,213 @@
+#include "memory.h"
+#include "stats.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#ifdef TALT_STATS
+namespace {
+
+//       : operator new
+//       
+struct Counter {
+    std::atomic<long long> current;
+    std::atomic<long long> peak;
+};
+
+Counter counters[MEM_COUNT];
+Counter total;
+
+//        
+bool accounting = false;
+std::atomic<long long> budget{ 0 };
+std::atomic<bool> exceeded{ false };
+
+thread_local MemoryTag currentTag = MEM_OTHER;
+
+//       ,  
+//   ,    
+struct alignas(std::max_align_t) BlockHeader {
+    std::size_t size;
+    MemoryTag tag;
+};
+
+void raisePeak(Counter& counter, long long value) {
+    long long peak = counter.peak.load(std::memory_order_relaxed);
+    while (value > peak &&
+        !counter.peak.compare_exchange_weak(peak, value, std::memory_order_relaxed)) {
+    }
+}
+
+void* allocate(std::size_t size) {
+    //   :      
+    Stats::counters[STAT_ALLOCATIONS].fetch_add(1, std::memory_order_relaxed);
+    Stats::counters[STAT_BYTES_ALLOCATED].fetch_add(size, std::memory_order_relaxed);
+    void* block = std::malloc(sizeof(BlockHeader) + size);
+    if (!block) throw std::bad_alloc();
+
+    BlockHeader* header = static_cast<BlockHeader*>(block);
+    header->size = size;
+    // ,    ,    
+    header->tag = accounting ? currentTag : MEM_COUNT;
+    if (!accounting) return header + 1;
+
+    long long bytes = (long long)size;
+    Counter& counter = counters[header->tag];
+    raisePeak(counter, counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    long long now = total.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    raisePeak(total, now);
+
+    long long limit = budget.load(std::memory_order_relaxed);
+    if (limit > 0 && now > limit) {
+        exceeded.store(true, std::memory_order_relaxed);
+    }
+    return header + 1;
+}
+
+void release(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+    if (header->tag == MEM_COUNT) {
+        std::free(header);
+        return;
+    }
+    long long bytes = (long long)header->size;
+    counters[header->tag].current.fetch_sub(bytes, std::memory_order_relaxed);
+    total.current.fetch_sub(bytes, std::memory_order_relaxed);
+    std::free(header);
+}
+
+}
+
+MemoryScope::MemoryScope(MemoryTag tag) : saved(currentTag) {
+    currentTag = tag;
+}
+
+MemoryScope::~MemoryScope() {
+    currentTag = saved;
+}
+
+MemoryUsage memoryUsage(MemoryTag tag) {
+    return { counters[tag].current.load(), counters[tag].peak.load() };
+}
+
+MemoryUsage totalMemoryUsage() {
+    return { total.current.load(), total.peak.load() };
+}
+
+void enableMemoryAccounting() {
+    accounting = true;
+}
+
+bool memoryAccountingEnabled() {
+    return accounting;
+}
+
+void setMemoryBudget(long long bytes) {
+    if (bytes > 0) accounting = true;
+    budget = bytes;
+    exceeded = bytes > 0 && total.current.load() > bytes;
+}
+
+long long memoryBudget() {
+    return budget.load();
+}
+
+bool memoryBudgetExceeded() {
+    return exceeded.load(std::memory_order_relaxed);
+}
+
+#else
+//  TALT_STATS  : operator new ,   
+namespace {
+bool accounting = false;
+std::atomic<long long> budget{ 0 };
+}
+
+MemoryUsage memoryUsage(MemoryTag) {
+    return { 0, 0 };
+}
+
+MemoryUsage totalMemoryUsage() {
+    return { 0, 0 };
+}
+
+void enableMemoryAccounting() {}
+
+bool memoryAccountingEnabled() {
+    return accounting;
+}
+
+void setMemoryBudget(long long bytes) {
+    budget = bytes;
+}
+
+long long memoryBudget() {
+    return budget.load();
+}
+
+bool memoryBudgetExceeded() {
+    return false;
+}
+#endif
+
+const char* memoryTagName(MemoryTag tag) {
+    switch (tag) {
+    case MEM_OTHER: return "other";
+    case MEM_SCANNER: return "scanner";
+    case MEM_AST: return "ast";
+    case MEM_SYMBOLS: return "symbols";
+    case MEM_DIAGNOSTICS: return "diagnostics";
+    default: return "unknown";
+    }
+}
+
+void printMemoryText(std::ostream& out) {
+    out << " ():                    \n";
+    for (int i = 0; i <= MEM_COUNT; i++) {
+        MemoryUsage usage = i < MEM_COUNT ? memoryUsage((MemoryTag)i) : totalMemoryUsage();
+        out << "  " << std::left << std::setw(16)
+            << (i < MEM_COUNT ? memoryTagName((MemoryTag)i) : "total") << std::right
+            << std::setw(14) << usage.current << std::setw(14) << usage.peak << "\n";
+    }
+}
+
+void printMemoryJson(std::ostream& out) {
+    out << "{";
+    for (int i = 0; i <= MEM_COUNT; i++) {
+        MemoryUsage usage = i < MEM_COUNT ? memoryUsage((MemoryTag)i) : totalMemoryUsage();
+        if (i > 0) out << ",";
+        out << "\"" << (i < MEM_COUNT ? memoryTagName((MemoryTag)i) : "total")
+            << "\":{\"current\":" << usage.current << ",\"peak\":" << usage.peak << "}";
+    }
+    out << "}";
+}
+
+#ifdef TALT_STATS
+//      operator new
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    release(ptr);
+}
+#endif
@@ -0,0 +1,67 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "stats.h"
+#include <ostream>
+
+// ,    .   
+// ,       operator new, 
+//  -    ,   .
+enum MemoryTag {
+    MEM_OTHER,
+    MEM_SCANNER,      //    
+    MEM_AST,          //  
+    MEM_SYMBOLS,      //     
+    MEM_DIAGNOSTICS,  //    
+
+    MEM_COUNT
+};
+
+//      . ,   
+// ,      TALT_STATS.
+class MemoryScope {
+private:
+    MemoryTag saved;
+
+public:
+    explicit MemoryScope(MemoryTag tag);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+};
+
+#ifdef TALT_STATS
+#define TALT_MEMORY_SCOPE(tag) MemoryScope TALT_CONCAT(taltMemory, __LINE__)(tag)
+#else
+#define TALT_MEMORY_SCOPE(tag) ((void)0)
+#endif
+
+// ,   operator new,    
+// 
+struct MemoryUsage {
+    long long current;
+    long long peak;
+};
+
+//  ,       :  
+// operator new    .   
+// .
+void enableMemoryAccounting();
+bool memoryAccountingEnabled();
+
+MemoryUsage memoryUsage(MemoryTag tag);
+MemoryUsage totalMemoryUsage();
+const char* memoryTagName(MemoryTag tag);
+
+//   ; 0 -  .    
+// ,   :      
+//     .
+void setMemoryBudget(long long bytes);
+long long memoryBudget();
+bool memoryBudgetExceeded();
+
+void printMemoryText(std::ostream& out);
+void printMemoryJson(std::ostream& out);
+
+#endif
@@ -0,0 +1,362 @@
+﻿#include "module.h"
+#include "context.h"
+#include "layout.h"
+#include "stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+std::string checkSettings(const CheckOptions& options) {
+    return std::string(targetAbiName(options.target)) +
+        (options.layout ? " layout" : "");
+}
+
+namespace {
+
+// Контексты проверки потока. Проверка модуля, импортированного во время
+// другой проверки, берет следующий контекст.
+thread_local std::vector<std::unique_ptr<CheckContext>> spareContexts;
+
+class ContextLease {
+private:
+    std::unique_ptr<CheckContext> context;
+
+public:
+    ContextLease() {
+        if (spareContexts.empty()) {
+            context.reset(new CheckContext());
+        }
+        else {
+            context = std::move(spareContexts.back());
+            spareContexts.pop_back();
+        }
+    }
+    ~ContextLease() { spareContexts.push_back(std::move(context)); }
+
+    ContextLease(const ContextLease&) = delete;
+    ContextLease& operator=(const ContextLease&) = delete;
+
+    CheckContext& operator*() { return *context; }
+};
+
+}
+
+void checkSource(const std::string& content, const CheckOptions& options,
+    ModuleProvider* modules, const std::string& module, CachedResult& result) {
+    ContextLease lease;
+    CheckContext& context = *lease;
+
+    ProgramNode* ast;
+    {
+        TALT_TIMER(PHASE_PARSE);
+        ast = context.parse(content, options.maxErrors);
+    }
+
+    // Ошибки выводит тот, кто показывает результат: он может быть из кэша
+    Parser& parser = context.getParser();
+    for (const auto& message : parser.errors) {
+        result.parseErrors += message;
+        result.parseErrors += '\n';
+    }
+
+    OutputWriter report(result.report);
+    if (!ast) {
+        report << "Не удалось построить AST.\n";
+        return;
+    }
+
+    SemanticAnalyzer& semantic = context.getSemantic();
+    {
+        TALT_TIMER(PHASE_SEMANTIC);
+        context.analyze(options.target, modules);
+    }
+
+    TALT_TIMER(PHASE_OUTPUT);
+    semantic.printStructTypes(report);
+    semantic.printSymbolTable(report);
+    semantic.printErrors(report);
+    semantic.printWarnings(report);
+    if (options.layout) {
+        printLayoutReport(semantic, report);
+    }
+
+    if (parser.hasError || semantic.hasErrors()) {
+        report << "\n✗ Обнаружены ошибки\n";
+    }
+    else {
+        report << "\n✓ Программа корректна\n";
+    }
+
+    result.summary = writeModuleSummary(semantic, module);
+}
+
+// Формат сводки, по строке на запись:
+//   struct <имя> <модуль> <размер> <выравнивание> <полная 0/1> <полей>
+//   <имя поля> <тип> <тип структуры или -> <смещение> <размер> <выравнивание>
+std::string writeModuleSummary(const SemanticAnalyzer& semantic, const std::string& module) {
+    std::string text;
+    OutputWriter out(text);
+    for (const StructTypeInfo* info : semantic.sortedStructTypes()) {
+        out << "struct " << info->name << ' '
+            << (info->module.empty() ? module : info->module) << ' '
+            << info->size << ' ' << info->align << ' ' << (info->complete ? 1 : 0)
+            << ' ' << (int)info->fields.size() << '\n';
+        for (const auto& field : info->fields) {
+            out << field.name << ' ' << (int)field.type << ' '
+                << (field.structTypeName.empty() ? "-" : field.structTypeName) << ' '
+                << field.offset << ' ' << field.size << ' ' << field.align << '\n';
+        }
+    }
+    out.flush();
+    return text;
+}
+
+bool readModuleSummary(const std::string& text, ModuleInterface& result) {
+    std::istringstream in(text);
+    std::string keyword;
+    while (in >> keyword) {
+        if (keyword != "struct") return false;
+        StructTypeInfo info;
+        int complete = 0, count = 0;
+        if (!(in >> info.name >> info.module >> info.size >> info.align
+            >> complete >> count)) {
+            return false;
+        }
+        info.complete = complete != 0;
+        for (int i = 0; i < count; i++) {
+            FieldInfo field;
+            int type = 0;
+            if (!(in >> field.name >> type >> field.structTypeName
+                >> field.offset >> field.size >> field.align)) {
+                return false;
+            }
+            field.type = (DataType)type;
+            if (field.structTypeName == "-") field.structTypeName.clear();
+            field.sourceOffset = 0;
+            info.fields.push_back(field);
+        }
+        result.structs.push_back(std::move(info));
+    }
+    return true;
+}
+
+std::vector<std::string> scanImports(const std::string& content) {
+    std::vector<std::string> names;
+    Scanner scanner(content.data(), content.size());
+
+    // Разбор обрывается на первом токене, который не продолжает import;
+    // ошибки в самой записи сообщит парсер при проверке модуля
+    Token token = scanner.getNextToken();
+    while (token.type == TK_IMPORT) {
+        token = scanner.getNextToken();
+        if (token.type != TK_IDENT) break;
+        std::string name = token.lexeme;
+        token = scanner.getNextToken();
+        while (token.type == TK_DOT) {
+            token = scanner.getNextToken();
+            if (token.type != TK_IDENT) return names;
+            name += "." + token.lexeme;
+            token = scanner.getNextToken();
+        }
+        if (token.type != TK_SEMICOLON) break;
+        names.push_back(name);
+        token = scanner.getNextToken();
+    }
+    return names;
+}
+
+ModuleBuilder::ModuleBuilder(const std::string& rootDir, const std::string& ext,
+    const CheckOptions& checkOptions, ResultCache* resultCache)
+    : root(rootDir), extension(ext), options(checkOptions),
+      settings(checkSettings(checkOptions)), cache(resultCache) {}
+
+std::string ModuleBuilder::directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+std::string ModuleBuilder::extensionOf(const std::string& path) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "";
+    }
+    return path.substr(dot);
+}
+
+std::string ModuleBuilder::moduleName(const std::string& path) const {
+    std::string name = path;
+    if (name.compare(0, 2, "./") == 0) name.erase(0, 2);
+    if (root != "." && name.size() > root.size() &&
+        name.compare(0, root.size(), root) == 0 &&
+        (name[root.size()] == '/' || name[root.size()] == '\\')) {
+        name.erase(0, root.size() + 1);
+    }
+    if (!extension.empty() && name.size() > extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+        name.erase(name.size() - extension.size());
+    }
+    std::replace(name.begin(), name.end(), '/', '.');
+    std::replace(name.begin(), name.end(), '\\', '.');
+    return name;
+}
+
+std::string ModuleBuilder::modulePath(const std::string& name) const {
+    std::string path = name;
+    std::replace(path.begin(), path.end(), '.', '/');
+    return root + "/" + path + extension;
+}
+
+Module* ModuleBuilder::addFile(const std::string& path) {
+    return load(moduleName(path), path);
+}
+
+Module* ModuleBuilder::load(const std::string& name, const std::string& path) {
+    auto found = modules.find(name);
+    if (found != modules.end()) {
+        Module* module = found->second.get();
+        auto cycle = std::find(loading.begin(), loading.end(), module);
+        if (cycle != loading.end()) {
+            // Модули цикла не проверяются: ни один нельзя проверить первым
+            std::string chain;
+            for (auto it = cycle; it != loading.end(); ++it) {
+                chain += (*it)->name + " -> ";
+            }
+            chain += name;
+            for (auto it = cycle; it != loading.end(); ++it) {
+                if ((*it)->error.empty()) (*it)->error = "циклический импорт: " + chain;
+            }
+        }
+        return module;
+    }
+
+    Module* module = new Module();
+    modules[name].reset(module);
+    module->name = name;
+    module->path = path;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        module->error = "файл не найден: " + path;
+        module->missing = true;
+        return module;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    module->content = buffer.str();
+
+    loading.push_back(module);
+    for (const auto& import : scanImports(module->content)) {
+        Module* dependency = load(import, modulePath(import));
+        module->imports.push_back(dependency);
+    }
+    loading.pop_back();
+
+    // Волна - длина самой длинной цепочки зависимостей
+    for (Module* dependency : module->imports) {
+        module->wave = std::max(module->wave, dependency->wave + 1);
+    }
+    return module;
+}
+
+void ModuleBuilder::check(Module& module) {
+    module.checked = true;
+    if (!module.error.empty()) return;
+
+    // Зависимость с ошибкой загрузки дает ошибку при import, ее
+    // сводка пуста
+    std::string key = settings + " " + module.name;
+    for (const Module* dependency : module.imports) {
+        char hash[24];
+        std::snprintf(hash, sizeof(hash), " %016llx",
+            (unsigned long long)dependency->interfaceHash);
+        key += hash;
+    }
+
+    uint64_t cacheKey = ResultCache::makeKey(module.content, key);
+    if (cache && cache->load(cacheKey, module.result)) {
+        module.reused = true;
+        reusedModules++;
+        TALT_COUNT(STAT_MODULES_REUSED);
+    }
+    else {
+        module.result = CachedResult();
+        checkSource(module.content, options, this, module.name, module.result);
+        if (cache) cache->store(cacheKey, module.result);
+        checkedModules++;
+        TALT_COUNT(STAT_MODULES_CHECKED);
+    }
+
+    module.interfaceHash = ResultCache::hash(module.result.summary.data(),
+        module.result.summary.size());
+    std::string().swap(module.content);
+}
+
+void ModuleBuilder::build(ThreadPool* pool) {
+    std::vector<std::vector<Module*>> byWave;
+    for (const auto& entry : modules) {
+        Module* module = entry.second.get();
+        if (module->checked) continue;
+        if ((int)byWave.size() <= module->wave) byWave.resize(module->wave + 1);
+        byWave[module->wave].push_back(module);
+    }
+
+    building = true;
+    for (auto& wave : byWave) {
+        if (wave.empty()) continue;
+        waves++;
+        if (pool && wave.size() > 1) {
+            pool->run((int)wave.size(), [&](int task, int) { check(*wave[task]); });
+        }
+        else {
+            for (Module* module : wave) check(*module);
+        }
+    }
+    building = false;
+}
+
+const ModuleInterface* ModuleBuilder::findModule(const std::string& name, std::string& why) {
+    auto found = modules.find(name);
+    Module* module = found != modules.end() ? found->second.get() : nullptr;
+
+    // Вне сборки модуль загружается и проверяется по требованию. Во время
+    // сборки зависимости уже проверены в предыдущих волнах, а менять
+    // таблицу модулей из потоков нельзя.
+    if (!module || !module->checked) {
+        if (building) {
+            why = "модуль не указан в import в начале файла";
+            return nullptr;
+        }
+        if (!module) module = load(name, modulePath(name));
+        build();
+    }
+
+    if (!module->error.empty()) {
+        why = module->error;
+        return nullptr;
+    }
+
+    std::call_once(module->interfaceOnce, [module]() {
+        readModuleSummary(module->result.summary, module->interface);
+    });
+    return &module->interface;
+}
+
+std::vector<Module*> ModuleBuilder::modulesInOrder() const {
+    std::vector<Module*> order;
+    for (const auto& entry : modules) {
+        order.push_back(entry.second.get());
+    }
+    std::sort(order.begin(), order.end(), [](const Module* a, const Module* b) {
+        return a->wave != b->wave ? a->wave < b->wave : a->name < b->name;
+    });
+    return order;
+}
+
+void ModuleBuilder::reset() {
+    modules.clear();
+    waves = 0;
+    checkedModules = 0;
+    reusedModules = 0;
+}
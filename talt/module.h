@@ -0,0 +1,111 @@
+#ifndef MODULE_H
+#define MODULE_H
+
+#include "semantic.h"
+#include "cache.h"
+#include "threadpool.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ,     
+struct CheckOptions {
+    TargetAbi target = ABI_ILP32;
+    int maxErrors = 100;
+    bool layout = false;
+};
+
+//       
+std::string checkSettings(const CheckOptions& options);
+
+//    : ,  , ,
+//   ,      import.
+//    ,    .
+void checkSource(const std::string& content, const CheckOptions& options,
+    ModuleProvider* modules, const std::string& module, CachedResult& result);
+
+//  -   ,  ,  .
+//       :   ,  
+// ,    ,     .
+std::string writeModuleSummary(const SemanticAnalyzer& semantic, const std::string& module);
+bool readModuleSummary(const std::string& text, ModuleInterface& result);
+
+//   import   ,   
+std::vector<std::string> scanImports(const std::string& content);
+
+//  :  a.b   <>/a/b<>
+struct Module {
+    std::string name;
+    std::string path;
+    std::string content;            //   
+    std::vector<Module*> imports;   //   import
+    std::string error;              //      
+    bool missing = false;           //   
+    int wave = 0;                   // 0 -   
+    bool checked = false;
+    bool reused = false;            //    
+    CachedResult result;
+    uint64_t interfaceHash = 0;
+
+    ModuleInterface interface;      //      import
+    std::once_flag interfaceOnce;
+};
+
+//    .     import 
+//  ,    :   
+//           .
+//
+//        .  
+//   ,     ,  
+//    .
+class ModuleBuilder : public ModuleProvider {
+public:
+    // cache   nullptr;      
+    ModuleBuilder(const std::string& root, const std::string& extension,
+        const CheckOptions& options, ResultCache* cache = nullptr);
+
+    //      -    
+    static std::string directoryOf(const std::string& path);
+    static std::string extensionOf(const std::string& path);
+
+    //      
+    Module* addFile(const std::string& path);
+
+    //   ,     
+    void build(ThreadPool* pool = nullptr);
+
+    const ModuleInterface* findModule(const std::string& name, std::string& why) override;
+
+    //    ,   -  
+    std::vector<Module*> modulesInOrder() const;
+    int waveCount() const { return waves; }
+    int checkedCount() const { return checkedModules; }
+    int reusedCount() const { return reusedModules; }
+
+    //  :    
+    void reset();
+
+private:
+    std::string root;
+    std::string extension;
+    CheckOptions options;
+    std::string settings;
+    ResultCache* cache;
+
+    std::unordered_map<std::string, std::unique_ptr<Module>> modules;
+    std::vector<Module*> loading;  //   ,  
+    bool building = false;
+    int waves = 0;
+    std::atomic<int> checkedModules{ 0 };
+    std::atomic<int> reusedModules{ 0 };
+
+    std::string moduleName(const std::string& path) const;
+    std::string modulePath(const std::string& name) const;
+    Module* load(const std::string& name, const std::string& path);
+    void check(Module& module);
+};
+
+#endif
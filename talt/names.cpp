@@ -0,0 +1,32 @@
+#include "names.h"
+
+NameTable::NameTable() {
+    static const std::string empty;
+    names.push_back(&empty);
+}
+
+NameId NameTable::intern(const std::string& name) {
+    if (name.empty()) {
+        return NO_NAME;
+    }
+
+    // emplace    ,   
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    it = ids.emplace(name, (NameId)names.size()).first;
+    names.push_back(&it->first);
+    return it->second;
+}
+
+void NameTable::clear() {
+    ids.clear();
+    names.resize(1);
+}
+
+NameId NameTable::find(const std::string& name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : NO_NAME;
+}
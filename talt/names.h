@@ -0,0 +1,36 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+//   .    
+// ,      .
+typedef uint32_t NameId;
+const NameId NO_NAME = 0;  //  
+
+class NameTable {
+private:
+    std::unordered_map<std::string, NameId> ids;
+    std::vector<const std::string*> names;  //    ids
+
+public:
+    NameTable();
+
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    //  ,     
+    NameId intern(const std::string& name);
+    //    NO_NAME,      
+    NameId find(const std::string& name) const;
+
+    const std::string& str(NameId id) const { return *names[id]; }
+    size_t size() const { return names.size(); }
+    //   ;     
+    void clear();
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include "output.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#define TALT_WRITE _write
+#else
+#include <unistd.h>
+#define TALT_WRITE ::write
+#endif
+
+//   cp1251 -> Unicode
+static const unsigned short cp1251Table[128] = {
+    0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+    0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+    0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+    0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+    0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+    0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F
+};
+
+static const std::string& indentSpaces() {
+    static const std::string spaces(256, ' ');
+    return spaces;
+}
+
+OutputWriter::OutputWriter(int fileDescriptor)
+    : fd(fileDescriptor), target(nullptr), buffer(new char[BUFFER_SIZE]), used(0),
+    failed(false) {}
+
+OutputWriter::OutputWriter(std::string& str)
+    : fd(-1), target(&str), buffer(new char[BUFFER_SIZE]), used(0), failed(false) {}
+
+OutputWriter::~OutputWriter() {
+    flush();
+    delete[] buffer;
+}
+
+void OutputWriter::write(const char* data, size_t size) {
+    while (size > 0) {
+        if (used == BUFFER_SIZE) flush();
+
+        size_t chunk = BUFFER_SIZE - used;
+        if (chunk > size) chunk = size;
+        std::memcpy(buffer + used, data, chunk);
+        used += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void OutputWriter::flush() {
+    if (target) {
+        target->append(buffer, used);
+        used = 0;
+        return;
+    }
+
+    // ,      std::cout,   
+    std::cout.flush();
+
+    //   write       
+    size_t offset = 0;
+    while (offset < used && !failed) {
+        auto written = TALT_WRITE(fd, buffer + offset, (unsigned)(used - offset));
+        if (written > 0) {
+            offset += (size_t)written;
+        }
+        else if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            failed = true;
+            std::cerr << "  : "
+                << (written < 0 ? std::strerror(errno) : "  ") << std::endl;
+        }
+    }
+    used = 0;
+}
+
+OutputWriter& OutputWriter::operator<<(const char* str) {
+    write(str, std::strlen(str));
+    return *this;
+}
+
+void OutputWriter::writeUnsigned(unsigned long long value, bool negative) {
+    char digits[24];
+    int pos = sizeof(digits);
+    do {
+        digits[--pos] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    if (negative) digits[--pos] = '-';
+    write(digits + pos, sizeof(digits) - pos);
+}
+
+OutputWriter& OutputWriter::operator<<(int value) {
+    return *this << (long long)value;
+}
+
+OutputWriter& OutputWriter::operator<<(long value) {
+    return *this << (long long)value;
+}
+
+OutputWriter& OutputWriter::operator<<(long long value) {
+    if (value < 0) {
+        writeUnsigned(0ULL - (unsigned long long)value, true);
+    }
+    else {
+        writeUnsigned((unsigned long long)value, false);
+    }
+    return *this;
+}
+
+OutputWriter& OutputWriter::operator<<(unsigned value) {
+    writeUnsigned(value, false);
+    return *this;
+}
+
+OutputWriter& OutputWriter::operator<<(unsigned long value) {
+    writeUnsigned(value, false);
+    return *this;
+}
+
+OutputWriter& OutputWriter::operator<<(unsigned long long value) {
+    writeUnsigned(value, false);
+    return *this;
+}
+
+OutputWriter& OutputWriter::indent(int count) {
+    const std::string& spaces = indentSpaces();
+    while (count > 0) {
+        int chunk = count < (int)spaces.size() ? count : (int)spaces.size();
+        write(spaces.data(), chunk);
+        count -= chunk;
+    }
+    return *this;
+}
+
+OutputWriter& OutputWriter::jsonString(const std::string& str) {
+    static const char hex[] = "0123456789abcdef";
+
+    put('"');
+    for (unsigned char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            put('\\');
+            put((char)ch);
+        }
+        else if (ch == '\n') {
+            write("\\n", 2);
+        }
+        else if (ch == '\t') {
+            write("\\t", 2);
+        }
+        else if (ch < 0x20 || ch >= 0x80) {
+            unsigned code = ch < 0x80 ? ch : cp1251Table[ch - 0x80];
+            char escape[6] = { '\\', 'u',
+                hex[(code >> 12) & 0xF], hex[(code >> 8) & 0xF],
+                hex[(code >> 4) & 0xF], hex[code & 0xF] };
+            write(escape, 6);
+        }
+        else {
+            put((char)ch);
+        }
+    }
+    put('"');
+    return *this;
+}
+
+//   UTF-8,   str[i]; 0 - 
+static size_t utf8Length(const std::string& str, size_t i) {
+    unsigned char lead = (unsigned char)str[i];
+    size_t length = lead >= 0xC2 && lead <= 0xDF ? 2 :
+        lead >= 0xE0 && lead <= 0xEF ? 3 : lead >= 0xF0 && lead <= 0xF4 ? 4 : 0;
+    if (length == 0 || i + length > str.size()) return 0;
+    for (size_t k = 1; k < length; k++) {
+        if (((unsigned char)str[i + k] & 0xC0) != 0x80) return 0;
+    }
+    //     ,     U+10FFFF
+    unsigned char next = (unsigned char)str[i + 1];
+    if ((lead == 0xE0 && next < 0xA0) || (lead == 0xED && next > 0x9F) ||
+        (lead == 0xF0 && next < 0x90) || (lead == 0xF4 && next > 0x8F)) {
+        return 0;
+    }
+    return length;
+}
+
+OutputWriter& OutputWriter::jsonBytes(const std::string& str) {
+    static const char hex[] = "0123456789abcdef";
+
+    put('"');
+    for (size_t i = 0; i < str.size(); i++) {
+        unsigned char ch = (unsigned char)str[i];
+        size_t length = ch >= 0x80 ? utf8Length(str, i) : 1;
+        if (length > 1) {
+            write(str.data() + i, length);
+            i += length - 1;
+        }
+        else if (ch == '"' || ch == '\\') {
+            put('\\');
+            put((char)ch);
+        }
+        else if (ch < 0x20 || ch >= 0x80) {
+            char escape[6] = { '\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF] };
+            write(escape, 6);
+        }
+        else {
+            put((char)ch);
+        }
+    }
+    put('"');
+    return *this;
+}
@@ -0,0 +1,68 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <string>
+#include <cstddef>
+
+//  .      
+//    write()   ,  flush 
+//  ,   std::endl.
+class OutputWriter {
+private:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    int fd;
+    std::string* target;  //     
+    char* buffer;
+    size_t used;
+    bool failed;  //   fd  ,   
+
+    void writeUnsigned(unsigned long long value, bool negative);
+
+public:
+    explicit OutputWriter(int fileDescriptor = 1);
+    explicit OutputWriter(std::string& str);
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    void write(const char* data, size_t size);
+    void put(char ch) {
+        if (used == BUFFER_SIZE) flush();
+        buffer[used++] = ch;
+    }
+    //     stderr  ,  good() == false
+    void flush();
+    bool good() const { return !failed; }
+
+    OutputWriter& operator<<(const std::string& str) {
+        write(str.data(), str.size());
+        return *this;
+    }
+    OutputWriter& operator<<(const char* str);
+    OutputWriter& operator<<(char ch) {
+        put(ch);
+        return *this;
+    }
+    OutputWriter& operator<<(int value);
+    OutputWriter& operator<<(long value);
+    OutputWriter& operator<<(long long value);
+    OutputWriter& operator<<(unsigned value);
+    OutputWriter& operator<<(unsigned long value);
+    OutputWriter& operator<<(unsigned long long value);
+
+    //     
+    OutputWriter& indent(int count);
+
+    //  JSON  .     
+    // cp1251 (  ),   ASCII 
+    //  \uXXXX,     UTF-8.
+    OutputWriter& jsonString(const std::string& str);
+    //  JSON      ,   .
+    //   UTF-8   , 
+    //  -  \u00XX.
+    OutputWriter& jsonBytes(const std::string& str);
+};
+
+#endif
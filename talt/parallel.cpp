@@ -0,0 +1,178 @@
+#include "parallel.h"
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+//      :   
+// ,      
+thread_local bool insideParallel = false;
+
+union Value {
+    int64_t i;
+    float f;
+};
+
+char* locate(const ExecAddress& address, const ExecContext& context) {
+    return (address.global ? context.globals : context.frame) + address.offset;
+}
+
+Value load(const char* p, ExecType type) {
+    Value v;
+    switch (type) {
+    case EXT_I16: { int16_t x; std::memcpy(&x, p, 2); v.i = x; break; }
+    case EXT_I32: { int32_t x; std::memcpy(&x, p, 4); v.i = x; break; }
+    case EXT_I64: std::memcpy(&v.i, p, 8); break;
+    default: std::memcpy(&v.f, p, 4); break;
+    }
+    return v;
+}
+
+void store(char* p, ExecType type, Value v) {
+    switch (type) {
+    case EXT_I16: { int16_t x = (int16_t)v.i; std::memcpy(p, &x, 2); break; }
+    case EXT_I32: { int32_t x = (int32_t)v.i; std::memcpy(p, &x, 4); break; }
+    case EXT_I64: std::memcpy(p, &v.i, 8); break;
+    default: std::memcpy(p, &v.f, 4); break;
+    }
+}
+
+Value identity(const ExecReduction& reduction) {
+    Value v;
+    if (reduction.type == EXT_F32) {
+        v.f = reduction.op == TK_MUL ? 1.0f : 0.0f;
+    }
+    else {
+        v.i = reduction.op == TK_MUL ? 1 : reduction.op == TK_BIT_AND ? -1 : 0;
+    }
+    return v;
+}
+
+//   ,   :    2^n
+Value combine(const ExecReduction& reduction, Value a, Value b) {
+    Value v;
+    if (reduction.type == EXT_F32) {
+        v.f = reduction.op == TK_MUL ? a.f * b.f : a.f + b.f;
+        return v;
+    }
+    uint64_t x = (uint64_t)a.i, y = (uint64_t)b.i, r;
+    switch (reduction.op) {
+    case TK_MUL: r = x * y; break;
+    case TK_BIT_AND: r = x & y; break;
+    case TK_BIT_OR: r = x | y; break;
+    case TK_BIT_XOR: r = x ^ y; break;
+    default: r = x + y; break;
+    }
+    switch (reduction.type) {
+    case EXT_I16: v.i = (int16_t)r; break;
+    case EXT_I32: v.i = (int32_t)r; break;
+    default: v.i = (int64_t)r; break;
+    }
+    return v;
+}
+
+struct WorkerState {
+    std::vector<int64_t> frame;
+    std::vector<int64_t> globals;
+    ExecContext context;
+    bool started = false;
+};
+
+}
+
+ParallelRuntime::ParallelRuntime(const ExecProgram& prog, ThreadPool& threads,
+    Executor executor, bool ordered)
+    : program(prog), pool(threads), execute(executor), deterministic(ordered) {}
+
+bool ParallelRuntime::runLoop(int index, ExecContext& context) {
+    if (insideParallel) return false;
+    const ExecParallelLoop& loop = program.parallelLoops[index];
+
+    //     64 ;   
+    //     int,   
+    int64_t start = load(locate(loop.induction, context), EXT_I32).i;
+    int64_t bound = loop.bound->op == EX_CONST ? (int32_t)loop.bound->intValue
+        : load(locate(loop.bound->address, context), EXT_I32).i;
+    if (loop.compare == TK_LE) bound++;
+    int64_t trips = bound > start ? (bound - start + loop.step - 1) / loop.step : 0;
+    int64_t last = start + trips * loop.step;
+    if (last > INT32_MAX) return false;
+    if (trips == 0) return true;
+
+    int64_t chunks = deterministic ? PARALLEL_DETERMINISTIC_CHUNKS
+        : (int64_t)pool.size() * PARALLEL_CHUNKS_PER_THREAD;
+    if (chunks > trips) chunks = trips;
+
+    size_t reductionCount = loop.reductions.size();
+    std::vector<WorkerState> workers(pool.size());
+    std::vector<Value> partials(deterministic ? chunks * reductionCount : 0);
+    std::atomic<int> status(EXEC_OK);
+
+    pool.run((int)chunks, [&](int chunk, int worker) {
+        insideParallel = true;
+        WorkerState& state = workers[worker];
+        if (!state.started) {
+            state.frame.assign(loop.chunk.frameSize / 8 + 1, 0);
+            std::memcpy(state.frame.data(), context.frame, loop.chunk.frameSize);
+            state.globals.assign(program.globalSize / 8 + 1, 0);
+            std::memcpy(state.globals.data(), context.globals, program.globalSize);
+            state.context.frame = (char*)state.frame.data();
+            state.context.globals = (char*)state.globals.data();
+            state.context.parallel = this;
+        }
+        if (!state.started || deterministic) {
+            for (const auto& reduction : loop.reductions) {
+                store(locate(reduction.address, state.context), reduction.type,
+                    identity(reduction));
+            }
+        }
+        state.started = true;
+
+        Value first, end;
+        first.i = start + trips * chunk / chunks * loop.step;
+        end.i = start + trips * (chunk + 1) / chunks * loop.step;
+        store(locate(loop.induction, state.context), EXT_I32, first);
+        store(locate(loop.chunkEnd, state.context), EXT_I32, end);
+
+        execute(loop.chunk, state.context);
+        if (state.context.status != EXEC_OK) status = state.context.status;
+
+        if (deterministic) {
+            for (size_t k = 0; k < reductionCount; k++) {
+                const ExecReduction& reduction = loop.reductions[k];
+                partials[chunk * reductionCount + k] =
+                    load(locate(reduction.address, state.context), reduction.type);
+            }
+        }
+        insideParallel = false;
+    });
+
+    for (size_t k = 0; k < reductionCount; k++) {
+        const ExecReduction& reduction = loop.reductions[k];
+        char* target = locate(reduction.address, context);
+        Value value = load(target, reduction.type);
+        if (deterministic) {
+            for (int64_t chunk = 0; chunk < chunks; chunk++) {
+                value = combine(reduction, value, partials[chunk * reductionCount + k]);
+            }
+        }
+        else {
+            for (const auto& state : workers) {
+                if (!state.started) continue;
+                value = combine(reduction, value,
+                    load(locate(reduction.address, state.context), reduction.type));
+            }
+        }
+        store(target, reduction.type, value);
+    }
+
+    Value after;
+    after.i = last;
+    store(locate(loop.induction, context), EXT_I32, after);
+    if (status != EXEC_OK) context.status = status;
+    return true;
+}
+
+int runParallelLoop(ExecContext* context, int index) {
+    return context->parallel && context->parallel->runLoop(index, *context) ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "lower.h"
+#include "threadpool.h"
+#include <functional>
+
+//     --deterministic:    
+const int PARALLEL_CHUNKS_PER_THREAD = 4;
+//   --deterministic:     
+const int PARALLEL_DETERMINISTIC_CHUNKS = 64;
+
+//    ExecProgram   .
+//        ,   
+//         
+//  .
+//
+//  deterministic     ,  
+//  float   ,     .
+//  deterministic   ,  
+//         : 
+//         .
+class ParallelRuntime {
+public:
+    typedef std::function<void(const ExecFunction&, ExecContext&)> Executor;
+
+    ParallelRuntime(const ExecProgram& program, ThreadPool& pool,
+        Executor execute, bool deterministic);
+
+    //   (   ). false - 
+    //   :     
+    //    .
+    bool runLoop(int index, ExecContext& context);
+
+private:
+    const ExecProgram& program;
+    ThreadPool& pool;
+    Executor execute;
+    bool deterministic;
+};
+
+//      JIT;  1,   
+int runParallelLoop(ExecContext* context, int index);
+
+#endif
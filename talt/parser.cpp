@@ -1,20 +1,104 @@
 #include "parser.h"
+#include "memory.h"
+#include "visitor.h"
+#include "dataflow.h"
+#include "typerules.h"
 #include <iostream>
 #include <sstream>
 #include <cctype>
 
 // ==================== Parser Implementation ====================
 
-Parser::Parser(Scanner& sc, SemanticAnalyzer& sem)
-    : scanner(sc), semantic(sem) {
+// ,    
+static const TokenSet TYPE_START =
+    tokenBit(TK_INT) | tokenBit(TK_SHORT) | tokenBit(TK_LONG) |
+    tokenBit(TK_FLOAT) | tokenBit(TK_VOID) | tokenBit(TK_STRUCT);
+
+//  :      
+//   (SYNC_BEFORE)     
+//  (SYNC_AFTER)
+static const TokenSet DECLARATION_SYNC_BEFORE = TYPE_START;
+static const TokenSet DECLARATION_SYNC_AFTER =
+    tokenBit(TK_SEMICOLON) | tokenBit(TK_RBRACE);
+
+static const TokenSet STATEMENT_SYNC_BEFORE = TYPE_START |
+    tokenBit(TK_FOR) | tokenBit(TK_RETURN) |
+    tokenBit(TK_LBRACE) | tokenBit(TK_RBRACE);
+static const TokenSet STATEMENT_SYNC_AFTER = tokenBit(TK_SEMICOLON);
+
+static const TokenSet FIELD_SYNC_BEFORE = TYPE_START | tokenBit(TK_RBRACE);
+static const TokenSet FIELD_SYNC_AFTER = tokenBit(TK_SEMICOLON);
+
+//        
+class NestingGuard {
+private:
+    int& depth;
+
+public:
+    explicit NestingGuard(int& d) : depth(d) { depth++; }
+    ~NestingGuard() { depth--; }
+};
+
+//   ; nullptr - 
+static thread_local Arena* nodeArena = nullptr;
+
+NodeArenaScope::NodeArenaScope(Arena* arena) : saved(nodeArena) {
+    nodeArena = arena;
+}
+
+NodeArenaScope::~NodeArenaScope() {
+    nodeArena = saved;
+}
+
+void* allocateNodeMemory(size_t size) {
+    return nodeArena ? nodeArena->allocate(size) : ::operator new(size);
+}
+
+void freeNodeMemory(void* memory) {
+    if (!nodeArena) ::operator delete(memory);
+}
+
+Parser::Parser(Scanner& sc)
+    : scanner(sc), lookaheadCount(0), parseNumber(0),
+    panicMode(false), aborted(false), errorCount(0),
+    nestingDepth(0), tokensConsumed(0), importsAllowed(true) {
     currentToken = scanner.getNextToken();
     hasError = false;
 }
 
-void Parser::advance() {
+void Parser::reset() {
+    lookaheadCount = 0;
+    parseNumber++;
+    panicMode = false;
+    aborted = false;
+    errorCount = 0;
+    nestingDepth = 0;
+    tokensConsumed = 0;
+    importsAllowed = true;
+    hasError = false;
+    errors.clear();
+    diagnostics.clear();
     currentToken = scanner.getNextToken();
 }
 
+void Parser::advance() {
+    if (aborted) return;
+
+    if (lookaheadCount > 0) {
+        currentToken = lookahead[0];
+        lookahead[0] = lookahead[1];
+        lookaheadCount--;
+    }
+    else {
+        currentToken = scanner.getNextToken();
+    }
+    tokensConsumed++;
+
+    if (memoryBudgetExceeded()) {
+        stopOnMemoryBudget();
+    }
+}
+
 bool Parser::match(TokenType expected) {
     if (currentToken.type == expected) {
         advance();
@@ -27,16 +111,101 @@ bool Parser::check(TokenType expected) const {
     return currentToken.type == expected;
 }
 
-Token Parser::peekToken() {
-    return scanner.peekNextToken();
+bool Parser::checkAny(TokenSet set) const {
+    return currentToken.type >= TK_INT && currentToken.type <= TK_ERROR &&
+        (set & tokenBit(currentToken.type)) != 0;
 }
 
-void Parser::error(const std::string& message) {
+const Token& Parser::peekToken(int distance) {
+    //       ,   
+    while (lookaheadCount < distance) {
+        lookahead[lookaheadCount++] = scanner.getNextToken();
+    }
+    return lookahead[distance - 1];
+}
+
+//   :    ,    
+void Parser::stopOnMemoryBudget() {
+    TALT_MEMORY_SCOPE(MEM_DIAGNOSTICS);
+    hasError = true;
+
+    SourcePosition at = scanner.lineTable().position(currentToken.offset);
     std::stringstream ss;
-    ss << "    " << currentToken.line
-        << ":" << currentToken.column << ": " << message;
-    std::cerr << ss.str() << std::endl;
+    ss << "   " << memoryBudget() / (1024 * 1024)
+        << "    " << at.line << ",  ";
+    if (reportToStderr) std::cerr << ss.str() << std::endl;
+    errors.push_back(ss.str());
+    diagnostics.push_back({ at.line, at.column, ss.str(), false });
+
+    aborted = true;
+    lookaheadCount = 0;
+    currentToken = Token(TK_EOF, "", currentToken.offset);
+}
+
+void Parser::error(const std::string& message) {
+    TALT_MEMORY_SCOPE(MEM_DIAGNOSTICS);
     hasError = true;
+
+    //      :  
+    //  
+    if (panicMode || aborted) return;
+    panicMode = true;
+
+    SourcePosition at = scanner.lineTable().position(currentToken.offset);
+    std::stringstream ss;
+    ss << "    " << at.line
+        << ":" << at.column << ": " << message;
+    if (reportToStderr) std::cerr << ss.str() << std::endl;
+    errors.push_back(ss.str());
+    diagnostics.push_back({ at.line, at.column, message, false });
+
+    if (++errorCount >= maxErrors) {
+        std::stringstream limit;
+        limit << "   (" << errorCount << "),  ";
+        if (reportToStderr) std::cerr << limit.str() << std::endl;
+        errors.push_back(limit.str());
+        aborted = true;
+        lookaheadCount = 0;
+        currentToken = Token(TK_EOF, "", currentToken.offset);
+    }
+}
+
+void Parser::synchronize(TokenSet stopBefore, TokenSet stopAfter) {
+    //       , 
+    //     
+    while (!check(TK_EOF)) {
+        if (checkAny(stopBefore)) {
+            break;
+        }
+        if (checkAny(stopAfter)) {
+            advance();
+            break;
+        }
+        advance();
+    }
+    panicMode = false;
+}
+
+bool Parser::checkNesting() {
+    if (nestingDepth > maxNestingDepth) {
+        error("  ");
+        return false;
+    }
+    return true;
+}
+
+bool Parser::isStructTypeName(const std::string& name) const {
+    auto found = structTypeNames.find(name);
+    return found != structTypeNames.end() && found->second == parseNumber;
+}
+
+bool Parser::isTypeStart() {
+    if (checkAny(TYPE_START)) {
+        return true;
+    }
+
+    //       : Point p;
+    return check(TK_IDENT) && peekToken().type == TK_IDENT;
 }
 
 DataType Parser::parseType(std::string* structTypeName) {
@@ -71,8 +240,9 @@ DataType Parser::parseType(std::string* structTypeName) {
         }
     }
     else if (check(TK_IDENT)) {
-        // ,      
-        if (semantic.findStructType(currentToken.lexeme)) {
+        //    struct.     ,
+        //     :   
+        if (isStructTypeName(currentToken.lexeme) || peekToken().type == TK_IDENT) {
             type = TYPE_STRUCT;
             if (structTypeName) {
                 *structTypeName = currentToken.lexeme;
@@ -88,6 +258,7 @@ DataType Parser::parseType(std::string* structTypeName) {
     return type;
 }
 std::unique_ptr<ProgramNode> Parser::parse() {
+    TALT_MEMORY_SCOPE(MEM_AST);
     auto program = parseProgram();
 
     if (!match(TK_EOF)) {
@@ -98,58 +269,113 @@ std::unique_ptr<ProgramNode> Parser::parse() {
 }
 std::unique_ptr<ProgramNode> Parser::parseProgram() {
     auto program = std::make_unique<ProgramNode>();
-    program->line = currentToken.line;
-    program->column = currentToken.column;
+    program->offset = currentToken.offset;
 
-    semantic.enterScope();
 
+    while (auto decl = parseNext()) {
+        program->declarations.push_back(std::move(decl));
+    }
+
+    return program;
+}
+
+std::unique_ptr<ASTNode> Parser::parseNext() {
+    TALT_MEMORY_SCOPE(MEM_AST);
     while (!check(TK_EOF)) {
+        unsigned long long consumedBefore = tokensConsumed;
+
         auto decl = parseDeclaration();
         if (decl) {
-            program->declarations.push_back(std::move(decl));
+            panicMode = false;
+            return decl;
         }
-        else {
-            if (!check(TK_EOF)) {
-                advance();
-            }
+
+        synchronize(DECLARATION_SYNC_BEFORE, DECLARATION_SYNC_AFTER);
+        if (tokensConsumed == consumedBefore && !check(TK_EOF)) {
+            advance();
         }
     }
+    return nullptr;
+}
 
-    semantic.leaveScope();
-    return program;
+void Parser::discardMessages() {
+    std::vector<std::string>().swap(errors);
+    std::vector<Diagnostic>().swap(diagnostics);
 }
 
 std::unique_ptr<ASTNode> Parser::parseDeclaration() {
-    //     
-    std::streampos savedPos = scanner.getPosition();
-    Token savedToken = currentToken;
+    if (check(TK_IMPORT)) {
+        if (!importsAllowed) {
+            error("import     ,  ");
+            return nullptr;
+        }
+        return parseImport();
+    }
+    importsAllowed = false;
+
+    // struct  { ... };
+    if (check(TK_STRUCT) && peekToken(2).type == TK_LBRACE) {
+        return parseStructDeclaration();
+    }
+
+    if (!isTypeStart()) {
+        return parseStatement();
+    }
 
-    //   
     std::string structTypeName;
     DataType type = parseType(&structTypeName);
 
     if (type == TYPE_UNDEFINED) {
-        //   -     
-        scanner.setPosition(savedPos);
-        currentToken = savedToken;
-        return parseStatement();
+        error(" ");
+        return nullptr;
     }
 
-    //    
     if (!check(TK_IDENT)) {
-        //   -     
-        scanner.setPosition(savedPos);
-        currentToken = savedToken;
-        return parseStatement();
+        error("   ");
+        return nullptr;
+    }
+
+    // ,    '(' -  
+    if (peekToken().type == TK_LPAREN) {
+        return parseFunctionDeclaration(type, structTypeName);
     }
 
-    //      -   
     return parseVariableDeclaration(type, structTypeName);
 }
+std::unique_ptr<ImportNode> Parser::parseImport() {
+    auto import = std::make_unique<ImportNode>();
+    import->offset = currentToken.offset;
+
+    match(TK_IMPORT); //  'import'
+
+    //  :   
+    if (!check(TK_IDENT)) {
+        error("    import");
+        return nullptr;
+    }
+    import->module = currentToken.lexeme;
+    advance();
+
+    while (match(TK_DOT)) {
+        if (!check(TK_IDENT)) {
+            error("    '.'");
+            return nullptr;
+        }
+        import->module += "." + currentToken.lexeme;
+        advance();
+    }
+
+    if (!match(TK_SEMICOLON)) {
+        error(" ';'   ");
+        return nullptr;
+    }
+
+    return import;
+}
+
 std::unique_ptr<StructDeclNode> Parser::parseStructDeclaration() {
     auto structDecl = std::make_unique<StructDeclNode>();
-    structDecl->line = currentToken.line;
-    structDecl->column = currentToken.column;
+    structDecl->offset = currentToken.offset;
 
     match(TK_STRUCT); //  'struct'
 
@@ -159,6 +385,7 @@ std::unique_ptr<StructDeclNode> Parser::parseStructDeclaration() {
     }
 
     structDecl->name = currentToken.lexeme;
+    structTypeNames[structDecl->name] = parseNumber;
     advance(); //   
 
     if (!match(TK_LBRACE)) {
@@ -166,52 +393,48 @@ std::unique_ptr<StructDeclNode> Parser::parseStructDeclaration() {
         return nullptr;
     }
 
-    //       
-    semantic.enterScope();
 
     while (!check(TK_RBRACE) && !check(TK_EOF)) {
+        unsigned long long consumedBefore = tokensConsumed;
+
         //   
         std::string fieldStructType;
         DataType fieldType = parseType(&fieldStructType);
 
         if (fieldType == TYPE_UNDEFINED) {
             error("   ");
-            semantic.leaveScope();
-            return nullptr;
         }
-
-        if (!check(TK_IDENT)) {
+        else if (!check(TK_IDENT)) {
             error("   ");
-            semantic.leaveScope();
-            return nullptr;
         }
+        else {
+            std::string fieldName = currentToken.lexeme;
+            SourceOffset fieldOffset = currentToken.offset;
+            advance();
 
-        std::string fieldName = currentToken.lexeme;
-        advance();
-
-        if (!match(TK_SEMICOLON)) {
+            if (match(TK_SEMICOLON)) {
+                //    ;    
+                //   
+                structDecl->fields.push_back(FieldInfo(fieldName, fieldType, fieldStructType));
+                structDecl->fields.back().sourceOffset = fieldOffset;
+                panicMode = false;
+                continue;
+            }
             error(" ';'   ");
-            semantic.leaveScope();
-            return nullptr;
         }
 
-        //    
-        structDecl->fields.push_back({ fieldName, fieldType });
-
-        //     
-        semantic.addFieldToStruct(structDecl->name, fieldName, fieldType, fieldStructType,
-            currentToken.line, currentToken.column);
+        //   :      
+        synchronize(FIELD_SYNC_BEFORE, FIELD_SYNC_AFTER);
+        if (tokensConsumed == consumedBefore && !check(TK_RBRACE) && !check(TK_EOF)) {
+            advance();
+        }
     }
 
     if (!match(TK_RBRACE)) {
         error(" '}'    ");
-        semantic.leaveScope();
         return nullptr;
     }
 
-    //     
-    semantic.leaveScope();
-
     if (!match(TK_SEMICOLON)) {
         error(" ';'   ");
         return nullptr;
@@ -219,11 +442,12 @@ std::unique_ptr<StructDeclNode> Parser::parseStructDeclaration() {
 
     return structDecl;
 }
-std::unique_ptr<FunctionNode> Parser::parseFunctionDeclaration(DataType returnType) {
+std::unique_ptr<FunctionNode> Parser::parseFunctionDeclaration(DataType returnType,
+    const std::string& returnStructName) {
     auto funcDecl = std::make_unique<FunctionNode>();
-    funcDecl->line = currentToken.line;
-    funcDecl->column = currentToken.column;
+    funcDecl->offset = currentToken.offset;
     funcDecl->returnType = returnType;
+    funcDecl->returnStructName = returnStructName;
 
     if (!check(TK_IDENT)) {
         error("  ");
@@ -238,37 +462,58 @@ std::unique_ptr<FunctionNode> Parser::parseFunctionDeclaration(DataType returnTy
         return nullptr;
     }
 
+    // :     
+    if (!check(TK_RPAREN)) {
+        do {
+            std::string paramStructType;
+            DataType paramType = parseType(&paramStructType);
+            if (paramType == TYPE_UNDEFINED) {
+                error("  ");
+                return nullptr;
+            }
+            //    :   
+            //    .  , 
+            //      
+            if (paramType == TYPE_STRUCT) {
+                error("-  :    ");
+                panicMode = false;
+            }
+            if (!check(TK_IDENT)) {
+                error("  ");
+                return nullptr;
+            }
+            funcDecl->params.push_back(ParamInfo(currentToken.lexeme, paramType,
+                paramStructType, currentToken.offset));
+            advance();
+        } while (match(TK_COMMA));
+    }
+
     if (!match(TK_RPAREN)) {
         error(" ')'   ");
         return nullptr;
     }
 
     //  
-    semantic.enterScope(); //     
 
     if (!check(TK_LBRACE)) {
         error(" '{'   ");
-        semantic.leaveScope();
         return nullptr;
     }
 
     auto body = parseBlock();
     if (!body) {
         error("  ");
-        semantic.leaveScope();
         return nullptr;
     }
 
     funcDecl->body = std::move(body);
-    semantic.leaveScope();
 
     return funcDecl;
 }
 
 std::unique_ptr<VarDeclNode> Parser::parseVariableDeclaration(DataType type, const std::string& structTypeName) {
     auto varDecl = std::make_unique<VarDeclNode>();
-    varDecl->line = currentToken.line;
-    varDecl->column = currentToken.column;
+    varDecl->offset = currentToken.offset;
     varDecl->type = type;
     varDecl->structName = structTypeName;
 
@@ -297,22 +542,18 @@ std::unique_ptr<VarDeclNode> Parser::parseVariableDeclaration(DataType type, con
 }
 
 std::unique_ptr<ASTNode> Parser::parseStatement() {
-    //     
-    std::streampos savedPos = scanner.getPosition();
-    Token savedToken = currentToken;
-
-    std::string structTypeName;
-    DataType type = parseType(&structTypeName);
+    //       
+    if (isTypeStart()) {
+        std::string structTypeName;
+        DataType type = parseType(&structTypeName);
 
-    if (type != TYPE_UNDEFINED && check(TK_IDENT)) {
-        //   
+        if (type == TYPE_UNDEFINED || !check(TK_IDENT)) {
+            error("  ");
+            return nullptr;
+        }
         return parseVariableDeclaration(type, structTypeName);
     }
 
-    //   - 
-    scanner.setPosition(savedPos);
-    currentToken = savedToken;
-
     //    
     if (check(TK_FOR)) {
         return parseForLoop();
@@ -341,9 +582,14 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
 }
 
 std::unique_ptr<ForLoopNode> Parser::parseForLoop() {
+    NestingGuard guard(nestingDepth);
+    if (!checkNesting()) {
+        return nullptr;
+    }
+
     auto forLoop = std::make_unique<ForLoopNode>();
-    forLoop->line = currentToken.line;
-    forLoop->column = currentToken.column;
+    forLoop->offset = currentToken.offset;
+    forLoop->parallel = currentToken.parallel;
 
     match(TK_FOR); //  'for'
 
@@ -352,42 +598,32 @@ std::unique_ptr<ForLoopNode> Parser::parseForLoop() {
         return nullptr;
     }
 
-    //       
-    semantic.enterScope();
 
     // 
     if (check(TK_SEMICOLON)) {
         match(TK_SEMICOLON);
     }
-    else {
-        //     
-        std::streampos savedPos = scanner.getPosition();
-        Token savedToken = currentToken;
-
+    else if (isTypeStart()) {
+        //   
         std::string structTypeName;
         DataType type = parseType(&structTypeName);
 
-        if (type != TYPE_UNDEFINED && check(TK_IDENT)) {
-            //   
-            auto varDecl = parseVariableDeclaration(type, structTypeName);
-            if (varDecl) {
-                forLoop->init = std::move(varDecl);
-            }
-            else {
-                semantic.leaveScope();
-                return nullptr;
-            }
+        auto varDecl = type != TYPE_UNDEFINED && check(TK_IDENT)
+            ? parseVariableDeclaration(type, structTypeName) : nullptr;
+        if (varDecl) {
+            forLoop->init = std::move(varDecl);
         }
         else {
-            //  
-            scanner.setPosition(savedPos);
-            currentToken = savedToken;
-            forLoop->init = parseExpression();
-            if (!match(TK_SEMICOLON)) {
-                error(" ';'   for");
-                semantic.leaveScope();
-                return nullptr;
-            }
+            error("   ");
+            return nullptr;
+        }
+    }
+    else {
+        //  
+        forLoop->init = parseExpression();
+        if (!match(TK_SEMICOLON)) {
+            error(" ';'   for");
+            return nullptr;
         }
     }
 
@@ -398,7 +634,6 @@ std::unique_ptr<ForLoopNode> Parser::parseForLoop() {
         forLoop->condition = parseExpression();
         if (!match(TK_SEMICOLON)) {
             error(" ';'   for");
-            semantic.leaveScope();
             return nullptr;
         }
     }
@@ -410,7 +645,6 @@ std::unique_ptr<ForLoopNode> Parser::parseForLoop() {
         forLoop->increment = parseExpression();
         if (!match(TK_RPAREN)) {
             error(" ')'   for");
-            semantic.leaveScope();
             return nullptr;
         }
     }
@@ -419,17 +653,14 @@ std::unique_ptr<ForLoopNode> Parser::parseForLoop() {
     forLoop->body = parseStatement();
     if (!forLoop->body) {
         error("   for");
-        semantic.leaveScope();
         return nullptr;
     }
 
-    semantic.leaveScope();
     return forLoop;
 }
 std::unique_ptr<ReturnNode> Parser::parseReturnStatement() {
     auto returnNode = std::make_unique<ReturnNode>();
-    returnNode->line = currentToken.line;
-    returnNode->column = currentToken.column;
+    returnNode->offset = currentToken.offset;
 
     match(TK_RETURN);
 
@@ -450,58 +681,76 @@ std::unique_ptr<ReturnNode> Parser::parseReturnStatement() {
 }
 
 std::unique_ptr<BlockNode> Parser::parseBlock() {
+    NestingGuard guard(nestingDepth);
+    if (!checkNesting()) {
+        //     ,   '}'
+        int depth = 0;
+        while (!check(TK_EOF)) {
+            if (check(TK_LBRACE)) depth++;
+            else if (check(TK_RBRACE) && --depth == 0) {
+                advance();
+                break;
+            }
+            advance();
+        }
+        return nullptr;
+    }
+
     auto block = std::make_unique<BlockNode>();
-    block->line = currentToken.line;
-    block->column = currentToken.column;
+    block->offset = currentToken.offset;
 
     match(TK_LBRACE);
 
-    semantic.enterScope(); //   
 
     while (!check(TK_RBRACE) && !check(TK_EOF)) {
+        unsigned long long consumedBefore = tokensConsumed;
+
         auto stmt = parseStatement();
         if (stmt) {
             block->statements.push_back(std::move(stmt));
+            panicMode = false;
         }
         else {
             //     
-            while (!check(TK_RBRACE) && !check(TK_EOF) &&
-                !check(TK_SEMICOLON) && !check(TK_LBRACE) &&
-                !check(TK_FOR) && !check(TK_RETURN)) {
+            synchronize(STATEMENT_SYNC_BEFORE, STATEMENT_SYNC_AFTER);
+            if (tokensConsumed == consumedBefore &&
+                !check(TK_RBRACE) && !check(TK_EOF)) {
                 advance();
             }
-
-            if (check(TK_SEMICOLON)) {
-                advance(); //   ;
-            }
         }
     }
 
     if (!match(TK_RBRACE)) {
         error(" '}'");
-        semantic.leaveScope();
         return nullptr;
     }
 
-    semantic.leaveScope(); //    
 
     return block;
 }
 
 std::unique_ptr<ASTNode> Parser::parseExpression() {
+    NestingGuard guard(nestingDepth);
+    if (!checkNesting()) {
+        return nullptr;
+    }
+
     //   
     auto left = parseLogicalOr();
 
     // ,    
     if (match(TK_ASSIGN)) {
         auto assign = std::make_unique<AssignNode>();
-        assign->line = currentToken.line;
-        assign->column = currentToken.column;
+        assign->offset = currentToken.offset;
 
         // ,     
-        if (auto varNode = dynamic_cast<VarNode*>(left.get())) {
+        if (auto varNode = nodeCast<VarNode>(left.get())) {
             assign->varName = varNode->name;
             assign->fieldName = varNode->fieldName;
+            assign->nameOffset = varNode->nameOffset;
+            if (!varNode->fieldName.empty()) {
+                assign->fieldOffset = varNode->offset;
+            }
         }
         else {
             error("     ");
@@ -525,8 +774,7 @@ std::unique_ptr<ASTNode> Parser::parseLogicalOr() {
 
     while (check(TK_BIT_OR)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -542,8 +790,7 @@ std::unique_ptr<ASTNode> Parser::parseLogicalAnd() {
 
     while (check(TK_BIT_AND)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -559,8 +806,7 @@ std::unique_ptr<ASTNode> Parser::parseBitwiseOr() {
 
     while (check(TK_BIT_OR)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -576,8 +822,7 @@ std::unique_ptr<ASTNode> Parser::parseBitwiseXor() {
 
     while (check(TK_BIT_XOR)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -593,8 +838,7 @@ std::unique_ptr<ASTNode> Parser::parseBitwiseAnd() {
 
     while (check(TK_BIT_AND)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -610,8 +854,7 @@ std::unique_ptr<ASTNode> Parser::parseEquality() {
 
     while (check(TK_EQ) || check(TK_NE)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -627,8 +870,7 @@ std::unique_ptr<ASTNode> Parser::parseRelational() {
 
     while (check(TK_LT) || check(TK_LE) || check(TK_GT) || check(TK_GE)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -644,8 +886,7 @@ std::unique_ptr<ASTNode> Parser::parseShift() {
 
     while (check(TK_SHL) || check(TK_SHR)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -661,8 +902,7 @@ std::unique_ptr<ASTNode> Parser::parseAdditive() {
 
     while (check(TK_PLUS) || check(TK_MINUS)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -678,8 +918,7 @@ std::unique_ptr<ASTNode> Parser::parseMultiplicative() {
 
     while (check(TK_MUL) || check(TK_DIV) || check(TK_MOD)) {
         auto opNode = std::make_unique<BinaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         opNode->left = std::move(node);
         advance();
@@ -692,9 +931,13 @@ std::unique_ptr<ASTNode> Parser::parseMultiplicative() {
 
 std::unique_ptr<ASTNode> Parser::parseUnary() {
     if (check(TK_PLUS) || check(TK_MINUS) || check(TK_BIT_NOT)) {
+        NestingGuard guard(nestingDepth);
+        if (!checkNesting()) {
+            return nullptr;
+        }
+
         auto opNode = std::make_unique<UnaryOpNode>();
-        opNode->line = currentToken.line;
-        opNode->column = currentToken.column;
+        opNode->offset = currentToken.offset;
         opNode->op = currentToken.type;
         advance();
         opNode->operand = parseUnary();
@@ -716,13 +959,13 @@ std::unique_ptr<ASTNode> Parser::parsePostfix() {
         }
 
         // ,   node 
-        if (auto varNode = dynamic_cast<VarNode*>(node.get())) {
+        if (auto varNode = nodeCast<VarNode>(node.get())) {
             //   VarNode    
             auto fieldAccess = std::make_unique<VarNode>();
-            fieldAccess->line = currentToken.line;
-            fieldAccess->column = currentToken.column;
+            fieldAccess->offset = currentToken.offset;
             fieldAccess->name = varNode->name;
             fieldAccess->fieldName = currentToken.lexeme;
+            fieldAccess->nameOffset = varNode->nameOffset;
 
             advance(); //   
             node = std::move(fieldAccess);
@@ -738,9 +981,14 @@ std::unique_ptr<ASTNode> Parser::parsePostfix() {
 
 std::unique_ptr<ASTNode> Parser::parsePrimary() {
     if (check(TK_IDENT)) {
+        // ,    '(' -  
+        if (peekToken().type == TK_LPAREN) {
+            return parseCall();
+        }
+
         auto varNode = std::make_unique<VarNode>();
-        varNode->line = currentToken.line;
-        varNode->column = currentToken.column;
+        varNode->offset = currentToken.offset;
+        varNode->nameOffset = currentToken.offset;
         varNode->name = currentToken.lexeme;
         advance();
         return varNode;
@@ -748,20 +996,24 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
 
     if (check(TK_INT_CONST)) {
         auto constNode = std::make_unique<ConstNode>();
-        constNode->line = currentToken.line;
-        constNode->column = currentToken.column;
-        constNode->type = TYPE_INT;
+        constNode->offset = currentToken.offset;
+        //    int  long,   C;   long, 
+        //       
+        constNode->type = currentToken.intValue > INT32_MAX ? TYPE_LONG : TYPE_INT;
         constNode->value = currentToken.lexeme;
+        constNode->intValue = currentToken.intValue;
+        constNode->range = currentToken.range;
         advance();
         return constNode;
     }
 
     if (check(TK_FLOAT_CONST)) {
         auto constNode = std::make_unique<ConstNode>();
-        constNode->line = currentToken.line;
-        constNode->column = currentToken.column;
+        constNode->offset = currentToken.offset;
         constNode->type = TYPE_FLOAT;
         constNode->value = currentToken.lexeme;
+        constNode->floatValue = currentToken.floatValue;
+        constNode->range = currentToken.range;
         advance();
         return constNode;
     }
@@ -779,372 +1031,756 @@ std::unique_ptr<ASTNode> Parser::parsePrimary() {
     return nullptr;
 }
 
+std::unique_ptr<CallNode> Parser::parseCall() {
+    auto call = std::make_unique<CallNode>();
+    call->offset = currentToken.offset;
+    call->name = currentToken.lexeme;
+    advance(); //   
+    match(TK_LPAREN);
+
+    if (!check(TK_RPAREN)) {
+        do {
+            auto argument = parseExpression();
+            if (!argument) {
+                error("  ");
+                return nullptr;
+            }
+            call->arguments.push_back(std::move(argument));
+        } while (match(TK_COMMA));
+    }
+
+    if (!match(TK_RPAREN)) {
+        error(" ')'   ");
+        return nullptr;
+    }
+
+    return call;
+}
+
 // ==================== AST Node Implementations ====================
 
-void ProgramNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Program:\n";
+//  JSON- :   
+static OutputWriter& writeNodeStart(OutputWriter& out, const char* kind,
+    const LineTable& lines, SourceOffset offset) {
+    SourcePosition at = lines.position(offset);
+    return out << "{\"kind\":\"" << kind << "\",\"line\":" << at.line
+        << ",\"column\":" << at.column;
+}
+
+void ASTNode::print(OutputWriter& out, int indent) const {
+    visitNode(*this, [&](const auto& node) { node.print(out, indent); });
+}
+
+void ASTNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    visitNode(*this, [&](const auto& node) { node.printJson(out, lines); });
+}
+
+const Type* ASTNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    return visitNode(*this, [&](auto& node) { return node.checkSemantics(sem, currentSymbol); });
+}
+
+void ProgramNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Program:\n";
+    for (const auto& decl : declarations) {
+        if (decl) decl->print(out, indent + 2);
+    }
+}
+
+void ProgramNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Program", lines, offset)
+        << ",\"declarations\":[";
+    bool first = true;
     for (const auto& decl : declarations) {
-        if (decl) decl->print(indent + 2);
+        if (!decl) continue;
+        if (!first) out << ',';
+        decl->printJson(out, lines);
+        first = false;
     }
+    out << "]}";
 }
 
-DataType ProgramNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+const Type* ProgramNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    TALT_MEMORY_SCOPE(MEM_SYMBOLS);
     for (const auto& decl : declarations) {
+        //      ,  
+        if (memoryBudgetExceeded()) break;
         decl->checkSemantics(sem, currentSymbol);
     }
-    return TYPE_VOID;
+    return builtinType(TYPE_VOID);
+}
+
+void ImportNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Import " << module << "\n";
+}
+
+void ImportNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Import", lines, offset)
+        << ",\"module\":";
+    out.jsonString(module) << '}';
+}
+
+const Type* ImportNode::checkSemantics(SemanticAnalyzer& sem, Symbol*&) {
+    sem.importModule(module, offset);
+    return builtinType(TYPE_VOID);
 }
 
-void StructDeclNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Struct " << name << ":\n";
+void StructDeclNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Struct " << name << ":\n";
     for (const auto& field : fields) {
-        std::cout << spaces << "  " << field.first << ": "
-            << SemanticAnalyzer::dataTypeToString(field.second) << "\n";
+        out.indent(indent + 2) << field.name << ": "
+            << SemanticAnalyzer::dataTypeToString(field.type) << "\n";
+    }
+}
+
+void StructDeclNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Struct", lines, offset)
+        << ",\"name\":";
+    out.jsonString(name) << ",\"fields\":[";
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (i > 0) out << ',';
+        out << "{\"name\":";
+        out.jsonString(fields[i].name) << ",\"type\":\""
+            << SemanticAnalyzer::dataTypeToString(fields[i].type) << '"';
+        if (!fields[i].structTypeName.empty()) {
+            out << ",\"struct\":";
+            out.jsonString(fields[i].structTypeName);
+        }
+        out << '}';
     }
+    out << "]}";
 }
 
-DataType StructDeclNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    if (!sem.declareStructType(name, line, column)) {
-        return TYPE_UNDEFINED;
+const Type* StructDeclNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    if (!sem.declareStructType(name, offset)) {
+        return builtinType(TYPE_UNDEFINED);
     }
 
     for (const auto& field : fields) {
-        if (!sem.addFieldToStruct(name, field.first, field.second, "", line, column)) {
-            return TYPE_UNDEFINED;
+        if (!sem.addFieldToStruct(name, field.name, field.type, field.structTypeName,
+            offset)) {
+            return builtinType(TYPE_UNDEFINED);
+        }
+        if (sem.isRecordingReferences()) {
+            sem.noteFieldReference(sem.getNames().find(name), field.name,
+                field.sourceOffset, true);
         }
     }
 
-    return TYPE_STRUCT;
+    if (!sem.layoutStruct(name, offset)) {
+        return builtinType(TYPE_UNDEFINED);
+    }
+
+    return sem.typeOf(TYPE_STRUCT, name);
 }
 
-void FunctionNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Function " << name << ": "
-        << SemanticAnalyzer::dataTypeToString(returnType) << "\n";
+void FunctionNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Function " << name << ": ";
+    if (returnType == TYPE_STRUCT && !returnStructName.empty()) {
+        out << "struct " << returnStructName << "\n";
+    }
+    else {
+        out << SemanticAnalyzer::dataTypeToString(returnType) << "\n";
+    }
+    for (const auto& param : params) {
+        out.indent(indent + 2) << "Param " << param.name << ": ";
+        if (param.type == TYPE_STRUCT && !param.structTypeName.empty()) {
+            out << "struct " << param.structTypeName << "\n";
+        }
+        else {
+            out << SemanticAnalyzer::dataTypeToString(param.type) << "\n";
+        }
+    }
     if (body) {
-        body->print(indent + 2);
+        body->print(out, indent + 2);
     }
 }
 
-DataType FunctionNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    //       
-    if (body) {
-        return body->checkSemantics(sem, currentSymbol);
+void FunctionNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Function", lines, offset)
+        << ",\"name\":";
+    out.jsonString(name) << ",\"returnType\":\""
+        << SemanticAnalyzer::dataTypeToString(returnType) << '"';
+    if (returnType == TYPE_STRUCT && !returnStructName.empty()) {
+        out << ",\"returnStruct\":";
+        out.jsonString(returnStructName);
+    }
+    out << ",\"params\":[";
+    for (size_t i = 0; i < params.size(); i++) {
+        if (i > 0) out << ',';
+        out << "{\"name\":";
+        out.jsonString(params[i].name) << ",\"type\":\""
+            << SemanticAnalyzer::dataTypeToString(params[i].type) << '"';
+        if (!params[i].structTypeName.empty()) {
+            out << ",\"struct\":";
+            out.jsonString(params[i].structTypeName);
+        }
+        out << '}';
+    }
+    out << "],\"body\":";
+    if (body) body->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* FunctionNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    size_t errorsBefore = sem.errorCount();
+
+    const Type* resultType = builtinType(returnType);
+    if (returnType == TYPE_STRUCT && !returnStructName.empty()) {
+        if (sem.findStructType(returnStructName)) {
+            resultType = sem.typeOf(TYPE_STRUCT, returnStructName);
+        }
+        else {
+            sem.addError("  '" + returnStructName + "'  ", offset);
+            resultType = builtinType(TYPE_UNDEFINED);
+        }
+    }
+
+    //    :     
+    if (Symbol* function = sem.declareFunction(name, resultType, offset)) {
+        SymbolExtra& extra = sem.extraInfo(function);
+        extra.paramCount = (int)params.size();
+        for (const auto& param : params) {
+            extra.paramTypes.push_back(param.type);
+        }
     }
-    return returnType;
+
+    //     -   ,   C
+    sem.enterScope();
+    for (const auto& param : params) {
+        if (param.type == TYPE_STRUCT) {
+            //   ;  ,  
+            //      
+            if (sem.findStructType(param.structTypeName) &&
+                sem.declareVariable(param.name, sem.typeOf(TYPE_STRUCT, param.structTypeName), param.offset)) {
+                sem.findVariableInCurrentScope(param.name)->isInitialized = true;
+            }
+            continue;
+        }
+        if (!isNumericKind(param.type)) {
+            sem.addError(" '" + param.name + "'    ",
+                param.offset);
+            continue;
+        }
+        if (sem.declareVariable(param.name, builtinType(param.type), param.offset)) {
+            sem.findVariableInCurrentScope(param.name)->isInitialized = true;
+        }
+    }
+    sem.setReturnType(resultType);
+    if (auto block = nodeCast<BlockNode>(body.get())) {
+        for (const auto& stmt : block->statements) {
+            if (stmt) stmt->checkSemantics(sem, currentSymbol);
+        }
+    }
+    sem.setReturnType(nullptr);
+    sem.leaveScope();
+
+    //      ,    
+    if (body && sem.errorCount() == errorsBefore) {
+        checkInitialization(*this, sem);
+    }
+    return builtinType(TYPE_VOID);
 }
 
-void VarDeclNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "VarDecl " << name << ": ";
+void VarDeclNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "VarDecl " << name << ": ";
 
     if (type == TYPE_STRUCT && !structName.empty()) {
-        std::cout << "struct " << structName;
+        out << "struct " << structName;
     }
     else {
-        std::cout << SemanticAnalyzer::dataTypeToString(type);
+        out << SemanticAnalyzer::dataTypeToString(type);
     }
 
     if (initValue) {
-        std::cout << " =\n";
-        initValue->print(indent + 2);
+        out << " =\n";
+        initValue->print(out, indent + 2);
     }
     else {
-        std::cout << "\n";
+        out << "\n";
     }
 }
 
-DataType VarDeclNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+void VarDeclNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "VarDecl", lines, offset)
+        << ",\"name\":";
+    out.jsonString(name) << ",\"type\":\"" << SemanticAnalyzer::dataTypeToString(type) << '"';
+    if (type == TYPE_STRUCT && !structName.empty()) {
+        out << ",\"struct\":";
+        out.jsonString(structName);
+    }
+    out << ",\"init\":";
+    if (initValue) initValue->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* VarDeclNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
     if (type == TYPE_STRUCT && !structName.empty()) {
         if (!sem.findStructType(structName)) {
-            sem.addError("  '" + structName + "'  ", line, column);
-            return TYPE_UNDEFINED;
+            sem.addError("  '" + structName + "'  ", offset);
+            return builtinType(TYPE_UNDEFINED);
         }
     }
 
-    if (!sem.declareVariable(name, type, structName, line, column)) {
-        return TYPE_UNDEFINED;
+    if (!sem.declareVariable(name, sem.typeOf(type, structName), offset)) {
+        return builtinType(TYPE_UNDEFINED);
     }
 
     if (initValue) {
-        DataType initType = initValue->checkSemantics(sem, currentSymbol);
+        const Type* initType = initValue->checkSemantics(sem, currentSymbol);
         Symbol* varSymbol = sem.findSymbol(name);
 
-        if (varSymbol && initType != TYPE_UNDEFINED) {
-            if (!sem.checkAssignment(varSymbol, initType, line, column)) {
-                return TYPE_UNDEFINED;
+        if (varSymbol && initType->kind != TYPE_UNDEFINED) {
+            if (!sem.checkAssignment(varSymbol, initType, offset)) {
+                return builtinType(TYPE_UNDEFINED);
             }
             varSymbol->isInitialized = true;
         }
     }
 
-    return TYPE_VOID;
+    return builtinType(TYPE_VOID);
 }
 
-void AssignNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Assign ";
+void AssignNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Assign ";
     if (!fieldName.empty()) {
-        std::cout << varName << "." << fieldName;
+        out << varName << "." << fieldName;
     }
     else {
-        std::cout << varName;
+        out << varName;
     }
-    std::cout << " =\n";
+    out << " =\n";
     if (expression) {
-        expression->print(indent + 2);
+        expression->print(out, indent + 2);
     }
 }
 
-DataType AssignNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+void AssignNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Assign", lines, offset)
+        << ",\"var\":";
+    out.jsonString(varName);
+    if (!fieldName.empty()) {
+        out << ",\"field\":";
+        out.jsonString(fieldName);
+    }
+    out << ",\"expression\":";
+    if (expression) expression->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* AssignNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
     Symbol* leftSymbol = sem.findSymbol(varName);
     if (!leftSymbol) {
-        sem.addError(" '" + varName + "'  ", line, column);
-        return TYPE_UNDEFINED;
+        sem.addError(" '" + varName + "'  ", offset);
+        return builtinType(TYPE_UNDEFINED);
     }
+    sem.noteReference(leftSymbol, nameOffset);
 
-    DataType exprType = TYPE_UNDEFINED;
+    //  :   ,   
+    //   
+    const Type* fieldType = nullptr;
+    if (!fieldName.empty()) {
+        if (!sem.checkFieldAccess(leftSymbol, fieldName, &fieldType, fieldOffset)) {
+            return builtinType(TYPE_UNDEFINED);
+        }
+        sem.noteFieldReference(leftSymbol->type->structName, fieldName, fieldOffset);
+    }
+
+    const Type* exprType = builtinType(TYPE_UNDEFINED);
     if (expression) {
         exprType = expression->checkSemantics(sem, currentSymbol);
     }
 
-    if (exprType != TYPE_UNDEFINED) {
-        if (!sem.checkAssignment(leftSymbol, exprType, line, column)) {
-            return TYPE_UNDEFINED;
+    if (exprType->kind != TYPE_UNDEFINED) {
+        if (fieldType) {
+            if (!sem.checkAssignable(fieldType, exprType, offset)) {
+                return builtinType(TYPE_UNDEFINED);
+            }
+        }
+        else {
+            if (!sem.checkAssignment(leftSymbol, exprType, offset)) {
+                return builtinType(TYPE_UNDEFINED);
+            }
+            leftSymbol->isInitialized = true;
         }
-        leftSymbol->isInitialized = true;
     }
 
     return exprType;
 }
 
-void ForLoopNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "For:\n";
-    std::cout << spaces << "  Init:\n";
-    if (init) init->print(indent + 4);
-    std::cout << spaces << "  Condition:\n";
-    if (condition) condition->print(indent + 4);
-    std::cout << spaces << "  Increment:\n";
-    if (increment) increment->print(indent + 4);
-    std::cout << spaces << "  Body:\n";
-    if (body) body->print(indent + 4);
+void ForLoopNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << (parallel ? "For (parallel):\n" : "For:\n");
+    out.indent(indent + 2) << "Init:\n";
+    if (init) init->print(out, indent + 4);
+    out.indent(indent + 2) << "Condition:\n";
+    if (condition) condition->print(out, indent + 4);
+    out.indent(indent + 2) << "Increment:\n";
+    if (increment) increment->print(out, indent + 4);
+    out.indent(indent + 2) << "Body:\n";
+    if (body) body->print(out, indent + 4);
+}
+
+void ForLoopNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "For", lines, offset);
+    if (parallel) out << ",\"parallel\":true";
+    const char* names[] = { "init", "condition", "increment", "body" };
+    const ASTNode* parts[] = { init.get(), condition.get(), increment.get(), body.get() };
+    for (int i = 0; i < 4; i++) {
+        out << ",\"" << names[i] << "\":";
+        if (parts[i]) parts[i]->printJson(out, lines);
+        else out << "null";
+    }
+    out << '}';
 }
 
-DataType ForLoopNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    DataType initType = TYPE_UNDEFINED;
-    DataType condType = TYPE_UNDEFINED;
-    DataType incType = TYPE_UNDEFINED;
+const Type* ForLoopNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    const Type* initType = builtinType(TYPE_UNDEFINED);
+    const Type* condType = builtinType(TYPE_UNDEFINED);
+    const Type* incType = builtinType(TYPE_UNDEFINED);
+
+    //        
+    sem.enterScope();
 
     if (init) initType = init->checkSemantics(sem, currentSymbol);
     if (condition) condType = condition->checkSemantics(sem, currentSymbol);
     if (increment) incType = increment->checkSemantics(sem, currentSymbol);
 
-    if (!sem.checkForLoop(initType, condType, incType, line, column)) {
-        return TYPE_UNDEFINED;
+    if (!sem.checkForLoop(initType, condType, incType, offset)) {
+        sem.leaveScope();
+        return builtinType(TYPE_UNDEFINED);
     }
 
     if (body) {
-        sem.enterScope();
         body->checkSemantics(sem, currentSymbol);
-        sem.leaveScope();
     }
 
-    return TYPE_VOID;
+    sem.leaveScope();
+    return builtinType(TYPE_VOID);
 }
 
-void BinaryOpNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "BinaryOp ";
-    //     
+static const char* operatorToString(TokenType op) {
     switch (op) {
-    case TK_PLUS: std::cout << "+"; break;
-    case TK_MINUS: std::cout << "-"; break;
-    case TK_MUL: std::cout << "*"; break;
-    case TK_DIV: std::cout << "/"; break;
-    case TK_MOD: std::cout << "%"; break;
-    case TK_EQ: std::cout << "=="; break;
-    case TK_NE: std::cout << "!="; break;
-    case TK_LT: std::cout << "<"; break;
-    case TK_LE: std::cout << "<="; break;
-    case TK_GT: std::cout << ">"; break;
-    case TK_GE: std::cout << ">="; break;
-    case TK_BIT_AND: std::cout << "&"; break;
-    case TK_BIT_OR: std::cout << "|"; break;
-    case TK_BIT_XOR: std::cout << "^"; break;
-    case TK_SHL: std::cout << "<<"; break;
-    case TK_SHR: std::cout << ">>"; break;
-    default: std::cout << "UNKNOWN"; break;
-    }
-    std::cout << ":\n";
-    if (left) left->print(indent + 2);
-    if (right) right->print(indent + 2);
-}
-
-DataType BinaryOpNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    DataType leftType = TYPE_UNDEFINED;
-    DataType rightType = TYPE_UNDEFINED;
+    case TK_PLUS: return "+";
+    case TK_MINUS: return "-";
+    case TK_MUL: return "*";
+    case TK_DIV: return "/";
+    case TK_MOD: return "%";
+    case TK_EQ: return "==";
+    case TK_NE: return "!=";
+    case TK_LT: return "<";
+    case TK_LE: return "<=";
+    case TK_GT: return ">";
+    case TK_GE: return ">=";
+    case TK_BIT_AND: return "&";
+    case TK_BIT_OR: return "|";
+    case TK_BIT_XOR: return "^";
+    case TK_BIT_NOT: return "~";
+    case TK_SHL: return "<<";
+    case TK_SHR: return ">>";
+    default: return "UNKNOWN";
+    }
+}
+
+void BinaryOpNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "BinaryOp " << operatorToString(op) << ":\n";
+    if (left) left->print(out, indent + 2);
+    if (right) right->print(out, indent + 2);
+}
+
+void BinaryOpNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "BinaryOp", lines, offset)
+        << ",\"op\":\"" << operatorToString(op) << "\",\"left\":";
+    if (left) left->printJson(out, lines);
+    else out << "null";
+    out << ",\"right\":";
+    if (right) right->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* BinaryOpNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    const Type* leftType = builtinType(TYPE_UNDEFINED);
+    const Type* rightType = builtinType(TYPE_UNDEFINED);
 
     if (left) leftType = left->checkSemantics(sem, currentSymbol);
     if (right) rightType = right->checkSemantics(sem, currentSymbol);
 
-    if (leftType == TYPE_UNDEFINED || rightType == TYPE_UNDEFINED) {
-        return TYPE_UNDEFINED;
-    }
-
-    return sem.checkBinaryOperation(op, leftType, rightType, line, column);
+    return sem.checkBinaryOperation(op, leftType, rightType, offset);
 }
 
-void UnaryOpNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "UnaryOp ";
+void UnaryOpNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "UnaryOp ";
     switch (op) {
-    case TK_PLUS: std::cout << "+"; break;
-    case TK_MINUS: std::cout << "-"; break;
-    case TK_BIT_NOT: std::cout << "~"; break;
-    default: std::cout << "UNKNOWN"; break;
+    case TK_PLUS:
+    case TK_MINUS:
+    case TK_BIT_NOT: out << operatorToString(op); break;
+    default: out << "UNKNOWN"; break;
     }
-    std::cout << ":\n";
-    if (operand) operand->print(indent + 2);
+    out << ":\n";
+    if (operand) operand->print(out, indent + 2);
 }
 
-DataType UnaryOpNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+void UnaryOpNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "UnaryOp", lines, offset)
+        << ",\"op\":\"" << operatorToString(op) << "\",\"operand\":";
+    if (operand) operand->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* UnaryOpNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
     if (!operand) {
-        return TYPE_UNDEFINED;
+        return builtinType(TYPE_UNDEFINED);
     }
 
-    DataType operandType = operand->checkSemantics(sem, currentSymbol);
-
-    if (operandType == TYPE_UNDEFINED) {
-        return TYPE_UNDEFINED;
+    const Type* operandType = operand->checkSemantics(sem, currentSymbol);
+    const TypeRule& rule = unaryRule(op, operandType->kind);
+    if (rule.diagnostic != TDIAG_NONE) {
+        sem.addError(typeDiagnosticText(rule.diagnostic), offset);
     }
+    return builtinType(rule.result);
+}
 
-    if (op == TK_PLUS || op == TK_MINUS) {
-        if (!sem.isNumericType(operandType)) {
-            sem.addError(" +  -     ", line, column);
-            return TYPE_UNDEFINED;
-        }
-        return operandType;
+void VarNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Var ";
+    if (!fieldName.empty()) {
+        out << name << "." << fieldName;
     }
-
-    if (op == TK_BIT_NOT) {
-        if (!sem.isIntegerType(operandType)) {
-            sem.addError("      ", line, column);
-            return TYPE_UNDEFINED;
-        }
-        return operandType;
+    else {
+        out << name;
     }
-
-    return TYPE_UNDEFINED;
+    out << "\n";
 }
 
-void VarNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Var ";
+void VarNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Var", lines, offset)
+        << ",\"name\":";
+    out.jsonString(name);
     if (!fieldName.empty()) {
-        std::cout << name << "." << fieldName;
-    }
-    else {
-        std::cout << name;
+        out << ",\"field\":";
+        out.jsonString(fieldName);
     }
-    std::cout << "\n";
+    out << '}';
 }
 
-void ConstNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Const " << SemanticAnalyzer::dataTypeToString(type)
+void ConstNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Const " << SemanticAnalyzer::dataTypeToString(type)
         << " " << value << "\n";
 }
 
-DataType VarNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+void ConstNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Const", lines, offset)
+        << ",\"type\":\"" << SemanticAnalyzer::dataTypeToString(type) << "\",\"value\":";
+    out.jsonString(value) << '}';
+}
+
+const Type* VarNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
     //  
     Symbol* symbol = sem.findSymbol(name);
 
     if (!symbol) {
         // ,      
         if (sem.findStructType(name)) {
-            sem.addError("'" + name + "'   ,   ", line, column);
-            return TYPE_UNDEFINED;
+            sem.addError("'" + name + "'   ,   ", offset);
+            return builtinType(TYPE_UNDEFINED);
         }
 
-        sem.addError(" '" + name + "'  ", line, column);
-        return TYPE_UNDEFINED;
+        sem.addError(" '" + name + "'  ", offset);
+        return builtinType(TYPE_UNDEFINED);
     }
+    sem.noteReference(symbol, nameOffset);
 
     if (!fieldName.empty()) {
         //     
-        DataType fieldType = TYPE_UNDEFINED;
-        if (!sem.checkFieldAccess(symbol, fieldName, &fieldType, line, column)) {
-            return TYPE_UNDEFINED;
+        const Type* fieldType = nullptr;
+        if (!sem.checkFieldAccess(symbol, fieldName, &fieldType, offset)) {
+            return builtinType(TYPE_UNDEFINED);
         }
-        nodeType = fieldType;
+        sem.noteFieldReference(symbol->type->structName, fieldName, offset);
+        nodeType = fieldType->kind;
+        return fieldType;
     }
     else {
         //   
         if (symbol->category == CAT_VARIABLE) {
-            nodeType = symbol->type;
+            nodeType = symbol->type->kind;
         }
         else if (symbol->category == CAT_TYPE || symbol->category == CAT_STRUCT_TYPE) {
-            sem.addError("'" + name + "'  ,   ", line, column);
-            return TYPE_UNDEFINED;
+            sem.addError("'" + name + "'  ,   ", offset);
+            return builtinType(TYPE_UNDEFINED);
         }
         else {
-            sem.addError("'" + name + "'   ", line, column);
-            return TYPE_UNDEFINED;
+            sem.addError("'" + name + "'   ", offset);
+            return builtinType(TYPE_UNDEFINED);
         }
     }
 
-    return nodeType;
+    return symbol->type;
 }
 
-DataType ConstNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    return type;
+const Type* ConstNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    if (type == TYPE_FLOAT) {
+        if (range == LIT_TOO_LARGE) {
+            sem.addError("  " + value + "    float",
+                offset);
+        }
+        else if (range == LIT_TOO_SMALL) {
+            sem.addWarning("  " + value +
+                "    float   ", offset);
+        }
+    }
+    else if (range == LIT_TOO_LARGE || (intValue > INT32_MAX && sem.typeSize(TYPE_LONG) < 8)) {
+        sem.addError("  " + value + "    long", offset);
+    }
+    return builtinType(type);
+}
+
+void BlockNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Block:\n";
+    for (const auto& stmt : statements) {
+        if (stmt) stmt->print(out, indent + 2);
+    }
 }
 
-void BlockNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Block:\n";
+void BlockNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Block", lines, offset)
+        << ",\"statements\":[";
+    bool first = true;
     for (const auto& stmt : statements) {
-        if (stmt) stmt->print(indent + 2);
+        if (!stmt) continue;
+        if (!first) out << ',';
+        stmt->printJson(out, lines);
+        first = false;
     }
+    out << "]}";
 }
 
-DataType BlockNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+const Type* BlockNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    sem.enterScope();
     for (const auto& stmt : statements) {
         if (stmt) {
             stmt->checkSemantics(sem, currentSymbol);
         }
     }
-    return TYPE_VOID;
+    sem.leaveScope();
+    return builtinType(TYPE_VOID);
 }
 
-void ReturnNode::print(int indent) const {
-    std::string spaces(indent, ' ');
-    std::cout << spaces << "Return";
+void ReturnNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Return";
     if (expression) {
-        std::cout << ":\n";
-        expression->print(indent + 2);
+        out << ":\n";
+        expression->print(out, indent + 2);
     }
     else {
-        std::cout << "\n";
+        out << "\n";
     }
 }
 
-DataType ReturnNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
-    if (expression) {
-        return expression->checkSemantics(sem, currentSymbol);
+void ReturnNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Return", lines, offset)
+        << ",\"expression\":";
+    if (expression) expression->printJson(out, lines);
+    else out << "null";
+    out << '}';
+}
+
+const Type* ReturnNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    if (!expression) {
+        return builtinType(TYPE_VOID);
+    }
+    const Type* type = expression->checkSemantics(sem, currentSymbol);
+
+    //        
+    const Type* expected = sem.getReturnType();
+    if (expected && expected->kind != TYPE_UNDEFINED && type->kind != TYPE_UNDEFINED) {
+        if (expected->kind == TYPE_VOID) {
+            sem.addError("  void    ", expression->offset);
+        }
+        else {
+            sem.checkAssignable(expected, type, expression->offset);
+        }
+    }
+    return type;
+}
+
+void CallNode::print(OutputWriter& out, int indent) const {
+    out.indent(indent) << "Call " << name << ":\n";
+    for (const auto& argument : arguments) {
+        if (argument) argument->print(out, indent + 2);
+    }
+}
+
+void CallNode::printJson(OutputWriter& out, const LineTable& lines) const {
+    writeNodeStart(out, "Call", lines, offset)
+        << ",\"name\":";
+    out.jsonString(name) << ",\"arguments\":[";
+    bool first = true;
+    for (const auto& argument : arguments) {
+        if (!argument) continue;
+        if (!first) out << ',';
+        argument->printJson(out, lines);
+        first = false;
+    }
+    out << "]}";
+}
+
+const Type* CallNode::checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) {
+    Symbol* function = sem.findSymbol(name);
+    if (function && function->category != CAT_FUNCTION) {
+        sem.addError("'" + name + "'   ", offset);
+        function = nullptr;
+    }
+    else if (!function) {
+        sem.addError(" '" + name + "'  ", offset);
+    }
+    else {
+        sem.noteReference(function, offset);
+    }
+
+    //     ; 
+    //       
+    const SymbolExtra* extra = function ? sem.findExtraInfo(function) : nullptr;
+    size_t paramCount = extra ? extra->paramTypes.size() : 0;
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const Type* argumentType = arguments[i]->checkSemantics(sem, currentSymbol);
+        if (i < paramCount && argumentType->kind != TYPE_UNDEFINED) {
+            sem.checkAssignable(builtinType(extra->paramTypes[i]), argumentType,
+                arguments[i]->offset);
+        }
+    }
+
+    if (!function) {
+        return builtinType(TYPE_UNDEFINED);
+    }
+    if (arguments.size() != paramCount) {
+        std::stringstream ss;
+        ss << " '" << name << "'  : " << paramCount
+            << ", : " << arguments.size() << "   "
+            << sem.position(offset).line;
+        sem.addError(ss.str(), offset);
+        return builtinType(TYPE_UNDEFINED);
+    }
+    return function->type;
+}
+
+void Parser::printAST(const ASTNode* node, OutputWriter& out) {
+    if (!node) {
+        out << "AST is empty\n";
+        return;
     }
-    return TYPE_VOID;
+    node->print(out);
 }
 
-void Parser::printAST(const ASTNode* node) {
+void Parser::printASTJson(const ASTNode* node, OutputWriter& out) {
     if (!node) {
-        std::cout << "AST is empty\n";
+        out << "null\n";
         return;
     }
-    node->print();
+    node->printJson(out, scanner.lineTable());
+    out << '\n';
 }
 
 void Parser::skipToToken(TokenType target) {
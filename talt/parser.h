@@ -3,121 +3,256 @@
 
 #include "scanner.h"
 #include "semantic.h"
+#include "stats.h"
+#include "output.h"
 #include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
+
+//  .       (. visitor.h),  
+//  :       .
+enum NodeKind : unsigned char {
+    NODE_PROGRAM,
+    NODE_STRUCT_DECL,
+    NODE_FUNCTION,
+    NODE_VAR_DECL,
+    NODE_ASSIGN,
+    NODE_FOR,
+    NODE_BINARY_OP,
+    NODE_UNARY_OP,
+    NODE_VAR,
+    NODE_CONST,
+    NODE_BLOCK,
+    NODE_RETURN,
+    NODE_CALL,
+    NODE_IMPORT
+};
+
+//   AST    .   ; 
+// NodeArenaScope    ,     
+//  -    Arena::rewind. , 
+//  ,     .
+class NodeArenaScope {
+private:
+    Arena* saved;
+
+public:
+    explicit NodeArenaScope(Arena* arena);
+    ~NodeArenaScope();
+
+    NodeArenaScope(const NodeArenaScope&) = delete;
+    NodeArenaScope& operator=(const NodeArenaScope&) = delete;
+};
+
+void* allocateNodeMemory(size_t size);
+void freeNodeMemory(void* memory);
+
+template <class T>
+struct NodeAllocator {
+    typedef T value_type;
+
+    NodeAllocator() = default;
+    template <class U>
+    NodeAllocator(const NodeAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocateNodeMemory(count * sizeof(T)));
+    }
+    void deallocate(T* memory, size_t) { freeNodeMemory(memory); }
+
+    template <class U>
+    bool operator==(const NodeAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const NodeAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using NodeVector = std::vector<T, NodeAllocator<T>>;
 
 //    AST
 class ASTNode {
 public:
+    explicit ASTNode(NodeKind nodeKind) : kind(nodeKind) {}
     virtual ~ASTNode() = default;
-    virtual void print(int indent = 0) const = 0;
-    virtual DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) = 0;
-    virtual DataType getDataType() const { return TYPE_UNDEFINED; }
-    virtual std::string getStringValue() const { return ""; }
 
-    int line = 0;
-    int column = 0;
+    static void* operator new(size_t size) { return allocateNodeMemory(size); }
+    static void operator delete(void* memory) { freeNodeMemory(memory); }
+
+    //       kind
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol);
+
+    SourceOffset offset = 0;  //     LineTable 
+    const NodeKind kind;
 };
 
 //   
 
 class ProgramNode : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ASTNode>> declarations;
+    static const NodeKind Kind = NODE_PROGRAM;
+
+    ProgramNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_PROGRAM); }
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    NodeVector<std::unique_ptr<ASTNode>> declarations;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class StructDeclNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_STRUCT_DECL;
+
+    StructDeclNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_STRUCT_DECL); }
+
     std::string name;
-    std::vector<std::pair<std::string, DataType>> fields;
+    NodeVector<FieldInfo> fields;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
+};
+
+//  
+struct ParamInfo {
+    std::string name;
+    DataType type;
+    std::string structTypeName;  //  ,  type == TYPE_STRUCT
+    SourceOffset offset;         //  
+
+    ParamInfo(const std::string& n = "", DataType t = TYPE_UNDEFINED,
+        const std::string& stn = "", SourceOffset at = 0)
+        : name(n), type(t), structTypeName(stn), offset(at) {}
 };
 
 class FunctionNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_FUNCTION;
+
+    FunctionNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_FUNCTION); }
+
     std::string name;
     DataType returnType;
-    std::unique_ptr<ASTNode> body;
-
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    std::string returnStructName;  //  TYPE_STRUCT
+    NodeVector<ParamInfo> params;
+    std::unique_ptr<ASTNode> body;  // BlockNode
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 
 class VarDeclNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_VAR_DECL;
+
+    VarDeclNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_VAR_DECL); }
+
     std::string name;
     DataType type;
     std::string structName;  //  ,  type == TYPE_STRUCT
     std::unique_ptr<ASTNode> initValue;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class AssignNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_ASSIGN;
+
+    AssignNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_ASSIGN); }
+
     std::string varName;
     std::string fieldName;
     std::unique_ptr<ASTNode> expression;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    //        '='
+    SourceOffset nameOffset = 0;
+    SourceOffset fieldOffset = 0;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class ForLoopNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_FOR;
+
+    ForLoopNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_FOR); }
+
     std::unique_ptr<ASTNode> init;
     std::unique_ptr<ASTNode> condition;
     std::unique_ptr<ASTNode> increment;
     std::unique_ptr<ASTNode> body;
+    bool parallel = false;  //  PRAGMA_PARALLEL  
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class BinaryOpNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_BINARY_OP;
+
+    BinaryOpNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_BINARY_OP); }
+
     TokenType op;
     std::unique_ptr<ASTNode> left;
     std::unique_ptr<ASTNode> right;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class UnaryOpNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_UNARY_OP;
+
+    UnaryOpNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_UNARY_OP); }
+
     TokenType op;
     std::unique_ptr<ASTNode> operand;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class VarNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_VAR;
+
+    VarNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_VAR); }
+
     std::string name;
     std::string fieldName;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol) override;
-    DataType getDataType() const override { return nodeType; }
+    //   ;     offset 
+    //   
+    SourceOffset nameOffset = 0;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem, Symbol*& currentSymbol);
+    DataType getDataType() const { return nodeType; }
 
 private:
     DataType nodeType = TYPE_UNDEFINED;
@@ -126,52 +261,134 @@ private:
 
 class ConstNode : public ASTNode {
 public:
-    DataType type;
-    std::string value;
+    static const NodeKind Kind = NODE_CONST;
+
+    ConstNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_CONST); }
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
-    DataType getDataType() const override { return type; }
-    std::string getStringValue() const override { return value; }
+    DataType type;
+    std::string value;              //    ,  
+    int64_t intValue = 0;           //   
+    float floatValue = 0;           //   
+    LiteralRange range = LIT_OK;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
+    DataType getDataType() const { return type; }
+    std::string getStringValue() const { return value; }
 };
 
 class BlockNode : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ASTNode>> statements;
+    static const NodeKind Kind = NODE_BLOCK;
+
+    BlockNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_BLOCK); }
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    NodeVector<std::unique_ptr<ASTNode>> statements;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
 class ReturnNode : public ASTNode {
 public:
+    static const NodeKind Kind = NODE_RETURN;
+
+    ReturnNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_RETURN); }
+
     std::unique_ptr<ASTNode> expression;
 
-    void print(int indent = 0) const override;
-    DataType checkSemantics(SemanticAnalyzer& sem,
-        Symbol*& currentSymbol) override;
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
+};
+
+//   name(); offset -  
+class CallNode : public ASTNode {
+public:
+    static const NodeKind Kind = NODE_CALL;
+
+    CallNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_CALL); }
+
+    std::string name;
+    NodeVector<std::unique_ptr<ASTNode>> arguments;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
 };
 
+// import a.b; -    a/b    
+class ImportNode : public ASTNode {
+public:
+    static const NodeKind Kind = NODE_IMPORT;
+
+    ImportNode() : ASTNode(Kind) { TALT_COUNT(STAT_NODE_IMPORT); }
+
+    std::string module;
+
+    void print(OutputWriter& out, int indent = 0) const;
+    void printJson(OutputWriter& out, const LineTable& lines) const;
+    const Type* checkSemantics(SemanticAnalyzer& sem,
+        Symbol*& currentSymbol);
+};
+
+//       
+typedef unsigned long long TokenSet;
+
+constexpr TokenSet tokenBit(TokenType type) {
+    return 1ULL << (type - TK_INT);
+}
+
 class Parser {
 private:
     Scanner& scanner;
     Token currentToken;
-    SemanticAnalyzer& semantic;
+
+    //     
+    Token lookahead[2];
+    int lookaheadCount;
+
+    //  ,    .  
+    //     :    
+    // .  -  ,    : reset
+    //   ,    .
+    std::unordered_map<std::string, unsigned> structTypeNames;
+    unsigned parseNumber;
+
+    //   
+    bool panicMode;
+    bool aborted;
+    int errorCount;
+    int nestingDepth;
+    unsigned long long tokensConsumed;
+    bool importsAllowed;  // import     
 
     void advance();
     bool match(TokenType expected);
     bool check(TokenType expected) const;
+    bool checkAny(TokenSet set) const;
     void error(const std::string& message);
+    void stopOnMemoryBudget();
     void skipToToken(TokenType target);
-    Token peekToken();
+    void synchronize(TokenSet stopBefore, TokenSet stopAfter);
+    const Token& peekToken(int distance = 1);
+    bool isStructTypeName(const std::string& name) const;
+    bool isTypeStart();
+    bool checkNesting();
 
     //  
     std::unique_ptr<ProgramNode> parseProgram();
     std::unique_ptr<ASTNode> parseDeclaration();
+    std::unique_ptr<ImportNode> parseImport();
     std::unique_ptr<StructDeclNode> parseStructDeclaration();
-    std::unique_ptr<FunctionNode> parseFunctionDeclaration(DataType returnType);
+    std::unique_ptr<FunctionNode> parseFunctionDeclaration(DataType returnType,
+        const std::string& returnStructName);
     std::unique_ptr<VarDeclNode> parseVariableDeclaration(DataType type, const std::string& structTypeName = "");
     std::unique_ptr<ASTNode> parseStatement();
     std::unique_ptr<ForLoopNode> parseForLoop();
@@ -190,17 +407,39 @@ private:
     std::unique_ptr<ASTNode> parseUnary();
     std::unique_ptr<ASTNode> parsePostfix();
     std::unique_ptr<ASTNode> parsePrimary();
+    std::unique_ptr<CallNode> parseCall();
 
     DataType parseType(std::string* structTypeName = nullptr);
     std::unique_ptr<BlockNode> parseBlock();
 
 public:
-    Parser(Scanner& sc, SemanticAnalyzer& sem);
+    explicit Parser(Scanner& sc);
+
+    //   ,    . 
+    //   ,   .
+    void reset();
+    //     : reset   
+    void releaseTables() { structTypeNames.clear(); }
+    size_t tableSize() const { return structTypeNames.size(); }
 
     std::unique_ptr<ProgramNode> parse();
-    void printAST(const ASTNode* node);
+
+    //  :      nullptr
+    //   .    .
+    std::unique_ptr<ASTNode> parseNext();
+    //  errors  diagnostics,   
+    void discardMessages();
+    void printAST(const ASTNode* node, OutputWriter& out);
+    void printASTJson(const ASTNode* node, OutputWriter& out);
 
     bool hasError = false;
+    std::vector<std::string> errors;  //   
+    std::vector<Diagnostic> diagnostics;
+    bool reportToStderr = true;       // false -   
+    // ,      
+    unsigned long long consumedTokens() const { return tokensConsumed; }
+    int maxErrors = 100;
+    int maxNestingDepth = 256;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "passes.h"
+#include "visitor.h"
+#include "interp.h"
+#include "stats.h"
+#include <charconv>
+
+namespace {
+
+//     -   Lowering::lowerBinary: 
+//    . short    .
+DataType widerType(DataType a, DataType b) {
+    if (a == TYPE_FLOAT || b == TYPE_FLOAT) return TYPE_FLOAT;
+    if (a == TYPE_LONG || b == TYPE_LONG) return TYPE_LONG;
+    return TYPE_INT;
+}
+
+bool isComparison(TokenType op) {
+    return op == TK_EQ || op == TK_NE || op == TK_LT ||
+        op == TK_LE || op == TK_GT || op == TK_GE;
+}
+
+//      ;   
+//     -    
+class ConstantEvaluator : public ASTWalker<ConstantEvaluator> {
+private:
+    ConstantTable& table;
+    bool longIs64;
+
+    ExecType execType(DataType type) const {
+        if (type == TYPE_FLOAT) return EXT_F32;
+        return type == TYPE_LONG && longIs64 ? EXT_I64 : EXT_I32;
+    }
+
+    //  ,    
+    ExecValue operand(const ConstantValue& value, DataType type) const {
+        ExecValue v;
+        if (type == TYPE_FLOAT) {
+            v.f = value.type == TYPE_FLOAT ? value.floatValue : (float)value.intValue;
+        }
+        else {
+            v.i = value.intValue;
+        }
+        return v;
+    }
+
+    static ConstantValue make(DataType type, ExecValue v) {
+        ConstantValue value{ type, 0, 0.0f };
+        if (type == TYPE_FLOAT) value.floatValue = v.f;
+        else value.intValue = v.i;
+        return value;
+    }
+
+    //   : ,   
+    void keep(const ASTNode* node, const ConstantValue& value) {
+        if (node->kind != NODE_CONST) table[node] = value;
+    }
+
+    bool evaluate(const ASTNode* node, ConstantValue& value) {
+        if (!node) return false;
+
+        if (node->kind == NODE_CONST) {
+            auto constant = static_cast<const ConstNode*>(node);
+            if (constant->range != LIT_OK) return false;
+            value = { constant->type, constant->intValue, constant->floatValue };
+            return true;
+        }
+
+        if (node->kind == NODE_UNARY_OP) {
+            auto unary = static_cast<const UnaryOpNode*>(node);
+            ConstantValue a;
+            if (!evaluate(unary->operand.get(), a)) return false;
+            ExecValue result;
+            if (evaluateUnary(unary->op, execType(a.type), operand(a, a.type), result)) {
+                value = make(a.type, result);
+                return true;
+            }
+            keep(unary->operand.get(), a);
+            return false;
+        }
+
+        if (node->kind == NODE_BINARY_OP) {
+            auto binary = static_cast<const BinaryOpNode*>(node);
+            ConstantValue a, b;
+            bool knownLeft = evaluate(binary->left.get(), a);
+            bool knownRight = evaluate(binary->right.get(), b);
+            if (knownLeft && knownRight) {
+                DataType type = widerType(a.type, b.type);
+                ExecValue result;
+                if (evaluateBinary(binary->op, execType(type), operand(a, type),
+                    operand(b, type), result)) {
+                    value = make(isComparison(binary->op) ? TYPE_INT : type, result);
+                    return true;
+                }
+            }
+            if (knownLeft) keep(binary->left.get(), a);
+            if (knownRight) keep(binary->right.get(), b);
+            return false;
+        }
+
+        //   :     
+        walk(*node);
+        return false;
+    }
+
+    void root(const ASTNode& node) {
+        ConstantValue value;
+        if (evaluate(&node, value)) table[&node] = value;
+    }
+
+public:
+    using ASTWalker::visit;
+
+    ConstantEvaluator(ConstantTable& result, bool wideLong)
+        : table(result), longIs64(wideLong) {}
+
+    void visit(const UnaryOpNode& node) { root(node); }
+    void visit(const BinaryOpNode& node) { root(node); }
+};
+
+std::unique_ptr<ASTNode> makeConstant(const ASTNode& node, const ConstantValue& value) {
+    auto constant = std::make_unique<ConstNode>();
+    constant->offset = node.offset;
+    constant->type = value.type;
+    constant->intValue = value.intValue;
+    constant->floatValue = value.floatValue;
+
+    //    ;      
+    char text[32];
+    auto result = value.type == TYPE_FLOAT
+        ? std::to_chars(text, text + sizeof(text), value.floatValue)
+        : std::to_chars(text, text + sizeof(text), value.intValue);
+    constant->value.assign(text, result.ptr);
+    return constant;
+}
+
+void fold(ASTNode& node, const ConstantTable& constants, int& folded) {
+    forEachChildSlot(node, [&](std::unique_ptr<ASTNode>& slot) {
+        if (!slot) return;
+        //    ;    
+        bool operation = slot->kind == NODE_BINARY_OP || slot->kind == NODE_UNARY_OP;
+        auto found = operation ? constants.find(slot.get()) : constants.end();
+        if (found != constants.end()) {
+            slot = makeConstant(*slot, found->second);
+            folded++;
+        }
+        else {
+            fold(*slot, constants, folded);
+        }
+    });
+}
+
+}
+
+PassManager::PassManager(ProgramNode& ast, const LineTable& lineTable,
+    TargetAbi targetAbi, ModuleProvider* provider)
+    : program(ast), lines(lineTable), target(targetAbi), modules(provider) {}
+
+SemanticAnalyzer& PassManager::semantic() {
+    if (!isValid(ANALYSIS_SEMANTIC)) {
+        semanticResult.reset(new SemanticAnalyzer());
+        semanticResult->setTargetAbi(target);
+        semanticResult->setModuleProvider(modules);
+        semanticResult->setLineTable(&lines);
+        Symbol* dummy = nullptr;
+        program.checkSemantics(*semanticResult, dummy);
+        valid |= analysisBit(ANALYSIS_SEMANTIC);
+        computed[ANALYSIS_SEMANTIC]++;
+        TALT_COUNT(STAT_ANALYSES_COMPUTED);
+    }
+    return *semanticResult;
+}
+
+const ConstantTable& PassManager::constants() {
+    if (!isValid(ANALYSIS_CONSTANTS)) {
+        //  long   ,   
+        bool longIs64 = semantic().typeSize(TYPE_LONG) == 8;
+        constantTable.clear();
+        ConstantEvaluator evaluator(constantTable, longIs64);
+        evaluator.walk(static_cast<const ProgramNode&>(program));
+        valid |= analysisBit(ANALYSIS_CONSTANTS);
+        computed[ANALYSIS_CONSTANTS]++;
+        TALT_COUNT(STAT_ANALYSES_COMPUTED);
+    }
+    return constantTable;
+}
+
+void PassManager::invalidate(AnalysisSet analyses) {
+    //      
+    if (analyses & analysisBit(ANALYSIS_SEMANTIC)) {
+        analyses |= analysisBit(ANALYSIS_CONSTANTS);
+    }
+    valid &= ~analyses;
+    if (analyses & analysisBit(ANALYSIS_CONSTANTS)) {
+        ConstantTable().swap(constantTable);
+    }
+}
+
+void PassManager::run(TransformPass& pass) {
+    AnalysisSet preserved = pass.run(program, *this);
+    invalidate(ALL_ANALYSES & ~preserved);
+}
+
+AnalysisSet ConstantFolding::run(ProgramNode& program, PassManager& passes) {
+    const ConstantTable& constants = passes.constants();
+    if (constants.empty()) return ALL_ANALYSES;
+
+    int before = folded;
+    fold(program, constants, folded);
+    TALT_COUNT_ADD(STAT_CONSTANTS_FOLDED, folded - before);
+
+    //  ,      . 
+    //  :     .
+    if (folded == before) return ALL_ANALYSES;
+    return analysisBit(ANALYSIS_SEMANTIC);
+}
@@ -0,0 +1,94 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include "parser.h"
+#include "semantic.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// ,   PassManager   
+enum AnalysisId {
+    ANALYSIS_SEMANTIC,   // ,    
+    ANALYSIS_CONSTANTS,  //  ,   
+
+    ANALYSIS_COUNT
+};
+
+typedef unsigned AnalysisSet;
+
+constexpr AnalysisSet analysisBit(AnalysisId id) {
+    return 1u << id;
+}
+
+const AnalysisSet NO_ANALYSES = 0;
+const AnalysisSet ALL_ANALYSES = (1u << ANALYSIS_COUNT) - 1;
+
+//      
+struct ConstantValue {
+    DataType type;
+    int64_t intValue;
+    float floatValue;
+};
+
+//     :  
+//     ,     -  
+//   .
+typedef std::unordered_map<const ASTNode*, ConstantValue> ConstantTable;
+
+class PassManager;
+
+// ,  .  ,   
+//  ;  PassManager .
+class TransformPass {
+public:
+    virtual ~TransformPass() = default;
+    virtual const char* name() const = 0;
+    virtual AnalysisSet run(ProgramNode& program, PassManager& passes) = 0;
+};
+
+//    .     ,
+//  ,   ,  ,   
+//  .       .
+class PassManager {
+public:
+    // lines -    program,    
+    PassManager(ProgramNode& program, const LineTable& lines, TargetAbi target,
+        ModuleProvider* modules = nullptr);
+
+    //   .    
+    //   :     .
+    SemanticAnalyzer& semantic();
+    const ConstantTable& constants();
+
+    void run(TransformPass& pass);
+    void invalidate(AnalysisSet analyses);
+    bool isValid(AnalysisId id) const { return (valid & analysisBit(id)) != 0; }
+    //    
+    int computeCount(AnalysisId id) const { return computed[id]; }
+
+private:
+    ProgramNode& program;
+    const LineTable& lines;
+    TargetAbi target;
+    ModuleProvider* modules;
+    AnalysisSet valid = NO_ANALYSES;
+    int computed[ANALYSIS_COUNT] = {};
+
+    std::unique_ptr<SemanticAnalyzer> semanticResult;
+    ConstantTable constantTable;
+};
+
+//  ,   , . 
+//   ,    
+// ;        
+// .   .
+class ConstantFolding : public TransformPass {
+public:
+    const char* name() const override { return "fold-constants"; }
+    AnalysisSet run(ProgramNode& program, PassManager& passes) override;
+
+    int folded = 0;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+//  ,    SLAB_SIZE .  
+//   :    ,  
+// ,  T    .  
+//    recycle(), create()   .
+template <class T, size_t SLAB_SIZE = 1024>
+class SlabPool {
+    static_assert(std::is_trivially_destructible<T>::value,
+        "SlabPool   ");
+
+private:
+    std::vector<T*> slabs;
+    size_t active;  //   ,    
+    size_t used;    //   
+    std::vector<T*> recycled;
+
+public:
+    //    rewind: ,   , 
+    struct Mark {
+        size_t active;
+        size_t used;
+    };
+
+    SlabPool() : active(0), used(SLAB_SIZE) {}
+    ~SlabPool() { release(); }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    template <class... Args>
+    T* create(Args&&... args) {
+        if (!recycled.empty()) {
+            T* object = recycled.back();
+            recycled.pop_back();
+            return new (object) T(std::forward<Args>(args)...);
+        }
+        if (used == SLAB_SIZE) {
+            //  rewind   ,     
+            if (active == slabs.size()) {
+                slabs.push_back(static_cast<T*>(::operator new(sizeof(T) * SLAB_SIZE)));
+            }
+            active++;
+            used = 0;
+        }
+        return new (slabs[active - 1] + used++) T(std::forward<Args>(args)...);
+    }
+
+    void recycle(T* object) {
+        recycled.push_back(object);
+    }
+
+    Mark mark() const { return { active, used }; }
+
+    //   mark  ,   - ;
+    //    
+    void rewind(Mark position) {
+        active = position.active;
+        used = position.used;
+        recycled.clear();
+    }
+
+    void release() {
+        for (T* slab : slabs) {
+            ::operator delete(slab);
+        }
+        slabs.clear();
+        recycled.clear();
+        active = 0;
+        used = SLAB_SIZE;
+    }
+
+    //  
+    size_t size() const {
+        return (active == 0 ? 0 : (active - 1) * SLAB_SIZE + used) - recycled.size();
+    }
+};
+
+//     ,    .
+//    ; rewind   
+//  ,     .
+class Arena {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+    static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+    std::vector<char*> blocks;
+    size_t active;    //   ,    
+    size_t used;      //   
+    std::vector<char*> large;  //   ,    
+
+public:
+    Arena() : active(0), used(BLOCK_SIZE) {}
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size) {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (size > BLOCK_SIZE / 4) {
+            large.push_back(static_cast<char*>(::operator new(size)));
+            return large.back();
+        }
+        if (used + size > BLOCK_SIZE) {
+            if (active == blocks.size()) {
+                blocks.push_back(static_cast<char*>(::operator new(BLOCK_SIZE)));
+            }
+            active++;
+            used = 0;
+        }
+        void* result = blocks[active - 1] + used;
+        used += size;
+        return result;
+    }
+
+    //     ,  
+    void rewind() {
+        for (char* block : large) {
+            ::operator delete(block);
+        }
+        large.clear();
+        active = 0;
+        used = BLOCK_SIZE;
+    }
+
+    void release() {
+        rewind();
+        for (char* block : blocks) {
+            ::operator delete(block);
+        }
+        blocks.clear();
+    }
+
+    //   ,  
+    size_t capacity() const { return blocks.size() * BLOCK_SIZE; }
+};
+
+#endif
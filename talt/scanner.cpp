@@ -1,19 +1,22 @@
 #include "scanner.h"
+#include "memory.h"
 #include <cctype>
+#include <charconv>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
 std::unordered_map<std::string, TokenType> Scanner::keywords = {
     {"int", TK_INT}, {"short", TK_SHORT}, {"long", TK_LONG},
     {"float", TK_FLOAT}, {"struct", TK_STRUCT}, {"for", TK_FOR},
-    {"return", TK_RETURN}, {"void", TK_VOID}
+    {"return", TK_RETURN}, {"void", TK_VOID}, {"import", TK_IMPORT}
 };
 
 std::string Token::typeToString() const {
     static std::unordered_map<TokenType, std::string> tokenNames = {
         {TK_INT, "TK_INT"}, {TK_SHORT, "TK_SHORT"}, {TK_LONG, "TK_LONG"},
         {TK_FLOAT, "TK_FLOAT"}, {TK_STRUCT, "TK_STRUCT"}, {TK_FOR, "TK_FOR"},
-        {TK_RETURN, "TK_RETURN"}, {TK_VOID, "TK_VOID"},
+        {TK_RETURN, "TK_RETURN"}, {TK_VOID, "TK_VOID"}, {TK_IMPORT, "TK_IMPORT"},
         {TK_PLUS, "TK_PLUS"}, {TK_MINUS, "TK_MINUS"}, {TK_MUL, "TK_MUL"},
         {TK_DIV, "TK_DIV"}, {TK_MOD, "TK_MOD"}, {TK_ASSIGN, "TK_ASSIGN"},
         {TK_LPAREN, "TK_LPAREN"}, {TK_RPAREN, "TK_RPAREN"},
@@ -35,79 +38,233 @@ std::string Token::typeToString() const {
     return "UNKNOWN_TOKEN";
 }
 
+// keepFrom   
+const size_t NOTHING_KEPT = (size_t)-1;
+
 Scanner::Scanner(const std::string& filename)
-    : line(1), column(0), eof(false), currentChar(' ') {
+    : data(nullptr), next(0), limit(0), keepFrom(NOTHING_KEPT), base(0),
+    input(&file), currentChar(' '), eof(false) {
     file.open(filename);
     if (!file.is_open()) {
         std::cerr << "  : " << filename << std::endl;
     }
 }
 
+Scanner::Scanner(std::istream& source)
+    : data(nullptr), next(0), limit(0), keepFrom(NOTHING_KEPT), base(0),
+    input(&source), currentChar(' '), eof(false) {}
+
+Scanner::Scanner(const char* text, size_t size)
+    : data(nullptr), next(0), limit(0), keepFrom(NOTHING_KEPT), base(0),
+    input(nullptr), currentChar(' '), eof(false) {
+    assign(text, size);
+}
+
+Scanner::Scanner()
+    : data(nullptr), next(0), limit(0), keepFrom(NOTHING_KEPT), base(0),
+    input(nullptr), currentChar(' '), eof(false) {
+    resetPush();
+}
+
+Scanner::Scanner(ChunkReader& source)
+    : data(nullptr), next(0), limit(0), keepFrom(NOTHING_KEPT), base(0),
+    input(nullptr), currentChar(' '), eof(false) {
+    resetPush();
+    reader = &source;
+}
+
+void Scanner::assign(const char* text, size_t size) {
+    if (file.is_open()) file.close();
+    input = nullptr;
+    data = text;
+    next = 0;
+    limit = size;
+    keepFrom = NOTHING_KEPT;
+    base = 0;
+    currentChar = ' ';
+    eof = false;
+    pendingParallel = false;
+    pushMode = false;
+    reader = nullptr;
+    lexState = LEX_CODE;
+    starved = false;
+
+    //  32-:     
+    if (limit > SOURCE_SIZE_LIMIT) {
+        std::cerr << ":    4 ,   " << std::endl;
+        limit = (size_t)SOURCE_SIZE_LIMIT;
+    }
+    lines.clear();
+    lines.scan(data, limit, 0);
+}
+
 Scanner::~Scanner() {
     if (file.is_open()) file.close();
 }
 
 bool Scanner::open() {
-    return file.is_open();
+    return input != &file || file.is_open();
 }
 
-char Scanner::getChar() {
-    if (!file.get(currentChar)) {
-        eof = true;
-        currentChar = '\0';
+//     ;  
+void Scanner::resetPush() {
+    pushMode = true;
+    finished = false;
+    lexState = LEX_CODE;
+    starved = false;
+    pendingParallel = false;
+    data = buffer.data();
+    next = limit = 0;
+    base = 0;
+    currentChar = ' ';
+    eof = false;
+    lines.clear();
+}
+
+//    .   next   ,
+//     -  ,    .
+char* Scanner::feedSpace(size_t size) {
+    size_t from = starved ? starvedNext : next;
+    if (from > 0) {
+        std::memmove(buffer.data(), buffer.data() + from, limit - from);
+        base += (SourceOffset)from;
+        limit -= from;
+        next -= from;
+        if (starved) starvedNext -= from;
     }
-    else {
-        column++;
-        if (currentChar == '\n') {
-            line++;
-            column = 0;
+    if (buffer.size() < limit + size) buffer.resize(limit + size);
+    data = buffer.data();
+    return buffer.data() + limit;
+}
+
+//    limit  size 
+void Scanner::fed(size_t size) {
+    uint64_t total = (uint64_t)base + limit;
+    if (total + size > SOURCE_SIZE_LIMIT) {
+        std::cerr << ":    4 ,   " << std::endl;
+        size = (size_t)(SOURCE_SIZE_LIMIT - total);
+        finished = true;
+    }
+    lines.scan(buffer.data() + limit, size, base + (SourceOffset)limit);
+    limit += size;
+}
+
+void Scanner::feed(const char* chunk, size_t size) {
+    if (finished || size == 0) return;
+    std::memcpy(feedSpace(size), chunk, size);
+    fed(size);
+}
+
+// ,      (next == limit); advance -
+//  getChar,    peekChar
+bool Scanner::refill(bool advance) {
+    if (pushMode) {
+        //   :     
+        if (!finished && !starved) {
+            starved = true;
+            starvedAdvance = advance;
+            starvedNext = next;
+            starvedChar = currentChar;
+        }
+        return false;
+    }
+    //     
+    if (!input) return false;
+
+    size_t kept = keepFrom < limit ? limit - keepFrom : 0;
+    if (kept > 0) std::memmove(buffer.data(), buffer.data() + keepFrom, kept);
+    if (keepFrom != NOTHING_KEPT) keepFrom = 0;
+    base += (SourceOffset)(limit - kept);
+    next = limit = kept;
+
+    if (!*input) return false;
+    size_t want = BLOCK_SIZE;
+    uint64_t total = (uint64_t)base + limit;
+    if (total + want > SOURCE_SIZE_LIMIT) {
+        want = (size_t)(SOURCE_SIZE_LIMIT - total);
+        if (want == 0) {
+            std::cerr << ":    4 ,   " << std::endl;
+            input->setstate(std::ios::failbit);
+            return false;
         }
     }
-    return currentChar;
+
+    if (buffer.size() < limit + want) buffer.resize(limit + want);
+    data = buffer.data();
+    input->read(buffer.data() + limit, want);
+    size_t got = (size_t)input->gcount();
+    if (got == 0) return false;
+    lines.scan(buffer.data() + limit, got, base + (SourceOffset)limit);
+    limit += got;
+    return true;
 }
 
 char Scanner::peekChar() {
     if (eof) return '\0';
-    char ch = file.peek();
-    return ch;
+    if (next == limit && !refill(false)) return '\0';
+    return data[next];
 }
 
 void Scanner::skipWhitespace() {
-    while (std::isspace(currentChar) && !eof) {
+    while (std::isspace((unsigned char)currentChar) && !eof) {
         getChar();
     }
 }
 
 void Scanner::skipComment() {
     if (currentChar == '/' && peekChar() == '/') {
-        while (currentChar != '\n' && !eof) {
-            getChar();
-        }
-        if (!eof) getChar(); //  \n
+        commentText.clear();
+        lexState = LEX_LINE_COMMENT;
+        continueLineComment();
     }
     else if (currentChar == '/' && peekChar() == '*') {
+        lexState = LEX_BLOCK_COMMENT;
         getChar(); //  *
         getChar(); //   
-        while (!eof) {
-            if (currentChar == '*' && peekChar() == '/') {
-                getChar(); //  *
-                getChar(); //  /
-                break;
-            }
-            getChar();
+        continueBlockComment();
+    }
+}
+
+//    ,    
+//         
+void Scanner::continueLineComment() {
+    std::string& text = commentText;
+    while (currentChar != '\n' && !eof) {
+        text += currentChar;
+        getChar();
+    }
+    if (starved) return;
+    // \n   currentChar,   skipWhitespace
+    lexState = LEX_CODE;
+
+    // : "// talt: parallel"   
+    size_t begin = text.find_first_not_of(" \t", 2);
+    size_t end = text.find_last_not_of(" \t\r");
+    if (begin != std::string::npos &&
+        text.compare(begin, end - begin + 1, PRAGMA_PARALLEL) == 0) {
+        pendingParallel = true;
+    }
+}
+
+void Scanner::continueBlockComment() {
+    while (!eof) {
+        if (currentChar == '*' && peekChar() == '/') {
+            getChar(); //  *
+            lexState = LEX_CODE;
+            getChar(); //  /
+            return;
         }
+        getChar();
     }
 }
 
 Token Scanner::scanNumber() {
     std::string num;
-    int startLine = line;
-    int startCol = column;
+    SourceOffset start = here();
     bool isFloat = false;
-    bool hasExponent = false;
 
     //  
-    while (std::isdigit(currentChar) && !eof) {
+    while (std::isdigit((unsigned char)currentChar) && !eof) {
         num += currentChar;
         getChar();
     }
@@ -118,7 +275,7 @@ Token Scanner::scanNumber() {
         num += currentChar;
         getChar();
 
-        while (std::isdigit(currentChar) && !eof) {
+        while (std::isdigit((unsigned char)currentChar) && !eof) {
             num += currentChar;
             getChar();
         }
@@ -127,7 +284,6 @@ Token Scanner::scanNumber() {
     //  
     if (currentChar == 'e' || currentChar == 'E') {
         isFloat = true;
-        hasExponent = true;
         num += currentChar;
         getChar();
 
@@ -136,170 +292,269 @@ Token Scanner::scanNumber() {
             getChar();
         }
 
-        if (!std::isdigit(currentChar)) {
-            return Token(TK_ERROR, num, startLine, startCol);
+        if (!std::isdigit((unsigned char)currentChar)) {
+            return Token(TK_ERROR, num, start);
         }
 
-        while (std::isdigit(currentChar) && !eof) {
+        while (std::isdigit((unsigned char)currentChar) && !eof) {
             num += currentChar;
             getChar();
         }
     }
 
     // ,      (   123abc)
-    if (std::isalpha(currentChar) || currentChar == '_') {
-        while (std::isalnum(currentChar) || currentChar == '_') {
+    if (std::isalpha((unsigned char)currentChar) || currentChar == '_') {
+        while (std::isalnum((unsigned char)currentChar) || currentChar == '_') {
             num += currentChar;
             getChar();
         }
-        return Token(TK_ERROR, num, startLine, startCol);
+        return Token(TK_ERROR, num, start);
     }
 
-    return Token(isFloat ? TK_FLOAT_CONST : TK_INT_CONST,
-        num, startLine, startCol);
+    //     ; from_chars    
+    Token token(isFloat ? TK_FLOAT_CONST : TK_INT_CONST, num, start);
+    const char* first = num.data();
+    const char* last = first + num.size();
+    if (isFloat) {
+        auto result = std::from_chars(first, last, token.floatValue);
+        if (result.ec == std::errc::result_out_of_range) {
+            //    : double  , 
+            //     ;    
+            double value = 0;
+            bool small = std::from_chars(first, last, value).ec == std::errc()
+                ? value < 1 : num.find('-') != std::string::npos;
+            token.range = small ? LIT_TOO_SMALL : LIT_TOO_LARGE;
+            token.floatValue = 0;
+        }
+    }
+    else {
+        auto result = std::from_chars(first, last, token.intValue);
+        if (result.ec == std::errc::result_out_of_range) {
+            token.range = LIT_TOO_LARGE;
+            token.intValue = 0;
+        }
+    }
+    return token;
 }
 
 Token Scanner::scanIdentifier() {
     std::string id;
-    int startLine = line;
-    int startCol = column;
+    SourceOffset start = here();
 
-    while ((std::isalnum(currentChar) || currentChar == '_') && !eof) {
+    while ((std::isalnum((unsigned char)currentChar) || currentChar == '_') && !eof) {
         id += currentChar;
         getChar();
     }
 
     auto it = keywords.find(id);
     if (it != keywords.end()) {
-        return Token(it->second, id, startLine, startCol);
+        return Token(it->second, id, start);
     }
 
-    return Token(TK_IDENT, id, startLine, startCol);
+    return Token(TK_IDENT, id, start);
 }
 
 Token Scanner::scanOperator() {
-    int startLine = line;
-    int startCol = column;
+    SourceOffset start = here();
     char firstChar = currentChar;
     std::string op(1, firstChar);
 
     getChar();
 
     switch (firstChar) {
-    case '+': return Token(TK_PLUS, op, startLine, startCol);
-    case '-': return Token(TK_MINUS, op, startLine, startCol);
-    case '*': return Token(TK_MUL, op, startLine, startCol);
-    case '/': return Token(TK_DIV, op, startLine, startCol);
-    case '%': return Token(TK_MOD, op, startLine, startCol);
+    case '+': return Token(TK_PLUS, op, start);
+    case '-': return Token(TK_MINUS, op, start);
+    case '*': return Token(TK_MUL, op, start);
+    case '/': return Token(TK_DIV, op, start);
+    case '%': return Token(TK_MOD, op, start);
     case '=':
         if (currentChar == '=') {
             getChar();
-            return Token(TK_EQ, "==", startLine, startCol);
+            return Token(TK_EQ, "==", start);
         }
-        return Token(TK_ASSIGN, "=", startLine, startCol);
+        return Token(TK_ASSIGN, "=", start);
     case '<':
         if (currentChar == '=') {
             getChar();
-            return Token(TK_LE, "<=", startLine, startCol);
+            return Token(TK_LE, "<=", start);
         }
         else if (currentChar == '<') {
             getChar();
-            return Token(TK_SHL, "<<", startLine, startCol);
+            return Token(TK_SHL, "<<", start);
         }
-        return Token(TK_LT, "<", startLine, startCol);
+        return Token(TK_LT, "<", start);
     case '>':
         if (currentChar == '=') {
             getChar();
-            return Token(TK_GE, ">=", startLine, startCol);
+            return Token(TK_GE, ">=", start);
         }
         else if (currentChar == '>') {
             getChar();
-            return Token(TK_SHR, ">>", startLine, startCol);
+            return Token(TK_SHR, ">>", start);
         }
-        return Token(TK_GT, ">", startLine, startCol);
+        return Token(TK_GT, ">", start);
     case '!':
         if (currentChar == '=') {
             getChar();
-            return Token(TK_NE, "!=", startLine, startCol);
+            return Token(TK_NE, "!=", start);
         }
         break;
     case '&':
-        return Token(TK_BIT_AND, "&", startLine, startCol);
+        return Token(TK_BIT_AND, "&", start);
     case '|':
-        return Token(TK_BIT_OR, "|", startLine, startCol);
+        return Token(TK_BIT_OR, "|", start);
     case '^':
-        return Token(TK_BIT_XOR, "^", startLine, startCol);
+        return Token(TK_BIT_XOR, "^", start);
     case '~':
-        return Token(TK_BIT_NOT, "~", startLine, startCol);
-    case '(': return Token(TK_LPAREN, "(", startLine, startCol);
-    case ')': return Token(TK_RPAREN, ")", startLine, startCol);
-    case '{': return Token(TK_LBRACE, "{", startLine, startCol);
-    case '}': return Token(TK_RBRACE, "}", startLine, startCol);
-    case ';': return Token(TK_SEMICOLON, ";", startLine, startCol);
-    case ',': return Token(TK_COMMA, ",", startLine, startCol);
-    case '.': return Token(TK_DOT, ".", startLine, startCol);
-    case ':': return Token(TK_COLON, ":", startLine, startCol);
+        return Token(TK_BIT_NOT, "~", start);
+    case '(': return Token(TK_LPAREN, "(", start);
+    case ')': return Token(TK_RPAREN, ")", start);
+    case '{': return Token(TK_LBRACE, "{", start);
+    case '}': return Token(TK_RBRACE, "}", start);
+    case ';': return Token(TK_SEMICOLON, ";", start);
+    case ',': return Token(TK_COMMA, ",", start);
+    case '.': return Token(TK_DOT, ".", start);
+    case ':': return Token(TK_COLON, ":", start);
     }
 
-    return Token(TK_ERROR, std::string(1, firstChar), startLine, startCol);
+    return Token(TK_ERROR, std::string(1, firstChar), start);
 }
 
 Token Scanner::getNextToken() {
-    if (eof) return Token(TK_EOF, "", line, column);
+    if (pushMode) return readToken();
+
+    TALT_MEMORY_SCOPE(MEM_SCANNER);
+    Token token = scanToken();
+    token.parallel = pendingParallel;
+    pendingParallel = false;
+    TALT_COUNT(STAT_TOKENS);
+    return token;
+}
 
-    skipWhitespace();
+// getNextToken   :    reader, 
+//   ;  reader    
+Token Scanner::readToken() {
+    Token token;
+    while (!nextToken(token)) {
+        size_t got = 0;
+        if (reader) {
+            got = reader->read(feedSpace(BLOCK_SIZE), BLOCK_SIZE);
+            fed(got);
+        }
+        if (got == 0) finish();
+    }
+    return token;
+}
 
-    //   
-    if (currentChar == '/' && (peekChar() == '/' || peekChar() == '*')) {
+bool Scanner::nextToken(Token& token) {
+    TALT_MEMORY_SCOPE(MEM_SCANNER);
+    if (starved) {
+        //   ,   
+        starved = false;
+        next = starvedNext;
+        currentChar = starvedChar;
+        eof = false;
+        if (starvedAdvance) getChar();
+    }
+    if (lexState == LEX_LINE_COMMENT) continueLineComment();
+    else if (lexState == LEX_BLOCK_COMMENT) continueBlockComment();
+    if (!starved) skipTrivia();
+    if (starved) return false;
+
+    //   :      ,  
+    //    ,    
+    size_t start = next;
+    char first = currentChar;
+    Token scanned = scanLexeme();
+    if (starved) {
+        starved = false;
+        next = start;
+        currentChar = first;
+        eof = false;
+        return false;
+    }
+
+    token = std::move(scanned);
+    token.parallel = pendingParallel;
+    pendingParallel = false;
+    TALT_COUNT(STAT_TOKENS);
+    return true;
+}
+
+//   ,     
+void Scanner::skipTrivia() {
+    skipWhitespace();
+    while (currentChar == '/' && (peekChar() == '/' || peekChar() == '*')) {
         skipComment();
         skipWhitespace();
     }
+}
 
-    if (eof) return Token(TK_EOF, "", line, column);
+Token Scanner::scanToken() {
+    if (eof) return Token(TK_EOF, "", here());
+    skipTrivia();
+    return scanLexeme();
+}
 
-    if (std::isdigit(currentChar)) {
+Token Scanner::scanLexeme() {
+    if (eof) return Token(TK_EOF, "", here());
+
+    if (std::isdigit((unsigned char)currentChar)) {
         return scanNumber();
     }
-    else if (std::isalpha(currentChar) || currentChar == '_') {
+    else if (std::isalpha((unsigned char)currentChar) || currentChar == '_') {
         return scanIdentifier();
     }
-    else if (std::ispunct(currentChar)) {
+    else if (std::ispunct((unsigned char)currentChar)) {
         return scanOperator();
     }
     else if (currentChar == '\0') {
-        return Token(TK_EOF, "", line, column);
+        return Token(TK_EOF, "", here());
     }
 
-    Token error(TK_ERROR, std::string(1, currentChar), line, column);
+    Token error(TK_ERROR, std::string(1, currentChar), here());
     getChar();
     return error;
 }
 
 void Scanner::reset() {
-    if (file.is_open()) {
-        file.clear();
-        file.seekg(0);
+    if (pushMode) {
+        resetPush();
+        return;
     }
-    line = 1;
-    column = 0;
+    next = 0;
+    keepFrom = NOTHING_KEPT;
     eof = false;
     currentChar = ' ';
+    lexState = LEX_CODE;
+    //         
+    if (!input) return;
+
+    if (open()) {
+        input->clear();
+        input->seekg(0);
+    }
+    limit = 0;
+    base = 0;
+    lines.clear();
 }
 
 Token Scanner::peekNextToken() {
-    std::streampos oldPos = file.tellg();
-    int oldLine = line;
-    int oldCol = column;
+    //       : refill
+    //    keepFrom
+    keepFrom = next;
     char oldChar = currentChar;
     bool oldEof = eof;
+    bool oldParallel = pendingParallel;
 
-    Token next = getNextToken();
+    Token token = getNextToken();
 
-    file.seekg(oldPos);
-    line = oldLine;
-    column = oldCol;
+    TALT_COUNT(STAT_BACKTRACKS);
+    next = keepFrom;
+    keepFrom = NOTHING_KEPT;
     currentChar = oldChar;
     eof = oldEof;
+    pendingParallel = oldParallel;
 
-    return next;
+    return token;
 }
\ No newline at end of file
@@ -1,14 +1,19 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <fstream>
+#include <istream>
 #include <unordered_map>
+#include <vector>
+#include "stats.h"
+#include "source.h"
 
 //  
-enum TokenType {
+enum TokenType : unsigned char {
     //  
     TK_INT = 100, TK_SHORT, TK_LONG, TK_FLOAT,
-    TK_STRUCT, TK_FOR, TK_RETURN, TK_VOID,
+    TK_STRUCT, TK_FOR, TK_RETURN, TK_VOID, TK_IMPORT,
 
     // 
     TK_PLUS, TK_MINUS, TK_MUL, TK_DIV, TK_MOD,
@@ -29,42 +34,133 @@ enum TokenType {
     TK_EOF, TK_ERROR
 };
 
+//       
+enum LiteralRange : unsigned char {
+    LIT_OK,
+    LIT_TOO_LARGE,  //   INT64_MAX    FLT_MAX
+    LIT_TOO_SMALL   //     
+};
+
 struct Token {
     TokenType type;
+    bool parallel = false;  //     PRAGMA_PARALLEL
+    LiteralRange range = LIT_OK;
+    SourceOffset offset;    //  ;     LineTable
+
+    //  TK_INT_CONST  TK_FLOAT_CONST,  
+    union {
+        int64_t intValue = 0;
+        float floatValue;
+    };
+
     std::string lexeme;
-    int line;
-    int column;
 
-    Token(TokenType t = TK_ERROR, std::string l = "", int ln = 0, int col = 0)
-        : type(t), lexeme(l), line(ln), column(col) {}
+    Token(TokenType t = TK_ERROR, std::string l = "", SourceOffset at = 0)
+        : type(t), offset(at), lexeme(l) {}
 
     std::string typeToString() const;
 };
 
+// -:     for  
+// ,   
+const char* const PRAGMA_PARALLEL = "talt: parallel";
+
+//       :  , 
+//  ,    ; 0 -  
+class ChunkReader {
+public:
+    virtual ~ChunkReader() = default;
+    virtual size_t read(char* buffer, size_t size) = 0;
+};
+
 class Scanner {
 private:
+    bool pendingParallel = false;
 
-   
+    // ,       
+    enum LexState : unsigned char {
+        LEX_CODE,
+        LEX_LINE_COMMENT,
+        LEX_BLOCK_COMMENT
+    };
 
     static std::unordered_map<std::string, TokenType> keywords;
 
-    char getChar();
+    //   .   - base +   
+    //  + 1;    lines     .
+    //      ,     .
+    static const size_t BLOCK_SIZE = 64 * 1024;
+    std::vector<char> buffer;
+    const char* data;   // buffer.data()    
+    size_t next;        //    currentChar
+    size_t limit;       //   
+    size_t keepFrom;    // refill     
+    SourceOffset base;  //     
+    LineTable lines;
+    std::string commentText;  //  ,   
+
+    //  :     feed  reader.
+    //      ,   ;
+    // ,    ,    .
+    bool pushMode = false;
+    bool finished = false;  // finish:    
+    ChunkReader* reader = nullptr;
+    LexState lexState = LEX_CODE;
+    bool starved = false;   //     
+    bool starvedAdvance;    //      
+    size_t starvedNext;     // next  currentChar   
+    char starvedChar;
+
+    bool refill(bool advance);
+    char getChar() {
+        if (next == limit && !refill(true)) {
+            eof = true;
+            currentChar = '\0';
+        }
+        else {
+            currentChar = data[next++];
+        }
+        return currentChar;
+    }
+    //  currentChar
+    SourceOffset here() const { return base + (SourceOffset)next; }
     char peekChar();
     void skipWhitespace();
     void skipComment();
+    void continueLineComment();
+    void continueBlockComment();
+    void skipTrivia();
 
     Token scanNumber();
     Token scanIdentifier();
     Token scanOperator();
+    Token scanLexeme();
+    Token scanToken();
+    Token readToken();
+
+    void resetPush();
+    char* feedSpace(size_t size);
+    void fed(size_t size);
 
 public:
 
     Scanner(const std::string& filename);
+    //     
+    explicit Scanner(std::istream& source);
+    //   ;   ,   
+    Scanner(const char* text, size_t size);
+    //  :     feed
+    Scanner();
+    //    reader: getNextToken   
+    explicit Scanner(ChunkReader& source);
     ~Scanner();
 
+    //      .    ,
+    //        .
+    void assign(const char* text, size_t size);
+
     std::ifstream file;
-    int line;
-    int column;
+    std::istream* input;
     char currentChar;
     bool eof;
 
@@ -72,15 +168,19 @@ public:
     Token getNextToken();
     void reset();
 
-
-    std::streampos getPosition(){
-        return file.tellg();
-    }
-
-    void setPosition(std::streampos pos) {
-        file.seekg(pos);
-        eof = false;
-    }
-
+    //  ;     
     Token peekNextToken();
+
+    //  . feed  , finish   .
+    // nextToken  false,      
+    // ;  finish     TK_EOF.
+    void feed(const char* chunk, size_t size);
+    void finish() { finished = true; }
+    bool nextToken(Token& token);
+
+    //     ,   
+    //     
+    const LineTable& lineTable() const { return lines; }
+    //  :   offset   
+    void discardLinesBefore(SourceOffset offset) { lines.discardBefore(offset); }
 };
\ No newline at end of file
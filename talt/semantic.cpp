@@ -1,97 +1,201 @@
 #include "semantic.h"
+#include "layout.h"
+#include "memory.h"
+#include "typerules.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TALT_SSE2
+#endif
+
+int StructTypeInfo::findFieldIndex(NameId id) const {
+    if (fieldIds.size() > SMALL_STRUCT_FIELDS) {
+        uint32_t index = fieldIndex.find(id);
+        return index == NameIndexMap::NOT_FOUND ? -1 : (int)index;
+    }
+
+    //  :    ,   
+    const NameId* ids = fieldIds.data();
+    size_t count = fieldIds.size();
+    size_t i = 0;
+#ifdef TALT_SSE2
+    __m128i key = _mm_set1_epi32((int)id);
+    for (; i + 4 <= count; i += 4) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, key)));
+        if (mask != 0) {
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                i++;
+            }
+            return (int)i;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        if (ids[i] == id) return (int)i;
+    }
+    return -1;
+}
 
 SemanticAnalyzer::SemanticAnalyzer() {
-    globalScope = new Symbol("global", CAT_TYPE, TYPE_VOID);
+    scopeDepth = 0;
+    targetAbi = ABI_ILP32;
+    recordReferences = false;
+    modules = nullptr;
+    lines = nullptr;
+    returnType = nullptr;
+    flushedErrors = 0;
+    flushedWarnings = 0;
+    keptGlobal = nullptr;
+    structTypeCount = 0;
+    addBuiltinTypes();
+}
+
+SemanticAnalyzer::~SemanticAnalyzer() {
+    //     
+}
+
+void SemanticAnalyzer::addBuiltinTypes() {
+    globalScope = createSymbol("global", CAT_TYPE, builtinType(TYPE_VOID));
     currentScope = globalScope;
 
     //   
-    Symbol* intType = new Symbol("int", CAT_TYPE, TYPE_INT);
-    Symbol* shortType = new Symbol("short", CAT_TYPE, TYPE_SHORT);
-    Symbol* longType = new Symbol("long", CAT_TYPE, TYPE_LONG);
-    Symbol* floatType = new Symbol("float", CAT_TYPE, TYPE_FLOAT);
-    Symbol* voidType = new Symbol("void", CAT_TYPE, TYPE_VOID);
-
-    addToCurrentScope(intType);
-    addToCurrentScope(shortType);
-    addToCurrentScope(longType);
-    addToCurrentScope(floatType);
-    addToCurrentScope(voidType);
+    addToCurrentScope(createSymbol("int", CAT_TYPE, builtinType(TYPE_INT)));
+    addToCurrentScope(createSymbol("short", CAT_TYPE, builtinType(TYPE_SHORT)));
+    addToCurrentScope(createSymbol("long", CAT_TYPE, builtinType(TYPE_LONG)));
+    addToCurrentScope(createSymbol("float", CAT_TYPE, builtinType(TYPE_FLOAT)));
+    addToCurrentScope(createSymbol("void", CAT_TYPE, builtinType(TYPE_VOID)));
+    builtinsEnd = symbolPool.mark();
+    builtinCount = globalSymbols.size();
 }
 
-SemanticAnalyzer::~SemanticAnalyzer() {
-    //   
-    std::function<void(Symbol*)> deleteSymbol = [&](Symbol* sym) {
-        for (Symbol* child : sym->childScopes) {
-            deleteSymbol(child);
-        }
-        delete sym;
-    };
-    deleteSymbol(globalScope);
+StructTypeInfo& SemanticAnalyzer::newStructType() {
+    if (structTypeCount == structTypes.size()) {
+        structTypes.emplace_back();
+        return structTypes[structTypeCount++];
+    }
+    StructTypeInfo& info = structTypes[structTypeCount++];
+    info.reset();
+    return info;
 }
 
 Symbol* SemanticAnalyzer::createSymbol(const std::string& name,
-    ObjectCategory cat, DataType type) {
-    return new Symbol(name, cat, type);
+    ObjectCategory cat, const Type* type) {
+    return symbolPool.create(names.intern(name), cat, type);
+}
+
+SymbolExtra& SemanticAnalyzer::extraInfo(const Symbol* symbol) {
+    auto found = extras.find(symbol);
+    if (found != extras.end()) return found->second;
+    if (spareExtras.empty()) return extras[symbol];
+
+    auto node = std::move(spareExtras.back());
+    spareExtras.pop_back();
+    node.key() = symbol;
+    SymbolExtra& extra = node.mapped();
+    extra.parentStruct = NO_NAME;
+    extra.paramCount = 0;
+    extra.paramTypes.clear();
+    extra.sourceOffset = 0;
+    return extras.insert(std::move(node)).position->second;
 }
 
 void SemanticAnalyzer::addToCurrentScope(Symbol* symbol) {
+    if (currentScope == globalScope && symbol->name != NO_NAME &&
+        globalIndex.insert(symbol->name, (uint32_t)globalSymbols.size())) {
+        globalSymbols.push_back(symbol);
+    }
     symbol->parentScope = currentScope;
-    currentScope->childScopes.push_back(symbol);
+    if (currentScope->lastChild) {
+        currentScope->lastChild->nextSibling = symbol;
+    }
+    else {
+        currentScope->firstChild = symbol;
+    }
+    currentScope->lastChild = symbol;
 }
 
 void SemanticAnalyzer::enterScope() {
-    Symbol* newScope = new Symbol("", CAT_TYPE, TYPE_VOID);
-    newScope->parentScope = currentScope;
-    currentScope->childScopes.push_back(newScope);
+    Symbol* newScope = symbolPool.create(NO_NAME, CAT_TYPE, builtinType(TYPE_VOID));
+    addToCurrentScope(newScope);
     currentScope = newScope;
+    scopeDepth++;
+
+    TALT_COUNT(STAT_SCOPES);
+    TALT_COUNT_MAX(STAT_MAX_SCOPE_DEPTH, scopeDepth);
 }
 
 void SemanticAnalyzer::leaveScope() {
     if (currentScope->parentScope) {
         currentScope = currentScope->parentScope;
+        scopeDepth--;
     }
 }
 
-bool SemanticAnalyzer::declareVariable(const std::string& name, DataType type,
-    const std::string& structTypeName,
-    int line, int col) {
+bool SemanticAnalyzer::declareVariable(const std::string& name, const Type* type,
+    SourceOffset at) {
     //    
     if (findSymbolInCurrentScope(name)) {
         std::stringstream ss;
         ss << "   '" << name
-            << "'   " << line;
-        addError(ss.str(), line, col);
+            << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
     Symbol* var = createSymbol(name, CAT_VARIABLE, type);
-    var->structTypeName = structTypeName;  //   
-    var->isInitialized = false;
     addToCurrentScope(var);
 
+    if (recordReferences) {
+        extraInfo(var).sourceOffset = at;
+        references.push_back({ at, (int)name.size(), var, NO_NAME, NO_NAME, true });
+    }
+
     return true;
 }
 
+Symbol* SemanticAnalyzer::declareFunction(const std::string& name, const Type* returnType,
+    SourceOffset at) {
+    if (findSymbolInCurrentScope(name)) {
+        std::stringstream ss;
+        ss << "   '" << name
+            << "'   " << position(at).line;
+        addError(ss.str(), at);
+        return nullptr;
+    }
+
+    Symbol* function = createSymbol(name, CAT_FUNCTION, returnType);
+    addToCurrentScope(function);
+    if (recordReferences) {
+        extraInfo(function).sourceOffset = at;
+        references.push_back({ at, (int)name.size(), function, NO_NAME, NO_NAME, true });
+    }
+
+    return function;
+}
+
 bool SemanticAnalyzer::declareStructType(const std::string& name,
-    int line, int col) {
+    SourceOffset at) {
     //    
-    if (structTypes.find(name) != structTypes.end()) {
+    NameId id = names.intern(name);
+    if (structTypeIndex.find(id) != NameIndexMap::NOT_FOUND) {
         std::stringstream ss;
         ss << "   '" << name
-            << "'   " << line;
-        addError(ss.str(), line, col);
+            << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    StructTypeInfo structInfo;
-    structInfo.name = name;
-    structTypes[name] = structInfo;
+    structTypeIndex.insert(id, (uint32_t)structTypeCount);
+    newStructType().name = name;
 
     //    
-    Symbol* structSym = createSymbol(name, CAT_STRUCT_TYPE, TYPE_STRUCT);
+    Symbol* structSym = createSymbol(name, CAT_STRUCT_TYPE, builtinType(TYPE_STRUCT));
     addToCurrentScope(structSym);
 
     return true;
@@ -101,45 +205,112 @@ bool SemanticAnalyzer::addFieldToStruct(const std::string& structName,
     const std::string& fieldName,
     DataType type,
     const std::string& fieldStructType,
-    int line, int col) {
-    auto it = structTypes.find(structName);
-    if (it == structTypes.end()) {
+    SourceOffset at) {
+    StructTypeInfo* info = findStructType(structName);
+    if (!info) {
         std::stringstream ss;
         ss << " '" << structName << "'      '"
-            << fieldName << "'   " << line;
-        addError(ss.str(), line, col);
+            << fieldName << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    if (!it->second.addField(fieldName, type, fieldStructType)) {
+    if (!info->addField(names.intern(fieldName), fieldName, type, fieldStructType)) {
         std::stringstream ss;
         ss << "   '" << fieldName
-            << "'   '" << structName << "'   " << line;
-        addError(ss.str(), line, col);
+            << "'   '" << structName << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
     return true;
 }
 
+bool SemanticAnalyzer::importModule(const std::string& name, SourceOffset at) {
+    std::string why = "     ";
+    const ModuleInterface* module = modules ? modules->findModule(name, why) : nullptr;
+    if (!module) {
+        std::stringstream ss;
+        ss << " '" << name << "'     " << position(at).line << ": " << why;
+        addError(ss.str(), at);
+        return false;
+    }
+
+    bool ok = true;
+    for (const auto& imported : module->structs) {
+        //          
+        StructTypeInfo* existing = findStructType(imported.name);
+        if (existing && !existing->module.empty() && existing->module == imported.module) {
+            continue;
+        }
+        if (!declareStructType(imported.name, at)) {
+            ok = false;
+            continue;
+        }
+
+        //      
+        StructTypeInfo& info = *findStructType(imported.name);
+        info.module = imported.module;
+        for (const auto& field : imported.fields) {
+            info.addField(names.intern(field.name), field.name, field.type, field.structTypeName);
+            info.fields.back() = field;
+        }
+        info.size = imported.size;
+        info.align = imported.align;
+        info.complete = imported.complete;
+    }
+    return ok;
+}
+
 Symbol* SemanticAnalyzer::findSymbol(const std::string& name) const {
-    Symbol* scope = currentScope;
+    TALT_COUNT(STAT_SYMBOL_LOOKUPS);
+    NameId id = names.find(name);
+    if (id == NO_NAME) {
+        return nullptr;
+    }
 
-    while (scope) {
-        for (Symbol* sym : scope->childScopes) {
-            if (sym->name == name && sym->category != CAT_TYPE) {
+    for (Symbol* scope = currentScope; scope != globalScope; scope = scope->parentScope) {
+        for (Symbol* sym = scope->firstChild; sym; sym = sym->nextSibling) {
+            if (sym->name == id && sym->category != CAT_TYPE) {
                 return sym;
             }
         }
-        scope = scope->parentScope;
     }
 
+    return findGlobal(id, false);
+}
+
+Symbol* SemanticAnalyzer::findGlobal(NameId id, bool types) const {
+    uint32_t index = globalIndex.find(id);
+    if (index == NameIndexMap::NOT_FOUND) {
+        return nullptr;
+    }
+
+    Symbol* sym = globalSymbols[index];
+    if (types || sym->category != CAT_TYPE) {
+        return sym;
+    }
+    //     :    
+    for (sym = sym->nextSibling; sym; sym = sym->nextSibling) {
+        if (sym->name == id && sym->category != CAT_TYPE) {
+            return sym;
+        }
+    }
     return nullptr;
 }
 
 Symbol* SemanticAnalyzer::findSymbolInCurrentScope(const std::string& name) const {
-    for (Symbol* sym : currentScope->childScopes) {
-        if (sym->name == name) {
+    TALT_COUNT(STAT_SYMBOL_LOOKUPS);
+    NameId id = names.find(name);
+    if (id == NO_NAME) {
+        return nullptr;
+    }
+
+    if (currentScope == globalScope) {
+        return findGlobal(id, true);
+    }
+    for (Symbol* sym = currentScope->firstChild; sym; sym = sym->nextSibling) {
+        if (sym->name == id) {
             return sym;
         }
     }
@@ -147,262 +318,289 @@ Symbol* SemanticAnalyzer::findSymbolInCurrentScope(const std::string& name) cons
 }
 
 StructTypeInfo* SemanticAnalyzer::findStructType(const std::string& name) const {
-    auto it = structTypes.find(name);
-    if (it != structTypes.end()) {
-        return const_cast<StructTypeInfo*>(&it->second);
+    NameId id = names.find(name);
+    return id != NO_NAME ? findStructType(id) : nullptr;
+}
+
+StructTypeInfo* SemanticAnalyzer::findStructType(NameId name) const {
+    TALT_COUNT(STAT_SYMBOL_LOOKUPS);
+    uint32_t index = structTypeIndex.find(name);
+    if (index == NameIndexMap::NOT_FOUND) {
+        return nullptr;
     }
-    return nullptr;
+    return const_cast<StructTypeInfo*>(&structTypes[index]);
+}
+
+const FieldInfo* SemanticAnalyzer::lookupField(NameId structName, NameId fieldName) const {
+    StructTypeInfo* info = findStructType(structName);
+    return info ? info->findField(fieldName) : nullptr;
+}
+
+std::vector<const StructTypeInfo*> SemanticAnalyzer::sortedStructTypes() const {
+    std::vector<const StructTypeInfo*> sorted;
+    sortedStructTypes(sorted);
+    return sorted;
+}
+
+void SemanticAnalyzer::sortedStructTypes(std::vector<const StructTypeInfo*>& sorted) const {
+    sorted.clear();
+    for (size_t i = 0; i < structTypeCount; i++) {
+        sorted.push_back(&structTypes[i]);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+        [](const StructTypeInfo* a, const StructTypeInfo* b) { return a->name < b->name; });
 }
 
 Symbol* SemanticAnalyzer::checkIdentifier(const std::string& name,
-    int line, int col) {
+    SourceOffset at) {
     Symbol* symbol = findSymbol(name);
 
     if (!symbol) {
         // ,      
         if (findStructType(name)) {
             std::stringstream ss;
-            ss << "'" << name << "'   ,      " << line;
-            addError(ss.str(), line, col);
+            ss << "'" << name << "'   ,      " << position(at).line;
+            addError(ss.str(), at);
             return nullptr;
         }
 
         std::stringstream ss;
-        ss << " '" << name << "'     " << line;
-        addError(ss.str(), line, col);
+        ss << " '" << name << "'     " << position(at).line;
+        addError(ss.str(), at);
         return nullptr;
     }
 
-    if (symbol->category == CAT_TYPE && symbol->type != TYPE_STRUCT) {
+    if (symbol->category == CAT_TYPE && !symbol->type->isStruct()) {
         std::stringstream ss;
-        ss << "'" << name << "'  ,      " << line;
-        addError(ss.str(), line, col);
+        ss << "'" << name << "'  ,      " << position(at).line;
+        addError(ss.str(), at);
         return nullptr;
     }
 
     return symbol;
 }
 
-bool SemanticAnalyzer::isIntegerType(DataType type) const {
-    return type == TYPE_SHORT || type == TYPE_INT || type == TYPE_LONG;
+void SemanticAnalyzer::noteReference(const Symbol* symbol, SourceOffset at) {
+    if (!recordReferences || !symbol || at == 0) return;
+    references.push_back({ at, (int)nameOf(symbol->name).size(), symbol,
+        NO_NAME, NO_NAME, false });
 }
 
-bool SemanticAnalyzer::isFloatType(DataType type) const {
-    return type == TYPE_FLOAT;
+void SemanticAnalyzer::noteFieldReference(NameId structName,
+    const std::string& fieldName, SourceOffset at, bool declaration) {
+    if (!recordReferences || at == 0) return;
+    NameId field = names.find(fieldName);
+    StructTypeInfo* info = findStructType(structName);
+    FieldInfo* found = info && field != NO_NAME ? info->findField(field) : nullptr;
+    if (!found) return;
+
+    if (declaration) {
+        found->sourceOffset = at;
+    }
+    references.push_back({ at, (int)fieldName.size(), nullptr,
+        structName, field, declaration });
 }
 
-bool SemanticAnalyzer::isNumericType(DataType type) const {
-    return isIntegerType(type) || isFloatType(type);
+const Type* SemanticAnalyzer::typeOf(DataType kind, const std::string& structName) {
+    return kind == TYPE_STRUCT ? types.structType(names.intern(structName))
+        : builtinType(kind);
 }
 
-DataType SemanticAnalyzer::promoteType(DataType t1, DataType t2) const {
-    if (t1 == TYPE_FLOAT || t2 == TYPE_FLOAT) {
-        return TYPE_FLOAT;
-    }
+const Type* SemanticAnalyzer::fieldType(const FieldInfo& field) {
+    return typeOf(field.type, field.structTypeName);
+}
 
-    if (t1 == TYPE_LONG || t2 == TYPE_LONG) {
-        return TYPE_LONG;
-    }
-    if (t1 == TYPE_INT || t2 == TYPE_INT) {
-        return TYPE_INT;
+std::string SemanticAnalyzer::typeToString(const Type* type) const {
+    if (type->isStruct() && type->structName != NO_NAME) {
+        return "struct " + nameOf(type->structName);
     }
-
-    return TYPE_SHORT;
+    return dataTypeToString(type->kind);
 }
 
-bool SemanticAnalyzer::checkAssignment(Symbol* left, DataType rightType,
-    int line, int col) {
+bool SemanticAnalyzer::checkAssignment(Symbol* left, const Type* rightType,
+    SourceOffset at) {
     if (!left) {
-        addError("    ", line, col);
+        addError("    ", at);
         return false;
     }
 
     if (left->category != CAT_VARIABLE) {
         std::stringstream ss;
-        ss << "        " << line;
-        addError(ss.str(), line, col);
+        ss << "        " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    DataType leftType = left->type;
-
-    //     
-    if (leftType == TYPE_STRUCT) {
-        if (rightType == TYPE_STRUCT) {
-            //   ,    
-            if (!left->structTypeName.empty()) {
-                Symbol* rightSymbol = findSymbolInCurrentScope("..."); //     
-                //  :    - 
-                return true;
-            }
-        }
-        return false;
-    }
+    return checkAssignable(left->type, rightType, at);
+}
 
-    if (leftType == rightType) {
+bool SemanticAnalyzer::checkAssignable(const Type* left, const Type* right,
+    SourceOffset at) {
+    //  : ,      
+    // , -   
+    if (left == right) {
         return true;
     }
 
-    if (leftType == TYPE_FLOAT && isIntegerType(rightType)) {
-        std::stringstream ss;
-        ss << "     float   " << line;
-        addWarning(ss.str(), line, col);
-        return true;
+    const AssignmentCheck& rule = assignmentRule(targetAbi, left->kind, right->kind);
+    if (rule.diagnostic == TDIAG_NONE) {
+        return rule.allowed;
     }
 
-    if (isIntegerType(leftType) && rightType == TYPE_FLOAT) {
-        std::stringstream ss;
-        ss << "  float      " << line
-            << " ( )";
-        addError(ss.str(), line, col);
-        return false;
+    std::stringstream ss;
+    ss << typeDiagnosticText(rule.diagnostic);
+    if (rule.diagnostic == TDIAG_INCOMPATIBLE_ASSIGNMENT) {
+        ss << ": " << typeToString(left) << "  " << typeToString(right);
+    }
+    ss << "   " << position(at).line;
+    if (rule.diagnostic == TDIAG_FLOAT_TO_INTEGER) {
+        ss << " ( )";
+    }
+    if (rule.allowed) {
+        addWarning(ss.str(), at);
+    }
+    else {
+        addError(ss.str(), at);
     }
+    return rule.allowed;
+}
 
-    if (isIntegerType(leftType) && isIntegerType(rightType)) {
-        int leftSize = 0, rightSize = 0;
-        if (leftType == TYPE_SHORT) leftSize = 2;
-        else if (leftType == TYPE_INT) leftSize = 4;
-        else if (leftType == TYPE_LONG) leftSize = 4;
+int SemanticAnalyzer::typeSize(DataType type) const {
+    return TYPE_TRAITS[type].size[targetAbi];
+}
 
-        if (rightType == TYPE_SHORT) rightSize = 2;
-        else if (rightType == TYPE_INT) rightSize = 4;
-        else if (rightType == TYPE_LONG) rightSize = 4;
+int SemanticAnalyzer::typeAlign(DataType type) const {
+    //      
+    int size = typeSize(type);
+    return size > 0 ? size : 1;
+}
 
-        if (rightSize > leftSize) {
-            std::stringstream ss;
-            ss << "       " << line;
-            addWarning(ss.str(), line, col);
-        }
-        return true;
+bool SemanticAnalyzer::layoutStruct(const std::string& name, SourceOffset at) {
+    StructTypeInfo* found = findStructType(name);
+    if (!found) {
+        return false;
     }
-
-    std::stringstream ss;
-    ss << "   : "
-        << dataTypeToString(leftType) << "  " << dataTypeToString(rightType)
-        << "   " << line;
-    addError(ss.str(), line, col);
-    return false;
-}
-
-DataType SemanticAnalyzer::checkBinaryOperation(TokenType op,
-    DataType leftType,
-    DataType rightType,
-    int line, int col) {
-    if (op == TK_PLUS || op == TK_MINUS || op == TK_MUL || op == TK_DIV) {
-        if (!isNumericType(leftType) || !isNumericType(rightType)) {
-            std::stringstream ss;
-            ss << "         " << line;
-            addError(ss.str(), line, col);
-            return TYPE_UNDEFINED;
+    StructTypeInfo& info = *found;
+
+    bool ok = true;
+    for (auto& field : info.fields) {
+        if (field.type == TYPE_STRUCT) {
+            //       ,
+            //       
+            const StructTypeInfo* nested = findStructType(field.structTypeName);
+            if (!nested || !nested->complete) {
+                std::stringstream ss;
+                ss << " '" << field.name << "'  '" << name
+                    << "'    '" << field.structTypeName
+                    << "'   " << position(at).line;
+                addError(ss.str(), at);
+                ok = false;
+                field.size = 0;
+                field.align = 1;
+                continue;
+            }
+            field.size = nested->size;
+            field.align = nested->align;
         }
-        return promoteType(leftType, rightType);
-    }
-
-    if (op == TK_EQ || op == TK_NE || op == TK_LT || op == TK_LE ||
-        op == TK_GT || op == TK_GE) {
-        if (!isNumericType(leftType) || !isNumericType(rightType)) {
-            std::stringstream ss;
-            ss << "         " << line;
-            addError(ss.str(), line, col);
-            return TYPE_UNDEFINED;
+        else {
+            field.size = typeSize(field.type);
+            field.align = typeAlign(field.type);
         }
-        return TYPE_INT;
+        if (field.align > info.align) info.align = field.align;
     }
 
-    if (op == TK_BIT_AND || op == TK_BIT_OR || op == TK_BIT_XOR ||
-        op == TK_SHL || op == TK_SHR) {
-        if (!isIntegerType(leftType) || !isIntegerType(rightType)) {
-            std::stringstream ss;
-            ss << "         " << line;
-            addError(ss.str(), line, col);
-            return TYPE_UNDEFINED;
-        }
-        return promoteType(leftType, rightType);
-    }
+    info.size = assignFieldOffsets(info.fields);
+    info.complete = ok;
+    return ok;
+}
 
-    if (op == TK_MOD) {
-        if (!isIntegerType(leftType) || !isIntegerType(rightType)) {
-            std::stringstream ss;
-            ss << " %        " << line;
-            addError(ss.str(), line, col);
-            return TYPE_UNDEFINED;
-        }
-        return promoteType(leftType, rightType);
+const Type* SemanticAnalyzer::checkBinaryOperation(TokenType op,
+    const Type* left,
+    const Type* right,
+    SourceOffset at) {
+    //       ,    
+    // TYPE_STRUCT     
+    const TypeRule& rule = binaryRule(op, left->kind, right->kind);
+    if (rule.diagnostic != TDIAG_NONE) {
+        std::stringstream ss;
+        ss << typeDiagnosticText(rule.diagnostic) << "   " << position(at).line;
+        addError(ss.str(), at);
     }
-
-    return TYPE_UNDEFINED;
+    return builtinType(rule.result);
 }
 
 bool SemanticAnalyzer::checkFieldAccess(Symbol* structVar,
     const std::string& fieldName,
-    DataType* resultType,
-    int line, int col) {
+    const Type** resultType,
+    SourceOffset at) {
     if (!structVar) {
-        addError("  ", line, col);
+        addError("  ", at);
         return false;
     }
 
-    if (structVar->type != TYPE_STRUCT) {
+    if (!structVar->type->isStruct()) {
         std::stringstream ss;
-        ss << "           " << line;
-        addError(ss.str(), line, col);
+        ss << "           " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    if (structVar->structTypeName.empty()) {
+    NameId structName = structVar->type->structName;
+    if (structName == NO_NAME) {
         std::stringstream ss;
-        ss << "      '" << structVar->name << "'   " << line;
-        addError(ss.str(), line, col);
+        ss << "      '" << nameOf(structVar->name)
+            << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    StructTypeInfo* structInfo = findStructType(structVar->structTypeName);
+    StructTypeInfo* structInfo = findStructType(structName);
     if (!structInfo) {
         std::stringstream ss;
-        ss << "  '" << structVar->structTypeName
-            << "'     " << line;
-        addError(ss.str(), line, col);
+        ss << "  '" << nameOf(structName)
+            << "'     " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
-    FieldInfo* field = structInfo->findField(fieldName);
+    FieldInfo* field = structInfo->findField(names.find(fieldName));
     if (!field) {
         std::stringstream ss;
         ss << " '" << fieldName << "'     '"
-            << structInfo->name << "'   " << line;
-        addError(ss.str(), line, col);
+            << structInfo->name << "'   " << position(at).line;
+        addError(ss.str(), at);
         return false;
     }
 
     if (resultType) {
-        *resultType = field->type;
+        *resultType = fieldType(*field);
     }
 
     return true;
 }
 
-bool SemanticAnalyzer::checkForLoop(DataType initType, DataType condType,
-    DataType incType, int line, int col) {
+bool SemanticAnalyzer::checkForLoop(const Type* initType, const Type* condType,
+    const Type* incType, SourceOffset at) {
     bool hasError = false;
 
-    if (initType != TYPE_VOID && !isNumericType(initType)) {
+    if (initType->kind != TYPE_VOID && !initType->isNumeric()) {
         std::stringstream ss;
-        ss << "    for      " << line;
-        addError(ss.str(), line, col);
+        ss << "    for      " << position(at).line;
+        addError(ss.str(), at);
         hasError = true;
     }
 
-    if (condType != TYPE_UNDEFINED && !isNumericType(condType)) {
+    if (condType->kind != TYPE_UNDEFINED && !condType->isNumeric()) {
         std::stringstream ss;
-        ss << "    for      " << line;
-        addError(ss.str(), line, col);
+        ss << "    for      " << position(at).line;
+        addError(ss.str(), at);
         hasError = true;
     }
 
-    if (incType != TYPE_UNDEFINED && !isNumericType(incType)) {
+    if (incType->kind != TYPE_UNDEFINED && !incType->isNumeric()) {
         std::stringstream ss;
-        ss << "    for      " << line;
-        addError(ss.str(), line, col);
+        ss << "    for      " << position(at).line;
+        addError(ss.str(), at);
         hasError = true;
     }
 
@@ -440,133 +638,222 @@ std::string SemanticAnalyzer::categoryToString(ObjectCategory cat) {
     case CAT_FIELD: return "field";
     case CAT_STRUCT_TYPE: return "struct_type";
     case CAT_TYPE: return "type";
+    case CAT_FUNCTION: return "function";
     default: return "unknown";
     }
 }
 
-void SemanticAnalyzer::addError(const std::string& error, int line, int col) {
+void SemanticAnalyzer::addError(const std::string& error, SourceOffset at) {
+    TALT_MEMORY_SCOPE(MEM_DIAGNOSTICS);
+    SourcePosition pos = position(at);
     std::stringstream ss;
     ss << "[] ";
-    if (line > 0) ss << " " << line;
-    if (col > 0) ss << ":" << col;
-    if (line > 0 || col > 0) ss << ": ";
+    if (pos.line > 0) ss << " " << pos.line;
+    if (pos.column > 0) ss << ":" << pos.column;
+    if (pos.line > 0 || pos.column > 0) ss << ": ";
     ss << error;
     errors.push_back(ss.str());
+    diagnostics.push_back({ pos.line, pos.column, error, false });
 }
 
-void SemanticAnalyzer::addWarning(const std::string& warning, int line, int col) {
+void SemanticAnalyzer::addWarning(const std::string& warning, SourceOffset at) {
+    TALT_MEMORY_SCOPE(MEM_DIAGNOSTICS);
+    SourcePosition pos = position(at);
     std::stringstream ss;
     ss << "[] ";
-    if (line > 0) ss << " " << line;
-    if (col > 0) ss << ":" << col;
-    if (line > 0 || col > 0) ss << ": ";
+    if (pos.line > 0) ss << " " << pos.line;
+    if (pos.column > 0) ss << ":" << pos.column;
+    if (pos.line > 0 || pos.column > 0) ss << ": ";
     ss << warning;
     warnings.push_back(ss.str());
+    diagnostics.push_back({ pos.line, pos.column, warning, true });
 }
 
-void SemanticAnalyzer::printErrors() const {
+void SemanticAnalyzer::printErrors(OutputWriter& out) const {
     if (errors.empty()) {
-        std::cout << "  .\n";
+        out << "  .\n";
         return;
     }
 
-    std::cout << "\n===    ===\n";
+    out << "\n===    ===\n";
     for (const auto& error : errors) {
-        std::cout << error << std::endl;
+        out << error << '\n';
     }
 }
 
-void SemanticAnalyzer::printWarnings() const {
+void SemanticAnalyzer::printWarnings(OutputWriter& out) const {
     if (warnings.empty()) {
         return;
     }
 
-    std::cout << "\n===  ===\n";
+    out << "\n===  ===\n";
+    for (const auto& warning : warnings) {
+        out << warning << '\n';
+    }
+}
+
+void SemanticAnalyzer::flushMessages(OutputWriter& out) {
+    for (const auto& error : errors) {
+        out << error << '\n';
+    }
     for (const auto& warning : warnings) {
-        std::cout << warning << std::endl;
+        out << warning << '\n';
     }
+    flushedErrors += errors.size();
+    flushedWarnings += warnings.size();
+    std::vector<std::string>().swap(errors);
+    std::vector<std::string>().swap(warnings);
+    std::vector<Diagnostic>().swap(diagnostics);
 }
 
-void SemanticAnalyzer::printSymbolTable() const {
-    std::function<void(const Symbol*, int)> printScope =
-        [&](const Symbol* scope, int depth) {
-        std::string indent(depth * 2, ' ');
+void SemanticAnalyzer::recycleScope(Symbol* scope) {
+    Symbol* child = scope->firstChild;
+    while (child) {
+        Symbol* next = child->nextSibling;
+        recycleScope(child);
+        child = next;
+    }
+    extras.erase(scope);
+    symbolPool.recycle(scope);
+}
 
-        if (scope->name.empty()) {
-            std::cout << indent << "Scope ( " << depth << "):\n";
+void SemanticAnalyzer::discardClosedScopes() {
+    if (currentScope != globalScope) return;
+
+    //     -  . 
+    //     ,  
+    //      .
+    Symbol* previous = keptGlobal;
+    Symbol* child = previous ? previous->nextSibling : globalScope->firstChild;
+    while (child) {
+        Symbol* next = child->nextSibling;
+        if (child->name == NO_NAME) {
+            if (previous) previous->nextSibling = next;
+            else globalScope->firstChild = next;
+            if (globalScope->lastChild == child) globalScope->lastChild = previous;
+            recycleScope(child);
         }
         else {
-            std::cout << indent << "Scope '" << scope->name << "':\n";
+            previous = child;
         }
+        child = next;
+    }
+    keptGlobal = previous;
+}
 
-        for (const Symbol* sym : scope->childScopes) {
-            std::cout << indent << "  " << sym->name
-                << " [" << categoryToString(sym->category)
-                << ", " << dataTypeToString(sym->type);
+void SemanticAnalyzer::printScope(OutputWriter& out, const Symbol* scope, int depth) const {
+    int indent = depth * 2;
 
-            if (!sym->structTypeName.empty()) {
-                std::cout << ", struct: " << sym->structTypeName;
-            }
+    if (scope->name == NO_NAME) {
+        out.indent(indent) << "Scope ( " << depth << "):\n";
+    }
+    else {
+        out.indent(indent) << "Scope '" << nameOf(scope->name) << "':\n";
+    }
 
-            if (sym->category == CAT_VARIABLE && sym->isInitialized) {
-                std::cout << ", initialized";
-            }
+    for (const Symbol* sym = scope->firstChild; sym; sym = sym->nextSibling) {
+        out.indent(indent + 2) << nameOf(sym->name)
+            << " [" << categoryToString(sym->category)
+            << ", " << dataTypeToString(sym->type->kind);
 
-            std::cout << "]\n";
+        if (sym->type->structName != NO_NAME) {
+            out << ", struct: " << nameOf(sym->type->structName);
+        }
 
-            if (!sym->childScopes.empty()) {
-                printScope(sym, depth + 2);
-            }
+        if (sym->category == CAT_VARIABLE && sym->isInitialized) {
+            out << ", initialized";
         }
-    };
 
-    std::cout << "\n===   ===\n";
-    printScope(globalScope, 0);
+        out << "]\n";
+
+        if (sym->firstChild) {
+            printScope(out, sym, depth + 2);
+        }
+    }
+}
+
+void SemanticAnalyzer::printSymbolTable(OutputWriter& out) const {
+    out << "\n===   ===\n";
+    printScope(out, globalScope, 0);
 }
 
-void SemanticAnalyzer::printStructTypes() const {
-    if (structTypes.empty()) {
-        std::cout << "  .\n";
+void SemanticAnalyzer::printStructTypes(OutputWriter& out) const {
+    if (structTypeCount == 0) {
+        out << "  .\n";
         return;
     }
 
-    std::cout << "\n===   ===\n";
-    for (const auto& pair : structTypes) {
-        std::cout << "struct " << pair.first << " {\n";
-        for (const auto& field : pair.second.fields) {
-            std::cout << "    " << dataTypeToString(field.type)
+    out << "\n===   ===\n";
+    for (const StructTypeInfo* info : sortedStructTypes()) {
+        out << "struct " << info->name;
+        if (!info->module.empty()) {
+            out << " ( " << info->module << ")";
+        }
+        out << " {\n";
+        for (const auto& field : info->fields) {
+            out << "    " << dataTypeToString(field.type)
                 << " " << field.name << ";\n";
         }
-        std::cout << "}\n";
+        out << "}\n";
     }
 }
 
 void SemanticAnalyzer::clear() {
     errors.clear();
     warnings.clear();
+    diagnostics.clear();
+    flushedErrors = 0;
+    flushedWarnings = 0;
+    references.clear();
     structTypes.clear();
+    structTypeCount = 0;
+    structTypeIndex.clear();
+
+    //     ,   
+    extras.clear();
+    decltype(spareExtras)().swap(spareExtras);
+    symbolPool.release();
+    globalIndex.clear();
+    globalSymbols.clear();
+    keptGlobal = nullptr;
+    scopeDepth = 0;
+    //         , reset 
+    //  ;   ,   
+    types.clear();
+    names.clear();
+    addBuiltinTypes();
+}
 
-    std::function<void(Symbol*)> clearScope = [&](Symbol* scope) {
-        for (Symbol* child : scope->childScopes) {
-            clearScope(child);
-        }
-        delete scope;
-    };
-
-    clearScope(globalScope);
-
-    globalScope = new Symbol("global", CAT_TYPE, TYPE_VOID);
+void SemanticAnalyzer::reset() {
+    errors.clear();
+    warnings.clear();
+    diagnostics.clear();
+    flushedErrors = 0;
+    flushedWarnings = 0;
+    references.clear();
+    structTypeCount = 0;
+    structTypeIndex.rewind();
+    while (!extras.empty()) {
+        spareExtras.push_back(extras.extract(extras.begin()));
+    }
+
+    //         
+    //  ;    ,   - 
+    symbolPool.rewind(builtinsEnd);
+    globalSymbols.resize(builtinCount);
+    globalIndex.rewind();
+    globalScope->firstChild = nullptr;
+    globalScope->lastChild = nullptr;
     currentScope = globalScope;
-
-    Symbol* intType = new Symbol("int", CAT_TYPE, TYPE_INT);
-    Symbol* shortType = new Symbol("short", CAT_TYPE, TYPE_SHORT);
-    Symbol* longType = new Symbol("long", CAT_TYPE, TYPE_LONG);
-    Symbol* floatType = new Symbol("float", CAT_TYPE, TYPE_FLOAT);
-    Symbol* voidType = new Symbol("void", CAT_TYPE, TYPE_VOID);
-
-    addToCurrentScope(intType);
-    addToCurrentScope(shortType);
-    addToCurrentScope(longType);
-    addToCurrentScope(floatType);
-    addToCurrentScope(voidType);
+    for (size_t i = 0; i < builtinCount; i++) {
+        Symbol* builtin = globalSymbols[i];
+        builtin->nextSibling = nullptr;
+        globalIndex.insert(builtin->name, (uint32_t)i);
+        if (globalScope->lastChild) globalScope->lastChild->nextSibling = builtin;
+        else globalScope->firstChild = builtin;
+        globalScope->lastChild = builtin;
+    }
+    keptGlobal = nullptr;
+    scopeDepth = 0;
+    returnType = nullptr;
 }
@@ -2,29 +2,26 @@
 #define SEMANTIC_H
 
 #include "scanner.h"
+#include "types.h"
+#include "stats.h"
+#include "output.h"
+#include "names.h"
+#include "pool.h"
+#include "flatmap.h"
 #include <string>
 #include <vector>
-#include <map>
+#include <deque>
 #include <memory>
-#include <functional>
+#include <unordered_map>
 
 // 
-enum ObjectCategory {
+enum ObjectCategory : unsigned char {
     CAT_UNDEFINED,
     CAT_VARIABLE,
     CAT_FIELD,
     CAT_STRUCT_TYPE,
-    CAT_TYPE
-};
-
-enum DataType {
-    TYPE_UNDEFINED,
-    TYPE_SHORT,
-    TYPE_INT,
-    TYPE_LONG,
-    TYPE_FLOAT,
-    TYPE_STRUCT,
-    TYPE_VOID
+    CAT_TYPE,
+    CAT_FUNCTION
 };
 
 //    
@@ -33,80 +30,208 @@ struct FieldInfo {
     DataType type;
     std::string structTypeName;
 
+    //   ,  SemanticAnalyzer::layoutStruct
+    int offset;
+    int size;
+    int align;
+
+    //      
+    SourceOffset sourceOffset;
+
     FieldInfo(const std::string& n = "", DataType t = TYPE_UNDEFINED,
         const std::string& stn = "")
-        : name(n), type(t), structTypeName(stn) {}
+        : name(n), type(t), structTypeName(stn), offset(-1), size(0), align(0),
+        sourceOffset(0) {}
 };
 
 //    
 struct StructTypeInfo {
+    //          ,
+    //     -
+    static const size_t SMALL_STRUCT_FIELDS = 16;
+
     std::string name;
+    std::string module;            //  ;  -   
     std::vector<FieldInfo> fields;
-    std::map<std::string, FieldInfo> fieldMap;
+    std::vector<NameId> fieldIds;  //  ,  fields
+    NameIndexMap fieldIndex;       //  -> ,    
+
+    // :      
+    int size = 0;
+    int align = 1;
+    bool complete = false;
 
-    bool addField(const std::string& fieldName, DataType type,
+    bool addField(NameId id, const std::string& fieldName, DataType type,
         const std::string& structTypeName = "") {
-        if (fieldMap.find(fieldName) != fieldMap.end()) {
+        if (findFieldIndex(id) >= 0) {
             return false;
         }
 
-        FieldInfo field(fieldName, type, structTypeName);
-        fields.push_back(field);
-        fieldMap[fieldName] = field;
+        fieldIds.push_back(id);
+        fields.push_back(FieldInfo(fieldName, type, structTypeName));
+
+        if (fieldIds.size() > SMALL_STRUCT_FIELDS) {
+            if (fieldIndex.size() == 0) {
+                for (size_t i = 0; i < fieldIds.size(); i++) {
+                    fieldIndex.insert(fieldIds[i], (uint32_t)i);
+                }
+            }
+            else {
+                fieldIndex.insert(id, (uint32_t)(fieldIds.size() - 1));
+            }
+        }
         return true;
     }
 
-    FieldInfo* findField(const std::string& fieldName) {
-        auto it = fieldMap.find(fieldName);
-        if (it != fieldMap.end()) {
-            return &it->second;
+    //    -1
+    int findFieldIndex(NameId id) const;
+
+    FieldInfo* findField(NameId id) {
+        int index = findFieldIndex(id);
+        return index >= 0 ? &fields[index] : nullptr;
+    }
+
+    //    ;    
+    void reset() {
+        name.clear();
+        module.clear();
+        fields.clear();
+        fieldIds.clear();
+        fieldIndex.rewind();
+        size = 0;
+        align = 1;
+        complete = false;
+    }
+
+    //        
+    int paddingBytes() const {
+        int used = 0;
+        for (const auto& field : fields) {
+            used += field.size;
         }
-        return nullptr;
+        return size - used;
     }
 };
 
-//   
+//   .    NameTable ,
+//          .
 class Symbol {
 public:
-    std::string name;
+    NameId name;
     ObjectCategory category;
-    DataType type;
-    std::string structTypeName;
-
-    //  
     bool isInitialized;
-    bool isField;
-    std::string parentStruct; //  
-
-    //   (    )
-    int paramCount;
-    std::vector<DataType> paramTypes;
+    //  ;    - TYPE_STRUCT  , 
+    //  -  
+    const Type* type;
 
+    //        
     Symbol* parentScope;
-    std::vector<Symbol*> childScopes;
+    Symbol* firstChild;
+    Symbol* lastChild;
+    Symbol* nextSibling;
 
-    Symbol(const std::string& n = "", ObjectCategory cat = CAT_UNDEFINED,
-        DataType t = TYPE_UNDEFINED)
-        : name(n), category(cat), type(t), structTypeName(""),
-        isInitialized(false), isField(false), parentStruct(""),
-        paramCount(0), parentScope(nullptr) {}
+    Symbol(NameId n = NO_NAME, ObjectCategory cat = CAT_UNDEFINED,
+        const Type* t = builtinType(TYPE_UNDEFINED))
+        : name(n), category(cat), isInitialized(false), type(t), parentScope(nullptr),
+        firstChild(nullptr), lastChild(nullptr), nextSibling(nullptr) {}
 
     bool isVariable() const { return category == CAT_VARIABLE; }
     bool isStructType() const { return category == CAT_STRUCT_TYPE; }
 };
 
+//    ,    Symbol
+struct SymbolExtra {
+    NameId parentStruct = NO_NAME;  //  
+    int paramCount = 0;             //  
+    std::vector<DataType> paramTypes;
+    SourceOffset sourceOffset = 0;  //  
+};
+
+//     ;     
+struct Diagnostic {
+    int line;
+    int column;
+    std::string message;
+    bool warning;
+};
+
+//     . ,   
+// setRecordReferences ( --lsp).
+struct SymbolReference {
+    SourceOffset offset;
+    int length;
+    const Symbol* symbol;  // ; nullptr  
+    NameId structName;     //  :    
+    NameId field;
+    bool declaration;
+};
+
+//    import:     .
+//   name, module, fields, size, align  complete.
+struct ModuleInterface {
+    std::vector<StructTypeInfo> structs;
+};
+
+//    
+class ModuleProvider {
+public:
+    virtual ~ModuleProvider() = default;
+    // nullptr,   ;  -  why
+    virtual const ModuleInterface* findModule(const std::string& name, std::string& why) = 0;
+};
+
 //  
 class SemanticAnalyzer {
 private:
     Symbol* currentScope;
     Symbol* globalScope;
-
-    std::map<std::string, StructTypeInfo> structTypes;
+    int scopeDepth;
+    TargetAbi targetAbi;
+
+    NameTable names;
+    TypeTable types;
+    SlabPool<Symbol> symbolPool;
+    //       : reset
+    //        globalSymbols
+    SlabPool<Symbol>::Mark builtinsEnd;
+    size_t builtinCount;
+    std::unordered_map<const Symbol*, SymbolExtra> extras;
+    //  extras,  reset:    ,
+    //     
+    std::vector<std::unordered_map<const Symbol*, SymbolExtra>::node_type> spareExtras;
+
+    //       . 
+    //     ,      .
+    NameIndexMap globalIndex;
+    std::vector<Symbol*> globalSymbols;
+
+    //     ; deque   ,
+    //    StructTypeInfo  .
+    //   structTypeCount,   reset
+    //   .
+    std::deque<StructTypeInfo> structTypes;
+    size_t structTypeCount;
+    NameIndexMap structTypeIndex;
     std::vector<std::string> errors;
     std::vector<std::string> warnings;
+    std::vector<Diagnostic> diagnostics;
+    size_t flushedErrors;    //   flushMessages
+    size_t flushedWarnings;
+    Symbol* keptGlobal;      // discardClosedScopes     
 
-    //  
+    bool recordReferences;
+    std::vector<SymbolReference> references;
 
+    ModuleProvider* modules;
+    const LineTable* lines;
+    const Type* returnType;  //  ,   
+
+    //  
+    void addBuiltinTypes();
+    StructTypeInfo& newStructType();
+    void recycleScope(Symbol* scope);
+    Symbol* findGlobal(NameId id, bool types) const;
+    void printScope(OutputWriter& out, const Symbol* scope, int depth) const;
 
 public:
     SemanticAnalyzer();
@@ -114,72 +239,146 @@ public:
 
 
     Symbol* createSymbol(const std::string& name, ObjectCategory cat,
-        DataType type = TYPE_UNDEFINED);
+        const Type* type = builtinType(TYPE_UNDEFINED));
     void addToCurrentScope(Symbol* symbol);
 
+    //  
+    const std::string& nameOf(NameId id) const { return names.str(id); }
+    const NameTable& getNames() const { return names; }
+    size_t symbolCount() const { return symbolPool.size(); }
 
-    bool isFloatType(DataType type) const;
-    bool isNumericType(DataType type) const;
-    bool isIntegerType(DataType type) const;
-    DataType promoteType(DataType t1, DataType t2) const;
+    //  ;     
+    SymbolExtra& extraInfo(const Symbol* symbol);
+    const SymbolExtra* findExtraInfo(const Symbol* symbol) const {
+        auto it = extras.find(symbol);
+        return it != extras.end() ? &it->second : nullptr;
+    }
+
+    //  
+    const Type* structType(NameId name) { return types.structType(name); }
+    //   :      
+    const Type* typeOf(DataType kind, const std::string& structName = "");
+    const Type* fieldType(const FieldInfo& field);
+    //   ;   -    
+    std::string typeToString(const Type* type) const;
 
     //   
     void enterScope();
     void leaveScope();
     Symbol* getCurrentScope() const { return currentScope; }
+    const Symbol* getGlobalScope() const { return globalScope; }
 
     //  
-    bool declareVariable(const std::string& name, DataType type,
-        const std::string& structTypeName = "",
-        int line = 0, int col = 0);
-    bool declareStructType(const std::string& name, int line = 0, int col = 0);
+    bool declareVariable(const std::string& name, const Type* type,
+        SourceOffset at = 0);
+    bool declareStructType(const std::string& name, SourceOffset at = 0);
+    //    ;    
+    //   SymbolExtra. nullptr -  .
+    Symbol* declareFunction(const std::string& name, const Type* returnType,
+        SourceOffset at = 0);
+    // ,    return; nullptr -  
+    void setReturnType(const Type* type) { returnType = type; }
+    const Type* getReturnType() const { return returnType; }
+    //   ;    import - 
+    void setModuleProvider(ModuleProvider* provider) { modules = provider; }
+    bool importModule(const std::string& name, SourceOffset at = 0);
     bool addFieldToStruct(const std::string& structName,
         const std::string& fieldName, DataType type,
         const std::string& fieldStructType = "",
-        int line = 0, int col = 0);
+        SourceOffset at = 0);
 
     //  
     Symbol* findSymbol(const std::string& name) const;
     Symbol* findSymbolInCurrentScope(const std::string& name) const;
     StructTypeInfo* findStructType(const std::string& name) const;
+    StructTypeInfo* findStructType(NameId name) const;
+    //     ,   
+    const FieldInfo* lookupField(NameId structName, NameId fieldName) const;
 
     //  
     Symbol* checkIdentifier(const std::string& name,
-        int line = 0, int col = 0);
-    bool checkAssignment(Symbol* left, DataType rightType,
-        int line = 0, int col = 0);
-    DataType checkBinaryOperation(TokenType op, DataType leftType,
-        DataType rightType,
-        int line = 0, int col = 0);
+        SourceOffset at = 0);
+    bool checkAssignment(Symbol* left, const Type* rightType,
+        SourceOffset at = 0);
+    //    right   left
+    bool checkAssignable(const Type* left, const Type* right,
+        SourceOffset at = 0);
+    const Type* checkBinaryOperation(TokenType op, const Type* leftType,
+        const Type* rightType,
+        SourceOffset at = 0);
     bool checkFieldAccess(Symbol* structVar, const std::string& fieldName,
-        DataType* resultType = nullptr,
-        int line = 0, int col = 0);
-    bool checkForLoop(DataType initType, DataType condType, DataType incType,
-        int line = 0, int col = 0);
+        const Type** resultType = nullptr,
+        SourceOffset at = 0);
+    bool checkForLoop(const Type* initType, const Type* condType,
+        const Type* incType, SourceOffset at = 0);
+
+    //     
+    void setTargetAbi(TargetAbi abi) { targetAbi = abi; }
+    TargetAbi getTargetAbi() const { return targetAbi; }
+    int typeSize(DataType type) const;
+    int typeAlign(DataType type) const;
+    bool layoutStruct(const std::string& name, SourceOffset at = 0);
+    //  ,   ,  
+    std::vector<const StructTypeInfo*> sortedStructTypes() const;
+    void sortedStructTypes(std::vector<const StructTypeInfo*>& sorted) const;
 
     //  
     DataType tokenTypeToDataType(TokenType token) const;
     static std::string dataTypeToString(DataType type);
     static std::string categoryToString(ObjectCategory cat);
 
+    //   :      
+    //      .    
+    //  0   .
+    void setLineTable(const LineTable* table) { lines = table; }
+    SourcePosition position(SourceOffset at) const {
+        return lines && at ? lines->position(at) : SourcePosition{ 0, 0 };
+    }
+
     //   
-    void addError(const std::string& error, int line = 0, int col = 0);
-    void addWarning(const std::string& warning, int line = 0, int col = 0);
-    void printErrors() const;
-    void printWarnings() const;
-    bool hasErrors() const { return !errors.empty(); }
+    void addError(const std::string& error, SourceOffset at = 0);
+    void addWarning(const std::string& warning, SourceOffset at = 0);
+    void printErrors(OutputWriter& out) const;
+    void printWarnings(OutputWriter& out) const;
+    bool hasErrors() const { return errorCount() > 0; }
+    size_t errorCount() const { return flushedErrors + errors.size(); }
+    size_t warningCount() const { return flushedWarnings + warnings.size(); }
+
+    //   (--stream).    
+    //      .
+    void flushMessages(OutputWriter& out);
+    //       :  
+    //   .      
+    //  setRecordReferences.
+    void discardClosedScopes();
     bool hasWarnings() const { return !warnings.empty(); }
+    const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics; }
+
+    //      
+    void setRecordReferences(bool record) { recordReferences = record; }
+    bool isRecordingReferences() const { return recordReferences; }
+    void noteReference(const Symbol* symbol, SourceOffset at);
+    void noteFieldReference(NameId structName, const std::string& fieldName,
+        SourceOffset at, bool declaration = false);
+    const std::vector<SymbolReference>& getReferences() const { return references; }
 
     //  
-    void printSymbolTable() const;
-    void printStructTypes() const;
+    void printSymbolTable(OutputWriter& out) const;
+    void printStructTypes(OutputWriter& out) const;
 
     // 
     void clear();
+    //     .    clear 
+    //  ,     ,   
+    //   .   .
+    void reset();
     Symbol* findVariableInCurrentScope(const std::string& name) const {
         //    ( ,  )
-        for (Symbol* sym : currentScope->childScopes) {
-            if (sym->name == name && sym->category == CAT_VARIABLE) {
+        TALT_COUNT(STAT_SYMBOL_LOOKUPS);
+        NameId id = names.find(name);
+        if (id == NO_NAME) return nullptr;
+        for (Symbol* sym = currentScope->firstChild; sym; sym = sym->nextSibling) {
+            if (sym->name == id && sym->category == CAT_VARIABLE) {
                 return sym;
             }
         }
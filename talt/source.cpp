@@ -0,0 +1,39 @@
+#include "source.h"
+#include <algorithm>
+#include <cstring>
+
+void LineTable::clear() {
+    starts.assign(1, 0);
+    firstLine = 1;
+}
+
+void LineTable::scan(const char* data, size_t size, SourceOffset base) {
+    const char* end = data + size;
+    for (const char* p = data; (p = (const char*)std::memchr(p, '\n', end - p)) != nullptr; p++) {
+        starts.push_back(base + (SourceOffset)(p - data) + 1);
+    }
+}
+
+void LineTable::assign(const std::string& text) {
+    clear();
+    scan(text.data(), text.size(), 0);
+}
+
+SourcePosition LineTable::position(SourceOffset offset) const {
+    //      offset
+    auto it = std::upper_bound(starts.begin(), starts.end(), offset);
+    if (it == starts.begin()) return { firstLine, 0 };
+    --it;
+    return { firstLine + (int)(it - starts.begin()), (int)(offset - *it) };
+}
+
+void LineTable::discardBefore(SourceOffset offset) {
+    auto it = std::upper_bound(starts.begin(), starts.end(), offset);
+    size_t dropped = it == starts.begin() ? 0 : it - starts.begin() - 1;
+    //   ,      :
+    // ,   ,     
+    // 
+    if (dropped == 0 || dropped * 2 < starts.size()) return;
+    starts.erase(starts.begin(), starts.begin() + dropped);
+    firstLine += (int)dropped;
+}
@@ -0,0 +1,57 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//    :  ,   1. 0 -  
+//    .     
+//    ,       .
+typedef uint32_t SourceOffset;
+
+//   32 :      
+const uint64_t SOURCE_SIZE_LIMIT = UINT32_MAX;
+
+struct SourcePosition {
+    int line;
+    int column;  //   ,  1; 0 -    
+};
+
+//   .     ; 
+//   memchr,    
+//  .
+class LineTable {
+private:
+    // starts[i] -      firstLine + i,
+    //      (0   )
+    std::vector<SourceOffset> starts;
+    int firstLine = 1;
+
+public:
+    LineTable() : starts(1, 0) {}
+
+    void clear();
+    //  ,    base
+    void scan(const char* data, size_t size, SourceOffset base);
+    //    
+    void assign(const std::string& text);
+
+    //       ,    
+    //  :      
+    //   0,  0 -   1,  0
+    SourcePosition position(SourceOffset offset) const;
+
+    //     
+    size_t lineCount() const { return firstLine - 1 + starts.size(); }
+    //     line ( 1),    
+    //   . ,  discardBefore, .
+    SourceOffset lineStart(size_t line) const { return starts[line - firstLine]; }
+
+    //  :    offset   . ,
+    //  offset, ,    .
+    void discardBefore(SourceOffset offset);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "stats.h"
+#include "memory.h"
+#include <fstream>
+#include <iomanip>
+
+std::atomic<unsigned long long> Stats::counters[STAT_COUNT];
+long long Stats::phaseTime[PHASE_COUNT] = {};
+std::vector<Stats::TraceEvent> Stats::trace;
+std::mutex Stats::traceLock;
+
+long long Stats::now() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+void Stats::reset() {
+    for (auto& counter : counters) counter.store(0, std::memory_order_relaxed);
+    for (auto& time : phaseTime) time = 0;
+    trace.clear();
+}
+
+const char* Stats::counterName(StatCounter counter) {
+    switch (counter) {
+    case STAT_TOKENS: return "tokens";
+    case STAT_BACKTRACKS: return "backtracks";
+    case STAT_SYMBOL_LOOKUPS: return "symbol_lookups";
+    case STAT_SCOPES: return "scopes";
+    case STAT_MAX_SCOPE_DEPTH: return "max_scope_depth";
+    case STAT_ALLOCATIONS: return "allocations";
+    case STAT_BYTES_ALLOCATED: return "bytes_allocated";
+    case STAT_CACHE_HITS: return "cache_hits";
+    case STAT_CACHE_MISSES: return "cache_misses";
+    case STAT_LOOPS_VECTORIZED: return "loops_vectorized";
+    case STAT_MODULES_CHECKED: return "modules_checked";
+    case STAT_MODULES_REUSED: return "modules_reused";
+    case STAT_ANALYSES_COMPUTED: return "analyses_computed";
+    case STAT_CONSTANTS_FOLDED: return "constants_folded";
+    case STAT_FLOW_BLOCKS: return "flow_blocks";
+    case STAT_FLOW_EVALUATIONS: return "flow_evaluations";
+    case STAT_CALLS_INLINED: return "calls_inlined";
+    case STAT_NODE_PROGRAM: return "node_program";
+    case STAT_NODE_STRUCT_DECL: return "node_struct_decl";
+    case STAT_NODE_FUNCTION: return "node_function";
+    case STAT_NODE_VAR_DECL: return "node_var_decl";
+    case STAT_NODE_ASSIGN: return "node_assign";
+    case STAT_NODE_FOR: return "node_for";
+    case STAT_NODE_BINARY_OP: return "node_binary_op";
+    case STAT_NODE_UNARY_OP: return "node_unary_op";
+    case STAT_NODE_VAR: return "node_var";
+    case STAT_NODE_CONST: return "node_const";
+    case STAT_NODE_BLOCK: return "node_block";
+    case STAT_NODE_RETURN: return "node_return";
+    case STAT_NODE_CALL: return "node_call";
+    case STAT_NODE_IMPORT: return "node_import";
+    default: return "unknown";
+    }
+}
+
+const char* Stats::phaseName(StatPhase phase) {
+    switch (phase) {
+    case PHASE_SCAN: return "scan";
+    case PHASE_PARSE: return "parse";
+    case PHASE_SEMANTIC: return "semantic";
+    case PHASE_OUTPUT: return "output";
+    case PHASE_LOWER: return "lower";
+    case PHASE_EXECUTE: return "execute";
+    default: return "unknown";
+    }
+}
+
+void Stats::printText(std::ostream& out) {
+    out << "\n===  ===\n";
+    out << "  ():\n";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        out << "  " << std::left << std::setw(20) << phaseName((StatPhase)i)
+            << std::fixed << std::setprecision(3) << phaseTime[i] / 1000.0 << "\n";
+    }
+    out << ":\n";
+    for (int i = 0; i < STAT_COUNT; i++) {
+        out << "  " << std::left << std::setw(20) << counterName((StatCounter)i)
+            << counters[i].load() << "\n";
+    }
+    out << std::right;
+    if (memoryAccountingEnabled()) printMemoryText(out);
+}
+
+void Stats::printJson(std::ostream& out) {
+    out << "{\"phases_us\":{";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        if (i > 0) out << ",";
+        out << "\"" << phaseName((StatPhase)i) << "\":" << phaseTime[i];
+    }
+    out << "},\"counters\":{";
+    for (int i = 0; i < STAT_COUNT; i++) {
+        if (i > 0) out << ",";
+        out << "\"" << counterName((StatCounter)i) << "\":" << counters[i].load();
+    }
+    out << "}";
+    if (memoryAccountingEnabled()) {
+        out << ",\"memory_bytes\":";
+        printMemoryJson(out);
+    }
+    out << "}\n";
+}
+
+bool Stats::writeTrace(const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    //  Chrome trace events (chrome://tracing, Perfetto)
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (i > 0) out << ",";
+        out << "\n{\"name\":\"" << phaseName(trace[i].phase)
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << trace[i].start
+            << ",\"dur\":" << trace[i].duration << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return true;
+}
@@ -0,0 +1,132 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+
+//  
+enum StatCounter {
+    STAT_TOKENS,
+    STAT_BACKTRACKS,
+    STAT_SYMBOL_LOOKUPS,
+    STAT_SCOPES,
+    STAT_MAX_SCOPE_DEPTH,
+    STAT_ALLOCATIONS,
+    STAT_BYTES_ALLOCATED,
+    STAT_CACHE_HITS,
+    STAT_CACHE_MISSES,
+    STAT_LOOPS_VECTORIZED,
+    STAT_MODULES_CHECKED,
+    STAT_MODULES_REUSED,
+    STAT_ANALYSES_COMPUTED,
+    STAT_CONSTANTS_FOLDED,
+    STAT_FLOW_BLOCKS,
+    STAT_FLOW_EVALUATIONS,
+    STAT_CALLS_INLINED,
+
+    //  AST  
+    STAT_NODE_PROGRAM,
+    STAT_NODE_STRUCT_DECL,
+    STAT_NODE_FUNCTION,
+    STAT_NODE_VAR_DECL,
+    STAT_NODE_ASSIGN,
+    STAT_NODE_FOR,
+    STAT_NODE_BINARY_OP,
+    STAT_NODE_UNARY_OP,
+    STAT_NODE_VAR,
+    STAT_NODE_CONST,
+    STAT_NODE_BLOCK,
+    STAT_NODE_RETURN,
+    STAT_NODE_CALL,
+    STAT_NODE_IMPORT,
+
+    STAT_COUNT
+};
+
+// ,   
+enum StatPhase {
+    PHASE_SCAN,
+    PHASE_PARSE,
+    PHASE_SEMANTIC,
+    PHASE_OUTPUT,
+    PHASE_LOWER,
+    PHASE_EXECUTE,
+
+    PHASE_COUNT
+};
+
+//     .  TALT_STATS  
+//        .
+class Stats {
+public:
+    struct TraceEvent {
+        StatPhase phase;
+        long long start;     //    
+        long long duration;  // 
+    };
+
+    //         
+    //   ;     
+    static std::atomic<unsigned long long> counters[STAT_COUNT];
+    static long long phaseTime[PHASE_COUNT];  // 
+    static std::vector<TraceEvent> trace;
+    static std::mutex traceLock;  //  phaseTime  trace
+
+    static long long now();
+    static void reset();
+    static void raise(StatCounter counter, unsigned long long value) {
+        unsigned long long current = counters[counter].load(std::memory_order_relaxed);
+        while (value > current &&
+            !counters[counter].compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static const char* counterName(StatCounter counter);
+    static const char* phaseName(StatPhase phase);
+
+    static void printText(std::ostream& out);
+    static void printJson(std::ostream& out);
+    static bool writeTrace(const std::string& filename);
+};
+
+//  ,     
+class ScopedTimer {
+private:
+    StatPhase phase;
+    long long start;
+
+public:
+    explicit ScopedTimer(StatPhase p) : phase(p), start(Stats::now()) {}
+    ~ScopedTimer() {
+        long long duration = Stats::now() - start;
+        //        
+        std::lock_guard<std::mutex> guard(Stats::traceLock);
+        Stats::phaseTime[phase] += duration;
+        Stats::trace.push_back({ phase, start, duration });
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define TALT_CONCAT_IMPL(a, b) a##b
+#define TALT_CONCAT(a, b) TALT_CONCAT_IMPL(a, b)
+
+#ifdef TALT_STATS
+#define TALT_COUNT(c) ((void)Stats::counters[(c)].fetch_add(1, std::memory_order_relaxed))
+#define TALT_COUNT_ADD(c, n) \
+    ((void)Stats::counters[(c)].fetch_add((n), std::memory_order_relaxed))
+#define TALT_COUNT_MAX(c, v) Stats::raise((c), (unsigned long long)(v))
+#define TALT_TIMER(phase) ScopedTimer TALT_CONCAT(taltTimer, __LINE__)(phase)
+#else
+#define TALT_COUNT(c) ((void)0)
+#define TALT_COUNT_ADD(c, n) ((void)0)
+#define TALT_COUNT_MAX(c, v) ((void)0)
+#define TALT_TIMER(phase) ((void)0)
+#endif
+
+#endif
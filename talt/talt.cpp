@@ -1,38 +1,236 @@
 ﻿#include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <memory>
+#include <functional>
+#include <algorithm>
 #include "scanner.h"
 #include "parser.h"
 #include "semantic.h"
+#include "stats.h"
+#include "output.h"
+#include "cache.h"
+#include "layout.h"
+#include "lower.h"
+#include "passes.h"
+#include "visitor.h"
+#include "interp.h"
+#include "jit.h"
+#include "parallel.h"
+#include "lsp.h"
+#include "module.h"
+#include "memory.h"
+#include "api.h"
+#include "context.h"
+#include "dataflow.h"
+#include "inline.h"
+#include <chrono>
 
-void printToken(const Token& token) {
-    std::cout << "[" << token.line << ":" << token.column << "] "
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <direct.h>
+#define TALT_NULL_DEVICE "NUL"
+#define TALT_FILENO _fileno
+#define TALT_MKDIR(path) _mkdir(path)
+#else
+#include <cerrno>
+#include <unistd.h>
+#define TALT_NULL_DEVICE "/dev/null"
+#define TALT_FILENO fileno
+#define TALT_MKDIR(path) mkdir(path, 0777)
+#endif
+
+// Формат машиночитаемого дампа
+enum DumpFormat {
+    DUMP_NONE,
+    DUMP_TEXT,
+    DUMP_JSON
+};
+
+// Режим сервера языка
+enum LspMode {
+    LSP_NONE,
+    LSP_SERVER,        // --lsp: протокол на stdin/stdout
+    LSP_BENCH,         // --lsp-bench: замер сценария в процессе
+    LSP_BENCH_SCRIPT   // --lsp-bench=script: вывод сценария
+};
+
+// Правок в сценарии --lsp-bench
+const int LSP_BENCH_ROUNDS = 200;
+
+// --api-bench проверяет текст, пока не пройдет это время
+const double API_BENCH_SECONDS = 1.0;
+
+// --dataflow-bench повторяет каждый замер, пока не пройдет это время
+const double DATAFLOW_BENCH_SECONDS = 0.2;
+
+// --dump-bench повторяет каждый замер, пока не пройдет это время
+const double DUMP_BENCH_SECONDS = 0.2;
+
+// --call-bench повторяет каждое выполнение, пока не пройдет это время
+const double CALL_BENCH_SECONDS = 0.5;
+
+// --symbol-bench: областей, переменных в каждой и повторов замера
+const int SYMBOL_BENCH_SCOPES = 10000;
+const int SYMBOL_BENCH_VARIABLES = 100;
+const int SYMBOL_BENCH_ROUNDS = 5;
+
+// --field-bench: обращений к полям на каждый размер структуры
+const int FIELD_BENCH_ACCESSES = 2000000;
+
+// --build-bench: модулей в каждой из трех волн
+const int BUILD_BENCH_LEAVES = 100;
+const int BUILD_BENCH_MIDS = 900;
+const int BUILD_BENCH_TOPS = 9000;
+
+// --literal-bench: присваиваний в программе; каждая фаза повторяется,
+// пока не пройдет это время
+const int LITERAL_BENCH_STATEMENTS = 100000;
+const double LITERAL_BENCH_SECONDS = 0.5;
+
+// --walk-bench: присваиваний в обходимом дереве и цикл, где свертка
+// убирает константные подвыражения из тела
+const int WALK_BENCH_STATEMENTS = 100000;
+const double WALK_BENCH_SECONDS = 0.5;
+const char* const WALK_BENCH_LOOP =
+    "int bench() {\n"
+    "    int s = 0;\n"
+    "    for (int i = 0; i < 300000; i = i + 1) {\n"
+    "        s = s + i * (3 * 4 + 2) - (100 / 7) * (2 + 3);\n"
+    "        s = s - (7 - 3 * 2) * (1000 / (4 * 5));\n"
+    "    }\n"
+    "    return s;\n"
+    "}\n";
+
+// --type-bench: размер программы, групп присваиваний в функции и число
+// запусков анализа для медианы
+const int TYPE_BENCH_STRUCTS = 60;
+const int TYPE_BENCH_FUNCTIONS = 300;
+const int TYPE_BENCH_GROUPS = 13;
+const int TYPE_BENCH_RUNS = 9;
+
+// Способ выполнения программы
+enum RunMode {
+    RUN_NONE,
+    RUN_INTERP,
+    RUN_JIT
+};
+
+// Параметры командной строки
+struct DriverOptions {
+    bool showStats = false;
+    bool statsJson = false;
+    std::string traceFile;
+    DumpFormat dumpTokens = DUMP_NONE;
+    DumpFormat dumpAst = DUMP_NONE;
+    int repeat = 1;
+    int maxErrors = 100;
+    TargetAbi target = ABI_ILP32;
+    bool layout = false;
+    bool check = false;
+    bool stream = false;
+    bool build = false;
+    std::string moduleRoot;  // пусто - каталог первого файла
+    std::string cacheDir;
+    RunMode run = RUN_NONE;
+    std::string entry = "main";
+    JitOptions jit;
+    int threads = 0;  // 0 - по числу ядер
+    bool deterministic = false;
+    LspMode lsp = LSP_NONE;
+    bool apiBench = false;
+    bool chunkCheck = false;
+    bool recoveryCheck = false;
+    bool allocCheck = false;
+    bool dataflowBench = false;
+    bool dumpBench = false;
+    bool callBench = false;
+    bool symbolBench = false;
+    bool fieldBench = false;
+    bool jitBench = false;
+    bool vectorBench = false;
+    bool parallelBench = false;
+    std::string buildBenchDir;  // --build-bench: каталог проекта
+    bool literalBench = false;
+    bool walkBench = false;
+    bool typeBench = false;
+    bool inlineCalls = true;
+    long long maxMemory = 0;  // МБ, 0 - без лимита
+    std::vector<std::string> files;
+};
+
+CheckOptions checkOptions(const DriverOptions& options) {
+    CheckOptions result;
+    result.target = options.target;
+    result.maxErrors = options.maxErrors;
+    result.layout = options.layout;
+    return result;
+}
+
+// Корень, от которого отсчитываются имена модулей в import
+std::string moduleRoot(const DriverOptions& options, const std::string& filename) {
+    return options.moduleRoot.empty() ? ModuleBuilder::directoryOf(filename)
+        : options.moduleRoot;
+}
+
+void printToken(const Token& token, const LineTable& lines, OutputWriter& out) {
+    SourcePosition at = lines.position(token.offset);
+    out << "[" << at.line << ":" << at.column << "] "
         << token.typeToString() << " '" << token.lexeme << "'\n";
 }
 
-void testScanner(const std::string& filename) {
-    std::cout << "\n=== ТЕСТИРОВАНИЕ СКАНЕРА ===" << std::endl;
+void printTokenJson(const Token& token, const LineTable& lines, OutputWriter& out) {
+    SourcePosition at = lines.position(token.offset);
+    out << "{\"type\":\"" << token.typeToString() << "\",\"lexeme\":";
+    out.jsonString(token.lexeme) << ",\"line\":" << at.line
+        << ",\"column\":" << at.column << '}';
+}
+
+std::vector<Token> scanTokens(Scanner& scanner) {
+    TALT_TIMER(PHASE_SCAN);
+    TALT_MEMORY_SCOPE(MEM_SCANNER);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = scanner.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TK_EOF && token.type != TK_ERROR);
+    return tokens;
+}
+
+void testScanner(const std::string& filename, OutputWriter& out) {
+    out << "\n=== ТЕСТИРОВАНИЕ СКАНЕРА ===\n";
 
     Scanner scanner(filename);
     if (!scanner.open()) {
+        out.flush();
         std::cerr << "Ошибка открытия файла: " << filename << std::endl;
         return;
     }
 
-    Token token;
-    int tokenCount = 0;
+    std::vector<Token> tokens = scanTokens(scanner);
 
-    do {
-        token = scanner.getNextToken();
-        printToken(token);
-        tokenCount++;
-    } while (token.type != TK_EOF && token.type != TK_ERROR);
+    TALT_TIMER(PHASE_OUTPUT);
+    for (const Token& token : tokens) {
+        printToken(token, scanner.lineTable(), out);
+    }
 
-    std::cout << "Всего токенов: " << tokenCount << std::endl;
+    out << "Всего токенов: " << tokens.size() << "\n";
 }
 
-void testParser(const std::string& filename) {
-    std::cout << "\n=== ТЕСТИРОВАНИЕ ПАРСЕРА И СЕМАНТИЧЕСКОГО АНАЛИЗА ===" << std::endl;
+void testParser(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    out << "\n=== ТЕСТИРОВАНИЕ ПАРСЕРА И СЕМАНТИЧЕСКОГО АНАЛИЗА ===\n";
+    // Синтаксические ошибки идут в std::cerr, выводим все накопленное раньше них
+    out.flush();
 
     Scanner scanner(filename);
     if (!scanner.open()) {
@@ -40,71 +238,2360 @@ void testParser(const std::string& filename) {
         return;
     }
 
+    // Импортируемые модули проверяются по требованию
+    ModuleBuilder modules(moduleRoot(options, filename),
+        ModuleBuilder::extensionOf(filename), checkOptions(options));
     SemanticAnalyzer semantic;
-    Parser parser(scanner, semantic);
+    semantic.setTargetAbi(options.target);
+    semantic.setModuleProvider(&modules);
+    semantic.setLineTable(&scanner.lineTable());
+    Parser parser(scanner);
+    parser.maxErrors = options.maxErrors;
 
-    auto ast = parser.parse();
+    std::unique_ptr<ProgramNode> ast;
+    {
+        TALT_TIMER(PHASE_PARSE);
+        ast = parser.parse();
+    }
 
     if (parser.hasError) {
-        std::cout << "В процессе разбора возникли ошибки." << std::endl;
+        out << "В процессе разбора возникли ошибки.\n";
     }
 
     if (ast) {
-        std::cout << "\n=== АБСТРАКТНОЕ СИНТАКСИЧЕСКОЕ ДЕРЕВО ===" << std::endl;
-        parser.printAST(ast.get());
+        {
+            TALT_TIMER(PHASE_OUTPUT);
+            out << "\n=== АБСТРАКТНОЕ СИНТАКСИЧЕСКОЕ ДЕРЕВО ===\n";
+            parser.printAST(ast.get(), out);
+        }
 
-        std::cout << "\n=== СЕМАНТИЧЕСКИЙ АНАЛИЗ ===" << std::endl;
-        Symbol* dummy = nullptr;
-        ast->checkSemantics(semantic, dummy);
+        out << "\n=== СЕМАНТИЧЕСКИЙ АНАЛИЗ ===\n";
+        {
+            TALT_TIMER(PHASE_SEMANTIC);
+            Symbol* dummy = nullptr;
+            ast->checkSemantics(semantic, dummy);
+        }
 
-        semantic.printStructTypes();
-        semantic.printSymbolTable();
-        semantic.printErrors();
-        semantic.printWarnings();
+        TALT_TIMER(PHASE_OUTPUT);
+        semantic.printStructTypes(out);
+        semantic.printSymbolTable(out);
+        semantic.printErrors(out);
+        semantic.printWarnings(out);
+        if (options.layout) {
+            printLayoutReport(semantic, out);
+        }
 
         if (!semantic.hasErrors()) {
-            std::cout << "\n✓ Программа корректна" << std::endl;
+            out << "\n✓ Программа корректна\n";
         }
         else {
-            std::cout << "\n✗ Обнаружены ошибки" << std::endl;
+            out << "\n✗ Обнаружены ошибки\n";
         }
     }
     else {
-        std::cout << "Не удалось построить AST." << std::endl;
+        out << "Не удалось построить AST.\n";
     }
 }
 
-void processFile(const std::string& filename) {
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "ОБРАБОТКА ФАЙЛА: " << filename << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
+void processFile(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    out << "\n" << std::string(60, '=') << "\n";
+    out << "ОБРАБОТКА ФАЙЛА: " << filename << "\n";
+    out << std::string(60, '=') << "\n";
 
     // Тестируем сканер
-    testScanner(filename);
+    testScanner(filename, out);
 
     // Тестируем парсер и семантический анализ
-    testParser(filename);
+    testParser(filename, options, out);
+    out.flush();
+}
+
+// Файл для дампа не открылся: объект JSON закрывается с полем error,
+// чтобы строка осталась корректным JSON
+void dumpOpenError(const std::string& filename, bool json, OutputWriter& out) {
+    if (json) {
+        out << ",\"error\":";
+        out.jsonString("Ошибка открытия файла") << "}\n";
+    }
+    out.flush();
+    std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+}
+
+// Дамп токенов и/или AST без пояснительного текста. В формате JSON
+// каждый файл дает один объект на отдельной строке.
+void dumpFile(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    bool json = options.dumpTokens == DUMP_JSON || options.dumpAst == DUMP_JSON;
+
+    if (json) {
+        out << "{\"file\":";
+        out.jsonBytes(filename);
+    }
+
+    if (options.dumpTokens != DUMP_NONE) {
+        Scanner scanner(filename);
+        if (!scanner.open()) {
+            dumpOpenError(filename, json, out);
+            return;
+        }
+
+        std::vector<Token> tokens = scanTokens(scanner);
+
+        TALT_TIMER(PHASE_OUTPUT);
+        if (json) {
+            out << ",\"tokens\":[";
+            for (size_t i = 0; i < tokens.size(); i++) {
+                if (i > 0) out << ',';
+                printTokenJson(tokens[i], scanner.lineTable(), out);
+            }
+            out << ']';
+        }
+        else {
+            for (const Token& token : tokens) {
+                printToken(token, scanner.lineTable(), out);
+            }
+        }
+    }
+
+    if (options.dumpAst != DUMP_NONE) {
+        out.flush();
+        Scanner scanner(filename);
+        if (!scanner.open()) {
+            dumpOpenError(filename, json, out);
+            return;
+        }
+
+        Parser parser(scanner);
+        parser.maxErrors = options.maxErrors;
+
+        std::unique_ptr<ProgramNode> ast;
+        {
+            TALT_TIMER(PHASE_PARSE);
+            ast = parser.parse();
+        }
+
+        TALT_TIMER(PHASE_OUTPUT);
+        if (json) {
+            out << ",\"ast\":";
+            if (ast) ast->printJson(out, scanner.lineTable());
+            else out << "null";
+        }
+        else {
+            parser.printAST(ast.get(), out);
+        }
+    }
+
+    if (json) {
+        out << "}\n";
+    }
+}
+
+// Вывод результата модуля в формате --check
+bool printCheckResult(const std::string& filename, const Module& module,
+    OutputWriter& out) {
+    if (module.missing) {
+        out.flush();
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+
+    out << "\n=== ПРОВЕРКА: " << filename << " ===\n";
+    if (!module.error.empty()) {
+        out << "Модуль " << module.name << " не проверен: " << module.error << "\n"
+            << "\n✗ Обнаружены ошибки\n";
+        return false;
+    }
+    const CachedResult& result = module.result;
+    if (!result.parseErrors.empty()) {
+        out.flush();
+        std::cerr << result.parseErrors;
+        std::cerr.flush();
+    }
+    out << result.report;
+    return result.parseErrors.empty() &&
+        result.report.find("✗") == std::string::npos;
+}
+
+// Режим --check: только итог проверки. Файлы и то, что они импортируют,
+// проверяются как модули одного проекта; при совпадении содержимого и
+// сводок зависимостей результат берется из кэша без сканирования и разбора.
+bool checkFiles(const DriverOptions& options, ResultCache* cache, OutputWriter& out) {
+    const std::string& first = options.files.front();
+    ModuleBuilder builder(moduleRoot(options, first), ModuleBuilder::extensionOf(first),
+        checkOptions(options), cache);
+    std::vector<Module*> modules;
+    for (const auto& filename : options.files) {
+        modules.push_back(builder.addFile(filename));
+    }
+    builder.build();
+
+    bool allCorrect = true;
+    for (size_t i = 0; i < modules.size(); i++) {
+        allCorrect &= printCheckResult(options.files[i], *modules[i], out);
+    }
+    return allCorrect;
+}
+
+// Режим --build: проект из файлов и всего, что они импортируют.
+// Модули проверяются волнами на пуле потоков; выводятся отчеты только
+// модулей с ошибками и итог сборки.
+bool buildProject(const DriverOptions& options, ResultCache* cache, OutputWriter& out) {
+    auto start = std::chrono::steady_clock::now();
+
+    const std::string& first = options.files.front();
+    ModuleBuilder builder(moduleRoot(options, first), ModuleBuilder::extensionOf(first),
+        checkOptions(options), cache);
+    for (const auto& filename : options.files) {
+        builder.addFile(filename);
+    }
+
+    ThreadPool pool(options.threads > 0 ? options.threads : ThreadPool::defaultThreads());
+    builder.build(&pool);
+
+    std::vector<Module*> modules = builder.modulesInOrder();
+    int failed = 0;
+    for (const Module* module : modules) {
+        const CachedResult& result = module->result;
+        if (module->error.empty() && result.parseErrors.empty() &&
+            result.report.find("✗") == std::string::npos) {
+            continue;
+        }
+        failed++;
+        printCheckResult(module->path, *module, out);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    char elapsed[32];
+    std::snprintf(elapsed, sizeof(elapsed), "%.1f", ms);
+    out << "\n=== СБОРКА ===\n"
+        << "Модулей: " << (int)modules.size()
+        << ", проверено: " << builder.checkedCount()
+        << ", из кэша: " << builder.reusedCount()
+        << ", волн: " << builder.waveCount()
+        << ", потоков: " << pool.size() << "\n"
+        << "С ошибками: " << failed << ", время: " << elapsed << " мс\n";
+    return failed == 0;
+}
+
+// Значение, которое вернула функция
+std::string resultText(const ExecFunction& function, const ExecContext& context) {
+    if (function.returnType == EXT_VOID) return "void";
+    char buffer[32];
+    if (function.returnType == EXT_F32) {
+        std::snprintf(buffer, sizeof(buffer), "%.9g", context.floatResult);
+    }
+    else {
+        std::snprintf(buffer, sizeof(buffer), "%lld", (long long)context.intResult);
+    }
+    return buffer;
+}
+
+// Режим --run: проверка, построение ExecProgram и выполнение функции
+// entry интерпретатором или JIT. Сначала выполняется инициализация
+// глобальных переменных.
+bool runFile(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    Scanner scanner(filename);
+    if (!scanner.open()) {
+        out.flush();
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+
+    ModuleBuilder modules(moduleRoot(options, filename),
+        ModuleBuilder::extensionOf(filename), checkOptions(options));
+    Parser parser(scanner);
+    parser.maxErrors = options.maxErrors;
+
+    std::unique_ptr<ProgramNode> ast;
+    {
+        TALT_TIMER(PHASE_PARSE);
+        ast = parser.parse();
+    }
+    if (!ast || parser.hasError) {
+        out.flush();
+        std::cerr << "Выполнение невозможно: синтаксические ошибки" << std::endl;
+        return false;
+    }
+
+    PassManager passes(*ast, scanner.lineTable(), options.target, &modules);
+    {
+        TALT_TIMER(PHASE_SEMANTIC);
+        passes.semantic();
+    }
+    if (passes.semantic().hasErrors()) {
+        passes.semantic().printErrors(out);
+        out.flush();
+        std::cerr << "Выполнение невозможно: семантические ошибки" << std::endl;
+        return false;
+    }
+
+    {
+        TALT_TIMER(PHASE_LOWER);
+        ConstantFolding folding;
+        passes.run(folding);
+    }
+
+    ExecProgram program;
+    Lowering lowering(passes.semantic(), program);
+    InlinePlanner inliner;
+    if (options.inlineCalls) {
+        inliner.analyze(*ast);
+        lowering.setInliner(&inliner);
+    }
+    bool lowered;
+    {
+        TALT_TIMER(PHASE_LOWER);
+        lowered = lowering.lower(ast.get());
+    }
+    if (!lowered) {
+        out.flush();
+        std::cerr << "Выполнение невозможно: " << lowering.error() << std::endl;
+        return false;
+    }
+
+    for (const auto& note : lowering.notes()) {
+        out.flush();
+        std::cerr << note << std::endl;
+    }
+
+    const ExecFunction* entry = program.findFunction(options.entry);
+    if (!entry) {
+        out.flush();
+        std::cerr << "Функция не найдена: " << options.entry << std::endl;
+        return false;
+    }
+
+    JitCode jit;
+    if (options.run == RUN_JIT) {
+        std::string error;
+        if (!jit.compile(program, options.jit, error)) {
+            out.flush();
+            std::cerr << error << std::endl;
+            return false;
+        }
+    }
+
+    // Память выделяется словами, чтобы 8-байтовые поля были выровнены
+    std::vector<int64_t> globals(program.globalSize / 8 + 1, 0);
+    std::vector<int64_t> initFrame(program.init.frameSize / 8 + 1, 0);
+    std::vector<int64_t> frame(entry->frameSize / 8 + 1, 0);
+    std::vector<int64_t> callStack(EXEC_CALL_STACK_SIZE / 8, 0);
+
+    // Пул потоков нужен, только если есть параллельные циклы
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<ParallelRuntime> runtime;
+    if (!program.parallelLoops.empty()) {
+        pool.reset(new ThreadPool(options.threads > 0
+            ? options.threads : ThreadPool::defaultThreads()));
+        ParallelRuntime::Executor execute = interpretFunction;
+        if (options.run == RUN_JIT) {
+            execute = [&jit](const ExecFunction& fn, ExecContext& ctx) { jit.call(fn, ctx); };
+        }
+        runtime.reset(new ParallelRuntime(program, *pool, execute, options.deterministic));
+    }
+
+    ExecContext context;
+    context.globals = (char*)globals.data();
+    context.parallel = runtime.get();
+    context.stack = (char*)callStack.data();
+    context.stackEnd = context.stack + callStack.size() * 8;
+    {
+        TALT_TIMER(PHASE_EXECUTE);
+        context.frame = (char*)initFrame.data();
+        if (options.run == RUN_JIT) jit.call(program.init, context);
+        else interpretFunction(program.init, context);
+
+        if (context.status == EXEC_OK) {
+            context.frame = (char*)frame.data();
+            if (options.run == RUN_JIT) jit.call(*entry, context);
+            else interpretFunction(*entry, context);
+        }
+    }
+
+    if (context.status == EXEC_DIVISION_BY_ZERO) {
+        out.flush();
+        std::cerr << "Ошибка выполнения: деление на ноль" << std::endl;
+        return false;
+    }
+    if (context.status == EXEC_STACK_OVERFLOW) {
+        out.flush();
+        std::cerr << "Ошибка выполнения: переполнение стека вызовов" << std::endl;
+        return false;
+    }
+
+    out << entry->name << "() = " << resultText(*entry, context) << "\n";
+    return true;
+}
+
+// Чтение stdin по мере поступления данных: в отличие от
+// std::istream::read, не ждет, пока канал заполнит весь блок
+class StdinReader : public ChunkReader {
+public:
+    size_t read(char* buffer, size_t size) override {
+#ifdef _WIN32
+        int got = _read(_fileno(stdin), buffer, (unsigned)size);
+#else
+        ssize_t got;
+        do {
+            got = ::read(0, buffer, size);
+        } while (got < 0 && errno == EINTR);
+#endif
+        return got > 0 ? (size_t)got : 0;
+    }
+};
+
+// Режим --stream: объявления верхнего уровня разбираются, проверяются
+// и освобождаются по одному, поэтому память не растет с длиной файла,
+// а ошибки выводятся сразу. Области видимости проверенных функций
+// освобождаются, таблица символов не выводится. С --dump-ast выводится
+// дерево каждого объявления. Имя "-" - текст из stdin: объявление
+// проверяется, как только пришел его последний токен, не дожидаясь
+// конца текста; модули ищутся от текущего каталога.
+bool streamFile(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    out << "\n=== ПОТОКОВАЯ ПРОВЕРКА: " << filename << " ===\n";
+    out.flush();
+
+    StdinReader stdinReader;
+    std::unique_ptr<Scanner> source(filename == "-" ? new Scanner(stdinReader)
+        : new Scanner(filename));
+    Scanner& scanner = *source;
+    if (!scanner.open()) {
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+
+    ModuleBuilder modules(moduleRoot(options, filename),
+        ModuleBuilder::extensionOf(filename), checkOptions(options));
+    SemanticAnalyzer semantic;
+    semantic.setTargetAbi(options.target);
+    semantic.setModuleProvider(&modules);
+    semantic.setLineTable(&scanner.lineTable());
+    Parser parser(scanner);
+    parser.maxErrors = options.maxErrors;
+
+    // Таймеры фаз здесь не ставятся: их трасса росла бы с числом объявлений
+    unsigned long long declarations = 0;
+    Symbol* dummy = nullptr;
+    for (;;) {
+        std::unique_ptr<ASTNode> decl = parser.parseNext();
+        // Синтаксические ошибки уже выведены в std::cerr
+        parser.discardMessages();
+        if (!decl || memoryBudgetExceeded()) break;
+        declarations++;
+
+        if (options.dumpAst == DUMP_JSON) {
+            decl->printJson(out, scanner.lineTable());
+            out << '\n';
+        }
+        else if (options.dumpAst == DUMP_TEXT) {
+            parser.printAST(decl.get(), out);
+        }
+
+        size_t messages = semantic.errorCount() + semantic.warningCount();
+        {
+            TALT_MEMORY_SCOPE(MEM_SYMBOLS);
+            decl->checkSemantics(semantic, dummy);
+            semantic.discardClosedScopes();
+        }
+        // Позиции проверенных объявлений больше не выводятся
+        scanner.discardLinesBefore(decl->offset);
+        if (semantic.errorCount() + semantic.warningCount() != messages) {
+            semantic.flushMessages(out);
+            out.flush();
+        }
+    }
+
+    bool correct = !parser.hasError && !semantic.hasErrors();
+    out << "Объявлений: " << declarations
+        << ", ошибок: " << (unsigned long long)semantic.errorCount()
+        << ", предупреждений: " << (unsigned long long)semantic.warningCount() << "\n"
+        << (correct ? "\n✓ Программа корректна\n" : "\n✗ Обнаружены ошибки\n");
+    return correct;
+}
+
+// Токен с позицией, для сравнения токенов разных разбиений текста
+std::string describeToken(const Token& token, const LineTable& lines) {
+    SourcePosition at = lines.position(token.offset);
+    std::ostringstream text;
+    text << "[" << at.line << ":" << at.column << "] " << token.typeToString()
+        << " '" << token.lexeme << "' @" << token.offset << " parallel=" << token.parallel
+        << " range=" << (int)token.range << " value=" << (long long)token.intValue;
+    return text.str();
+}
+
+// Токены текста, поданного сканеру фрагментами с границами cuts
+std::vector<std::string> scanPushed(Scanner& scanner, const std::string& text,
+    const std::vector<size_t>& cuts) {
+    std::vector<std::string> tokens;
+    scanner.reset();
+    Token token;
+    size_t from = 0;
+    for (size_t i = 0; i <= cuts.size(); i++) {
+        size_t to = i < cuts.size() ? cuts[i] : text.size();
+        scanner.feed(text.data() + from, to - from);
+        from = to;
+        if (i == cuts.size()) scanner.finish();
+        while (scanner.nextToken(token)) {
+            tokens.push_back(describeToken(token, scanner.lineTable()));
+            if (token.type == TK_EOF) return tokens;
+        }
+    }
+    return tokens;
+}
+
+// Режим --chunk-check: текст файла подается сканеру в режиме подачи
+// двумя фрагментами, разрезанный по каждому байту, и по одному байту.
+// Токены, их позиции и значения должны совпасть с токенами всего текста.
+bool checkChunks(const std::string& filename, OutputWriter& out) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        out.flush();
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    std::vector<std::string> expected;
+    Scanner whole(text.data(), text.size());
+    for (Token token = whole.getNextToken(); ; token = whole.getNextToken()) {
+        expected.push_back(describeToken(token, whole.lineTable()));
+        if (token.type == TK_EOF) break;
+    }
+
+    out << "\n=== РАЗБИЕНИЯ: " << filename << " ===\n";
+    Scanner scanner;
+    unsigned long long splits = 0, mismatches = 0;
+    auto compare = [&](const std::vector<size_t>& cuts, const std::string& how) {
+        splits++;
+        std::vector<std::string> tokens = scanPushed(scanner, text, cuts);
+        if (tokens == expected) return;
+        if (mismatches++ > 0) return;
+        size_t i = 0;
+        while (i < tokens.size() && i < expected.size() && tokens[i] == expected[i]) i++;
+        out << "Расхождение, " << how << ", токен " << (unsigned long long)i << ":\n"
+            << "  ожидался " << (i < expected.size() ? expected[i] : "конец") << "\n"
+            << "  получен  " << (i < tokens.size() ? tokens[i] : "конец") << "\n";
+    };
+
+    std::vector<size_t> cuts(1);
+    for (size_t at = 0; at <= text.size(); at++) {
+        cuts[0] = at;
+        compare(cuts, "разрез на байте " + std::to_string(at));
+    }
+    cuts.clear();
+    for (size_t at = 1; at < text.size(); at++) cuts.push_back(at);
+    compare(cuts, "по одному байту");
+
+    out << "Токенов: " << (unsigned long long)expected.size()
+        << ", разбиений: " << splits << ", расхождений: " << mismatches << "\n"
+        << (mismatches == 0 ? "\n✓ Разбиения совпадают\n" : "\n✗ Обнаружены расхождения\n");
+    return mismatches == 0;
+}
+
+// Вырожденные входы для --recovery-check: piece повторяется count раз
+// между prefix и suffix
+struct RecoveryInput {
+    const char* name;
+    const char* prefix;
+    const char* piece;
+    const char* suffix;
+};
+
+const RecoveryInput RECOVERY_INPUTS[] = {
+    { "'}' вне блоков", "", "} ", "" },
+    { "')' в теле функции", "int f() { ", ") ", "}" },
+    { "';' в описании структуры", "struct S { ", "; int ", "}" },
+    { "тип без имени", "", "int ", "" },
+    { "вложенные '('", "int x = ", "(", "1;" },
+    { "вложенные '{'", "int f() ", "{ ", "" },
+    { "вложенные for", "int f() { ", "for (int i = 0; i < 1; i = i + 1) ", "" },
+    { "оборванные выражения", "int f() { int a = 1; ", "a = a + ; a = * 2; ", "}" },
+    { "оборванные объявления", "", "struct T { int x ", "" }
+};
+
+// Режим --recovery-check: парсер получает вырожденные входы нескольких
+// размеров. Восстановление после ошибок должно брать из сканера не больше
+// токенов, чем есть во входе, а сообщений не больше maxErrors и одного
+// о прекращении разбора. Без лимита ошибок число сообщений не превышает
+// числа токенов, с лимитом разбор прекращается, не дочитав вход.
+bool checkRecovery(OutputWriter& out) {
+    out << "\n=== ВОССТАНОВЛЕНИЕ ПОСЛЕ ОШИБОК ===\n"
+        << "Повторов  Токенов  Лимит      Взято  Ошибок  Время, мс  Вход\n";
+    bool correct = true;
+    for (const RecoveryInput& input : RECOVERY_INPUTS) {
+        for (int count = 1000; count <= 64000; count *= 8) {
+            std::string text = input.prefix;
+            for (int i = 0; i < count; i++) text += input.piece;
+            text += input.suffix;
+
+            // Вместе с TK_EOF: разбор берет и его
+            unsigned long long tokens = 1;
+            Scanner counter(text.data(), text.size());
+            for (Token token = counter.getNextToken(); token.type != TK_EOF;
+                token = counter.getNextToken()) {
+                tokens++;
+            }
+
+            for (int limit : { 100, INT_MAX }) {
+                Scanner scanner(text.data(), text.size());
+                Parser parser(scanner);
+                parser.reportToStderr = false;
+                parser.maxErrors = limit;
+
+                auto start = std::chrono::steady_clock::now();
+                std::unique_ptr<ProgramNode> ast = parser.parse();
+                double time = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+
+                unsigned long long consumed = parser.consumedTokens();
+                size_t errors = parser.errors.size();
+                bool ok = parser.hasError && consumed <= tokens &&
+                    (limit == INT_MAX ? errors <= tokens : errors <= (size_t)limit + 1);
+                correct &= ok;
+
+                char row[128];
+                std::snprintf(row, sizeof(row), "%8d  %7llu  %5s  %9llu  %6zu  %9.3f  ",
+                    count, tokens, limit == INT_MAX ? "нет" : "100", consumed, errors, time);
+                out << row << input.name << (ok ? "" : "  ✗") << "\n";
+            }
+        }
+    }
+    out << (correct ? "\n✓ Восстановление линейно\n" : "\n✗ Нарушены пределы восстановления\n");
+    return correct;
+}
+
+// Режим --lsp-bench: сценарий правок и запросов к серверу в том же
+// процессе, с таблицей задержек. С =script сценарий выводится кадрами
+// протокола, чтобы подать его на вход talt --lsp.
+bool benchLanguageServer(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        out.flush();
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    std::vector<std::string> script = makeLspBenchScript("file://" + filename,
+        buffer.str(), LSP_BENCH_ROUNDS);
+    if (options.lsp == LSP_BENCH_SCRIPT) {
+        for (const auto& message : script) {
+            writeLspFrame(out, message);
+        }
+        return true;
+    }
+
+    // Ответы сервера не нужны, буфер очищается после каждого сообщения
+    std::string responses;
+    OutputWriter sink(responses);
+    LspServer server(sink, options.target);
+    size_t responseBytes = 0;
+    for (const auto& message : script) {
+        server.process(message);
+        responseBytes += responses.size();
+        responses.clear();
+    }
+
+    out << "\n=== СЦЕНАРИЙ LSP: " << filename << " ===\n"
+        << "Сообщений: " << (unsigned long long)script.size()
+        << ", байт ответов: " << (unsigned long long)responseBytes << "\n";
+    server.printLatency(out);
+    return server.exited();
+}
+
+// Режим --api-bench: текст файла многократно проверяется через
+// TaltContext, как его проверяла бы встроившая библиотеку программа.
+// Две первые проверки заполняют память контекста (вторая - и списки,
+// которые reset оставляет для повторного использования) и в замер не
+// входят. В
+// сборке с TALT_STATS повторная проверка корректного текста не длиннее
+// CheckContext::RETAIN_LIMIT не должна обращаться к куче, иначе режим
+// завершается с ошибкой.
+bool benchApi(const std::string& filename, const DriverOptions& options,
+    OutputWriter& out) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        out.flush();
+        std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    TaltOptions api;
+    api.maxErrors = options.maxErrors;
+    switch (options.target) {
+    case ABI_LP64: api.target = TALT_TARGET_LP64; break;
+    case ABI_LLP64: api.target = TALT_TARGET_LLP64; break;
+    default: api.target = TALT_TARGET_ILP32; break;
+    }
+
+    TaltContext context;
+    const TaltResult* result = &context.check(text, api);
+    result = &context.check(text, api);
+#ifdef TALT_STATS
+    unsigned long long allocations = Stats::counters[STAT_ALLOCATIONS].load();
+#endif
+    unsigned long long checks = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    do {
+        result = &context.check(text, api);
+        checks++;
+        seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    } while (seconds < API_BENCH_SECONDS);
+
+    size_t errors = 0, warnings = 0;
+    for (const auto& diagnostic : result->diagnostics) {
+        (diagnostic.warning ? warnings : errors)++;
+    }
+
+    char rate[64];
+    std::snprintf(rate, sizeof(rate), "%.0f проверок/с, %.1f МБ/с",
+        checks / seconds, checks * text.size() / seconds / (1024 * 1024));
+    out << "\n=== API: " << filename << " ===\n"
+        << "Проверок: " << checks << ", " << rate << "\n";
+    bool allocationFree = true;
+#ifdef TALT_STATS
+    allocations = Stats::counters[STAT_ALLOCATIONS].load() - allocations;
+    char perCheck[32];
+    std::snprintf(perCheck, sizeof(perCheck), "%.1f", (double)allocations / checks);
+    out << "Выделений памяти на проверку: " << perCheck << "\n";
+    if (result->ok && text.size() <= CheckContext::RETAIN_LIMIT && allocations > 0) {
+        out << "✗ Повторная проверка корректного текста выделяет память: "
+            << allocations << " раз за " << checks << " проверок\n";
+        allocationFree = false;
+    }
+#endif
+    out << "Ошибок: " << (unsigned long long)errors
+        << ", предупреждений: " << (unsigned long long)warnings
+        << ", структур: " << (unsigned long long)result->structs.size()
+        << ", символов: " << (unsigned long long)result->symbols.size() << "\n"
+        << (result->ok ? "\n✓ Программа корректна\n" : "\n✗ Обнаружены ошибки\n");
+    return result->ok && allocationFree;
+}
+
+// Программа для --alloc-check: в каждой функции три области (параметры
+// с телом, цикл, блок тела цикла) и пять символов
+std::string makeAllocCheckText(int functions) {
+    std::string text = "struct P { int x; float y; };\nint g = 1;\n";
+    char line[256];
+    for (int f = 0; f < functions; f++) {
+        std::snprintf(line, sizeof(line),
+            "int f%d(int a) {\n"
+            "    struct P p;\n"
+            "    for (int i = 0; i < 4; i = i + 1) { int b = a + i; p.x = b; }\n"
+            "    return a + g;\n"
+            "}\n", f);
+        text += line;
+    }
+    return text;
+}
+
+// Функций в программе --alloc-check и предел выделений памяти при ее
+// семантической проверке. Символы и области берутся из пулов блоками,
+// повторяющиеся имена интернируются один раз. На функцию остаются ее
+// новое имя, запись SymbolExtra и типы параметров; запас - на блоки
+// пулов и таблиц.
+const int ALLOC_CHECK_FUNCTIONS = 2000;
+const unsigned long long ALLOC_CHECK_PER_FUNCTION = 4;
+const unsigned long long ALLOC_CHECK_SLACK = 256;
+
+// Режим --alloc-check: семантическая проверка фиксированной программы
+// в новом контексте. Области строятся один раз, при проверке, поэтому
+// их число точно равно числу конструкций с областью. Число выделений
+// памяти не зависит от числа символов и областей.
+bool checkAllocations(OutputWriter& out) {
+#ifdef TALT_STATS
+    std::string text = makeAllocCheckText(ALLOC_CHECK_FUNCTIONS);
+    CheckContext context;
+    ProgramNode* ast = context.parse(text, 100);
+    if (!ast || context.getParser().hasError) {
+        out << "Программа для проверки не разобрана\n";
+        return false;
+    }
+
+    unsigned long long scopes = Stats::counters[STAT_SCOPES].load();
+    unsigned long long allocations = Stats::counters[STAT_ALLOCATIONS].load();
+    unsigned long long bytes = Stats::counters[STAT_BYTES_ALLOCATED].load();
+    context.analyze(ABI_ILP32, nullptr);
+    scopes = Stats::counters[STAT_SCOPES].load() - scopes;
+    allocations = Stats::counters[STAT_ALLOCATIONS].load() - allocations;
+    bytes = Stats::counters[STAT_BYTES_ALLOCATED].load() - bytes;
+
+    SemanticAnalyzer& semantic = context.getSemantic();
+    unsigned long long expectedScopes = 3ULL * ALLOC_CHECK_FUNCTIONS;
+    unsigned long long limit = ALLOC_CHECK_PER_FUNCTION * ALLOC_CHECK_FUNCTIONS +
+        ALLOC_CHECK_SLACK;
+    bool scopesOk = scopes == expectedScopes;
+    bool allocationsOk = allocations <= limit;
+    bool correct = scopesOk && allocationsOk && !semantic.hasErrors();
+
+    out << "\n=== ВЫДЕЛЕНИЯ ПАМЯТИ: проверка " << ALLOC_CHECK_FUNCTIONS << " функций ===\n"
+        << "Символов: " << (unsigned long long)semantic.symbolCount() << "\n"
+        << "Областей: " << scopes << ", ожидалось " << expectedScopes
+        << (scopesOk ? "" : "  ✗") << "\n"
+        << "Выделений: " << allocations << ", предел " << limit
+        << (allocationsOk ? "" : "  ✗") << "\n"
+        << "Байт: " << bytes << "\n"
+        << (correct ? "\n✓ Выделения в пределах\n" : "\n✗ Пределы выделений нарушены\n");
+    return correct;
+#else
+    out.flush();
+    std::cerr << "Проверка выделений недоступна: сборка без TALT_STATS" << std::endl;
+    return false;
+#endif
+}
+
+// Функция с variables переменными для --dataflow-bench. Переменные
+// группами по 16 меняются в двух вложенных циклах и читают переменные
+// других групп; нечетные объявлены без инициализатора.
+std::string makeDataflowBenchText(int variables) {
+    std::string text = "int bench() {\n";
+    char line[128];
+    for (int v = 0; v < variables; v++) {
+        std::snprintf(line, sizeof(line), v % 2 ? "    int v%d;\n" : "    int v%d = %d;\n", v, v);
+        text += line;
+    }
+    for (int group = 0; group < variables; group += 16) {
+        text += "    for (int i = 0; i < 4; i = i + 1) {\n"
+            "        for (int j = 0; j < 4; j = j + 1) {\n";
+        for (int v = group; v < group + 16 && v < variables; v++) {
+            std::snprintf(line, sizeof(line), "            v%d = v%d + i * j;\n",
+                v, (v * 7 + 3) % variables);
+            text += line;
+        }
+        text += "        }\n    }\n";
+    }
+    text += "    return v0;\n}\n";
+    return text;
+}
+
+// Среднее время вызова f в миллисекундах; f повторяется seconds секунд
+template <class F>
+double averageTime(double seconds, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    int runs = 0;
+    do {
+        f();
+        runs++;
+        elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < seconds);
+    return elapsed * 1000 / runs;
+}
+
+// Режим --dataflow-bench: граф потока и анализы для функций со все
+// большим числом переменных. Время анализа растет как блоки * слова
+// строки битов, то есть квадратично от размера функции.
+void benchDataflow(OutputWriter& out) {
+    out << "\n=== DATAFLOW: масштабирование ===\n"
+        << "Переменных  Блоков  Событий  Граф, мс  Инициализация, мс  "
+        "Определения, мс  Живые, мс  Вычислений блоков\n";
+
+    for (int variables = 1000; variables <= 16000; variables *= 2) {
+        std::string text = makeDataflowBenchText(variables);
+        CheckContext context;
+        ProgramNode* program = context.parse(text, 100);
+        if (!program || program->declarations.empty()) continue;
+        context.analyze(ABI_ILP32, nullptr);
+        auto function = static_cast<const FunctionNode*>(program->declarations[0].get());
+        const NameTable& names = context.getSemantic().getNames();
+
+        FlowGraph graph;
+        DataflowSolver solver;
+        DefiniteInitialization initialization;
+        ReachingDefinitions reaching;
+        LiveVariables live;
+
+        double buildTime = averageTime(DATAFLOW_BENCH_SECONDS, [&] { graph.build(*function, names); });
+        double initTime = averageTime(DATAFLOW_BENCH_SECONDS, [&] { initialization.compute(graph, solver); });
+        double reachingTime = averageTime(DATAFLOW_BENCH_SECONDS, [&] { reaching.compute(graph, solver); });
+        double liveTime = averageTime(DATAFLOW_BENCH_SECONDS, [&] { live.compute(graph, solver); });
+        size_t evaluations = initialization.solution.evaluations +
+            reaching.solution.evaluations + live.solution.evaluations;
+
+        char row[160];
+        std::snprintf(row, sizeof(row), "%10d  %6zu  %7zu  %8.3f  %17.3f  %15.3f  %9.3f  %17zu\n",
+            variables, graph.blockCount(), graph.events.size(), buildTime, initTime,
+            reachingTime, liveTime, evaluations);
+        out << row;
+    }
+}
+
+// Программа с functions функциями для --dump-bench: структура, циклы,
+// выражения и присваивания полям, чтобы в дампе были все виды узлов
+std::string makeDumpBenchText(int functions) {
+    std::string text = "struct Point { int x; int y; float w; };\n";
+    char line[256];
+    for (int f = 0; f < functions; f++) {
+        std::snprintf(line, sizeof(line),
+            "int f%d() {\n"
+            "    struct Point p;\n"
+            "    int s = %d;\n"
+            "    for (int i = 0; i < 10; i = i + 1) {\n"
+            "        p.x = i * 2 + s;\n"
+            "        s = s + p.x %% 7 - (i << 1);\n"
+            "    }\n"
+            "    p.w = 1.5;\n"
+            "    return s;\n"
+            "}\n", f, f);
+        text += line;
+    }
+    return text;
+}
+
+// Режим --dump-bench: скорость дампов токенов и AST через OutputWriter
+// в нулевое устройство. Для текстовых дампов тот же текст выводится и
+// построчно через std::ofstream с std::endl, как до OutputWriter:
+// сброс на каждой строке - отдельный системный вызов.
+bool benchDump(OutputWriter& out) {
+    struct Dump {
+        const char* name;
+        bool lines;  // есть построчный вариант для сравнения
+        std::function<void(OutputWriter&)> write;
+    };
+
+    out << "\n=== ДАМП: скорость вывода ===\n"
+        << "Функций  Формат       Байт дампа  OutputWriter, мс    МБ/с  std::endl, мс  Ускорение\n";
+    bool correct = true;
+    for (int functions = 250; functions <= 4000; functions *= 4) {
+        std::string text = makeDumpBenchText(functions);
+        CheckContext context;
+        ProgramNode* ast = context.parse(text, 100);
+        Scanner scanner(text.data(), text.size());
+        if (!ast || context.getParser().hasError || !scanner.open()) {
+            out << "Программа для замера не разобрана\n";
+            return false;
+        }
+        std::vector<Token> tokens = scanTokens(scanner);
+        const LineTable& lines = context.lineTable();
+
+        const Dump dumps[] = {
+            { "tokens/text", true, [&](OutputWriter& w) {
+                for (const Token& token : tokens) printToken(token, lines, w);
+            } },
+            { "tokens/json", false, [&](OutputWriter& w) {
+                w << "{\"tokens\":[";
+                for (size_t i = 0; i < tokens.size(); i++) {
+                    if (i > 0) w << ',';
+                    printTokenJson(tokens[i], lines, w);
+                }
+                w << "]}\n";
+            } },
+            { "ast/text", true, [&](OutputWriter& w) { context.getParser().printAST(ast, w); } },
+            { "ast/json", false, [&](OutputWriter& w) {
+                ast->printJson(w, lines);
+                w << '\n';
+            } }
+        };
+
+        for (const Dump& dump : dumps) {
+            std::string captured;
+            {
+                OutputWriter capture(captured);
+                dump.write(capture);
+            }
+
+            FILE* sink = std::fopen(TALT_NULL_DEVICE, "wb");
+            if (!sink) {
+                out << "Нулевое устройство недоступно\n";
+                return false;
+            }
+            double writerTime;
+            {
+                OutputWriter writer(TALT_FILENO(sink));
+                writerTime = averageTime(DUMP_BENCH_SECONDS, [&] {
+                    dump.write(writer);
+                    writer.flush();
+                });
+            }
+            std::fclose(sink);
+
+            char row[160];
+            double mbPerSecond = captured.size() / (writerTime / 1000) / (1024 * 1024);
+            if (dump.lines) {
+                std::ofstream stream(TALT_NULL_DEVICE, std::ios::binary);
+                double endlTime = averageTime(DUMP_BENCH_SECONDS, [&] {
+                    size_t start = 0;
+                    while (start < captured.size()) {
+                        size_t end = captured.find('\n', start);
+                        if (end == std::string::npos) end = captured.size();
+                        stream.write(captured.data() + start, end - start);
+                        stream << std::endl;
+                        start = end + 1;
+                    }
+                });
+                correct &= stream.good();
+                std::snprintf(row, sizeof(row), "%7d  %-11s  %10zu  %16.3f  %6.1f  %13.3f  %8.2fx\n",
+                    functions, dump.name, captured.size(), writerTime, mbPerSecond,
+                    endlTime, endlTime / writerTime);
+            }
+            else {
+                std::snprintf(row, sizeof(row), "%7d  %-11s  %10zu  %16.3f  %6.1f  %13s  %9s\n",
+                    functions, dump.name, captured.size(), writerTime, mbPerSecond, "-", "-");
+            }
+            out << row;
+            correct &= !captured.empty();
+        }
+    }
+    return correct;
+}
+
+// Программы --call-bench. В рекурсивной встраиваются только листья
+// less и add, сама fib остается вызовом; в циклической встраиваются
+// все вызовы. Условие записано циклом for, выполняющимся не более
+// одного раза.
+const char* const CALL_BENCH_RECURSIVE =
+    "int less(int a, int b) { return a < b; }\n"
+    "int add(int a, int b) { return a + b; }\n"
+    "int fib(int n) {\n"
+    "    int r = n;\n"
+    "    for (int k = 0; less(1, n); n = 0) {\n"
+    "        r = add(fib(n - 1), fib(n - 2));\n"
+    "    }\n"
+    "    return r;\n"
+    "}\n"
+    "int bench() { return fib(22); }\n";
+
+const char* const CALL_BENCH_LEAVES =
+    "int square(int x) { return x * x; }\n"
+    "int clamp(int x, int high) {\n"
+    "    int r = x;\n"
+    "    for (int k = 0; x > high; x = 0) { r = high; }\n"
+    "    return r;\n"
+    "}\n"
+    "float scale(float x, float k) { return x * k + 1.0; }\n"
+    "float bench() {\n"
+    "    int s = 0;\n"
+    "    float f = 0.0;\n"
+    "    for (int i = 0; i < 100000; i = i + 1) {\n"
+    "        s = s + clamp(square(i & 127), 10000);\n"
+    "        f = scale(f, 0.5);\n"
+    "    }\n"
+    "    return f + s;\n"
+    "}\n";
+
+// Время выполнения bench() в программе text интерпретатором и JIT;
+// без interpret - только JIT. При threads > 0 циклы с прагмой
+// выполняются на пуле из threads потоков, иначе подряд.
+struct CallBenchResult {
+    bool ok = false;
+    std::string error;
+    int inlined = 0;
+    double interpTime = 0;
+    double jitTime = 0;
+    std::string interpValue;
+    std::string jitValue;
+};
+
+CallBenchResult runCallBench(const char* text, bool inlineCalls,
+    const JitOptions& jitOptions = JitOptions(), bool interpret = true,
+    int threads = 0, bool deterministic = false, bool fold = false) {
+    CallBenchResult result;
+    CheckContext check;
+    ProgramNode* ast = check.parse(text, 100);
+    if (!ast || check.getParser().hasError) {
+        result.error = "синтаксические ошибки";
+        return result;
+    }
+    check.analyze(ABI_ILP32, nullptr);
+    if (check.getSemantic().hasErrors()) {
+        result.error = "семантические ошибки";
+        return result;
+    }
+
+    // Свертка заменяет узлы, а дерево CheckContext лежит в его арене:
+    // для нее текст разбирается еще раз в кучу, и дальше все идет, как
+    // в --run, через PassManager со своим анализатором
+    SemanticAnalyzer* semantic = &check.getSemantic();
+    Scanner foldScanner(text, std::strlen(text));
+    Parser foldParser(foldScanner);
+    std::unique_ptr<ProgramNode> foldTree;
+    std::unique_ptr<PassManager> passes;
+    if (fold) {
+        foldParser.reportToStderr = false;
+        if (foldScanner.open()) foldTree = foldParser.parse();
+        if (!foldTree) {
+            result.error = "синтаксические ошибки";
+            return result;
+        }
+        ast = foldTree.get();
+        passes.reset(new PassManager(*ast, foldScanner.lineTable(), ABI_ILP32));
+        ConstantFolding folding;
+        passes->run(folding);
+        semantic = &passes->semantic();
+    }
+
+    ExecProgram program;
+    Lowering lowering(*semantic, program);
+    InlinePlanner inliner;
+    if (inlineCalls) {
+        inliner.analyze(*ast);
+        lowering.setInliner(&inliner);
+    }
+    if (!lowering.lower(ast)) {
+        result.error = lowering.error();
+        return result;
+    }
+    result.inlined = lowering.callsInlined();
+
+    const ExecFunction* entry = program.findFunction("bench");
+    JitCode jit;
+    if (!entry || !jit.compile(program, jitOptions, result.error)) {
+        if (result.error.empty()) result.error = "нет функции bench";
+        return result;
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<ParallelRuntime> interpRuntime, jitRuntime;
+    if (threads > 0 && !program.parallelLoops.empty()) {
+        pool.reset(new ThreadPool(threads));
+        interpRuntime.reset(new ParallelRuntime(program, *pool, interpretFunction, deterministic));
+        jitRuntime.reset(new ParallelRuntime(program, *pool,
+            [&jit](const ExecFunction& fn, ExecContext& ctx) { jit.call(fn, ctx); }, deterministic));
+    }
+
+    std::vector<int64_t> globals(program.globalSize / 8 + 1, 0);
+    std::vector<int64_t> frame(entry->frameSize / 8 + 1, 0);
+    std::vector<int64_t> callStack(EXEC_CALL_STACK_SIZE / 8, 0);
+    ExecContext context;
+    context.globals = (char*)globals.data();
+    context.stack = (char*)callStack.data();
+    context.stackEnd = context.stack + callStack.size() * 8;
+    context.frame = (char*)frame.data();
+
+    bool interpOk = true;
+    if (interpret) {
+        context.parallel = interpRuntime.get();
+        result.interpTime = averageTime(CALL_BENCH_SECONDS, [&] { interpretFunction(*entry, context); });
+        result.interpValue = resultText(*entry, context);
+        interpOk = context.status == EXEC_OK;
+    }
+    context.parallel = jitRuntime.get();
+    result.jitTime = averageTime(CALL_BENCH_SECONDS, [&] { jit.call(*entry, context); });
+    result.jitValue = resultText(*entry, context);
+    result.ok = interpOk && context.status == EXEC_OK;
+    if (!result.ok) result.error = "ошибка выполнения";
+    return result;
+}
+
+// Режим --call-bench: цена вызова без встраивания и со встраиванием
+// для рекурсивной программы и программы с вызовами листьев в цикле
+bool benchCalls(OutputWriter& out) {
+    struct Program {
+        const char* name;
+        const char* text;
+    };
+    const Program programs[] = {
+        { "рекурсивная", CALL_BENCH_RECURSIVE },
+        { "листья", CALL_BENCH_LEAVES }
+    };
+
+    out << "\n=== ВЫЗОВЫ: встраивание ===\n"
+        << "Встроено  Интерпретатор, мс          JIT, мс                    Результат  Программа\n"
+        << "          без     с       ускор.     без     с       ускор.\n";
+    bool allCorrect = true;
+    for (const Program& p : programs) {
+        CallBenchResult plain = runCallBench(p.text, false);
+        CallBenchResult inlined = runCallBench(p.text, true);
+        if (!plain.ok || !inlined.ok) {
+            out << p.name << ": " << (plain.ok ? inlined.error : plain.error) << "\n";
+            allCorrect = false;
+            continue;
+        }
+        // Встраивание не должно менять результат ни в одном режиме
+        bool same = plain.interpValue == plain.jitValue &&
+            plain.interpValue == inlined.interpValue &&
+            plain.interpValue == inlined.jitValue;
+        allCorrect &= same;
+
+        char row[192];
+        std::snprintf(row, sizeof(row), "%8d  %7.3f %7.3f %6.2fx    %7.3f %7.3f %6.2fx    %9s  ",
+            inlined.inlined, plain.interpTime, inlined.interpTime,
+            plain.interpTime / inlined.interpTime, plain.jitTime, inlined.jitTime,
+            plain.jitTime / inlined.jitTime, plain.interpValue.c_str());
+        out << row << p.name << (same ? "" : " ✗ результаты расходятся") << "\n";
+    }
+    return allCorrect;
+}
+
+// Программа для --symbol-bench: scopes блоков по variables переменных
+std::string makeSymbolBenchText(int scopes, int variables) {
+    std::string text;
+    char line[32];
+    for (int s = 0; s < scopes; s++) {
+        text += "{\n";
+        for (int v = 0; v < variables; v++) {
+            std::snprintf(line, sizeof(line), "    int v%d;\n", v);
+            text += line;
+        }
+        text += "}\n";
+    }
+    return text;
+}
+
+// Медиана замеров в миллисекундах
+double medianTime(std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    return times.empty() ? 0 : times[times.size() / 2];
+}
+
+// Режим --symbol-bench: таблица символов большого файла. Время
+// построения - analyze, освобождения - clear; память и число выделений
+// на символ считают счетчики TALT_STATS.
+bool benchSymbols(OutputWriter& out) {
+    std::string text = makeSymbolBenchText(SYMBOL_BENCH_SCOPES, SYMBOL_BENCH_VARIABLES);
+    CheckContext context;
+    ProgramNode* ast = context.parse(text, 100);
+    if (!ast || context.getParser().hasError) {
+        out << "Программа для замера не разобрана\n";
+        return false;
+    }
+
+    SemanticAnalyzer& semantic = context.getSemantic();
+    semantic.clear();
+    std::vector<double> buildTimes, destroyTimes;
+    size_t symbols = 0;
+    unsigned long long allocations = 0, bytes = 0;
+    bool correct = true;
+    for (int round = 0; round < SYMBOL_BENCH_ROUNDS; round++) {
+#ifdef TALT_STATS
+        allocations = Stats::counters[STAT_ALLOCATIONS].load();
+        bytes = Stats::counters[STAT_BYTES_ALLOCATED].load();
+#endif
+        auto start = std::chrono::steady_clock::now();
+        context.analyze(ABI_ILP32, nullptr);
+        auto built = std::chrono::steady_clock::now();
+#ifdef TALT_STATS
+        allocations = Stats::counters[STAT_ALLOCATIONS].load() - allocations;
+        bytes = Stats::counters[STAT_BYTES_ALLOCATED].load() - bytes;
+#endif
+        symbols = semantic.symbolCount();
+        correct &= !semantic.hasErrors();
+        semantic.clear();
+        auto end = std::chrono::steady_clock::now();
+        buildTimes.push_back(std::chrono::duration<double, std::milli>(built - start).count());
+        destroyTimes.push_back(std::chrono::duration<double, std::milli>(end - built).count());
+    }
+
+    char row[256];
+    out << "\n=== СИМВОЛЫ: " << SYMBOL_BENCH_SCOPES << " областей по "
+        << SYMBOL_BENCH_VARIABLES << " переменных ===\n";
+    std::snprintf(row, sizeof(row), "Символов: %zu\n"
+        "Построение, мс: минимум %.1f, медиана %.1f\n"
+        "Освобождение, мс: минимум %.1f, медиана %.1f\n",
+        symbols, *std::min_element(buildTimes.begin(), buildTimes.end()), medianTime(buildTimes),
+        *std::min_element(destroyTimes.begin(), destroyTimes.end()), medianTime(destroyTimes));
+    out << row;
+#ifdef TALT_STATS
+    std::snprintf(row, sizeof(row), "Байт на символ: %.1f, выделений памяти: %llu\n",
+        (double)bytes / symbols, allocations);
+    out << row;
+#endif
+    if (!correct) {
+        out << "✗ Программа для замера содержит ошибки\n";
+    }
+    return correct;
+}
+
+// Режим --field-bench: поиск поля в структурах разного размера.
+// checkFieldAccess получает имя строкой, как от парсера; lookupField -
+// по интернированным номерам, как при генерации кода. Поля выбираются
+// псевдослучайно, одна и та же последовательность в каждом запуске.
+bool benchFields(OutputWriter& out) {
+    out << "\n=== ПОЛЯ: поиск, нс на обращение ===\n"
+        << "Полей  checkFieldAccess  lookupField\n";
+    bool correct = true;
+    for (int fields : { 4, 64, 1024 }) {
+        std::string text = "struct S {";
+        std::vector<std::string> names;
+        for (int f = 0; f < fields; f++) {
+            names.push_back("f" + std::to_string(f));
+            text += " int " + names.back() + ";";
+        }
+        text += " };\nstruct S s;\n";
+
+        CheckContext context;
+        ProgramNode* ast = context.parse(text, 100);
+        if (!ast || context.getParser().hasError) {
+            out << "Программа для замера не разобрана\n";
+            return false;
+        }
+        context.analyze(ABI_ILP32, nullptr);
+        SemanticAnalyzer& semantic = context.getSemantic();
+        Symbol* variable = semantic.findSymbol("s");
+        NameId structId = semantic.getNames().find("S");
+        std::vector<NameId> ids;
+        for (const std::string& name : names) ids.push_back(semantic.getNames().find(name));
+        if (semantic.hasErrors() || !variable) {
+            out << "Программа для замера содержит ошибки\n";
+            return false;
+        }
+
+        // Одна последовательность индексов на оба замера
+        std::vector<int> order(FIELD_BENCH_ACCESSES);
+        uint32_t state = 12345;
+        for (int& index : order) {
+            state = state * 1664525u + 1013904223u;
+            index = (int)((state >> 8) % (uint32_t)fields);
+        }
+
+        size_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int index : order) {
+            const Type* type = nullptr;
+            found += semantic.checkFieldAccess(variable, names[index], &type, 0) ? 1 : 0;
+        }
+        auto checked = std::chrono::steady_clock::now();
+        for (int index : order) {
+            found += semantic.lookupField(structId, ids[index]) ? 1 : 0;
+        }
+        auto end = std::chrono::steady_clock::now();
+        correct &= found == 2 * order.size();
+
+        char row[96];
+        std::snprintf(row, sizeof(row), "%5d  %16.1f  %11.1f\n", fields,
+            std::chrono::duration<double, std::nano>(checked - start).count() / order.size(),
+            std::chrono::duration<double, std::nano>(end - checked).count() / order.size());
+        out << row;
+    }
+    if (!correct) {
+        out << "✗ Не все поля найдены\n";
+    }
+    return correct;
+}
+
+// Программа --jit-bench: вложенные циклы с целочисленной арифметикой
+const char* const JIT_BENCH_LOOPS =
+    "int bench() {\n"
+    "    int s = 0;\n"
+    "    for (int i = 0; i < 2000; i = i + 1) {\n"
+    "        for (int j = 0; j < 1000; j = j + 1) {\n"
+    "            s = s + (i * j) % 7 - (i ^ j);\n"
+    "        }\n"
+    "    }\n"
+    "    return s;\n"
+    "}\n";
+
+// Режим --jit-bench: интерпретатор и JIT на одной программе
+bool benchJit(OutputWriter& out) {
+    CallBenchResult result = runCallBench(JIT_BENCH_LOOPS, false);
+    out << "\n=== JIT: 2000 x 1000 итераций ===\n";
+    if (!result.ok) {
+        out << result.error << "\n";
+        return false;
+    }
+    char row[192];
+    std::snprintf(row, sizeof(row), "Интерпретатор, мс: %.3f\nJIT, мс: %.3f\nУскорение: %.1fx\n",
+        result.interpTime, result.jitTime, result.interpTime / result.jitTime);
+    out << row << "Результат: " << result.interpValue;
+    if (result.interpValue != result.jitValue) {
+        out << " ✗ JIT: " << result.jitValue << "\n";
+        return false;
+    }
+    out << "\n";
+    return true;
+}
+
+// Программы --vector-bench: 200 x 100000 итераций свертки во
+// внутреннем цикле, r не меняется внутри него
+const char* const VECTOR_BENCH_SUM =
+    "int bench() {\n"
+    "    int s = 0;\n"
+    "    for (int r = 0; r < 200; r = r + 1) {\n"
+    "        for (int i = 0; i < 100000; i = i + 1) { s = s + i * 3 - (i ^ r); }\n"
+    "    }\n"
+    "    return s;\n"
+    "}\n";
+
+const char* const VECTOR_BENCH_TWO =
+    "int bench() {\n"
+    "    int x = 0;\n"
+    "    int p = 1;\n"
+    "    for (int r = 0; r < 200; r = r + 1) {\n"
+    "        for (int i = 0; i < 100000; i = i + 1) { x = x ^ (i * r); p = p * (i | 1); }\n"
+    "    }\n"
+    "    return x + p;\n"
+    "}\n";
+
+const char* const VECTOR_BENCH_FLOAT =
+    "float bench() {\n"
+    "    float s = 0.0;\n"
+    "    for (int r = 0; r < 200; r = r + 1) {\n"
+    "        for (int i = 0; i < 100000; i = i + 1) { s = s + i * 1.5e-2 - r; }\n"
+    "    }\n"
+    "    return s;\n"
+    "}\n";
+
+// Режим --vector-bench: JIT со скалярными и векторными циклами.
+// Целые суммы должны совпасть; сумма float с --fast-math отличается
+// из-за другого порядка округлений.
+bool benchVectorize(OutputWriter& out) {
+    struct Program {
+        const char* name;
+        const char* text;
+        bool fastMath;
+    };
+    const Program programs[] = {
+        { "s = s + i * 3 - (i ^ r)", VECTOR_BENCH_SUM, false },
+        { "x = x ^ (i * r); p = p * (i | 1)", VECTOR_BENCH_TWO, false },
+        { "s = s + i * 1.5e-2 - r (fast-math)", VECTOR_BENCH_FLOAT, true }
+    };
+
+    out << "\n=== ВЕКТОРИЗАЦИЯ: 200 x 100000 итераций, JIT ===\n"
+        << "Скалярно, мс  Векторно, мс  Ускорение  Тело цикла\n";
+    bool correct = true;
+    for (const Program& p : programs) {
+        JitOptions scalarOptions;
+        scalarOptions.vectorize = false;
+        scalarOptions.fastMath = p.fastMath;
+        JitOptions vectorOptions = scalarOptions;
+        vectorOptions.vectorize = true;
+
+        CallBenchResult scalar = runCallBench(p.text, false, scalarOptions, false);
+        CallBenchResult vector = runCallBench(p.text, false, vectorOptions, false);
+        if (!scalar.ok || !vector.ok) {
+            out << p.name << ": " << (scalar.ok ? vector.error : scalar.error) << "\n";
+            correct = false;
+            continue;
+        }
+
+        char row[96];
+        std::snprintf(row, sizeof(row), "%12.3f  %12.3f  %8.1fx  ",
+            scalar.jitTime, vector.jitTime, scalar.jitTime / vector.jitTime);
+        out << row << p.name;
+        if (scalar.jitValue != vector.jitValue) {
+            out << ": " << scalar.jitValue << " и " << vector.jitValue;
+            correct &= p.fastMath;
+        }
+        out << "\n";
+    }
+    return correct;
+}
+
+// Программы --parallel-bench: гармоническая сумма float, целая
+// свертка и длинный целый цикл для замера времени
+const char* const PARALLEL_BENCH_HARMONIC =
+    "float bench() {\n"
+    "    float s = 0.0;\n"
+    "    // talt: parallel\n"
+    "    for (int i = 1; i < 100001; i = i + 1) { s = s + 1.0 / i; }\n"
+    "    return s;\n"
+    "}\n";
+
+const char* const PARALLEL_BENCH_INTEGER =
+    "int bench() {\n"
+    "    int s = 0;\n"
+    "    int x = 1;\n"
+    "    // talt: parallel\n"
+    "    for (int i = 0; i < 1000000; i = i + 1) { s = s + (i * 7) % 13; x = x ^ (i * i); }\n"
+    "    return s + x;\n"
+    "}\n";
+
+const char* const PARALLEL_BENCH_LONG =
+    "int bench() {\n"
+    "    int s = 0;\n"
+    "    // talt: parallel\n"
+    "    for (int i = 0; i < 64000000; i = i + 1) { s = s + (i * 7) % 13; }\n"
+    "    return s;\n"
+    "}\n";
+
+// Режим --parallel-bench: результаты и время циклов с прагмой при
+// разном числе потоков. Гармоническая сумма с --deterministic и целые
+// свертки должны совпасть при любом числе потоков.
+bool benchParallel(OutputWriter& out) {
+    const int threadCounts[] = { 1, 2, 3, 8 };
+    bool correct = true;
+
+    out << "\n=== ПАРАЛЛЕЛЬНЫЕ ЦИКЛЫ: ядер " << ThreadPool::defaultThreads() << " ===\n"
+        << "Гармоническая сумма 1e5 членов, интерпретатор\n"
+        << "Потоков  Обычно          --deterministic\n";
+    std::string deterministicValue;
+    for (int threads : threadCounts) {
+        CallBenchResult unordered = runCallBench(PARALLEL_BENCH_HARMONIC, false, JitOptions(), true, threads, false);
+        CallBenchResult fixed = runCallBench(PARALLEL_BENCH_HARMONIC, false, JitOptions(), true, threads, true);
+        if (!unordered.ok || !fixed.ok) {
+            out << (unordered.ok ? fixed.error : unordered.error) << "\n";
+            return false;
+        }
+        char row[96];
+        std::snprintf(row, sizeof(row), "%7d  %-14s  %s\n",
+            threads, unordered.interpValue.c_str(), fixed.interpValue.c_str());
+        out << row;
+        if (deterministicValue.empty()) deterministicValue = fixed.interpValue;
+        correct &= fixed.interpValue == deterministicValue && fixed.jitValue == deterministicValue;
+    }
+
+    CallBenchResult serial = runCallBench(PARALLEL_BENCH_INTEGER, false);
+    out << "\nЦелая свертка подряд: " << serial.interpValue << "\n";
+    correct &= serial.ok && serial.interpValue == serial.jitValue;
+    for (int threads : threadCounts) {
+        for (bool deterministic : { false, true }) {
+            CallBenchResult result = runCallBench(PARALLEL_BENCH_INTEGER, false, JitOptions(), true,
+                threads, deterministic);
+            if (!result.ok || result.interpValue != serial.interpValue ||
+                result.jitValue != serial.interpValue) {
+                out << "✗ Потоков " << threads << (deterministic ? ", --deterministic" : "")
+                    << ": " << result.interpValue << " и " << result.jitValue << "\n";
+                correct = false;
+            }
+        }
+    }
+
+    out << "\nЦикл 64M итераций, JIT\n"
+        << "Потоков  мс\n";
+    CallBenchResult base = runCallBench(PARALLEL_BENCH_LONG, false, JitOptions(), false);
+    char row[64];
+    std::snprintf(row, sizeof(row), "подряд   %.1f\n", base.jitTime);
+    out << row;
+    for (int threads : { 1, 2, 4, 8, 16 }) {
+        CallBenchResult result = runCallBench(PARALLEL_BENCH_LONG, false, JitOptions(), false, threads);
+        correct &= result.ok && result.jitValue == base.jitValue;
+        std::snprintf(row, sizeof(row), "%7d  %.1f\n", threads, result.jitTime);
+        out << row;
+    }
+    if (!correct) {
+        out << "✗ Результаты расходятся\n";
+    }
+    return correct;
 }
 
-int main() {
+// Проект --build-bench: листья со структурой, средние модули импортируют
+// два листа, верхние - два средних. Первая строка каждого файла -
+// номер запуска, чтобы кэш прежних запусков в том же каталоге не
+// использовался.
+bool writeBuildBenchFile(const std::string& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+    file.close();
+    return !file.fail();
+}
+
+std::string buildBenchLeaf(const std::string& stamp, int leaf, bool extraField, int bodyValue) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+        "// %s\n"
+        "struct L%d { int a; int b;%s };\n"
+        "int lf%d(int x) { int y = x + %d; return y; }\n",
+        stamp.c_str(), leaf, extraField ? " int c;" : "", leaf, bodyValue);
+    return text;
+}
+
+bool writeBuildBenchProject(const std::string& dir, const std::string& stamp,
+    std::vector<std::string>& tops) {
+    char text[512];
+    bool ok = true;
+    for (int leaf = 0; leaf < BUILD_BENCH_LEAVES; leaf++) {
+        ok &= writeBuildBenchFile(dir + "/l" + std::to_string(leaf) + ".txt",
+            buildBenchLeaf(stamp, leaf, false, leaf));
+    }
+    for (int mid = 0; mid < BUILD_BENCH_MIDS; mid++) {
+        int a = mid % BUILD_BENCH_LEAVES, b = (mid * 7 + 3) % BUILD_BENCH_LEAVES;
+        std::snprintf(text, sizeof(text),
+            "// %s\nimport l%d;\nimport l%d;\n"
+            "struct M%d { struct L%d p; int c; };\n"
+            "int mf%d() { struct L%d q; q.a = %d; return q.a; }\n",
+            stamp.c_str(), a, b, mid, a, mid, b, mid);
+        ok &= writeBuildBenchFile(dir + "/m" + std::to_string(mid) + ".txt", text);
+    }
+    tops.clear();
+    for (int top = 0; top < BUILD_BENCH_TOPS; top++) {
+        int a = top % BUILD_BENCH_MIDS, b = (top * 13 + 5) % BUILD_BENCH_MIDS;
+        std::snprintf(text, sizeof(text),
+            "// %s\nimport m%d;\nimport m%d;\n"
+            "int tf%d() { struct M%d q; q.c = %d; struct M%d r; r.c = q.c; return r.c; }\n",
+            stamp.c_str(), a, b, top, a, top, b);
+        tops.push_back(dir + "/t" + std::to_string(top) + ".txt");
+        ok &= writeBuildBenchFile(tops.back(), text);
+    }
+    return ok;
+}
+
+// Режим --build-bench DIR: сборка созданного в DIR проекта из
+// BUILD_BENCH_LEAVES + MIDS + TOPS модулей в три волны. Замеряются
+// чистая сборка, сборка с записью кэша, сборка без изменений и после
+// правки тела и структуры одного листа.
+bool benchBuild(const std::string& dir, OutputWriter& out) {
+    TALT_MKDIR(dir.c_str());
+    std::string stamp = std::to_string(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+    std::vector<std::string> tops;
+    if (!writeBuildBenchProject(dir, stamp, tops)) {
+        out << "Не удалось записать проект в " << dir << "\n";
+        return false;
+    }
+    ResultCache cache(dir + "/cache");
+    if (!cache.isUsable()) {
+        out << "Каталог кэша недоступен: " << dir << "/cache\n";
+        return false;
+    }
+
+    struct Step {
+        const char* name;
+        int threads;
+        bool useCache;
+        int expectChecked;  // -1 - больше одного, но не все
+    };
+    int total = BUILD_BENCH_LEAVES + BUILD_BENCH_MIDS + BUILD_BENCH_TOPS;
+    const Step steps[] = {
+        { "чистая, без кэша", 1, false, total },
+        { "чистая, без кэша, 4 потока", 4, false, total },
+        { "чистая, запись кэша", 1, true, total },
+        { "без изменений", 1, true, 0 },
+        { "правка тела листа", 1, true, 1 },
+        { "правка структуры листа", 1, true, -1 }
+    };
+
+    out << "\n=== СБОРКА: " << total << " модулей ===\n"
+        << "Проверено  Из кэша  Волн      мс  Сборка\n";
+    bool correct = true;
+    for (const Step& step : steps) {
+        if (step.expectChecked == 1) {
+            correct &= writeBuildBenchFile(dir + "/l0.txt", buildBenchLeaf(stamp, 0, false, 1000));
+        }
+        else if (step.expectChecked == -1) {
+            correct &= writeBuildBenchFile(dir + "/l0.txt", buildBenchLeaf(stamp, 0, true, 1000));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ModuleBuilder builder(dir, ".txt", CheckOptions(), step.useCache ? &cache : nullptr);
+        for (const std::string& top : tops) {
+            builder.addFile(top);
+        }
+        ThreadPool pool(step.threads);
+        builder.build(&pool);
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+
+        int failed = 0;
+        for (const Module* module : builder.modulesInOrder()) {
+            if (!module->error.empty() || !module->result.parseErrors.empty() ||
+                module->result.report.find("✗") != std::string::npos) {
+                failed++;
+            }
+        }
+        int checked = builder.checkedCount();
+        bool expected = step.expectChecked >= 0 ? checked == step.expectChecked
+            : checked > 1 && checked < total;
+        correct &= expected && failed == 0 &&
+            checked + builder.reusedCount() == total;
+
+        char row[96];
+        std::snprintf(row, sizeof(row), "%9d  %7d  %4d  %6.1f  ",
+            checked, builder.reusedCount(), builder.waveCount(), ms);
+        out << row << step.name << (expected ? "" : " ✗") << "\n";
+        if (failed > 0) {
+            out << "✗ Модулей с ошибками: " << failed << "\n";
+        }
+    }
+    return correct;
+}
+
+// Программа --literal-bench: statements присваиваний; в нечетных три
+// целые константы, в четных две float, одна из них с порядком
+std::string makeLiteralBenchText(int statements) {
+    std::string text = "int bench() {\n    int a = 0;\n    float x = 0.0;\n    float y = 0.5;\n";
+    char line[96];
+    for (int k = 0; k < statements; k++) {
+        if (k % 2) {
+            std::snprintf(line, sizeof(line), "    a = a + %d * 3 - %d;\n", k % 1000, k % 997 * 3);
+        }
+        else {
+            std::snprintf(line, sizeof(line), "    x = y + %d.25 + %d.5e-3;\n", k % 100, k % 89);
+        }
+        text += line;
+    }
+    text += "    return a;\n}\n";
+    return text;
+}
+
+// Режим --literal-bench: фазы для файла с большим числом констант.
+// Столбец "повторный разбор" - то, что делало понижение до того, как
+// значения стал разбирать сканер: strtoull для целых и istringstream
+// для float по тексту каждой константы.
+bool benchLiterals(OutputWriter& out) {
+    std::string text = makeLiteralBenchText(LITERAL_BENCH_STATEMENTS);
+    CheckContext context;
+    ProgramNode* ast = context.parse(text, 100);
+    if (!ast || context.getParser().hasError) {
+        out << "Программа для замера не разобрана\n";
+        return false;
+    }
+    context.analyze(ABI_ILP32, nullptr);
+    if (context.getSemantic().hasErrors()) {
+        out << "Программа для замера содержит ошибки\n";
+        return false;
+    }
+
+    std::vector<Token> tokens;
+    double scanTime = averageTime(LITERAL_BENCH_SECONDS, [&] {
+        Scanner scanner(text.data(), text.size());
+        if (scanner.open()) tokens = scanTokens(scanner);
+    });
+    size_t literals = 0;
+    for (const Token& token : tokens) {
+        literals += token.type == TK_INT_CONST || token.type == TK_FLOAT_CONST;
+    }
+
+    CheckContext parseContext;
+    double parseTime = averageTime(LITERAL_BENCH_SECONDS, [&] { parseContext.parse(text, 100); });
+
+    bool lowered = true;
+    double lowerTime = averageTime(LITERAL_BENCH_SECONDS, [&] {
+        ExecProgram program;
+        Lowering lowering(context.getSemantic(), program);
+        lowered &= lowering.lower(ast);
+    });
+
+    double checksum = 0;
+    double redecodeTime = averageTime(LITERAL_BENCH_SECONDS, [&] {
+        for (const Token& token : tokens) {
+            if (token.type == TK_INT_CONST) {
+                checksum += (double)std::strtoull(token.lexeme.c_str(), nullptr, 10);
+            }
+            else if (token.type == TK_FLOAT_CONST) {
+                std::istringstream in(token.lexeme);
+                float value = 0;
+                in >> value;
+                checksum += value;
+            }
+        }
+    });
+
+    CallBenchResult run = runCallBench(text.c_str(), false);
+    if (!lowered || !run.ok) {
+        out << (lowered ? run.error : "Понижение не удалось") << "\n";
+        return false;
+    }
+
+    char row[256];
+    std::snprintf(row, sizeof(row),
+        "\n=== КОНСТАНТЫ: %d присваиваний, %zu констант, %zu байт ===\n"
+        "Сканирование, мс: %.1f\nРазбор, мс: %.1f\nПонижение, мс: %.1f\n",
+        LITERAL_BENCH_STATEMENTS, literals, text.size(), scanTime, parseTime, lowerTime);
+    out << row;
+    std::snprintf(row, sizeof(row),
+        "Повторный разбор констант, мс: %.1f\nВыполнение, мс: интерпретатор %.1f, JIT %.1f\n",
+        redecodeTime, run.interpTime, run.jitTime);
+    out << row << "Результат: " << run.interpValue << "\n";
+    return checksum != 0 && run.interpValue == run.jitValue;
+}
+
+// Обход цепочкой dynamic_cast, как было до тегов kind: лист проходит
+// все проверки, прежде чем оказаться ни одним из составных узлов
+size_t countNodesByCast(const ASTNode* node) {
+    if (!node) return 0;
+    size_t count = 1;
+    if (auto program = dynamic_cast<const ProgramNode*>(node)) {
+        for (const auto& decl : program->declarations) count += countNodesByCast(decl.get());
+    }
+    else if (auto function = dynamic_cast<const FunctionNode*>(node)) {
+        count += countNodesByCast(function->body.get());
+    }
+    else if (auto block = dynamic_cast<const BlockNode*>(node)) {
+        for (const auto& stmt : block->statements) count += countNodesByCast(stmt.get());
+    }
+    else if (auto decl = dynamic_cast<const VarDeclNode*>(node)) {
+        count += countNodesByCast(decl->initValue.get());
+    }
+    else if (auto assign = dynamic_cast<const AssignNode*>(node)) {
+        count += countNodesByCast(assign->expression.get());
+    }
+    else if (auto loop = dynamic_cast<const ForLoopNode*>(node)) {
+        count += countNodesByCast(loop->init.get()) + countNodesByCast(loop->condition.get()) +
+            countNodesByCast(loop->increment.get()) + countNodesByCast(loop->body.get());
+    }
+    else if (auto ret = dynamic_cast<const ReturnNode*>(node)) {
+        count += countNodesByCast(ret->expression.get());
+    }
+    else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        count += countNodesByCast(binary->left.get()) + countNodesByCast(binary->right.get());
+    }
+    else if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        count += countNodesByCast(unary->operand.get());
+    }
+    else if (auto call = dynamic_cast<const CallNode*>(node)) {
+        for (const auto& argument : call->arguments) count += countNodesByCast(argument.get());
+    }
+    return count;
+}
+
+class NodeCounter : public ASTWalker<NodeCounter> {
+public:
+    size_t count = 0;
+
+    template <class Node>
+    void visit(Node& node) {
+        count++;
+        visitChildren(node);
+    }
+};
+
+// Режим --walk-bench: цена одного обхода дерева цепочкой dynamic_cast и
+// ASTWalker, повторные запросы констант через PassManager и --run со
+// сверткой констант и без нее
+bool benchWalks(OutputWriter& out) {
+    std::string text = makeLiteralBenchText(WALK_BENCH_STATEMENTS);
+    CheckContext context;
+    ProgramNode* ast = context.parse(text, 100);
+    if (!ast || context.getParser().hasError) {
+        out << "Программа для замера не разобрана\n";
+        return false;
+    }
+
+    size_t castNodes = 0, walkerNodes = 0;
+    double castTime = averageTime(WALK_BENCH_SECONDS, [&] { castNodes = countNodesByCast(ast); });
+    double walkerTime = averageTime(WALK_BENCH_SECONDS, [&] {
+        NodeCounter counter;
+        counter.walk(*static_cast<const ASTNode*>(ast));
+        walkerNodes = counter.count;
+    });
+
+    PassManager passes(*ast, context.lineTable(), ABI_ILP32);
+    auto start = std::chrono::steady_clock::now();
+    size_t constants = passes.constants().size();
+    double firstTime = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) constants = passes.constants().size();
+    double repeatTime = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    CallBenchResult plain = runCallBench(WALK_BENCH_LOOP, false);
+    CallBenchResult folded = runCallBench(WALK_BENCH_LOOP, false, JitOptions(), true, 0, false, true);
+    if (!plain.ok || !folded.ok) {
+        out << (plain.ok ? folded.error : plain.error) << "\n";
+        return false;
+    }
+
+    char row[256];
+    std::snprintf(row, sizeof(row),
+        "\n=== ОБХОД ДЕРЕВА: %zu узлов ===\n"
+        "Цепочка dynamic_cast, мс: %.1f\nASTWalker, мс: %.1f\n",
+        walkerNodes, castTime, walkerTime);
+    out << row;
+    std::snprintf(row, sizeof(row),
+        "constants(), мс: первый %.1f (с семантикой), еще 10 раз %.3f; вычислений %d, выражений %zu\n",
+        firstTime, repeatTime, passes.computeCount(ANALYSIS_CONSTANTS), constants);
+    out << row;
+    std::snprintf(row, sizeof(row),
+        "Цикл с константными подвыражениями, мс: без свертки %.1f / %.1f, со сверткой %.1f / %.1f"
+        " (интерпретатор / JIT)\n",
+        plain.interpTime, plain.jitTime, folded.interpTime, folded.jitTime);
+    out << row;
+    return castNodes == walkerNodes && passes.computeCount(ANALYSIS_CONSTANTS) == 1 &&
+        plain.interpValue == folded.interpValue && plain.jitValue == folded.jitValue;
+}
+
+// Программа --type-bench: structs структур и functions функций; каждая
+// функция группами копирует структуры и присваивает их поля
+std::string makeTypeBenchText(int structs, int functions) {
+    std::string text;
+    char line[160];
+    for (int s = 0; s < structs; s++) {
+        std::snprintf(line, sizeof(line),
+            "struct S%d { int a; int b; float f; long l; };\n", s);
+        text += line;
+    }
+    for (int k = 0; k < functions; k++) {
+        int s = k % structs;
+        std::snprintf(line, sizeof(line),
+            "int f%d() {\n    struct S%d p;\n    struct S%d q;\n    p.a = %d;\n    p.f = 0.5;\n",
+            k, s, s, k);
+        text += line;
+        for (int g = 0; g < TYPE_BENCH_GROUPS; g++) {
+            std::snprintf(line, sizeof(line),
+                "    q = p;\n    q.b = p.a + %d;\n    p.l = q.b * 2;\n    p.f = q.f + %d.25;\n"
+                "    p = q;\n", g, g);
+            text += line;
+        }
+        text += "    return p.a + q.b;\n}\n";
+    }
+    return text;
+}
+
+// Режим --type-bench: семантический анализ файла, где почти каждое
+// присваивание проверяет тип структуры или поля. Медиана по запускам и
+// число поисков символа за один анализ.
+bool benchTypes(OutputWriter& out) {
+    std::string text = makeTypeBenchText(TYPE_BENCH_STRUCTS, TYPE_BENCH_FUNCTIONS);
+    CheckContext context;
+    std::vector<double> times;
+    unsigned long long lookups = 0;
+    for (int run = 0; run < TYPE_BENCH_RUNS; run++) {
+        ProgramNode* ast = context.parse(text, 100);
+        if (!ast || context.getParser().hasError) {
+            out << "Программа для замера не разобрана\n";
+            return false;
+        }
+        unsigned long long before = Stats::counters[STAT_SYMBOL_LOOKUPS].load();
+        auto start = std::chrono::steady_clock::now();
+        context.analyze(ABI_ILP32, nullptr);
+        times.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+        lookups = Stats::counters[STAT_SYMBOL_LOOKUPS].load() - before;
+        if (context.getSemantic().hasErrors()) {
+            out << "Программа для замера содержит ошибки\n";
+            return false;
+        }
+    }
+
+    char row[256];
+    std::snprintf(row, sizeof(row),
+        "\n=== ТИПЫ: %d структур, %d функций, %zu байт ===\n"
+        "Семантический анализ, мс (медиана %d запусков): %.2f\n",
+        TYPE_BENCH_STRUCTS, TYPE_BENCH_FUNCTIONS, text.size(), TYPE_BENCH_RUNS, medianTime(times));
+    out << row;
+#ifdef TALT_STATS
+    out << "Поисков символа: " << lookups << "\n";
+#else
+    (void)lookups;
+    out << "Поисков символа: недоступно, сборка без TALT_STATS\n";
+#endif
+    return true;
+}
+
+// Режим --lsp: сервер работает, пока клиент не пришлет exit
+int runLanguageServer(const DriverOptions& options) {
+    std::ios::sync_with_stdio(false);
+#ifdef _WIN32
+    // Content-Length считает байты, перевод строк менять нельзя
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    OutputWriter protocol;
+    LspServer server(protocol, options.target);
+    int code = server.run(std::cin);
+    protocol.flush();
+
+    if (options.showStats) {
+        OutputWriter report(2);
+        server.printLatency(report);
+    }
+    return code;
+}
+
+bool parseDumpFormat(const std::string& arg, size_t prefixLength, DumpFormat& format) {
+    if (arg.size() == prefixLength) {
+        format = DUMP_TEXT;
+        return true;
+    }
+    std::string value = arg.substr(prefixLength);
+    if (value == "=text") {
+        format = DUMP_TEXT;
+        return true;
+    }
+    if (value == "=json") {
+        format = DUMP_JSON;
+        return true;
+    }
+    return false;
+}
+
+bool parseArguments(int argc, char* argv[], DriverOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--stats") {
+            options.showStats = true;
+        }
+        else if (arg == "--stats=json") {
+            options.showStats = true;
+            options.statsJson = true;
+        }
+        else if (arg.compare(0, 8, "--trace=") == 0) {
+            options.traceFile = arg.substr(8);
+        }
+        else if (arg.compare(0, 13, "--dump-tokens") == 0) {
+            if (!parseDumpFormat(arg, 13, options.dumpTokens)) {
+                std::cerr << "Неизвестный формат дампа: " << arg << std::endl;
+                return false;
+            }
+        }
+        else if (arg.compare(0, 10, "--dump-ast") == 0) {
+            if (!parseDumpFormat(arg, 10, options.dumpAst)) {
+                std::cerr << "Неизвестный формат дампа: " << arg << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::atoi(argv[++i]);
+            if (options.repeat < 1) options.repeat = 1;
+        }
+        else if (arg.compare(0, 9, "--target=") == 0) {
+            if (!parseTargetAbi(arg.substr(9), options.target)) {
+                std::cerr << "Неизвестная платформа: " << arg << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--layout") {
+            options.layout = true;
+        }
+        else if (arg == "--check") {
+            options.check = true;
+        }
+        else if (arg == "--cache-dir" && i + 1 < argc) {
+            options.cacheDir = argv[++i];
+            if (!options.build) options.check = true;
+        }
+        else if (arg == "--stream") {
+            options.stream = true;
+        }
+        else if (arg == "--build") {
+            options.build = true;
+            options.check = false;
+        }
+        else if (arg == "--module-root" && i + 1 < argc) {
+            options.moduleRoot = argv[++i];
+        }
+        else if (arg == "--run=interp") {
+            options.run = RUN_INTERP;
+        }
+        else if (arg == "--run=jit" || arg == "--run") {
+            options.run = RUN_JIT;
+        }
+        else if (arg == "--fast-math") {
+            options.jit.fastMath = true;
+        }
+        else if (arg == "--no-vectorize") {
+            options.jit.vectorize = false;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+            if (options.threads < 1) options.threads = 1;
+        }
+        else if (arg == "--deterministic") {
+            options.deterministic = true;
+        }
+        else if (arg == "--lsp") {
+            options.lsp = LSP_SERVER;
+        }
+        else if (arg == "--lsp-bench") {
+            options.lsp = LSP_BENCH;
+        }
+        else if (arg == "--lsp-bench=script") {
+            options.lsp = LSP_BENCH_SCRIPT;
+        }
+        else if (arg == "--api-bench") {
+            options.apiBench = true;
+        }
+        else if (arg == "--chunk-check") {
+            options.chunkCheck = true;
+        }
+        else if (arg == "--dataflow-bench") {
+            options.dataflowBench = true;
+        }
+        else if (arg == "--alloc-check") {
+            options.allocCheck = true;
+        }
+        else if (arg == "--recovery-check") {
+            options.recoveryCheck = true;
+        }
+        else if (arg == "--dump-bench") {
+            options.dumpBench = true;
+        }
+        else if (arg == "--call-bench") {
+            options.callBench = true;
+        }
+        else if (arg == "--symbol-bench") {
+            options.symbolBench = true;
+        }
+        else if (arg == "--field-bench") {
+            options.fieldBench = true;
+        }
+        else if (arg == "--jit-bench") {
+            options.jitBench = true;
+        }
+        else if (arg == "--vector-bench") {
+            options.vectorBench = true;
+        }
+        else if (arg == "--parallel-bench") {
+            options.parallelBench = true;
+        }
+        else if (arg == "--build-bench" && i + 1 < argc) {
+            options.buildBenchDir = argv[++i];
+        }
+        else if (arg == "--literal-bench") {
+            options.literalBench = true;
+        }
+        else if (arg == "--walk-bench") {
+            options.walkBench = true;
+        }
+        else if (arg == "--type-bench") {
+            options.typeBench = true;
+        }
+        else if (arg == "--no-inline") {
+            options.inlineCalls = false;
+        }
+        else if (arg == "--entry" && i + 1 < argc) {
+            options.entry = argv[++i];
+        }
+        else if (arg == "--max-memory" && i + 1 < argc) {
+            options.maxMemory = std::atoll(argv[++i]);
+            if (options.maxMemory < 1) options.maxMemory = 1;
+        }
+        else if (arg == "--max-errors" && i + 1 < argc) {
+            options.maxErrors = std::atoi(argv[++i]);
+            if (options.maxErrors < 1) options.maxErrors = 1;
+        }
+        // "-" - stdin для --stream
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Неизвестный параметр: " << arg << std::endl;
+            return false;
+        }
+        else {
+            options.files.push_back(arg);
+        }
+    }
+    return true;
+}
+
+// Итог при исчерпании --max-memory: разбор уже прекращен, объясняем,
+// на что ушла память
+bool reportMemoryBudget(const DriverOptions& options, OutputWriter& out) {
+    if (!memoryBudgetExceeded()) return false;
+    out.flush();
+    std::cerr << "Превышен лимит памяти --max-memory " << options.maxMemory
+        << " МБ, обработка остановлена\n";
+    printMemoryText(std::cerr);
+    std::cerr.flush();
+    return true;
+}
+
+void reportStats(const DriverOptions& options) {
+#ifdef TALT_STATS
+    if (options.showStats) {
+        // Статистика идет в std::cerr, чтобы не смешиваться с дампами
+        if (options.statsJson) {
+            Stats::printJson(std::cerr);
+        }
+        else {
+            Stats::printText(std::cerr);
+        }
+    }
+
+    if (!options.traceFile.empty() && !Stats::writeTrace(options.traceFile)) {
+        std::cerr << "Ошибка записи трассировки: " << options.traceFile << std::endl;
+    }
+#else
+    if (options.showStats || !options.traceFile.empty()) {
+        std::cerr << "Статистика недоступна: сборка без TALT_STATS" << std::endl;
+    }
+#endif
+}
+
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "rus");
+
+    DriverOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+    if (options.showStats) enableMemoryAccounting();
+    setMemoryBudget(options.maxMemory * 1024 * 1024);
+#ifndef TALT_STATS
+    if (options.maxMemory > 0) {
+        std::cerr << "Лимит памяти недоступен: сборка без TALT_STATS" << std::endl;
+    }
+#endif
+
+    if (options.lsp == LSP_SERVER) {
+        return runLanguageServer(options);
+    }
+
+    OutputWriter out;
+
+    if (options.allocCheck) {
+        bool correct = checkAllocations(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.recoveryCheck) {
+        bool correct = checkRecovery(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.dumpBench) {
+        bool correct = benchDump(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.dataflowBench) {
+        benchDataflow(out);
+        out.flush();
+        reportStats(options);
+        return out.good() ? 0 : 1;
+    }
+
+    if (options.callBench) {
+        bool correct = benchCalls(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.symbolBench) {
+        bool correct = benchSymbols(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.fieldBench) {
+        bool correct = benchFields(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.jitBench) {
+        bool correct = benchJit(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.vectorBench) {
+        bool correct = benchVectorize(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.parallelBench) {
+        bool correct = benchParallel(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (!options.buildBenchDir.empty()) {
+        bool correct = benchBuild(options.buildBenchDir, out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.literalBench) {
+        bool correct = benchLiterals(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.walkBench) {
+        bool correct = benchWalks(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (options.typeBench) {
+        bool correct = benchTypes(out);
+        out.flush();
+        reportStats(options);
+        return correct && out.good() ? 0 : 1;
+    }
+
+    if (!options.files.empty()) {
+        bool dump = options.dumpTokens != DUMP_NONE || options.dumpAst != DUMP_NONE;
+        bool allCorrect = true;
+
+        std::unique_ptr<ResultCache> cache;
+        if (!options.cacheDir.empty()) {
+            cache.reset(new ResultCache(options.cacheDir));
+            if (!cache->isUsable()) {
+                std::cerr << "Каталог кэша недоступен: " << options.cacheDir << std::endl;
+            }
+        }
+
+        // --repeat многократно прогоняет те же файлы для замеров
+        for (int run = 0; run < options.repeat; run++) {
+            // Файлы проверяются вместе: они могут импортировать друг друга
+            if (options.lsp == LSP_NONE && options.run == RUN_NONE &&
+                !options.apiBench && !options.chunkCheck && (options.build || options.check)) {
+                allCorrect &= options.build ? buildProject(options, cache.get(), out)
+                    : checkFiles(options, cache.get(), out);
+            }
+            else {
+                for (const auto& filename : options.files) {
+                    if (options.lsp != LSP_NONE) {
+                        allCorrect &= benchLanguageServer(filename, options, out);
+                    }
+                    else if (options.apiBench) {
+                        allCorrect &= benchApi(filename, options, out);
+                    }
+                    else if (options.chunkCheck) {
+                        allCorrect &= checkChunks(filename, out);
+                    }
+                    else if (options.run != RUN_NONE) {
+                        allCorrect &= runFile(filename, options, out);
+                    }
+                    else if (options.stream) {
+                        allCorrect &= streamFile(filename, options, out);
+                    }
+                    else if (dump) {
+                        dumpFile(filename, options, out);
+                    }
+                    else {
+                        processFile(filename, options, out);
+                    }
+                    if (memoryBudgetExceeded()) break;
+                }
+            }
+            if (reportMemoryBudget(options, out)) {
+                allCorrect = false;
+                break;
+            }
+        }
+        out.flush();
+        if (cache) {
+            std::cerr << "Кэш: попаданий " << cache->hits
+                << ", промахов " << cache->misses << std::endl;
+        }
+        reportStats(options);
+        return allCorrect && out.good() ? 0 : 1;
+    }
+
     // Запускаем все тесты
-    processFile("test_correct.txt");
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "\n";
+    processFile("test_correct.txt", options, out);
+    out << "\n" << std::string(60, '=') << "\n";
+    out << "\n";
+
+    processFile("test_error1.txt", options, out);
+    out << "\n" << std::string(60, '=') << "\n";
+    out << "\n";
 
-    processFile("test_error1.txt");
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "\n";
+    processFile("test_error2.txt", options, out);
 
-    processFile("test_error2.txt");
+    out << "\n" << std::string(60, '=') << "\n";
+    out << "ВСЕ ТЕСТЫ ВЫПОЛНЕНЫ\n";
+    out.flush();
 
-    std::cout << "\n" << std::string(60, '=') << std::endl;
-    std::cout << "ВСЕ ТЕСТЫ ВЫПОЛНЕНЫ" << std::endl;
+    reportStats(options);
 
     // Пауза
     std::cout << "\nНажмите Enter для выхода...";
     std::cin.get();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,109 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int count) : workerCount(count < 1 ? 1 : count) {
+    for (int i = 0; i < workerCount; i++) {
+        queues.emplace_back(new WorkQueue());
+    }
+    for (int i = 1; i < workerCount; i++) {
+        threads.emplace_back(&ThreadPool::threadMain, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    startSignal.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+int ThreadPool::defaultThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : (int)count;
+}
+
+bool ThreadPool::take(int worker, int& task) {
+    {
+        WorkQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    //   :     
+    for (int i = 1; i < workerCount; i++) {
+        WorkQueue& victim = *queues[(worker + i) % workerCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work(int worker, const Task& task) {
+    int item;
+    while (take(worker, item)) {
+        task(item, worker);
+    }
+}
+
+void ThreadPool::threadMain(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        const Task* task;
+        {
+            std::unique_lock<std::mutex> guard(stateLock);
+            startSignal.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            task = current;
+        }
+
+        work(worker, *task);
+
+        {
+            std::lock_guard<std::mutex> guard(stateLock);
+            finished++;
+        }
+        doneSignal.notify_one();
+    }
+}
+
+void ThreadPool::run(int count, const Task& task) {
+    //   :      
+    for (int w = 0; w < workerCount; w++) {
+        WorkQueue& queue = *queues[w];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        int begin = (int)((long long)count * w / workerCount);
+        int end = (int)((long long)count * (w + 1) / workerCount);
+        for (int i = begin; i < end; i++) {
+            queue.tasks.push_back(i);
+        }
+    }
+
+    if (workerCount > 1) {
+        std::lock_guard<std::mutex> guard(stateLock);
+        current = &task;
+        finished = 0;
+        generation++;
+    }
+    startSignal.notify_all();
+
+    work(0, task);
+
+    //        ,  
+    //      task
+    std::unique_lock<std::mutex> guard(stateLock);
+    doneSignal.wait(guard, [&] { return finished == workerCount - 1; });
+    current = nullptr;
+}
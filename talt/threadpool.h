@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//     .    run() 
+//       ;   
+//    ,     -   .
+//      0.
+class ThreadPool {
+public:
+    typedef std::function<void(int task, int worker)> Task;
+
+    explicit ThreadPool(int count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return workerCount; }
+
+    //  task(0..count-1); ,   
+    void run(int count, const Task& task);
+
+    //    :  
+    static int defaultThreads();
+
+    //       
+    unsigned long long stealCount() const { return steals.load(); }
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<int> tasks;
+    };
+
+    int workerCount;
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    std::mutex stateLock;
+    std::condition_variable startSignal;
+    std::condition_variable doneSignal;
+    const Task* current = nullptr;
+    unsigned generation = 0;
+    int finished = 0;   //  ,   run()
+    bool stopping = false;
+
+    std::atomic<unsigned long long> steals{ 0 };
+
+    bool take(int worker, int& task);
+    void work(int worker, const Task& task);
+    void threadMain(int worker);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "typerules.h"
+
+const char* typeDiagnosticText(TypeDiagnostic diagnostic) {
+    switch (diagnostic) {
+    case TDIAG_ARITHMETIC_OPERANDS: return "      ";
+    case TDIAG_COMPARISON_OPERANDS: return "      ";
+    case TDIAG_BITWISE_OPERANDS: return "      ";
+    case TDIAG_MODULO_OPERANDS: return " %     ";
+    case TDIAG_SIGN_OPERAND: return " +  -     ";
+    case TDIAG_BIT_NOT_OPERAND: return "      ";
+    case TDIAG_INTEGER_TO_FLOAT: return "     float";
+    case TDIAG_FLOAT_TO_INTEGER: return "  float   ";
+    case TDIAG_NARROWING: return "    ";
+    case TDIAG_INCOMPATIBLE_ASSIGNMENT: return "   ";
+    default: return "";
+    }
+}
+
+namespace {
+
+//    : ,  
+// ,    SemanticAnalyzer  ,  
+// TYPE_RULES   ,    
+
+constexpr bool referenceInteger(DataType t) {
+    return t == TYPE_SHORT || t == TYPE_INT || t == TYPE_LONG;
+}
+
+constexpr bool referenceNumeric(DataType t) {
+    return referenceInteger(t) || t == TYPE_FLOAT;
+}
+
+constexpr DataType referencePromote(DataType a, DataType b) {
+    if (a == TYPE_FLOAT || b == TYPE_FLOAT) return TYPE_FLOAT;
+    if (a == TYPE_LONG || b == TYPE_LONG) return TYPE_LONG;
+    if (a == TYPE_INT || b == TYPE_INT) return TYPE_INT;
+    return TYPE_SHORT;
+}
+
+constexpr int referenceSize(TargetAbi abi, DataType t) {
+    switch (t) {
+    case TYPE_SHORT: return 2;
+    case TYPE_INT: return 4;
+    case TYPE_LONG: return abi == ABI_LP64 ? 8 : 4;
+    case TYPE_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+constexpr TypeRule referenceBinary(TokenType op, DataType a, DataType b) {
+    if (a == TYPE_UNDEFINED || b == TYPE_UNDEFINED) return { TYPE_UNDEFINED, TDIAG_NONE };
+    switch (op) {
+    case TK_PLUS: case TK_MINUS: case TK_MUL: case TK_DIV:
+        if (!referenceNumeric(a) || !referenceNumeric(b)) return { TYPE_UNDEFINED, TDIAG_ARITHMETIC_OPERANDS };
+        return { referencePromote(a, b), TDIAG_NONE };
+    case TK_EQ: case TK_NE: case TK_LT: case TK_LE: case TK_GT: case TK_GE:
+        if (!referenceNumeric(a) || !referenceNumeric(b)) return { TYPE_UNDEFINED, TDIAG_COMPARISON_OPERANDS };
+        return { TYPE_INT, TDIAG_NONE };
+    case TK_BIT_AND: case TK_BIT_OR: case TK_BIT_XOR: case TK_SHL: case TK_SHR:
+        if (!referenceInteger(a) || !referenceInteger(b)) return { TYPE_UNDEFINED, TDIAG_BITWISE_OPERANDS };
+        return { referencePromote(a, b), TDIAG_NONE };
+    case TK_MOD:
+        if (!referenceInteger(a) || !referenceInteger(b)) return { TYPE_UNDEFINED, TDIAG_MODULO_OPERANDS };
+        return { referencePromote(a, b), TDIAG_NONE };
+    default:
+        return { TYPE_UNDEFINED, TDIAG_NONE };
+    }
+}
+
+constexpr TypeRule referenceUnary(TokenType op, DataType t) {
+    if (t == TYPE_UNDEFINED) return { TYPE_UNDEFINED, TDIAG_NONE };
+    if (op == TK_PLUS || op == TK_MINUS) {
+        if (!referenceNumeric(t)) return { TYPE_UNDEFINED, TDIAG_SIGN_OPERAND };
+        return { t, TDIAG_NONE };
+    }
+    if (op == TK_BIT_NOT) {
+        if (!referenceInteger(t)) return { TYPE_UNDEFINED, TDIAG_BIT_NOT_OPERAND };
+        return { t, TDIAG_NONE };
+    }
+    return { TYPE_UNDEFINED, TDIAG_NONE };
+}
+
+constexpr AssignmentCheck referenceAssignment(TargetAbi abi, DataType left, DataType right) {
+    if (left == right && left != TYPE_STRUCT) return { true, TDIAG_NONE };
+    if (left == TYPE_STRUCT || right == TYPE_STRUCT) return { false, TDIAG_INCOMPATIBLE_ASSIGNMENT };
+    if (left == TYPE_FLOAT && referenceInteger(right)) return { true, TDIAG_INTEGER_TO_FLOAT };
+    if (referenceInteger(left) && right == TYPE_FLOAT) return { false, TDIAG_FLOAT_TO_INTEGER };
+    if (referenceInteger(left) && referenceInteger(right)) {
+        if (referenceSize(abi, right) > referenceSize(abi, left)) return { true, TDIAG_NARROWING };
+        return { true, TDIAG_NONE };
+    }
+    return { false, TDIAG_INCOMPATIBLE_ASSIGNMENT };
+}
+
+constexpr bool sameRule(const TypeRule& a, const TypeRule& b) {
+    return a.result == b.result && a.diagnostic == b.diagnostic;
+}
+
+//    TK_INT  TK_ERROR,     
+constexpr bool tablesMatchReference() {
+    for (int op = TK_INT; op <= TK_ERROR; op++) {
+        for (int a = 0; a < TYPE_KINDS; a++) {
+            if (!sameRule(unaryRule((TokenType)op, (DataType)a),
+                referenceUnary((TokenType)op, (DataType)a))) {
+                return false;
+            }
+            for (int b = 0; b < TYPE_KINDS; b++) {
+                if (!sameRule(binaryRule((TokenType)op, (DataType)a, (DataType)b),
+                    referenceBinary((TokenType)op, (DataType)a, (DataType)b))) {
+                    return false;
+                }
+            }
+        }
+    }
+    for (int abi = 0; abi < TARGET_ABIS; abi++) {
+        for (int a = 0; a < TYPE_KINDS; a++) {
+            for (int b = 0; b < TYPE_KINDS; b++) {
+                const AssignmentCheck& table = assignmentRule((TargetAbi)abi, (DataType)a, (DataType)b);
+                AssignmentCheck reference = referenceAssignment((TargetAbi)abi, (DataType)a, (DataType)b);
+                if (table.allowed != reference.allowed || table.diagnostic != reference.diagnostic) {
+                    return false;
+                }
+                if (TYPE_TRAITS[a].size[abi] != referenceSize((TargetAbi)abi, (DataType)a)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(tablesMatchReference(),
+    " TYPE_RULES    ");
+
+}
@@ -0,0 +1,207 @@
+#ifndef TYPERULES_H
+#define TYPERULES_H
+
+#include "types.h"
+
+//   .  -    
+//  ;       TYPE_RULES,
+//         .
+
+//   ;  - typeDiagnosticText
+enum TypeDiagnostic : unsigned char {
+    TDIAG_NONE,
+    TDIAG_ARITHMETIC_OPERANDS,
+    TDIAG_COMPARISON_OPERANDS,
+    TDIAG_BITWISE_OPERANDS,
+    TDIAG_MODULO_OPERANDS,
+    TDIAG_SIGN_OPERAND,
+    TDIAG_BIT_NOT_OPERAND,
+    TDIAG_INTEGER_TO_FLOAT,
+    TDIAG_FLOAT_TO_INTEGER,
+    TDIAG_NARROWING,
+    TDIAG_INCOMPATIBLE_ASSIGNMENT
+};
+
+const char* typeDiagnosticText(TypeDiagnostic diagnostic);
+
+//   
+enum OperandRule : unsigned char {
+    OPERANDS_NUMERIC,
+    OPERANDS_INTEGER
+};
+
+//  
+enum ResultRule : unsigned char {
+    RESULT_PROMOTED,  //   
+    RESULT_INT,
+    RESULT_OPERAND    //   
+};
+
+struct OperatorRule {
+    TokenType op;
+    OperandRule operands;
+    ResultRule result;
+    TypeDiagnostic diagnostic;  //   
+};
+
+inline constexpr OperatorRule BINARY_OPERATOR_RULES[] = {
+    { TK_PLUS, OPERANDS_NUMERIC, RESULT_PROMOTED, TDIAG_ARITHMETIC_OPERANDS },
+    { TK_MINUS, OPERANDS_NUMERIC, RESULT_PROMOTED, TDIAG_ARITHMETIC_OPERANDS },
+    { TK_MUL, OPERANDS_NUMERIC, RESULT_PROMOTED, TDIAG_ARITHMETIC_OPERANDS },
+    { TK_DIV, OPERANDS_NUMERIC, RESULT_PROMOTED, TDIAG_ARITHMETIC_OPERANDS },
+    { TK_MOD, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_MODULO_OPERANDS },
+    { TK_EQ, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_NE, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_LT, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_LE, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_GT, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_GE, OPERANDS_NUMERIC, RESULT_INT, TDIAG_COMPARISON_OPERANDS },
+    { TK_BIT_AND, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_BITWISE_OPERANDS },
+    { TK_BIT_OR, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_BITWISE_OPERANDS },
+    { TK_BIT_XOR, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_BITWISE_OPERANDS },
+    { TK_SHL, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_BITWISE_OPERANDS },
+    { TK_SHR, OPERANDS_INTEGER, RESULT_PROMOTED, TDIAG_BITWISE_OPERANDS }
+};
+
+inline constexpr OperatorRule UNARY_OPERATOR_RULES[] = {
+    { TK_PLUS, OPERANDS_NUMERIC, RESULT_OPERAND, TDIAG_SIGN_OPERAND },
+    { TK_MINUS, OPERANDS_NUMERIC, RESULT_OPERAND, TDIAG_SIGN_OPERAND },
+    { TK_BIT_NOT, OPERANDS_INTEGER, RESULT_OPERAND, TDIAG_BIT_NOT_OPERAND }
+};
+
+//    source   target.
+//    ,    
+// ; ,    , - .
+struct AssignmentRule {
+    TypeClass target;
+    TypeClass source;
+    bool allowed;            // false -  diagnostic
+    bool narrowingOnly;      // diagnostic,   source  target
+    TypeDiagnostic diagnostic;
+};
+
+inline constexpr AssignmentRule ASSIGNMENT_RULES[] = {
+    { CLASS_INTEGER, CLASS_INTEGER, true, true, TDIAG_NARROWING },
+    { CLASS_FLOAT, CLASS_INTEGER, true, false, TDIAG_INTEGER_TO_FLOAT },
+    { CLASS_INTEGER, CLASS_FLOAT, false, false, TDIAG_FLOAT_TO_INTEGER }
+};
+
+//  : TYPE_UNDEFINED -  , 
+// diagnostic.      
+// :      .
+struct TypeRule {
+    DataType result;
+    TypeDiagnostic diagnostic;
+};
+
+struct AssignmentCheck {
+    bool allowed;
+    TypeDiagnostic diagnostic;  //  allowed - 
+};
+
+//       TK_PLUS;   - 
+//  ,       
+const int RULE_OPERATORS = TK_SHR - TK_PLUS + 1;
+
+struct TypeRuleTables {
+    TypeRule binary[RULE_OPERATORS + 1][TYPE_KINDS][TYPE_KINDS] = {};
+    TypeRule unary[RULE_OPERATORS + 1][TYPE_KINDS] = {};
+    AssignmentCheck assignment[TARGET_ABIS][TYPE_KINDS][TYPE_KINDS] = {};
+};
+
+constexpr bool operandAllowed(OperandRule rule, DataType kind) {
+    return rule == OPERANDS_INTEGER ? isIntegerKind(kind) : isNumericKind(kind);
+}
+
+constexpr TypeRule applyOperatorRule(const OperatorRule& rule, DataType left, DataType right) {
+    if (left == TYPE_UNDEFINED || right == TYPE_UNDEFINED) {
+        return { TYPE_UNDEFINED, TDIAG_NONE };
+    }
+    if (!operandAllowed(rule.operands, left) || !operandAllowed(rule.operands, right)) {
+        return { TYPE_UNDEFINED, rule.diagnostic };
+    }
+    switch (rule.result) {
+    case RESULT_INT: return { TYPE_INT, TDIAG_NONE };
+    case RESULT_OPERAND: return { left, TDIAG_NONE };
+    default:
+        return { TYPE_TRAITS[left].rank >= TYPE_TRAITS[right].rank ? left : right,
+            TDIAG_NONE };
+    }
+}
+
+constexpr AssignmentCheck applyAssignmentRules(TargetAbi abi, DataType target, DataType source) {
+    if (target == source && target != TYPE_STRUCT) {
+        return { true, TDIAG_NONE };
+    }
+    for (const AssignmentRule& rule : ASSIGNMENT_RULES) {
+        if (rule.target != TYPE_TRAITS[target].typeClass ||
+            rule.source != TYPE_TRAITS[source].typeClass) {
+            continue;
+        }
+        if (rule.narrowingOnly &&
+            TYPE_TRAITS[source].size[abi] <= TYPE_TRAITS[target].size[abi]) {
+            return { rule.allowed, TDIAG_NONE };
+        }
+        return { rule.allowed, rule.diagnostic };
+    }
+    return { false, TDIAG_INCOMPATIBLE_ASSIGNMENT };
+}
+
+constexpr TypeRuleTables expandTypeRules() {
+    TypeRuleTables tables;
+    //       
+    for (const OperatorRule& rule : UNARY_OPERATOR_RULES) {
+        for (int a = 0; a < TYPE_KINDS; a++) {
+            tables.unary[rule.op - TK_PLUS][a] =
+                applyOperatorRule(rule, (DataType)a, (DataType)a);
+        }
+    }
+    for (const OperatorRule& rule : BINARY_OPERATOR_RULES) {
+        for (int a = 0; a < TYPE_KINDS; a++) {
+            for (int b = 0; b < TYPE_KINDS; b++) {
+                tables.binary[rule.op - TK_PLUS][a][b] =
+                    applyOperatorRule(rule, (DataType)a, (DataType)b);
+            }
+        }
+    }
+    for (int abi = 0; abi < TARGET_ABIS; abi++) {
+        for (int a = 0; a < TYPE_KINDS; a++) {
+            for (int b = 0; b < TYPE_KINDS; b++) {
+                tables.assignment[abi][a][b] =
+                    applyAssignmentRules((TargetAbi)abi, (DataType)a, (DataType)b);
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr TypeRuleTables TYPE_RULES = expandTypeRules();
+
+constexpr unsigned ruleRow(TokenType op) {
+    unsigned row = (unsigned)op - TK_PLUS;
+    return row < (unsigned)RULE_OPERATORS ? row : RULE_OPERATORS;
+}
+
+constexpr const TypeRule& binaryRule(TokenType op, DataType left, DataType right) {
+    return TYPE_RULES.binary[ruleRow(op)][left][right];
+}
+
+constexpr const TypeRule& unaryRule(TokenType op, DataType operand) {
+    return TYPE_RULES.unary[ruleRow(op)][operand];
+}
+
+//   ;     - 
+//  ,      
+constexpr const AssignmentCheck& assignmentRule(TargetAbi abi, DataType target, DataType source) {
+    return TYPE_RULES.assignment[abi][target][source];
+}
+
+//      ; nullptr -  
+constexpr const OperatorRule* findBinaryOperatorRule(TokenType op) {
+    for (const OperatorRule& rule : BINARY_OPERATOR_RULES) {
+        if (rule.op == op) return &rule;
+    }
+    return nullptr;
+}
+
+#endif
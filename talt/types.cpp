@@ -0,0 +1,35 @@
+#include "types.h"
+
+namespace {
+
+const Type BUILTIN_TYPES[] = {
+    { TYPE_UNDEFINED, NO_NAME },
+    { TYPE_SHORT, NO_NAME },
+    { TYPE_INT, NO_NAME },
+    { TYPE_LONG, NO_NAME },
+    { TYPE_FLOAT, NO_NAME },
+    { TYPE_STRUCT, NO_NAME },
+    { TYPE_VOID, NO_NAME }
+};
+
+}
+
+const Type* builtinType(DataType kind) {
+    return &BUILTIN_TYPES[kind];
+}
+
+const Type* TypeTable::structType(NameId name) {
+    if (name == NO_NAME) return builtinType(TYPE_STRUCT);
+
+    uint32_t found = index.find(name);
+    if (found != NameIndexMap::NOT_FOUND) return &structs[found];
+
+    index.insert(name, (uint32_t)structs.size());
+    structs.push_back(Type{ TYPE_STRUCT, name });
+    return &structs.back();
+}
+
+void TypeTable::clear() {
+    structs.clear();
+    index.clear();
+}
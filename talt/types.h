@@ -0,0 +1,97 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include "scanner.h"
+#include "names.h"
+#include "flatmap.h"
+#include <deque>
+
+enum DataType : unsigned char {
+    TYPE_UNDEFINED,
+    TYPE_SHORT,
+    TYPE_INT,
+    TYPE_LONG,
+    TYPE_FLOAT,
+    TYPE_STRUCT,
+    TYPE_VOID
+};
+
+const int TYPE_KINDS = TYPE_VOID + 1;
+
+//    :  int, long  
+enum TargetAbi {
+    ABI_ILP32,  // 32- : long = 4
+    ABI_LP64,   // Linux, macOS x64: long = 8
+    ABI_LLP64   // Windows x64: long = 4
+};
+
+const int TARGET_ABIS = ABI_LLP64 + 1;
+
+enum TypeClass : unsigned char {
+    CLASS_OTHER,
+    CLASS_INTEGER,
+    CLASS_FLOAT
+};
+
+//   .     
+//     .
+struct TypeTraits {
+    TypeClass typeClass;
+    unsigned char rank;
+    unsigned char size[TARGET_ABIS];  // , 0 -   
+};
+
+inline constexpr TypeTraits TYPE_TRAITS[TYPE_KINDS] = {
+    /* TYPE_UNDEFINED */ { CLASS_OTHER, 0, { 0, 0, 0 } },
+    /* TYPE_SHORT */     { CLASS_INTEGER, 1, { 2, 2, 2 } },
+    /* TYPE_INT */       { CLASS_INTEGER, 2, { 4, 4, 4 } },
+    /* TYPE_LONG */      { CLASS_INTEGER, 3, { 4, 8, 4 } },
+    /* TYPE_FLOAT */     { CLASS_FLOAT, 4, { 4, 4, 4 } },
+    /* TYPE_STRUCT */    { CLASS_OTHER, 0, { 0, 0, 0 } },
+    /* TYPE_VOID */      { CLASS_OTHER, 0, { 0, 0, 0 } }
+};
+
+constexpr bool isIntegerKind(DataType kind) {
+    return TYPE_TRAITS[kind].typeClass == CLASS_INTEGER;
+}
+
+constexpr bool isNumericKind(DataType kind) {
+    return TYPE_TRAITS[kind].typeClass != CLASS_OTHER;
+}
+
+//  .       , 
+//   :     
+// .      ,  
+//  TypeTable.
+struct Type {
+    DataType kind;
+    NameId structName;  //  TYPE_STRUCT,  NO_NAME
+
+    bool isStruct() const { return kind == TYPE_STRUCT; }
+    bool isInteger() const { return isIntegerKind(kind); }
+    bool isNumeric() const { return isNumericKind(kind); }
+};
+
+//  ;  TYPE_STRUCT -   
+const Type* builtinType(DataType kind);
+
+//    .    
+// ;   ,   NameTable ,  
+//    reset,     .
+// clear      .
+class TypeTable {
+private:
+    std::deque<Type> structs;  //   
+    NameIndexMap index;        //  ->   structs
+
+public:
+    TypeTable() = default;
+    TypeTable(const TypeTable&) = delete;
+    TypeTable& operator=(const TypeTable&) = delete;
+
+    const Type* structType(NameId name);
+    size_t structCount() const { return structs.size(); }
+    void clear();
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "vectorize.h"
+#include <algorithm>
+
+namespace {
+
+bool sameAddress(const ExecAddress& a, const ExecAddress& b) {
+    return a.global == b.global && a.offset == b.offset;
+}
+
+bool isWritten(const VectorLoop& loop, const ExecAddress& address) {
+    if (sameAddress(loop.induction, address)) return true;
+    for (const auto& reduction : loop.reductions) {
+        if (sameAddress(reduction.address, address)) return true;
+    }
+    return false;
+}
+
+//  : ,     
+//    ,     
+bool isVectorExpression(const ExecNode* node, const VectorLoop& loop) {
+    if (node->type != EXT_I32 && node->type != EXT_F32) return false;
+
+    switch (node->op) {
+    case EX_CONST:
+        return true;
+
+    case EX_LOAD:
+        return sameAddress(node->address, loop.induction) ||
+            !isWritten(loop, node->address);
+
+    case EX_CONVERT:
+        return node->type == EXT_F32 && node->left->type == EXT_I32 &&
+            isVectorExpression(node->left, loop);
+
+    case EX_NEGATE:
+        return isVectorExpression(node->left, loop);
+
+    case EX_BIT_NOT:
+        return node->type == EXT_I32 && isVectorExpression(node->left, loop);
+
+    case EX_BINARY:
+        if (node->operandType != node->type) return false;  // 
+        if (node->type == EXT_F32) {
+            if (node->binop != TK_PLUS && node->binop != TK_MINUS &&
+                node->binop != TK_MUL && node->binop != TK_DIV) {
+                return false;
+            }
+        }
+        else if (node->binop != TK_PLUS && node->binop != TK_MINUS &&
+            node->binop != TK_MUL && node->binop != TK_BIT_AND &&
+            node->binop != TK_BIT_OR && node->binop != TK_BIT_XOR) {
+            return false;
+        }
+        return isVectorExpression(node->left, loop) &&
+            isVectorExpression(node->right, loop);
+
+    default:
+        return false;
+    }
+}
+
+// :   int  float   
+bool collectReductions(const ExecNode* node, bool fastMath, VectorLoop& loop) {
+    if (node->op == EX_SEQ) {
+        for (const ExecNode* item : node->items) {
+            if (!collectReductions(item, fastMath, loop)) return false;
+        }
+        return true;
+    }
+
+    Reduction reduction;
+    if (!matchReduction(node, fastMath, reduction) ||
+        (reduction.type != EXT_I32 && reduction.type != EXT_F32) ||
+        isWritten(loop, reduction.address)) {
+        return false;
+    }
+    loop.reductions.push_back(reduction);
+    return true;
+}
+
+}
+
+bool analyzeVectorLoop(const ExecNode* node, bool fastMath, VectorLoop& result) {
+    VectorLoop loop;
+    if (!node->body || !matchCountedLoop(node, loop)) {
+        return false;
+    }
+
+    if (!collectReductions(node->body, fastMath, loop) || loop.reductions.empty()) {
+        return false;
+    }
+
+    //        ,   
+    for (const auto& reduction : loop.reductions) {
+        for (const auto& term : reduction.terms) {
+            if (!isVectorExpression(term.value, loop)) return false;
+        }
+    }
+    if (loop.bound->op == EX_LOAD && isWritten(loop, loop.bound->address)) {
+        return false;
+    }
+
+    result = std::move(loop);
+    return true;
+}
+
+int vectorRegisters(const ExecNode* value) {
+    switch (value->op) {
+    case EX_CONVERT:
+        return vectorRegisters(value->left);
+    case EX_NEGATE:
+    case EX_BIT_NOT:
+        return std::max(vectorRegisters(value->left), 2);
+    case EX_BINARY: {
+        int count = std::max(vectorRegisters(value->left),
+            1 + vectorRegisters(value->right));
+        //  int  SSE4.1    
+        if (value->type == EXT_I32 && value->binop == TK_MUL) {
+            count = std::max(count, 4);
+        }
+        return count;
+    }
+    default:
+        return 1;
+    }
+}
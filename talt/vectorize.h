@@ -0,0 +1,26 @@
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include "depend.h"
+#include <vector>
+
+//  : 4  int  float (128 , SSE2)
+const int VECTOR_LANES = 4;
+
+//  ,      
+struct VectorLoop : CountedLoop {
+    std::vector<Reduction> reductions;
+};
+
+// ,      VECTOR_LANES  .
+//         ; 
+//    ,   , 
+//    .     (
+//     2^32 ),  float - 
+//  fastMath,       .
+bool analyzeVectorLoop(const ExecNode* loop, bool fastMath, VectorLoop& result);
+
+//      
+int vectorRegisters(const ExecNode* value);
+
+#endif
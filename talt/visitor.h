@@ -0,0 +1,120 @@
+#ifndef VISITOR_H
+#define VISITOR_H
+
+#include "parser.h"
+#include <memory>
+#include <type_traits>
+
+// T   Base:      
+template <class Base, class T>
+using NodeLike = typename std::conditional<std::is_const<Base>::value, const T, T>::type;
+
+//   kind  dynamic_cast; nullptr    
+template <class T, class Base>
+NodeLike<Base, T>* nodeCast(Base* node) {
+    return node && node->kind == T::Kind ? static_cast<NodeLike<Base, T>*>(node) : nullptr;
+}
+
+//  f  ,    .  - switch  kind,
+//   ;   f    .
+template <class Base, class F>
+decltype(auto) visitNode(Base& node, F&& f) {
+    switch (node.kind) {
+    case NODE_PROGRAM: return f(static_cast<NodeLike<Base, ProgramNode>&>(node));
+    case NODE_STRUCT_DECL: return f(static_cast<NodeLike<Base, StructDeclNode>&>(node));
+    case NODE_FUNCTION: return f(static_cast<NodeLike<Base, FunctionNode>&>(node));
+    case NODE_VAR_DECL: return f(static_cast<NodeLike<Base, VarDeclNode>&>(node));
+    case NODE_ASSIGN: return f(static_cast<NodeLike<Base, AssignNode>&>(node));
+    case NODE_FOR: return f(static_cast<NodeLike<Base, ForLoopNode>&>(node));
+    case NODE_BINARY_OP: return f(static_cast<NodeLike<Base, BinaryOpNode>&>(node));
+    case NODE_UNARY_OP: return f(static_cast<NodeLike<Base, UnaryOpNode>&>(node));
+    case NODE_VAR: return f(static_cast<NodeLike<Base, VarNode>&>(node));
+    case NODE_CONST: return f(static_cast<NodeLike<Base, ConstNode>&>(node));
+    case NODE_BLOCK: return f(static_cast<NodeLike<Base, BlockNode>&>(node));
+    case NODE_RETURN: return f(static_cast<NodeLike<Base, ReturnNode>&>(node));
+    case NODE_CALL: return f(static_cast<NodeLike<Base, CallNode>&>(node));
+    default: return f(static_cast<NodeLike<Base, ImportNode>&>(node));
+    }
+}
+
+//        ,  .
+//      .
+template <class Node, class F>
+void forEachChildSlot(Node& node, F&& f) {
+    using Plain = typename std::remove_const<Node>::type;
+    if constexpr (std::is_same<Plain, ProgramNode>::value) {
+        for (auto& decl : node.declarations) f(decl);
+    }
+    else if constexpr (std::is_same<Plain, FunctionNode>::value) {
+        f(node.body);
+    }
+    else if constexpr (std::is_same<Plain, VarDeclNode>::value) {
+        f(node.initValue);
+    }
+    else if constexpr (std::is_same<Plain, AssignNode>::value ||
+        std::is_same<Plain, ReturnNode>::value) {
+        f(node.expression);
+    }
+    else if constexpr (std::is_same<Plain, ForLoopNode>::value) {
+        f(node.init);
+        f(node.condition);
+        f(node.increment);
+        f(node.body);
+    }
+    else if constexpr (std::is_same<Plain, BinaryOpNode>::value) {
+        f(node.left);
+        f(node.right);
+    }
+    else if constexpr (std::is_same<Plain, UnaryOpNode>::value) {
+        f(node.operand);
+    }
+    else if constexpr (std::is_same<Plain, BlockNode>::value) {
+        for (auto& stmt : node.statements) f(stmt);
+    }
+    else if constexpr (std::is_same<Plain, CallNode>::value) {
+        for (auto& argument : node.arguments) f(argument);
+    }
+    else if constexpr (std::is_same<Plain, ASTNode>::value) {
+        visitNode(node, [&](auto& concrete) { forEachChildSlot(concrete, f); });
+    }
+}
+
+//   
+template <class Node, class F>
+void forEachChild(Node& node, F&& f) {
+    forEachChildSlot(node, [&](auto& slot) {
+        if (slot) f(static_cast<NodeLike<Node, ASTNode>&>(*slot));
+    });
+}
+
+//      .  
+// visit     ,   :
+//
+//   class LoopCounter : public ASTWalker<LoopCounter> {
+//   public:
+//       using ASTWalker::visit;
+//       int loops = 0;
+//       void visit(const ForLoopNode& node) { loops++; visitChildren(node); }
+//   };
+template <class Derived>
+class ASTWalker {
+public:
+    template <class Node>
+    void walk(Node& node) {
+        visitNode(static_cast<NodeLike<Node, ASTNode>&>(node), [this](auto& concrete) {
+            static_cast<Derived*>(this)->visit(concrete);
+        });
+    }
+
+    template <class Node>
+    void visit(Node& node) {
+        visitChildren(node);
+    }
+
+    template <class Node>
+    void visitChildren(Node& node) {
+        forEachChild(node, [this](auto& child) { walk(child); });
+    }
+};
+
+#endif